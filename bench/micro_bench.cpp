@@ -0,0 +1,499 @@
+#include "../include/bench_harness.hpp"
+#include "../include/crc.hpp"
+#include "../include/packet.hpp"
+#include "../include/telemetry.hpp"
+#include "../include/commands.hpp"
+#include "../include/rule_program.hpp"
+#include "../include/multi_ground_station.hpp"
+#include "../include/thread_safe_queue.hpp"
+#include "../include/sharded_counter.hpp"
+#include "../include/gf256.hpp"
+#include "../include/fec.hpp"
+#include "../include/viterbi.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Hot-path micro-benchmarks: CRC, packet codec, telemetry and command
+ * serialization, ground-side telemetry rules, ground station ingest,
+ * forward error correction, Viterbi decoding, the inter-thread queue and
+ * metric counters.
+ */
+
+namespace {
+
+Telemetry sample_telemetry() {
+    Telemetry t;
+    t.ts = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(1234567890123LL));
+    t.temperature_c = 21.37;
+    t.battery_pct = 87.5;
+    t.orbit_altitude_km = 412.81;
+    t.pitch_deg = 1.25;
+    t.yaw_deg = -3.5;
+    t.roll_deg = 0.75;
+    return t;
+}
+
+Packet sample_packet(const std::string& payload) {
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.seq = 4242;
+    pkt.payload = payload;
+    pkt.payload_size = static_cast<uint32_t>(payload.size());
+    pkt.compute_crc();
+    return pkt;
+}
+
+void add_crc(bench::Harness& h) {
+    for (size_t size : {16, 64, 256, 1024, 4096}) {
+        auto data = std::make_shared<std::vector<uint8_t>>(size);
+        for (size_t i = 0; i < size; ++i) (*data)[i] = static_cast<uint8_t>(i * 31 + 7);
+        h.add("crc16_ccitt/" + std::to_string(size), [data](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                uint16_t c = crc::crc16_ccitt(data->data(), data->size());
+                bench::do_not_optimize(c);
+            }
+        }, static_cast<double>(size));
+    }
+}
+
+void add_packet(bench::Harness& h) {
+    const std::string telemetry_payload = sample_telemetry().to_json();
+    for (size_t size : {size_t{0}, telemetry_payload.size(), size_t{1024}}) {
+        std::string payload = size == telemetry_payload.size()
+            ? telemetry_payload : std::string(size, 'x');
+        Packet pkt = sample_packet(payload);
+        const std::string bytes = pkt.to_bytes();
+        const std::string suffix = "/" + std::to_string(size);
+        const double wire = static_cast<double>(bytes.size());
+
+        h.add("packet_to_bytes" + suffix, [pkt](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                std::string b = pkt.to_bytes();
+                bench::do_not_optimize(b);
+            }
+        }, wire);
+        h.add("packet_from_bytes" + suffix, [bytes](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                Packet p = Packet::from_bytes(bytes);
+                bench::do_not_optimize(p);
+            }
+        }, wire);
+        h.add("packet_compute_crc" + suffix, [pkt](uint64_t iters) mutable {
+            for (uint64_t i = 0; i < iters; ++i) {
+                pkt.compute_crc();
+                bench::do_not_optimize(pkt.crc16);
+            }
+        }, wire);
+    }
+}
+
+void add_telemetry(bench::Harness& h) {
+    const Telemetry t = sample_telemetry();
+    const std::string json = t.to_json();
+    const double size = static_cast<double>(json.size());
+
+    h.add("telemetry_to_json", [t](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            std::string s = t.to_json();
+            bench::do_not_optimize(s);
+        }
+    }, size);
+    h.add("telemetry_from_json", [json](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            Telemetry parsed = Telemetry::from_json(json);
+            bench::do_not_optimize(parsed);
+        }
+    }, size);
+    h.add("telemetry_to_csv", [t](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            std::string s = t.to_csv();
+            bench::do_not_optimize(s);
+        }
+    });
+}
+
+void add_command(bench::Harness& h) {
+    Command adjust;
+    adjust.type = CommandType::AdjustOrientation;
+    adjust.d_pitch = 1.5;
+    adjust.d_yaw = -2.25;
+    adjust.d_roll = 0.5;
+    Command tagged;
+    tagged.type = CommandType::ThrustBurn;
+    tagged.burn_seconds = 2.5;
+    tagged.exec_time_ns = 9876543210LL;
+
+    for (const auto& [name, cmd] : {std::pair{"adjust", adjust}, std::pair{"timetagged_burn", tagged}}) {
+        const std::string wire = cmd.serialize();
+        h.add(std::string("command_serialize/") + name, [cmd](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                std::string s = cmd.serialize();
+                bench::do_not_optimize(s);
+            }
+        }, static_cast<double>(wire.size()));
+        h.add(std::string("command_deserialize/") + name, [wire](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                Command parsed = Command::deserialize(wire);
+                bench::do_not_optimize(parsed);
+            }
+        }, static_cast<double>(wire.size()));
+
+        const std::string binary = cmd.encode();
+        h.add(std::string("command_encode/") + name, [cmd](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                std::string s = cmd.encode();
+                bench::do_not_optimize(s);
+            }
+        }, static_cast<double>(binary.size()));
+        h.add(std::string("command_decode/") + name, [binary](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                Command parsed = Command::decode(binary);
+                bench::do_not_optimize(parsed);
+            }
+        }, static_cast<double>(binary.size()));
+    }
+}
+
+void add_rules(bench::Harness& h) {
+    // One iteration = one telemetry sample from each of 1000 satellites
+    constexpr uint32_t kSats = 1000;
+    std::vector<uint32_t> sat_ids(kSats);
+    for (uint32_t i = 0; i < kSats; ++i) sat_ids[i] = i;
+
+    for (size_t num_rules : {16, 256}) {
+        std::vector<RuleProgram::Rule> rules(num_rules);
+        for (size_t r = 0; r < num_rules; ++r) {
+            rules[r].field = static_cast<RuleProgram::Field>(r % RuleProgram::kNumFields);
+            rules[r].rate = r % 3 == 0;
+            rules[r].above = r % 2 == 0;
+            rules[r].threshold = static_cast<double>(r % 50);
+            rules[r].cmd.type = CommandType::EnterSafeMode;
+        }
+        auto run = [&sat_ids, &rules](bool batched) {
+            auto program = std::make_shared<RuleProgram>(rules, sat_ids, [](size_t, uint32_t) { return true; });
+            return [sat_ids, program, batched](uint64_t iters) {
+                Telemetry t = sample_telemetry();
+                uint64_t fired = 0;
+                auto count = [&fired](uint32_t, const Command&) { fired++; };
+                for (uint64_t i = 0; i < iters; ++i) {
+                    const double now = static_cast<double>(i);
+                    for (uint32_t id : sat_ids) {
+                        t.battery_pct = static_cast<double>((id + i) % 100);
+                        program->add_sample(id, t, now, count);
+                        if (!batched) {
+                            program->evaluate(count);
+                        }
+                    }
+                    program->evaluate(count);
+                }
+                bench::do_not_optimize(fired);
+            };
+        };
+        const std::string suffix = "/" + std::to_string(num_rules) + "rules_1000sats";
+        h.add("rules_batched" + suffix, run(true));
+        h.add("rules_per_sample" + suffix, run(false));
+    }
+}
+
+void add_ground_station(bench::Harness& h) {
+    // One shard stepped on the benchmark thread: ns/op is CPU time on one
+    // core per telemetry packet, including the link hand-off both ways
+    // (packet in, ACK out). Shards share nothing, so a station with N
+    // workers scales this by at most N.
+    constexpr uint32_t kSats = 1000;
+    struct Station {
+        std::vector<std::unique_ptr<Link>> links;
+        std::unique_ptr<MultiGroundStation> gs;
+        uint32_t seq = 0;  // Keeps rising across repetitions so nothing is a duplicate
+    };
+    auto station = std::make_shared<Station>();
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 1;
+    station->gs = std::make_unique<MultiGroundStation>(gs_config);
+    for (uint32_t id = 0; id < kSats; ++id) {
+        station->links.push_back(std::make_unique<Link>(link_config));
+        station->gs->add_session(id, *station->links.back());
+    }
+    Telemetry t = sample_telemetry();
+    t.ts = std::chrono::steady_clock::now();
+    Packet sample = sample_packet(t.to_json());
+
+    h.add("gs_ingest/1000sats", [station, sample](uint64_t iters) mutable {
+        Packet ack;
+        for (uint64_t done = 0; done < iters;) {
+            sample.seq = station->seq++;
+            sample.compute_crc();
+            for (uint32_t id = 0; id < kSats && done < iters; ++id, ++done) {
+                station->links[id]->send_sat_to_gs(sample);
+            }
+            station->gs->step_shard(0);
+            for (auto& link : station->links) {
+                while (link->recv_gs_to_sat(ack, std::chrono::milliseconds(0))) {
+                    bench::do_not_optimize(ack);
+                }
+            }
+        }
+    }, static_cast<double>(sample.to_bytes().size()));
+}
+
+void add_fec(bench::Harness& h) {
+    constexpr size_t kRegion = 4096;
+    auto src = std::make_shared<std::vector<uint8_t>>(kRegion);
+    for (size_t i = 0; i < kRegion; ++i) (*src)[i] = static_cast<uint8_t>(i * 131 + 17);
+    for (auto kernel : {gf256::Kernel::Scalar, gf256::Kernel::Ssse3, gf256::Kernel::Avx2}) {
+        if (!gf256::supported(kernel)) {
+            continue;
+        }
+        h.add(std::string("gf256_mul_add/") + gf256::kernel_name(kernel), [src, kernel](uint64_t iters) {
+            std::vector<uint8_t> dst(kRegion);
+            for (uint64_t i = 0; i < iters; ++i) {
+                gf256::mul_add_region(dst.data(), src->data(), static_cast<uint8_t>(0x8E + i), kRegion, kernel);
+                bench::do_not_optimize(dst[0]);
+            }
+        }, static_cast<double>(kRegion));
+    }
+
+    // Full RS(255,223) blocks: clean (syndrome check only) and with the
+    // maximum 16 byte errors
+    auto block = std::make_shared<std::vector<uint8_t>>(fec::kRsBlock);
+    for (size_t i = 0; i < fec::kRsData; ++i) (*block)[i] = static_cast<uint8_t>(i * 29 + 3);
+    fec::rs_encode(block->data(), fec::kRsData, block->data() + fec::kRsData);
+    auto damaged = std::make_shared<std::vector<uint8_t>>(*block);
+    for (size_t e = 0; e < fec::kRsParity / 2; ++e) (*damaged)[e * 15 + 1] ^= static_cast<uint8_t>(e + 1);
+    const double data_bytes = static_cast<double>(fec::kRsData);
+
+    h.add("rs_encode/223", [block](uint64_t iters) {
+        uint8_t parity[fec::kRsParity];
+        for (uint64_t i = 0; i < iters; ++i) {
+            fec::rs_encode(block->data(), fec::kRsData, parity);
+            bench::do_not_optimize(parity[0]);
+        }
+    }, data_bytes);
+    h.add("rs_decode/clean", [block](uint64_t iters) {
+        std::vector<uint8_t> b = *block;
+        for (uint64_t i = 0; i < iters; ++i) {
+            auto fixed = fec::rs_decode(b.data(), b.size());
+            bench::do_not_optimize(fixed);
+        }
+    }, data_bytes);
+    h.add("rs_decode/16errors", [damaged](uint64_t iters) {
+        std::vector<uint8_t> b;
+        for (uint64_t i = 0; i < iters; ++i) {
+            b = *damaged;
+            auto fixed = fec::rs_decode(b.data(), b.size());
+            bench::do_not_optimize(fixed);
+        }
+    }, data_bytes);
+
+    // Packet-sized shards: a group of 16 with 4 parity, losing 4 members
+    constexpr size_t kData = 16, kParity = 4, kShard = 256;
+    auto shards = std::make_shared<std::vector<std::vector<uint8_t>>>(kData + kParity, std::vector<uint8_t>(kShard));
+    for (size_t s = 0; s < kData; ++s) {
+        for (size_t i = 0; i < kShard; ++i) (*shards)[s][i] = static_cast<uint8_t>(s * 7 + i);
+    }
+    auto code = std::make_shared<fec::ErasureCode>(kData, kParity);
+    const double group_bytes = static_cast<double>(kData * kShard);
+
+    h.add("erasure_encode/16+4", [shards, code](uint64_t iters) {
+        std::vector<uint8_t*> ptrs;
+        for (auto& s : *shards) ptrs.push_back(s.data());
+        for (uint64_t i = 0; i < iters; ++i) {
+            code->encode(ptrs.data(), ptrs.data() + kData, kShard);
+            bench::do_not_optimize(ptrs[kData][0]);
+        }
+    }, group_bytes);
+    h.add("erasure_reconstruct/16+4", [shards, code](uint64_t iters) {
+        auto work = *shards;
+        std::vector<uint8_t*> ptrs;
+        for (auto& s : work) ptrs.push_back(s.data());
+        code->encode(ptrs.data(), ptrs.data() + kData, kShard);
+        bool present[kData + kParity];
+        for (size_t s = 0; s < kData + kParity; ++s) present[s] = s >= kData || s % 4 != 1;  // Members 1, 5, 9 and 13 lost
+        for (uint64_t i = 0; i < iters; ++i) {
+            bool ok = code->reconstruct(ptrs.data(), present, kShard);
+            bench::do_not_optimize(ok);
+        }
+    }, group_bytes);
+}
+
+void add_viterbi(bench::Harness& h) {
+    // K=7 r=1/2 convolutional code over a 1 KiB frame; decoding is per
+    // kernel on noisy soft symbols (MB/s x 8 = decoded Mbit/s)
+    constexpr size_t kFrame = 1024;
+    auto frame = std::make_shared<std::vector<uint8_t>>(kFrame);
+    for (size_t i = 0; i < kFrame; ++i) (*frame)[i] = static_cast<uint8_t>(i * 73 + 11);
+    auto symbols = std::make_shared<std::vector<uint8_t>>(viterbi::encode(frame->data(), kFrame));
+    for (size_t i = 0; i < symbols->size(); ++i) {
+        const int jitter = static_cast<int>((i * 2654435761u) >> 24) % 97 - 48;
+        (*symbols)[i] = static_cast<uint8_t>(std::clamp((*symbols)[i] + jitter * ((*symbols)[i] ? -1 : 1), 0, 255));
+    }
+    h.add("viterbi_encode/1024", [frame](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            auto coded = viterbi::encode(frame->data(), kFrame);
+            bench::do_not_optimize(coded);
+        }
+    }, static_cast<double>(kFrame));
+    for (auto kernel : {viterbi::Kernel::Scalar, viterbi::Kernel::Sse2, viterbi::Kernel::Avx2}) {
+        if (!viterbi::supported(kernel)) {
+            continue;
+        }
+        h.add(std::string("viterbi_decode/") + viterbi::kernel_name(kernel), [symbols, kernel](uint64_t iters) {
+            std::vector<uint8_t> out(kFrame);
+            for (uint64_t i = 0; i < iters; ++i) {
+                viterbi::decode(symbols->data(), kFrame, out.data(), kernel);
+                bench::do_not_optimize(out[0]);
+            }
+        }, static_cast<double>(kFrame));
+    }
+}
+
+void add_queue(bench::Harness& h) {
+    // Uncontended: push then pop on one thread
+    h.add("queue_push_pop/1thread", [](uint64_t iters) {
+        ThreadSafeQueue<Packet> q;
+        Packet pkt = sample_packet("");
+        for (uint64_t i = 0; i < iters; ++i) {
+            q.push(pkt);
+            auto out = q.try_pop();
+            bench::do_not_optimize(out);
+        }
+    });
+
+    // Producer/consumer hand-off; ns/op is per packet transferred
+    h.add("queue_transfer/2threads", [](uint64_t iters) {
+        ThreadSafeQueue<Packet> q;
+        std::thread producer([&q, iters] {
+            Packet pkt = sample_packet("");
+            for (uint64_t i = 0; i < iters; ++i) {
+                pkt.seq = static_cast<uint32_t>(i);
+                q.push(pkt);
+            }
+        });
+        for (uint64_t i = 0; i < iters; ++i) {
+            Packet out = q.pop();
+            bench::do_not_optimize(out);
+        }
+        producer.join();
+    });
+}
+
+/**
+ * Split iters increments across threads hammering one counter; ns/op is
+ * per increment, so a contended line shows up as ns/op growing with threads.
+ */
+template<typename Counter>
+void increment_from_threads(Counter& counter, uint64_t iters, unsigned threads) {
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        const uint64_t share = iters / threads + (t < iters % threads ? 1 : 0);
+        workers.emplace_back([&counter, share] {
+            for (uint64_t i = 0; i < share; ++i) {
+                counter++;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    bench::do_not_optimize(counter);
+}
+
+void add_counters(bench::Harness& h) {
+    for (unsigned threads : {1u, 4u, 16u, 32u}) {
+        const std::string suffix = "/" + std::to_string(threads) + "threads";
+        h.add("counter_atomic" + suffix, [threads](uint64_t iters) {
+            std::atomic<uint64_t> counter{0};
+            increment_from_threads(counter, iters, threads);
+        });
+        h.add("counter_sharded" + suffix, [threads](uint64_t iters) {
+            ShardedCounter counter;
+            increment_from_threads(counter, iters, threads);
+        });
+    }
+}
+
+void print_help(const char* prog) {
+    std::cout << "Usage: " << prog << " [options]\n\n"
+              << "Options:\n"
+              << "  --filter S       Run only benchmarks whose name contains S\n"
+              << "  --reps N         Measured repetitions per benchmark (default: 15)\n"
+              << "  --warmup N       Warm-up repetitions (default: 2)\n"
+              << "  --min-time-ms N  Minimum time per repetition (default: 20)\n"
+              << "  --json PATH      Write results as JSON (default: bench_results.json)\n"
+              << "  --no-counters    Skip hardware performance counters\n"
+              << "  --help           Show this help message\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Harness::Options options;
+    std::string json_path = "bench_results.json";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help") {
+            print_help(argv[0]);
+            return 0;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--reps" && i + 1 < argc) {
+            options.reps = std::atoi(argv[++i]);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup_reps = std::atoi(argv[++i]);
+        } else if (arg == "--min-time-ms" && i + 1 < argc) {
+            options.min_rep_time = std::chrono::milliseconds(std::atoi(argv[++i]));
+        } else if (arg == "--no-counters") {
+            options.counters = false;
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (options.counters) {
+        bench::PerfCounters probe;
+        if (!probe.available()) {
+            std::cout << "Hardware counters unavailable (" << probe.unavailable_reason()
+                      << "); reporting time only\n\n";
+        }
+    }
+
+    bench::Harness harness(options);
+    add_crc(harness);
+    add_packet(harness);
+    add_telemetry(harness);
+    add_command(harness);
+    add_rules(harness);
+    add_ground_station(harness);
+    add_fec(harness);
+    add_viterbi(harness);
+    add_queue(harness);
+    add_counters(harness);
+
+    auto results = harness.run();
+    bench::Harness::print_table(std::cout, results);
+
+    std::ofstream json(json_path);
+    if (!json) {
+        std::cerr << "Cannot write " << json_path << "\n";
+        return 1;
+    }
+    bench::Harness::write_json(json, "satcom_bench", results);
+    std::cout << "\nResults written to " << json_path << std::endl;
+    return 0;
+}
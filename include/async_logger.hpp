@@ -0,0 +1,172 @@
+#pragma once
+
+#include "spsc_ring.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Asynchronous console logger for the --verbose protocol trace.
+ *
+ * A log call copies a binary record (the format string's address plus its
+ * raw arguments) into the calling thread's SPSC ring and returns; no
+ * formatting, locking or I/O happens on the caller. A background thread
+ * drains the rings, orders records by timestamp, formats them and writes
+ * whole lines in one batched write. A full ring drops the line (counted)
+ * rather than stall the protocol, so verbose output no longer changes
+ * timing or throughput.
+ *
+ * Formats are printf-style ("%u", "%.1f", "%s", "%x", ...); length
+ * modifiers are unnecessary since every argument is stored widened.
+ * Strings are copied into the record, so temporaries are safe. The format
+ * must be a string literal: only its address is recorded.
+ *
+ * Before start() (or after stop()) lines are formatted and written to
+ * std::cout immediately, so library users that never start the logger
+ * still see their output.
+ */
+namespace logging {
+
+class AsyncLogger {
+public:
+    static constexpr size_t kMaxArgs = 10;
+    static constexpr size_t kTextBytes = 96;  // Shared by a record's string arguments
+
+    enum class Kind : uint8_t { Int, UInt, Double, String };
+
+    struct Text {
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    union Arg {
+        int64_t i;
+        uint64_t u;
+        double d;
+        Text s;
+    };
+
+    struct Record {
+        const char* fmt;
+        uint64_t ts_ns;
+        std::array<Arg, kMaxArgs> args;
+        std::array<Kind, kMaxArgs> kinds;
+        uint8_t nargs;
+        uint16_t text_used;
+        char text[kTextBytes];
+    };
+
+    static AsyncLogger& instance();
+
+    /**
+     * Start the background writer on out (which must outlive stop()).
+     * Throws std::runtime_error if already running.
+     */
+    void start(std::ostream& out,
+               std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20));
+
+    /**
+     * Write everything logged so far and stop the writer.
+     */
+    void stop();
+
+    bool active() const { return active_.load(std::memory_order_acquire); }
+
+    template<typename... Args>
+    void log(const char* fmt, const Args&... args) {
+        static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+        Record rec;
+        rec.fmt = fmt;
+        rec.nargs = 0;
+        rec.text_used = 0;
+        (put(rec, args), ...);
+        submit(rec);
+    }
+
+    uint64_t get_lines_written() const { return lines_written_; }
+    uint64_t get_lines_dropped() const { return lines_dropped_; }
+
+    /**
+     * Expand a record's format with its arguments (no trailing newline).
+     */
+    static void format(const Record& rec, std::string& out);
+
+private:
+    struct Ring {
+        SpscRing<Record, 1024> records;
+    };
+
+    AsyncLogger() = default;
+    ~AsyncLogger();
+
+    template<typename T>
+    static void put(Record& rec, const T& value) {
+        Arg& arg = rec.args[rec.nargs];
+        Kind& kind = rec.kinds[rec.nargs];
+        rec.nargs++;
+        if constexpr (std::is_enum_v<T>) {
+            kind = Kind::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            kind = Kind::Int;
+            arg.i = value;
+        } else if constexpr (std::is_integral_v<T>) {
+            kind = Kind::UInt;
+            arg.u = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            kind = Kind::Double;
+            arg.d = value;
+        } else {
+            const std::string_view text(value);
+            const size_t length = std::min(text.size(), kTextBytes - rec.text_used);
+            std::memcpy(rec.text + rec.text_used, text.data(), length);
+            kind = Kind::String;
+            arg.s.offset = rec.text_used;
+            arg.s.length = static_cast<uint16_t>(length);
+            rec.text_used = static_cast<uint16_t>(rec.text_used + length);
+        }
+    }
+
+    void submit(Record& rec);
+    Ring* local_ring();
+    void flush_loop(std::chrono::milliseconds interval);
+    void drain();
+
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> generation_{0};
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex flush_mutex_;  // Serializes drain() and protects out_
+    std::condition_variable flush_cv_;
+    bool stopping_ = false;
+    std::thread flusher_;
+    std::ostream* out_ = nullptr;
+    std::vector<Record> batch_;
+
+    std::atomic<uint64_t> lines_written_{0};
+    std::atomic<uint64_t> lines_dropped_{0};
+};
+
+/**
+ * Log one line through the shared logger.
+ */
+template<typename... Args>
+void log(const char* fmt, const Args&... args) {
+    AsyncLogger::instance().log(fmt, args...);
+}
+
+} // namespace logging
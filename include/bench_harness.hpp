@@ -0,0 +1,139 @@
+#pragma once
+
+#include "perf_counters.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal micro-benchmark harness.
+ * Each benchmark is a body that runs a given number of iterations. The
+ * harness calibrates the iteration count so one repetition takes at least
+ * min_rep_time, runs warm-up repetitions, then reports the median and p99
+ * of per-repetition ns/op (and bytes/s when the body declares a byte
+ * count per op). Where the kernel allows it, hardware counters are read
+ * around the measured repetitions and reported per op (IPC, cache and
+ * branch misses). Results can be printed as a table or written as JSON
+ * for trend tracking.
+ */
+namespace bench {
+
+/**
+ * Keep a value (and everything it depends on) from being optimized away.
+ */
+template<typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Compiler barrier: memory written before it must really be written.
+ */
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+class Harness {
+public:
+    struct Options {
+        int warmup_reps = 2;
+        int reps = 15;
+        std::chrono::nanoseconds min_rep_time = std::chrono::milliseconds(20);
+        std::string filter;  // Run only benchmarks whose name contains this
+        bool counters = true;  // Read hardware counters when available
+    };
+
+    /**
+     * Benchmark body: run iters operations.
+     */
+    using Body = std::function<void(uint64_t iters)>;
+
+    struct Result {
+        std::string name;
+        uint64_t iters_per_rep = 0;
+        int reps = 0;
+        double median_ns = 0.0;  // Per op
+        double p99_ns = 0.0;
+        double min_ns = 0.0;
+        double mean_ns = 0.0;
+        double bytes_per_op = 0.0;
+        double bytes_per_sec = 0.0;  // At the median
+
+        // Hardware counters summed over the measured repetitions
+        PerfCounters::Sample counters;
+        uint64_t counted_ops = 0;
+
+        bool has(PerfCounters::Counter c) const { return counted_ops > 0 && counters.has(c); }
+
+        /**
+         * Counter value per op; 0 when not counted.
+         */
+        double per_op(PerfCounters::Counter c) const {
+            return has(c) ? static_cast<double>(counters[c]) / static_cast<double>(counted_ops) : 0.0;
+        }
+
+        /**
+         * Instructions per cycle; 0 when not counted.
+         */
+        double ipc() const {
+            return has(PerfCounters::Cycles) && has(PerfCounters::Instructions) && counters[PerfCounters::Cycles]
+                ? static_cast<double>(counters[PerfCounters::Instructions]) /
+                  static_cast<double>(counters[PerfCounters::Cycles])
+                : 0.0;
+        }
+    };
+
+    Harness() = default;
+    explicit Harness(const Options& options) : options_(options) {}
+
+    /**
+     * Register a benchmark. bytes_per_op > 0 enables throughput reporting.
+     */
+    void add(std::string name, Body body, double bytes_per_op = 0.0);
+
+    /**
+     * Run all registered benchmarks matching the filter, in order.
+     */
+    std::vector<Result> run() const;
+
+    /**
+     * Measure one body with the configured options.
+     */
+    Result measure(const std::string& name, const Body& body, double bytes_per_op = 0.0) const;
+
+    /**
+     * Per-op statistics from per-repetition ns/op samples.
+     */
+    static void summarize(std::vector<double> samples, Result& result);
+
+    static void print_table(std::ostream& out, const std::vector<Result>& results);
+
+    /**
+     * Write {"context": {...}, "benchmarks": [...]} with one object per
+     * result. suite names the run in the context block.
+     */
+    static void write_json(std::ostream& out, const std::string& suite,
+                           const std::vector<Result>& results);
+
+private:
+    struct Entry {
+        std::string name;
+        Body body;
+        double bytes_per_op;
+    };
+
+    Options options_;
+    std::vector<Entry> entries_;
+};
+
+} // namespace bench
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "packet.hpp"
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Compact binary checkpoint file.
+ *
+ * Layout: an 8-byte magic ("SATCKPT" + format version) followed by tagged
+ * sections, each [tag:4][length:8][payload][crc16:2], and an "END "
+ * section. Values are stored in host byte order; the header records it
+ * and a reader on a host of the other order rejects the file.
+ *
+ * Components write their own sections with save(CheckpointWriter&) and
+ * read them back in the same order with restore(CheckpointReader&).
+ * Time points are stored relative to the moment of saving.
+ */
+class CheckpointWriter {
+public:
+    /**
+     * Write the file header to out.
+     */
+    explicit CheckpointWriter(std::ostream& out);
+
+    /**
+     * Start a section with a 4-character tag.
+     */
+    void begin(const char* tag);
+
+    /**
+     * Finish the current section and write it out.
+     */
+    void end();
+
+    /**
+     * Write the end marker and flush. Throws std::runtime_error if the
+     * stream failed.
+     */
+    void finish();
+
+    template<typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "put() needs a trivially copyable type");
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void put_vector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "put_vector() needs a trivially copyable type");
+        put<uint64_t>(values.size());
+        buffer_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void put_string(const std::string& s);
+    void put_packet(const Packet& pkt);
+    void put_rng(const std::mt19937& rng);
+
+    uint64_t bytes_written() const { return bytes_written_; }
+
+private:
+    void write(const void* data, size_t len);
+
+    std::ostream& out_;
+    char tag_[4] = {};
+    bool open_ = false;
+    std::string buffer_;
+    uint64_t bytes_written_ = 0;
+};
+
+class CheckpointReader {
+public:
+    /**
+     * Read and validate the file header. Throws std::runtime_error if in
+     * is not a checkpoint of this format version.
+     */
+    explicit CheckpointReader(std::istream& in);
+
+    /**
+     * Read the next section, which must carry this tag. Throws
+     * std::runtime_error on a tag mismatch, truncation (including a length
+     * past the end of the file) or bad CRC.
+     */
+    void begin(const char* tag);
+
+    /**
+     * Finish the current section; throws if it was not fully consumed.
+     */
+    void end();
+
+    template<typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>, "get() needs a trivially copyable type");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    std::vector<T> get_vector() {
+        static_assert(std::is_trivially_copyable_v<T>, "get_vector() needs a trivially copyable type");
+        uint64_t n = get<uint64_t>();
+        if (n > (buffer_.size() - pos_) / sizeof(T)) {
+            throw std::runtime_error("Checkpoint section truncated");
+        }
+        std::vector<T> values(n);
+        std::memcpy(values.data(), take(n * sizeof(T)), n * sizeof(T));
+        return values;
+    }
+
+    std::string get_string();
+    Packet get_packet();
+    void get_rng(std::mt19937& rng);
+
+private:
+    const char* take(size_t len);
+    void read(void* data, size_t len);
+
+    std::istream& in_;
+    std::string buffer_;
+    size_t pos_ = 0;
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "commands.hpp"
+#include "rule_program.hpp"
+#include "telemetry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <vector>
+
+/**
+ * Ground-station command plan: per-satellite timelines, repeat rules and
+ * telemetry-triggered commands, loaded from a line-based text DSL.
+ *
+ * One directive per line, '#' starts a comment:
+ *
+ *   at 5 sat 0-9 ADJUST_ORIENTATION 1.5 0 -0.5    # once, at t = 5 s
+ *   at 10 sat all THRUST_BURN 2 every 60 times 3   # t = 10, 70, 130
+ *   at 0 sat 4,7 REBOOT every 30 until 300
+ *   when battery_pct < 20 sat all ENTER_SAFE_MODE  # once per crossing
+ *   when temperature_c > 80 sat 2 ENTER_SAFE_MODE cooldown 60
+ *   when battery_pct < 15 clear 25 sat all ENTER_SAFE_MODE
+ *   when temperature_c rate > 0.5 sat 0-99 REBOOT  # rising > 0.5 C/s
+ *
+ * Times are seconds since the station started. A satellite selector is
+ * "all" or a comma list of IDs and inclusive ranges "a-b". Commands are
+ * written as in Command::serialize() with spaces instead of '|', and are
+ * validated while loading. Trigger fields are the Telemetry fields
+ * (temperature_c, battery_pct, orbit_altitude_km, pitch_deg, yaw_deg,
+ * roll_deg), or with "rate" their change per second, compared with '<' or
+ * '>'. A trigger fires when its condition becomes true and re-arms when it
+ * is false again, or with "clear" only once the value is back past that
+ * level (hysteresis). With a cooldown it fires again every cooldown
+ * seconds while the condition holds. See RuleProgram.
+ */
+class CommandPlan {
+public:
+    static constexpr double kForever = std::numeric_limits<double>::infinity();
+
+    using Field = RuleProgram::Field;
+
+    /**
+     * Satellite IDs; all = every satellite the station serves.
+     */
+    struct Selector {
+        bool all = false;
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;  // Inclusive
+
+        bool matches(uint32_t sat_id) const;
+    };
+
+    struct Timeline {
+        double at_sec = 0.0;
+        Selector sats;
+        Command cmd;
+        double every_sec = 0.0;    // 0 = once
+        uint32_t times = 0;        // Repeats: total occurrences, 0 = unbounded
+        double until_sec = kForever;
+        uint32_t line = 0;
+    };
+
+    struct Trigger {
+        RuleProgram::Rule rule;
+        Selector sats;
+        uint32_t line = 0;
+    };
+
+    /**
+     * One occurrence of a timeline for one satellite.
+     */
+    struct Event {
+        double at_sec;
+        uint32_t sat_id;
+        uint32_t timeline;   // Index into timelines()
+        uint32_t remaining;  // Occurrences left after this one (UINT32_MAX = unbounded)
+    };
+
+    /**
+     * Parse a plan. Throws std::runtime_error naming the line on any error.
+     */
+    static CommandPlan parse(std::istream& in);
+
+    /**
+     * Expand timelines over the given satellites into first occurrences,
+     * sorted by time (ties keep plan order, then satellite ID). IDs a
+     * timeline names that are not listed are skipped, so a sharded station
+     * compiles only its own satellites.
+     */
+    std::vector<Event> compile(const std::vector<uint32_t>& sat_ids) const;
+
+    const std::vector<Timeline>& timelines() const { return timelines_; }
+    const std::vector<Trigger>& triggers() const { return triggers_; }
+
+private:
+    std::vector<Timeline> timelines_;
+    std::vector<Trigger> triggers_;
+};
+
+/**
+ * Consumes a compiled plan for a set of satellites.
+ *
+ * Pending events live in a binary min-heap on time (the compiled list is
+ * already sorted, so building it is free): dispatch() pops only what is
+ * due, so a pass with nothing due is O(1) and each dispatched or re-queued
+ * repeat is O(log n), independent of how many events the plan holds.
+ * Triggers are compiled into a RuleProgram over the same satellites.
+ * Not thread-safe: one owner (e.g. one shard).
+ */
+class PlanScheduler {
+public:
+    using Dispatch = RuleProgram::Dispatch;
+
+    PlanScheduler(const CommandPlan& plan, const std::vector<uint32_t>& sat_ids);
+
+    /**
+     * Hand every event due at or before now_sec to fn in time order and
+     * re-queue repeats. Returns the number dispatched.
+     */
+    size_t dispatch(double now_sec, const Dispatch& fn);
+
+    /**
+     * Evaluate the satellite's triggers against one telemetry sample.
+     * Returns the number of commands fired.
+     */
+    size_t on_telemetry(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn);
+
+    /**
+     * Batched form of on_telemetry(): queue samples from many satellites,
+     * then evaluate_triggers() once (e.g. per shard pass). Queueing a
+     * second sample for a satellite evaluates the batch early. Both return
+     * the number of commands fired.
+     */
+    size_t queue_telemetry(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn);
+    size_t evaluate_triggers(const Dispatch& fn);
+
+    /**
+     * Continue another scheduler over the same plan and satellites from its
+     * queued() events and get_dispatched() count (checkpoint restore).
+     * Throws std::runtime_error if an event names a timeline this plan
+     * does not have.
+     */
+    void resume(std::vector<CommandPlan::Event> events, uint64_t dispatched);
+
+    const std::vector<CommandPlan::Event>& queued() const { return heap_; }
+    size_t pending() const { return heap_.size(); }
+    double next_due_sec() const { return heap_.empty() ? CommandPlan::kForever : heap_.front().at_sec; }
+    uint64_t get_dispatched() const { return dispatched_; }
+
+private:
+    const CommandPlan& plan_;
+    std::vector<CommandPlan::Event> heap_;
+    RuleProgram rules_;
+    uint64_t dispatched_ = 0;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "commands.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * Onboard stored-command schedule for time-tagged commands.
+ * Min-heap keyed by execution time; commands with equal tags run in
+ * uplink order. Storage is reserved up front so steady-state scheduling
+ * never allocates. Not thread-safe (owned by the satellite thread).
+ */
+class CommandSchedule {
+public:
+    explicit CommandSchedule(size_t capacity) : capacity_(capacity) {
+        heap_.reserve(capacity_);
+    }
+
+    /**
+     * Store a time-tagged command.
+     *
+     * @return false if the schedule is full
+     */
+    bool schedule(const Command& cmd) {
+        if (heap_.size() >= capacity_) {
+            return false;
+        }
+        heap_.push_back(Entry{cmd.exec_time_ns, next_order_++, cmd});
+        std::push_heap(heap_.begin(), heap_.end(), Later{});
+        return true;
+    }
+
+    /**
+     * Check whether the earliest command is due (O(1)).
+     */
+    bool has_due(int64_t now_ns) const {
+        return !heap_.empty() && heap_.front().exec_time_ns <= now_ns;
+    }
+
+    /**
+     * Remove and return the earliest command if it is due.
+     */
+    std::optional<Command> pop_due(int64_t now_ns) {
+        if (!has_due(now_ns)) {
+            return std::nullopt;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), Later{});
+        Command cmd = heap_.back().cmd;
+        heap_.pop_back();
+        return cmd;
+    }
+
+    /**
+     * Execution time of the earliest stored command, if any.
+     */
+    std::optional<int64_t> next_exec_time_ns() const {
+        if (heap_.empty()) {
+            return std::nullopt;
+        }
+        return heap_.front().exec_time_ns;
+    }
+
+    /**
+     * Copy of every stored command in execution order.
+     */
+    std::vector<Command> pending() const {
+        std::vector<Entry> entries = heap_;
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return Later{}(b, a); });
+        std::vector<Command> commands;
+        commands.reserve(entries.size());
+        for (const Entry& e : entries) {
+            commands.push_back(e.cmd);
+        }
+        return commands;
+    }
+
+    void clear() { heap_.clear(); }
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        int64_t exec_time_ns;
+        uint64_t order;
+        Command cmd;
+    };
+
+    // Heap comparator: earliest time (then earliest uplink) on top
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.exec_time_ns != b.exec_time_ns) {
+                return a.exec_time_ns > b.exec_time_ns;
+            }
+            return a.order > b.order;
+        }
+    };
+
+    size_t capacity_;
+    uint64_t next_order_{0};
+    std::vector<Entry> heap_;
+};
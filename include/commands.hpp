@@ -1,11 +1,20 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 /**
  * Command types that ground station can send to satellite.
+ * Each type needs one row in kCommandRegistry below.
  */
 enum class CommandType {
     AdjustOrientation,  // Adjust pitch/yaw/roll
@@ -16,8 +25,18 @@ enum class CommandType {
 
 /**
  * Command structure with type and optional parameters.
+ *
+ * Two encodings are generated from kCommandRegistry:
+ * - text, "TYPE|param1|param2|..." (serialize / deserialize), kept for
+ *   checkpoints and human-readable logs;
+ * - binary, used on the uplink (encode / decode):
+ *   [opcode:1][exec_time_ns:8 if opcode & kTimeTagFlag][arg:8]...
+ *   Integers are big-endian like the packet header; each argument is
+ *   the IEEE-754 bit pattern of a double, in registry order.
  */
 struct Command {
+    static constexpr uint8_t kTimeTagFlag = 0x80;
+
     CommandType type;
 
     // Orientation adjustment deltas (degrees)
@@ -28,72 +47,352 @@ struct Command {
     // Thrust burn duration (seconds)
     double burn_seconds = 0.0;
 
+    // Execution time tag (steady_clock nanoseconds); 0 = execute on receipt
+    int64_t exec_time_ns = 0;
+
+    /**
+     * Check whether command carries an execution time tag.
+     */
+    bool is_time_tagged() const { return exec_time_ns > 0; }
+
     /**
      * Serialize command to string format: "TYPE|param1|param2|..."
+     * Time-tagged commands are prefixed with "AT|<nanos>|".
      */
-    std::string serialize() const {
-        std::ostringstream oss;
-        switch (type) {
-            case CommandType::AdjustOrientation:
-                oss << "ADJUST_ORIENTATION|" << d_pitch << "|" << d_yaw << "|" << d_roll;
-                break;
-            case CommandType::ThrustBurn:
-                oss << "THRUST_BURN|" << burn_seconds;
-                break;
-            case CommandType::EnterSafeMode:
-                oss << "ENTER_SAFE_MODE";
-                break;
-            case CommandType::Reboot:
-                oss << "REBOOT";
-                break;
-        }
-        return oss.str();
-    }
+    std::string serialize() const;
 
     /**
      * Deserialize command from string format.
+     * Throws std::runtime_error if malformed or out of range.
+     */
+    static Command deserialize(const std::string& s);
+
+    /**
+     * Encode to the binary uplink format.
+     */
+    std::string encode() const;
+
+    /**
+     * Decode the binary uplink format.
+     * Throws std::runtime_error on an unknown opcode, wrong length or an
+     * argument outside its registered range.
      */
-    static Command deserialize(const std::string& s) {
-        Command cmd;
-        std::istringstream iss(s);
-        std::string type_str;
+    static Command decode(std::string_view bytes);
+
+    /**
+     * Check every argument is finite and within its registered range.
+     * Throws std::runtime_error naming the offending argument.
+     */
+    void validate() const;
+
+    /**
+     * Get human-readable command name.
+     */
+    std::string name() const;
+};
+
+constexpr size_t kMaxCommandArgs = 3;
+
+/**
+ * One typed argument: the Command field it lives in and its valid range.
+ */
+struct CommandArg {
+    std::string_view name;
+    double Command::*field;
+    double min;
+    double max;
+};
+
+/**
+ * Everything the codecs need to know about one command type.
+ */
+struct CommandDef {
+    CommandType type;
+    uint8_t opcode;            // Binary format; below Command::kTimeTagFlag
+    std::string_view name;     // name()
+    std::string_view keyword;  // Text format
+    size_t num_args;
+    std::array<CommandArg, kMaxCommandArgs> args;
+};
+
+/**
+ * Command registry, in CommandType order. Adding a command is one enum
+ * value plus one row here; encode, decode, validation and name() all read
+ * this table.
+ */
+inline constexpr std::array<CommandDef, 4> kCommandRegistry = {{
+    {CommandType::AdjustOrientation, 0x01, "AdjustOrientation", "ADJUST_ORIENTATION", 3,
+     {{{"d_pitch", &Command::d_pitch, -180.0, 180.0},
+       {"d_yaw", &Command::d_yaw, -180.0, 180.0},
+       {"d_roll", &Command::d_roll, -180.0, 180.0}}}},
+    {CommandType::ThrustBurn, 0x02, "ThrustBurn", "THRUST_BURN", 1,
+     {{{"burn_seconds", &Command::burn_seconds, 0.0, 600.0}}}},
+    {CommandType::EnterSafeMode, 0x03, "EnterSafeMode", "ENTER_SAFE_MODE", 0, {}},
+    {CommandType::Reboot, 0x04, "Reboot", "REBOOT", 0, {}},
+}};
+
+namespace command_registry {
+
+constexpr bool well_formed() {
+    for (size_t i = 0; i < kCommandRegistry.size(); ++i) {
+        const CommandDef& def = kCommandRegistry[i];
+        if (static_cast<size_t>(def.type) != i || def.opcode == 0 || def.opcode >= Command::kTimeTagFlag ||
+            def.num_args > kMaxCommandArgs) {
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (kCommandRegistry[j].opcode == def.opcode || kCommandRegistry[j].keyword == def.keyword) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(well_formed(), "kCommandRegistry rows must follow CommandType order with unique opcodes and keywords");
+
+// Opcode -> registry row, or -1
+inline constexpr std::array<int8_t, Command::kTimeTagFlag> kByOpcode = [] {
+    std::array<int8_t, Command::kTimeTagFlag> table{};
+    table.fill(-1);
+    for (size_t i = 0; i < kCommandRegistry.size(); ++i) {
+        table[kCommandRegistry[i].opcode] = static_cast<int8_t>(i);
+    }
+    return table;
+}();
+
+inline const CommandDef& def(CommandType type) {
+    const auto i = static_cast<size_t>(type);
+    if (i >= kCommandRegistry.size()) {
+        throw std::runtime_error("Unknown command type");
+    }
+    return kCommandRegistry[i];
+}
+
+inline void put_u64(std::string& out, uint64_t v) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((v >> shift) & 0xFF));
+    }
+}
+
+inline uint64_t get_u64(std::string_view in, size_t pos) {
+    uint64_t v = 0;
+    for (size_t k = 0; k < 8; ++k) {
+        v = (v << 8) | static_cast<uint8_t>(in[pos + k]);
+    }
+    return v;
+}
+
+} // namespace command_registry
 
-        if (!std::getline(iss, type_str, '|')) {
-            throw std::runtime_error("Invalid command format");
+inline std::string Command::name() const {
+    const auto i = static_cast<size_t>(type);
+    return i < kCommandRegistry.size() ? std::string(kCommandRegistry[i].name) : "Unknown";
+}
+
+inline void Command::validate() const {
+    const CommandDef& def = command_registry::def(type);
+    for (size_t a = 0; a < def.num_args; ++a) {
+        const CommandArg& arg = def.args[a];
+        const double value = this->*arg.field;
+        if (!std::isfinite(value) || value < arg.min || value > arg.max) {
+            throw std::runtime_error(std::string(def.name) + " " + std::string(arg.name) + " out of range");
+        }
+    }
+    if (exec_time_ns < 0) {
+        throw std::runtime_error("Negative command time tag");
+    }
+}
+
+inline std::string Command::serialize() const {
+    const CommandDef& def = command_registry::def(type);
+    std::ostringstream oss;
+    if (is_time_tagged()) {
+        oss << "AT|" << exec_time_ns << "|";
+    }
+    oss << def.keyword;
+    for (size_t a = 0; a < def.num_args; ++a) {
+        oss << "|" << this->*def.args[a].field;
+    }
+    return oss.str();
+}
+
+inline Command Command::deserialize(const std::string& s) {
+    Command cmd;
+    std::istringstream iss(s);
+    std::string type_str;
+
+    if (!std::getline(iss, type_str, '|')) {
+        throw std::runtime_error("Invalid command format");
+    }
+
+    if (type_str == "AT") {
+        std::string time_str;
+        if (!std::getline(iss, time_str, '|') || !std::getline(iss, type_str, '|')) {
+            throw std::runtime_error("Invalid time tag format");
+        }
+        try {
+            cmd.exec_time_ns = std::stoll(time_str);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid time tag: " + time_str);
+        }
+    }
+
+    const CommandDef* def = nullptr;
+    for (const CommandDef& candidate : kCommandRegistry) {
+        if (candidate.keyword == type_str) {
+            def = &candidate;
+            break;
+        }
+    }
+    if (!def) {
+        throw std::runtime_error("Unknown command type: " + type_str);
+    }
+    cmd.type = def->type;
+
+    for (size_t a = 0; a < def->num_args; ++a) {
+        char delim;
+        if ((a > 0 && !(iss >> delim)) || !(iss >> cmd.*def->args[a].field)) {
+            throw std::runtime_error("Invalid " + std::string(def->name) + " parameters");
+        }
+    }
+    cmd.validate();
+    return cmd;
+}
+
+inline std::string Command::encode() const {
+    const CommandDef& def = command_registry::def(type);
+    std::string out;
+    out.reserve(1 + 8 + 8 * def.num_args);
+    out.push_back(static_cast<char>(def.opcode | (is_time_tagged() ? kTimeTagFlag : 0)));
+    if (is_time_tagged()) {
+        command_registry::put_u64(out, static_cast<uint64_t>(exec_time_ns));
+    }
+    for (size_t a = 0; a < def.num_args; ++a) {
+        command_registry::put_u64(out, std::bit_cast<uint64_t>(this->*def.args[a].field));
+    }
+    return out;
+}
+
+inline Command Command::decode(std::string_view bytes) {
+    if (bytes.empty()) {
+        throw std::runtime_error("Empty command");
+    }
+    const auto op = static_cast<uint8_t>(bytes[0]);
+    const bool tagged = (op & kTimeTagFlag) != 0;
+    const int8_t row = command_registry::kByOpcode[op & ~kTimeTagFlag];
+    if (row < 0) {
+        throw std::runtime_error("Unknown command opcode: " + std::to_string(op & ~kTimeTagFlag));
+    }
+    const CommandDef& def = kCommandRegistry[static_cast<size_t>(row)];
+    const size_t expected = 1 + (tagged ? 8 : 0) + 8 * def.num_args;
+    if (bytes.size() != expected) {
+        throw std::runtime_error("Invalid " + std::string(def.name) + " length: " + std::to_string(bytes.size()));
+    }
+
+    Command cmd;
+    cmd.type = def.type;
+    size_t pos = 1;
+    if (tagged) {
+        cmd.exec_time_ns = static_cast<int64_t>(command_registry::get_u64(bytes, pos));
+        pos += 8;
+        if (cmd.exec_time_ns <= 0) {
+            throw std::runtime_error("Invalid time tag");
         }
+    }
+    for (size_t a = 0; a < def.num_args; ++a, pos += 8) {
+        cmd.*def.args[a].field = std::bit_cast<double>(command_registry::get_u64(bytes, pos));
+    }
+    cmd.validate();
+    return cmd;
+}
 
-        if (type_str == "ADJUST_ORIENTATION") {
-            cmd.type = CommandType::AdjustOrientation;
-            char delim;
-            if (!(iss >> cmd.d_pitch >> delim >> cmd.d_yaw >> delim >> cmd.d_roll)) {
-                throw std::runtime_error("Invalid AdjustOrientation parameters");
+/**
+ * Ordered group of commands uplinked in one CommandBatchPkt: one ACK for
+ * the whole group, and the satellite executes all of them or none.
+ *
+ * Wire format: [count:2] then per command [length:1][binary command],
+ * big-endian like the rest of the uplink.
+ */
+struct CommandBatch {
+    static constexpr size_t kMaxCommands = 65535;
+
+    std::vector<Command> commands;
+
+    /**
+     * Throws std::runtime_error if the batch is empty, too large or holds
+     * an invalid command.
+     */
+    std::string encode() const {
+        if (commands.empty() || commands.size() > kMaxCommands) {
+            throw std::runtime_error("Command batch must hold 1.." + std::to_string(kMaxCommands) + " commands");
+        }
+        std::string out;
+        out.reserve(2 + commands.size() * 26);
+        out.push_back(static_cast<char>(commands.size() >> 8));
+        out.push_back(static_cast<char>(commands.size() & 0xFF));
+        for (const Command& cmd : commands) {
+            cmd.validate();
+            const std::string bytes = cmd.encode();
+            out.push_back(static_cast<char>(bytes.size()));
+            out += bytes;
+        }
+        return out;
+    }
+
+    /**
+     * Decode and validate every command. Throws std::runtime_error if any
+     * part of the batch is malformed, so a bad batch is rejected whole.
+     */
+    static CommandBatch decode(std::string_view bytes) {
+        if (bytes.size() < 2) {
+            throw std::runtime_error("Command batch too short");
+        }
+        const size_t count = (static_cast<size_t>(static_cast<uint8_t>(bytes[0])) << 8) |
+                             static_cast<uint8_t>(bytes[1]);
+        if (count == 0) {
+            throw std::runtime_error("Empty command batch");
+        }
+        CommandBatch batch;
+        batch.commands.reserve(count);
+        size_t pos = 2;
+        for (size_t k = 0; k < count; ++k) {
+            if (pos >= bytes.size()) {
+                throw std::runtime_error("Command batch truncated");
             }
-        } else if (type_str == "THRUST_BURN") {
-            cmd.type = CommandType::ThrustBurn;
-            if (!(iss >> cmd.burn_seconds)) {
-                throw std::runtime_error("Invalid ThrustBurn parameters");
+            const size_t length = static_cast<uint8_t>(bytes[pos++]);
+            if (length > bytes.size() - pos) {
+                throw std::runtime_error("Command batch truncated");
             }
-        } else if (type_str == "ENTER_SAFE_MODE") {
-            cmd.type = CommandType::EnterSafeMode;
-        } else if (type_str == "REBOOT") {
-            cmd.type = CommandType::Reboot;
-        } else {
-            throw std::runtime_error("Unknown command type: " + type_str);
+            batch.commands.push_back(Command::decode(bytes.substr(pos, length)));
+            pos += length;
         }
-
-        return cmd;
+        if (pos != bytes.size()) {
+            throw std::runtime_error("Trailing bytes after command batch");
+        }
+        return batch;
     }
 
     /**
-     * Get human-readable command name.
+     * Check the batch can run to completion from the given safe-mode
+     * state. Commands tagged after now_ns are stored rather than run; of
+     * the rest, a ThrustBurn that safe mode (already on, or entered earlier
+     * in the batch) would block makes the whole batch fail. Throws
+     * std::runtime_error naming the first such command.
      */
-    std::string name() const {
-        switch (type) {
-            case CommandType::AdjustOrientation: return "AdjustOrientation";
-            case CommandType::ThrustBurn: return "ThrustBurn";
-            case CommandType::EnterSafeMode: return "EnterSafeMode";
-            case CommandType::Reboot: return "Reboot";
-            default: return "Unknown";
+    void check_runnable(bool safe_mode, int64_t now_ns = std::numeric_limits<int64_t>::max()) const {
+        for (size_t k = 0; k < commands.size(); ++k) {
+            const Command& cmd = commands[k];
+            if (cmd.is_time_tagged() && cmd.exec_time_ns > now_ns) {
+                continue;
+            }
+            if (cmd.type == CommandType::EnterSafeMode) {
+                safe_mode = true;
+            } else if (cmd.type == CommandType::Reboot) {
+                safe_mode = false;
+            } else if (cmd.type == CommandType::ThrustBurn && safe_mode) {
+                throw std::runtime_error("Batch command " + std::to_string(k) + " (ThrustBurn) blocked by safe mode");
+            }
         }
     }
 };
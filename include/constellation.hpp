@@ -0,0 +1,300 @@
+#pragma once
+
+#include "hdr_histogram.hpp"
+#include "link.hpp"
+#include "metrics.hpp"
+#include "logical_clock.hpp"
+#include "commands.hpp"
+#include "packet.hpp"
+#include "sequence.hpp"
+#include "sharded_counter.hpp"
+#include "work_stealing_pool.hpp"
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * Constellation-scale satellite simulation.
+ * Keeps the state of every satellite in struct-of-arrays form and advances
+ * it in fixed ticks on a fixed worker pool. Each worker owns a contiguous
+ * slice of satellites; workers meet at a barrier once per tick. State
+ * kernels are branch-free loops over flat arrays so the compiler can
+ * vectorize them, and per-satellite randomness comes from a counter-based
+ * hash of (seed, satellite, tick) rather than a per-satellite RNG object.
+ *
+ * With start(pool) each tick is instead forked into fixed-size chunks on a
+ * shared WorkStealingPool; the last chunk to finish closes the tick and
+ * arms a pool timer for the next one, so no thread blocks between ticks.
+ *
+ * Lockstep mode (Config::clock set) makes runs reproducible on any number
+ * of workers: ticks run back to back on simulated time, the clock moves
+ * only at the barrier, links draw impairments keyed by logical time, and
+ * a tick peer (e.g. ground station shards) steps inside the same epoch.
+ * A packet sent in tick t is deliverable from tick t+1 at the earliest,
+ * so what each agent sees in a tick never depends on thread timing.
+ *
+ * capture() snapshots the whole constellation between two ticks. Dense
+ * state and the small per-satellite telemetry counters (sequence numbers,
+ * ACK wait) change every tick or telemetry period and are copied in bulk.
+ * Pending telemetry packets are tracked per satellite, and replay windows
+ * and safe mode, which only commands and anomalies change, in dirty
+ * blocks of kDirtyBlock satellites; only what was written since the
+ * previous capture is copied, so the pause costs a few memcpys plus the
+ * packets sent in between rather than a copy of every packet.
+ *
+ * Satellite i talks to the ground over links[i] (deferred delivery
+ * recommended). Telemetry uses non-blocking stop-and-wait; a new sample
+ * supersedes one still awaiting its ACK. Time tags on uplinked commands
+ * are not honoured: commands execute on receipt.
+ */
+class ConstellationEngine {
+public:
+    struct Config {
+        size_t num_satellites = 10000;
+        size_t num_workers = 0;           // 0 = hardware concurrency
+        double tick_hz = 10.0;            // State update rate
+        double telemetry_rate_hz = 1.0;   // Per-satellite telemetry rate
+        int ack_timeout_ms = 1000;
+        int max_retries = 3;
+        unsigned int seed = 42;
+
+        // Lockstep: advance this clock by one tick period at every tick
+        // barrier instead of pacing ticks to the wall clock. Links and
+        // peers should share the clock.
+        LogicalClock* clock = nullptr;
+    };
+
+    /**
+     * Work every worker runs each tick after its own satellites, with
+     * (worker, number of workers). Must only touch state partitioned by
+     * worker index. Thread mode and step() only.
+     */
+    using TickPeer = std::function<void(size_t worker, size_t num_workers)>;
+
+    /**
+     * Create engine. links must be empty (state-only simulation) or hold
+     * one link per satellite. Throws std::runtime_error otherwise.
+     */
+    ConstellationEngine(const Config& config, std::vector<Link*> links);
+    ~ConstellationEngine();
+
+    // Start/stop worker pool
+    void start();
+    void stop();
+
+    /**
+     * Run ticks as chunked tasks on a shared pool instead of dedicated
+     * threads. The pool must outlive the engine (or at least stop()).
+     */
+    void start(WorkStealingPool& pool);
+
+    /**
+     * Advance all satellites by one tick on the calling thread (engine
+     * must be stopped). Used by tests and benchmarks.
+     */
+    void step();
+
+    /**
+     * Run exactly ticks ticks on the worker threads and return with the
+     * engine stopped. Paced like start() unless a logical clock is set.
+     */
+    void run(uint64_t ticks);
+
+    /**
+     * Set the tick peer (engine stopped).
+     */
+    void set_tick_peer(TickPeer peer) { tick_peer_ = std::move(peer); }
+
+    size_t worker_count() const { return num_workers_; }
+
+    /**
+     * Point-in-time copy of every satellite's state, taken between ticks.
+     */
+    struct Snapshot {
+        uint64_t tick = 0;  // Next tick to run
+
+        // Dense state, copied in full
+        std::vector<double> temperature_c;
+        std::vector<double> battery_pct;
+        std::vector<double> orbit_altitude_km;
+        std::vector<double> pitch_deg;
+        std::vector<double> yaw_deg;
+        std::vector<double> roll_deg;
+        std::vector<uint32_t> tx_seq;
+        std::vector<uint8_t> awaiting_ack;
+        std::vector<uint8_t> attempts;
+        std::vector<uint64_t> ack_deadline_tick;
+
+        // Refreshed per satellite when replaced
+        std::vector<Packet> pending;  // Meaningful where awaiting_ack is set
+
+        // Sparse state, refreshed per dirty block
+        std::vector<uint8_t> safe_mode;
+        std::vector<uint8_t> safe_mode_prev;
+        std::vector<ReplayWindow<>> rx_window;
+
+        // Engine totals
+        uint64_t telemetry_sent = 0;
+        uint64_t telemetry_acked = 0;
+        uint64_t telemetry_unacked = 0;
+        uint64_t retries = 0;
+        uint64_t commands_received = 0;
+        uint64_t safe_mode_entries = 0;
+
+        /**
+         * Write as a checkpoint section; only packets awaiting an ACK are
+         * stored.
+         */
+        void save(CheckpointWriter& out) const;
+    };
+
+    /**
+     * Capture a snapshot. While running, the calling thread waits for the
+     * next tick boundary, where the copy is made with every worker parked.
+     * Snapshots are copy-on-write: one still held by a caller is never
+     * modified by a later capture.
+     */
+    std::shared_ptr<const Snapshot> capture();
+
+    /**
+     * Load a saved snapshot into a stopped engine. Throws
+     * std::runtime_error if it is invalid or from a constellation of a
+     * different size.
+     */
+    void restore(CheckpointReader& in);
+
+    // Last capture: time the simulation was paused and dirty blocks copied
+    uint64_t get_last_capture_ns() const { return last_capture_ns_; }
+    uint64_t get_last_capture_blocks() const { return last_capture_blocks_; }
+
+    size_t size() const { return config_.num_satellites; }
+    uint64_t get_ticks() const { return ticks_; }
+    uint64_t get_tick_overruns() const { return tick_overruns_; }
+    double get_mean_tick_ms() const;
+
+    // Aggregate metrics (summed across workers)
+    uint64_t get_telemetry_sent() const;
+    uint64_t get_telemetry_acked() const;
+    uint64_t get_telemetry_unacked() const;
+    uint64_t get_retries() const;
+    uint64_t get_commands_received() const;
+    uint64_t get_safe_mode_entries() const;
+
+    /**
+     * Telemetry ACK round trip per attempt, in whole ticks (links are
+     * polled once per tick), as a snapshot.
+     */
+    HdrHistogram get_ack_rtt() const { return ack_rtt_.snapshot(); }
+
+    /**
+     * Register this engine's counters and histograms for live export; labels
+     * are added to every series.
+     */
+    void register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels = {}) const;
+
+    // Per-satellite state snapshot (read while stopped)
+    double temperature_c(size_t i) const { return temperature_c_[i]; }
+    double battery_pct(size_t i) const { return battery_pct_[i]; }
+    double orbit_altitude_km(size_t i) const { return orbit_altitude_km_[i]; }
+    double pitch_deg(size_t i) const { return pitch_deg_[i]; }
+    bool safe_mode(size_t i) const { return safe_mode_[i] != 0; }
+
+private:
+    struct TickDone {
+        ConstellationEngine* engine;
+        void operator()() noexcept;
+    };
+
+    static constexpr size_t kPoolChunk = 1024;  // Satellites per pool task
+    static constexpr size_t kDirtyBlock = 64;   // Satellites per dirty flag
+
+    void mark_dirty(size_t i) { dirty_[i / kDirtyBlock].store(1, std::memory_order_relaxed); }
+    void copy_to_shadow();
+
+    std::chrono::steady_clock::time_point end_tick();
+    void launch_pool_tick();
+    void run_worker(size_t worker);
+    void step_slice(size_t begin, size_t end, uint64_t tick);
+    void update_state(size_t begin, size_t end, uint64_t tick);
+    void check_anomalies(size_t begin, size_t end);
+    void service_link(size_t i, uint64_t tick);
+    void send_telemetry(size_t i, uint64_t tick);
+    void execute_command(size_t i, const Command& cmd);
+    void reply(size_t i, PacketType type, uint32_t seq);
+
+    Config config_;
+    std::vector<Link*> links_;
+    size_t num_workers_;
+    double dt_;
+    uint64_t telemetry_period_ticks_;
+    uint64_t ack_timeout_ticks_;
+
+    // Struct-of-arrays satellite state
+    std::vector<double> temperature_c_;
+    std::vector<double> battery_pct_;
+    std::vector<double> orbit_altitude_km_;
+    std::vector<double> pitch_deg_;
+    std::vector<double> yaw_deg_;
+    std::vector<double> roll_deg_;
+    std::vector<uint8_t> safe_mode_;
+    std::vector<uint8_t> safe_mode_prev_;
+    std::vector<uint32_t> tx_seq_;
+    std::vector<ReplayWindow<>> rx_window_;  // Commands already executed
+
+    // Telemetry stop-and-wait state
+    std::vector<uint8_t> awaiting_ack_;
+    std::vector<uint8_t> attempts_;
+    std::vector<uint64_t> ack_deadline_tick_;
+    std::vector<Packet> pending_;
+    std::vector<uint8_t> pending_dirty_;  // Written by the owning worker only
+
+    TickPeer tick_peer_;
+    LatencyHistogram ack_rtt_;
+    uint64_t tick_limit_{UINT64_MAX};  // run(): last tick + 1
+
+    // Worker pool
+    std::atomic<bool> running_{false};
+    bool exit_requested_{false};  // Published to workers through the barrier
+    std::unique_ptr<std::barrier<TickDone>> barrier_;
+    std::vector<std::thread> workers_;
+    WorkStealingPool* pool_{nullptr};
+    std::atomic<size_t> chunks_remaining_{0};
+    std::atomic<bool> pool_active_{false};  // Cleared once the last pool tick closes
+    std::chrono::steady_clock::time_point next_tick_;
+    std::chrono::steady_clock::time_point tick_start_;
+
+    // Checkpointing
+    std::unique_ptr<std::atomic<uint8_t>[]> dirty_;
+    size_t num_blocks_{0};
+    std::shared_ptr<Snapshot> shadow_;  // Latest capture, updated in place unless shared
+    std::mutex capture_serial_;         // One capture at a time
+    std::mutex capture_mutex_;          // Guards the handshake with end_tick
+    std::condition_variable capture_cv_;
+    bool capture_requested_{false};
+    bool ticking_{false};               // Ticks may be in progress (not stopped)
+    std::atomic<uint64_t> last_capture_ns_{0};
+    std::atomic<uint64_t> last_capture_blocks_{0};
+
+    // Timing
+    // Incremented by every worker; sharded so they do not share a line
+    ShardedCounter telemetry_sent_;
+    ShardedCounter telemetry_acked_;
+    ShardedCounter telemetry_unacked_;  // Superseded or out of retries
+    ShardedCounter retries_;
+    ShardedCounter commands_received_;
+    ShardedCounter safe_mode_entries_;
+
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> tick_overruns_{0};
+    std::atomic<uint64_t> busy_ns_{0};
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "link.hpp"
+#include "packet.hpp"
+#include "work_stealing_pool.hpp"
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    // Hand control straight back to the awaiter (symmetric transfer)
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+/**
+ * Lazily started coroutine producing T.
+ * co_await on a Task starts it and resumes the awaiter when it finishes;
+ * control passes by symmetric transfer, so nested tasks cost no stack and
+ * no scheduler round trip. Exceptions propagate to the awaiter.
+ */
+template<typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+/**
+ * Runs coroutine agents on a WorkStealingPool.
+ * A suspended agent holds no thread: sleeps park on a pool timer, yields
+ * go to the back of the shared run queue, and link receives arm the
+ * link's arrival hook so the agent wakes when the next packet is due (or
+ * at its deadline) without polling. One agent only ever runs on one
+ * worker at a time, so code inside an agent is sequential and needs no
+ * locking of its own.
+ *
+ * Links used from agents must use deferred delivery; an inline-latency
+ * link would put the worker thread to sleep on every send. Each link
+ * direction supports one coroutine receiver at a time.
+ */
+class CoroutineRuntime {
+public:
+    using Clock = WorkStealingPool::Clock;
+
+    struct Config {
+        size_t num_workers = 0;  // 0 = hardware concurrency
+    };
+
+    explicit CoroutineRuntime(const Config& config);
+
+    /**
+     * Start an agent. on_done (optional) runs on the worker once the agent
+     * returns or throws; exceptions are reported and swallowed.
+     */
+    void spawn(Task<void> agent, std::function<void()> on_done = {});
+
+    /**
+     * Block until every agent has finished.
+     */
+    void wait_idle() { pool_.wait_idle(); }
+
+    size_t size() const { return pool_.size(); }
+    WorkStealingPool& pool() { return pool_; }
+
+    struct SleepAwaiter {
+        CoroutineRuntime* runtime;
+        Clock::time_point when;
+
+        bool await_ready() const { return when <= Clock::now(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            runtime->pool_.submit_at(when, [h] { h.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct YieldAwaiter {
+        CoroutineRuntime* runtime;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            runtime->pool_.submit_fair([h] { h.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * Result is the next packet, or nullopt if none arrived by the deadline.
+     */
+    class RecvAwaiter {
+    public:
+        using RecvFn = bool (Link::*)(Packet&, std::chrono::milliseconds);
+        using NotifyFn = void (Link::*)(Link::ArrivalHook);
+
+        RecvAwaiter(CoroutineRuntime* runtime, Link* link, RecvFn recv, NotifyFn notify,
+                    Clock::time_point deadline);
+
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        std::optional<Packet> await_resume();
+
+    private:
+        // Shared with the arrival hook and deadline timer, either of which
+        // may still be pending after the other has resumed the agent
+        struct State {
+            CoroutineRuntime* runtime;
+            Link* link;
+            RecvFn recv;
+            NotifyFn notify;
+            Clock::time_point deadline;
+            std::coroutine_handle<> handle;
+            Packet pkt;
+            bool received = false;
+            bool resumed = false;
+            std::mutex mutex;
+        };
+
+        static void arm(const std::shared_ptr<State>& state);
+        static void attempt(const std::shared_ptr<State>& state);
+
+        std::shared_ptr<State> state_;
+    };
+
+    // Awaitables
+    SleepAwaiter sleep_until(Clock::time_point when) { return {this, when}; }
+    SleepAwaiter sleep_for(Clock::duration d) { return {this, Clock::now() + d}; }
+    YieldAwaiter yield() { return {this}; }
+
+    RecvAwaiter recv_sat_to_gs(Link& link, Clock::time_point deadline) {
+        return RecvAwaiter(this, &link, &Link::recv_sat_to_gs, &Link::notify_sat_to_gs, deadline);
+    }
+    RecvAwaiter recv_gs_to_sat(Link& link, Clock::time_point deadline) {
+        return RecvAwaiter(this, &link, &Link::recv_gs_to_sat, &Link::notify_gs_to_sat, deadline);
+    }
+
+private:
+    Config config_;
+    WorkStealingPool pool_;
+};
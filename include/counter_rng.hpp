@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Counter-based random numbers: stateless hashes of a key rather than a
+ * stream, so a draw depends only on what it is for (seed, entity, time,
+ * stream) and never on how many draws other threads made first.
+ */
+namespace counter_rng {
+
+/**
+ * SplitMix64 finalizer: cheap, stateless, well-mixed 64-bit hash.
+ */
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Hash of (seed, a, b, c).
+ */
+inline uint64_t hash(uint64_t seed, uint64_t a, uint64_t b, uint64_t c) {
+    return mix64(seed ^ mix64(a) ^ (b * 0xD1B54A32D192ED03ULL) ^ mix64(c * 0x8CB92BA72F3D8DD7ULL));
+}
+
+/**
+ * Uniform in [0, 1) from a hash.
+ */
+inline double unit(uint64_t h) {
+    return static_cast<double>(h >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Standard normal from two hashes (Box-Muller).
+ */
+inline double normal(uint64_t h1, uint64_t h2) {
+    double u1 = unit(h1) + 0x1.0p-54;  // Keep log() finite
+    double u2 = unit(h2);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+} // namespace counter_rng
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "packet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Forward error correction over GF(256) (see gf256.hpp): spend CPU and
+ * bandwidth up front so the receiver repairs damage itself instead of
+ * waiting a round trip for a retransmission.
+ *
+ * - Byte level: a Reed-Solomon RS(255,223) codec for serialized frames.
+ *   Each 255-byte block carries 223 data and 32 check bytes and corrects
+ *   up to 16 corrupted bytes anywhere in the block; shorter blocks are
+ *   shortened codes with the same strength. Field and generator roots
+ *   (alpha^1..alpha^32) follow the common conventional-basis layout, not
+ *   the CCSDS dual basis.
+ * - Packet level: a systematic erasure code over groups of N packets.
+ *   M parity packets let the receiver rebuild any M lost members of the
+ *   group, whichever they are.
+ */
+namespace fec {
+
+constexpr size_t kRsBlock = 255;
+constexpr size_t kRsData = 223;
+constexpr size_t kRsParity = 32;
+
+/**
+ * Compute the kRsParity check bytes for k <= kRsData data bytes.
+ */
+void rs_encode(const uint8_t* data, size_t k, uint8_t* parity);
+
+/**
+ * Correct a block of n bytes (data followed by its kRsParity check bytes,
+ * kRsParity < n <= kRsBlock) in place. Returns the number of bytes
+ * corrected, or nullopt when the block has more errors than the code can
+ * correct (the block is then left unchanged).
+ */
+std::optional<size_t> rs_decode(uint8_t* block, size_t n);
+
+/**
+ * Split a frame into blocks of up to kRsData bytes, each followed by its
+ * check bytes.
+ */
+std::string encode_frame(std::string_view frame);
+
+/**
+ * Inverse of encode_frame. Throws std::runtime_error when a block cannot
+ * be corrected or the length cannot be an encoded frame. corrected, if
+ * given, receives the number of bytes repaired.
+ */
+std::string decode_frame(std::string_view coded, size_t* corrected = nullptr);
+
+/**
+ * Systematic Reed-Solomon erasure code: data_shards equal-length shards
+ * plus parity_shards parity shards, any data_shards of which rebuild the
+ * rest. Parity rows come from a Cauchy matrix, so every square submatrix
+ * of the generator is invertible. Shard arithmetic runs through the
+ * gf256 region kernels.
+ */
+class ErasureCode {
+public:
+    static constexpr size_t kMaxShards = 256;
+
+    /**
+     * Throws std::runtime_error unless data_shards >= 1, parity_shards >= 1
+     * and the total is at most kMaxShards.
+     */
+    ErasureCode(size_t data_shards, size_t parity_shards);
+
+    size_t data_shards() const { return k_; }
+    size_t parity_shards() const { return m_; }
+
+    /**
+     * Fill parity[0..m) from data[0..k), every shard len bytes long.
+     */
+    void encode(const uint8_t* const* data, uint8_t* const* parity, size_t len) const;
+
+    /**
+     * shards holds k data then m parity shards of len bytes; present marks
+     * which hold received bytes. Rebuilds the missing data shards in place
+     * (parity shards are left as they are). Returns false, changing
+     * nothing, if fewer than k shards are present.
+     */
+    bool reconstruct(uint8_t* const* shards, const bool* present, size_t len) const;
+
+private:
+    uint8_t coefficient(size_t parity_row, size_t data_col) const;
+
+    size_t k_;
+    size_t m_;
+    std::vector<uint8_t> matrix_;  // m x k parity rows
+};
+
+/**
+ * Payload of a ParityPkt: one parity shard of a packet group, plus enough
+ * to identify the group. A member's shard is its serialized packet
+ * (Packet::to_bytes, which is self-delimiting) zero-padded to the longest
+ * member.
+ *
+ * Wire format: [members:1][parity:1][index:1][shard_len:2][seq:4 per
+ * member][shard], big-endian like the packet header.
+ */
+struct ParityShard {
+    std::vector<uint32_t> seqs;  // Group members, in encoding order
+    uint8_t parity_count = 0;
+    uint8_t index = 0;           // Parity row
+    std::string shard;
+
+    std::string encode() const;
+
+    /**
+     * Throws std::runtime_error if the payload is malformed.
+     */
+    static ParityShard decode(std::string_view bytes);
+};
+
+/**
+ * Parity packets protecting a group of 1..255 packets (all of which are
+ * serialized as sent, so their CRCs must be final). Throws
+ * std::runtime_error for an empty or oversized group or parity outside
+ * 1..(256 - group size).
+ */
+std::vector<Packet> make_parity_packets(const std::vector<Packet>& group, size_t parity);
+
+/**
+ * Receive side of the packet-level code. Remembers recently received
+ * packets and the parity of open groups, and rebuilds lost members as soon
+ * as a group has as many parity shards as it has missing members, in
+ * whatever order data and parity arrive. Memory is bounded: the oldest
+ * remembered packets and groups are forgotten first. Not thread-safe.
+ */
+class PacketRecovery {
+public:
+    explicit PacketRecovery(size_t window_packets = 512, size_t max_groups = 16);
+
+    /**
+     * Feed a packet that arrived intact: a group member (any type other
+     * than ParityPkt) or a ParityPkt. Returns the members it let us
+     * rebuild, which the caller should process as if they had arrived. A
+     * malformed parity packet is ignored.
+     */
+    std::vector<Packet> add(const Packet& pkt);
+
+    uint64_t rebuilt() const { return rebuilt_; }
+
+private:
+    struct Group {
+        std::vector<uint32_t> seqs;
+        uint8_t parity_count = 0;
+        size_t shard_len = 0;
+        std::vector<std::string> parity;  // By parity row; empty = not received
+        size_t parity_received = 0;
+    };
+
+    void remember(uint32_t seq, std::string bytes);
+    bool try_rebuild(Group& group, std::vector<Packet>& out);
+
+    size_t window_;
+    size_t max_groups_;
+    std::unordered_map<uint32_t, std::string> received_;  // seq -> serialized packet
+    std::deque<uint32_t> received_order_;
+    std::deque<Group> groups_;
+    uint64_t rebuilt_ = 0;
+};
+
+} // namespace fec
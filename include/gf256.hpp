@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Arithmetic in GF(2^8) with the primitive polynomial
+ * x^8 + x^4 + x^3 + x^2 + 1 (0x11D) and generator alpha = 2, the field of
+ * the Reed-Solomon codes in fec.hpp. Addition is XOR; multiplication is
+ * table-driven (log/antilog for single symbols, a full 64 KiB product
+ * table for scalar regions).
+ *
+ * Region operations multiply a whole buffer by one constant, the inner
+ * loop of erasure coding. On x86 they use pshufb: a byte is the XOR of
+ * c * (low nibble) and c * (high nibble << 4), both 16-entry lookups that
+ * one shuffle answers for 16 (SSSE3) or 32 (AVX2) bytes at a time. The
+ * widest kernel the CPU supports is picked on first use.
+ */
+namespace gf256 {
+
+/**
+ * alpha^i, for any i (reduced mod 255).
+ */
+uint8_t exp(unsigned i);
+
+/**
+ * Discrete log base alpha, in [0, 255). a must be nonzero.
+ */
+uint8_t log(uint8_t a);
+
+uint8_t mul(uint8_t a, uint8_t b);
+
+/**
+ * Multiplicative inverse. a must be nonzero.
+ */
+uint8_t inv(uint8_t a);
+
+/**
+ * a / b. b must be nonzero.
+ */
+uint8_t div(uint8_t a, uint8_t b);
+
+enum class Kernel : uint8_t { Scalar, Ssse3, Avx2 };
+
+/**
+ * Whether this CPU (and build) can run the kernel.
+ */
+bool supported(Kernel kernel);
+
+/**
+ * Kernel the region operations use by default: the widest supported.
+ */
+Kernel best_kernel();
+
+const char* kernel_name(Kernel kernel);
+
+/**
+ * dst[i] = c * src[i]. dst and src may be the same buffer.
+ */
+void mul_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n);
+void mul_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n, Kernel kernel);
+
+/**
+ * dst[i] ^= c * src[i]. dst and src must not overlap.
+ */
+void mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n);
+void mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n, Kernel kernel);
+
+} // namespace gf256
@@ -1,17 +1,34 @@
 #pragma once
 
+#include "command_plan.hpp"
 #include "link.hpp"
 #include "telemetry.hpp"
 #include "commands.hpp"
+#include "fec.hpp"
 #include "packet.hpp"
+#include "sequence.hpp"
+#include "coroutine_runtime.hpp"
+#include "hdr_histogram.hpp"
+#include "metrics.hpp"
+#include "sharded_counter.hpp"
+#include "thread_safe_queue.hpp"
 #include <atomic>
 #include <thread>
 #include <fstream>
+#include <memory>
+#include <optional>
 #include <random>
 
 /**
  * Ground station simulator running in its own thread.
  * Receives telemetry from satellite and sends commands.
+ *
+ * Telemetry that arrives while a command waits for its ACK is ingested
+ * rather than dropped. start(runtime) runs it as a coroutine agent
+ * instead; that requires a deferred-delivery link.
+ *
+ * With a command plan (satellite ID 0) the plan replaces the built-in
+ * periodic commands; commands due together go out as one batch.
  */
 class GroundStation {
 public:
@@ -21,6 +38,8 @@ public:
         std::string log_file = "telemetry.log";
         bool verbose = false;
         unsigned int seed = 42;
+        const CommandPlan* plan = nullptr;  // Must outlive the station
+        bool fec = false;  // Rebuild lost telemetry from ParityPkt groups (fec.hpp)
     };
 
     GroundStation(Link& link, const Config& config);
@@ -30,36 +49,110 @@ public:
     void start();
     void stop();
 
+    /**
+     * Run as a coroutine agent on the given runtime (must outlive stop()).
+     */
+    void start(CoroutineRuntime& runtime);
+
+    /**
+     * Ask the thread or agent to finish without waiting for it; stop()
+     * still has to be called. Lets many instances wind down together.
+     */
+    void request_stop();
+
+    /**
+     * Queue commands for uplink as one CommandBatchPkt (thread-safe): a
+     * single ACK covers the batch and the satellite executes all of the
+     * commands or none. Batches go out between periodic commands.
+     * Throws std::runtime_error if the batch cannot be encoded.
+     */
+    void send_batch(std::vector<Command> commands);
+
+    /**
+     * Save sequence numbers, RNG, counters and command plan progress (plan
+     * clock and queued timeline events). Throws std::runtime_error while
+     * running.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * Replace state with a saved one before start(). Throws
+     * std::runtime_error while running or if the checkpoint is invalid.
+     */
+    void restore(CheckpointReader& in);
+
     // Metrics
     uint64_t get_telemetry_received() const { return telemetry_received_; }
     uint64_t get_commands_sent() const { return commands_sent_; }
     uint64_t get_retries() const { return retries_; }
     uint64_t get_naks_sent() const { return naks_sent_; }
+    uint64_t get_events_received() const { return events_received_; }
+    uint64_t get_plan_commands() const { return plan_commands_; }
+    uint64_t get_packets_recovered() const { return packets_recovered_; }  // Rebuilt from parity
+
+    // Latency distributions (snapshots)
+    HdrHistogram get_telemetry_age() const { return telemetry_age_.snapshot(); }  // Ingest time - Telemetry::ts
+    HdrHistogram get_ack_rtt() const { return ack_rtt_.snapshot(); }              // Command ACK RTT per attempt
+
+    /**
+     * Register this ground station's counters and histograms for live export; labels
+     * are added to every series.
+     */
+    void register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels = {}) const;
 
 private:
     void run();
     void receive_telemetry();
+    void handle_downlink(const Packet& pkt);
+    void recover(const Packet& pkt);
+    std::optional<Command> next_periodic_command();
+    std::optional<Packet> next_command_packet(size_t& commands);
     void send_periodic_commands();
-    void send_command_with_retry(const Command& cmd);
+    void start_plan();
+    double plan_seconds() const;  // Plan clock, continued across a restore
+    Packet make_command_packet(const Command& cmd);
+    Packet make_batch_packet(std::string payload, size_t commands);
+    void note_retry(uint32_t seq, int retry);
+    void finish_command(uint32_t seq, bool delivered, size_t commands);
+    void send_with_retry(const Packet& pkt, size_t commands);
+    void send_queued_batches();
     bool wait_for_ack(uint32_t seq, std::chrono::milliseconds timeout);
     void log_telemetry(const Telemetry& t);
 
+    // Coroutine agent versions of the blocking paths above
+    Task<void> run_async(CoroutineRuntime& rt);
+    Task<void> send_async(CoroutineRuntime& rt, Packet pkt, size_t commands);
+    Task<bool> wait_for_ack_async(CoroutineRuntime& rt, uint32_t seq, std::chrono::milliseconds timeout);
+
     Link& link_;
     Config config_;
     std::atomic<bool> running_{false};
     std::thread thread_;
+    std::atomic<bool> agent_running_{false};
     std::ofstream log_file_;
     std::mt19937 rng_;
 
     // State
     uint32_t tx_seq_{0};
-    uint32_t rx_seq_expected_{0};
+    ThreadSafeQueue<std::pair<std::string, size_t>> batches_;  // Encoded payload, command count
+    ReplayWindow<128> rx_window_;  // Telemetry already ingested
     std::chrono::steady_clock::time_point start_time_;
     std::chrono::steady_clock::time_point last_command_time_;
+    std::unique_ptr<PlanScheduler> plan_;
+    std::vector<Command> plan_due_;  // Dispatched, not yet sent
+    double plan_offset_sec_{0.0};    // Plan time elapsed before the current start
+    bool plan_clock_running_{false};
+    bool plan_restored_{false};      // Next start resumes the restored plan
+    std::unique_ptr<fec::PacketRecovery> fec_;
 
     // Metrics
-    std::atomic<uint64_t> telemetry_received_{0};
-    std::atomic<uint64_t> commands_sent_{0};
-    std::atomic<uint64_t> retries_{0};
-    std::atomic<uint64_t> naks_sent_{0};
+    ShardedCounter telemetry_received_;
+    ShardedCounter commands_sent_;
+    ShardedCounter retries_;
+    ShardedCounter naks_sent_;
+    ShardedCounter events_received_;
+    ShardedCounter plan_commands_;
+    ShardedCounter packets_recovered_;
+    LatencyHistogram telemetry_age_;
+    LatencyHistogram ack_rtt_;
 };
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "sharded_counter.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * HDR-style histogram of nanosecond values.
+ * Buckets are log-linear: exact below 128, then 64 linear sub-buckets per
+ * power of two, so any recorded value is reported within 1/64 (~1.6%) of
+ * its true value from 1 ns up to kMaxValue (~4.9 hours; larger values
+ * clamp). Fixed bucket layout makes merging a plain element-wise sum.
+ *
+ * This is the single-threaded value type used for snapshots and reports;
+ * concurrent recording goes through LatencyHistogram.
+ */
+class HdrHistogram {
+public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+    static constexpr uint64_t kHalf = kSubBuckets / 2;
+    static constexpr int kMaxValueBits = 44;
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 2) * kHalf;
+
+    static constexpr size_t bucket_index(uint64_t value) {
+        value = std::min(value, kMaxValue);
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const int shift = std::bit_width(value) - kSubBucketBits;
+        return static_cast<size_t>(shift * kHalf + (value >> shift));
+    }
+
+    static constexpr uint64_t bucket_lowest(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        const uint64_t shift = index / kHalf - 1;
+        return (index % kHalf + kHalf) << shift;
+    }
+
+    static constexpr uint64_t bucket_highest(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        const uint64_t shift = index / kHalf - 1;
+        return ((index % kHalf + kHalf + 1) << shift) - 1;
+    }
+
+    HdrHistogram() : counts_(kBucketCount, 0) {}
+
+    void record(uint64_t value, uint64_t count = 1);
+    void record(std::chrono::nanoseconds d) { record(d.count() > 0 ? static_cast<uint64_t>(d.count()) : 0); }
+
+    /**
+     * Add another histogram's counts to this one.
+     */
+    void merge(const HdrHistogram& other);
+
+    void clear();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    uint64_t sum() const { return sum_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+    /**
+     * Value at percentile p in [0, 100]: the highest value equivalent to
+     * the bucket holding that rank (never above max()). 0 when empty.
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * One line: "label  p50 ... p99 ... p999 ... max ... (n=...)" in ms.
+     */
+    void print(std::ostream& out, const std::string& label) const;
+
+    const std::vector<uint64_t>& counts() const { return counts_; }
+
+private:
+    friend class LatencyHistogram;
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
+
+/**
+ * Concurrent latency histogram: lock-free recording into per-thread
+ * shards, merged on snapshot().
+ * Each thread records into its own shard (allocated on its first record),
+ * so the hot path is a few relaxed atomic adds on a cache line no other
+ * thread writes. Threads beyond kMaxShards share shards, which stays
+ * correct (every update is atomic) at the cost of some contention.
+ * One histogram may be shared by many components (e.g. all links).
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kMaxShards = 64;
+
+    LatencyHistogram() = default;
+    ~LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value_ns) {
+        Shard& shard = local_shard();
+        shard.counts[HdrHistogram::bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value_ns, std::memory_order_relaxed);
+        uint64_t seen = shard.max.load(std::memory_order_relaxed);
+        while (value_ns > seen &&
+               !shard.max.compare_exchange_weak(seen, value_ns, std::memory_order_relaxed)) {}
+        seen = shard.min.load(std::memory_order_relaxed);
+        while (value_ns < seen &&
+               !shard.min.compare_exchange_weak(seen, value_ns, std::memory_order_relaxed)) {}
+    }
+
+    template<typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        record(ns > 0 ? static_cast<uint64_t>(ns) : uint64_t{0});
+    }
+
+    /**
+     * Merge all shards. Concurrent records may or may not be included.
+     */
+    HdrHistogram snapshot() const;
+
+    /**
+     * Zero all shards (not atomic with respect to concurrent records).
+     */
+    void reset();
+
+private:
+    struct Shard {
+        std::array<std::atomic<uint64_t>, HdrHistogram::kBucketCount> counts{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+    };
+
+    Shard& local_shard();
+
+    std::array<std::atomic<Shard*>, kMaxShards> shards_{};
+};
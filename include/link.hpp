@@ -1,12 +1,20 @@
 #pragma once
 
+#include "hdr_histogram.hpp"
+#include "logical_clock.hpp"
+#include "metrics.hpp"
 #include "packet.hpp"
+#include "sharded_counter.hpp"
 #include "thread_safe_queue.hpp"
 #include <chrono>
+#include <functional>
 #include <random>
 #include <thread>
 #include <memory>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 /**
  * Simulated bidirectional radio link between satellite and ground station.
  * Introduces realistic impairments: latency, jitter, and packet loss.
@@ -21,6 +29,27 @@ public:
         int jitter_ms = 30;        // Latency jitter (std deviation)
         double loss_prob = 0.05;   // Packet loss probability [0..1]
         unsigned int seed = 42;    // Random seed for determinism
+
+        // Timestamp packets for later delivery instead of sleeping in the
+        // sender. Lets one thread serve many links; delivery stays FIFO.
+        bool deferred_delivery = false;
+
+        // Lockstep mode: take time from this clock instead of steady_clock
+        // and key loss and latency draws by (direction, logical time, send
+        // index at that time) instead of drawing from one shared stream.
+        // Implies deferred delivery; a packet is never delivered at the
+        // instant it was sent, so senders and receivers in the same tick
+        // cannot race. Receives never block.
+        const LogicalClock* clock = nullptr;
+
+        // Optional: record how long each packet waits in that direction's
+        // queue once deliverable (queueing delay, not simulated latency).
+        // One histogram may be shared by many links.
+        LatencyHistogram* sat_to_gs_residency = nullptr;
+        LatencyHistogram* gs_to_sat_residency = nullptr;
+
+        // Stream ID this link's packet trace events carry (see packet_trace.hpp)
+        uint32_t trace_id = 0;
     };
 
     explicit Link(const Config& config);
@@ -33,23 +62,84 @@ public:
     void send_gs_to_sat(Packet pkt);
     bool recv_gs_to_sat(Packet& out, std::chrono::milliseconds timeout);
 
+    /**
+     * One-shot arrival notification for event-driven receivers. The hook
+     * is called with the delivery time of the next packet in that
+     * direction: at once if one is already queued, otherwise from the
+     * sender when one is queued. Arming again replaces a pending hook.
+     */
+    using ArrivalHook = std::function<void(std::chrono::steady_clock::time_point)>;
+    void notify_sat_to_gs(ArrivalHook hook);
+    void notify_gs_to_sat(ArrivalHook hook);
+
+    /**
+     * Save RNG state, packets in flight (with their remaining delay) and
+     * counters. Senders should be quiescent so the two directions are
+     * captured at the same instant.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * Replace link state with a saved one; in-flight packets are due after
+     * their remaining delay from now. Arrival hooks are kept.
+     */
+    void restore(CheckpointReader& in);
+
     // Metrics
     uint64_t get_packets_dropped() const { return packets_dropped_; }
     uint64_t get_packets_sent() const { return packets_sent_; }
 
+    /**
+     * Register this link's counters and histograms for live export; labels
+     * are added to every series.
+     */
+    void register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels = {}) const;
+
 private:
+    // Packet in flight with its earliest delivery time
+    struct InFlight {
+        Packet pkt;
+        std::chrono::steady_clock::time_point deliver_at;
+    };
+
+    // Per-direction queue; last_deliver_at keeps deferred delivery FIFO
+    struct Channel {
+        ThreadSafeQueue<InFlight> queue;
+        std::chrono::steady_clock::time_point last_deliver_at{};
+        ArrivalHook arrival_hook;
+        LatencyHistogram* residency = nullptr;
+
+        // Lockstep draw key: sends so far at the current logical instant
+        uint64_t draw_ns = UINT64_MAX;
+        uint64_t draw_index = 0;
+    };
+
+    bool deferred() const { return config_.deferred_delivery || config_.clock; }
+    std::chrono::steady_clock::time_point now() const {
+        return config_.clock ? config_.clock->now() : std::chrono::steady_clock::now();
+    }
+    void draw_impairments(Channel& channel, double& loss_value, double& delay_ms);
+
     // Apply latency and loss, then enqueue with delay
-    void apply_impairments_and_send(Packet pkt, ThreadSafeQueue<Packet>& queue);
+    void apply_impairments_and_send(Packet pkt, Channel& channel);
+    bool receive(Channel& channel, Packet& out, std::chrono::milliseconds timeout);
+    void take(Channel& channel, InFlight& in_flight, Packet& out);
+    void arm(Channel& channel, ArrivalHook hook);
+    void enqueue(Channel& channel, InFlight in_flight);
+    void save_channel(CheckpointWriter& out, const Channel& channel,
+                      std::chrono::steady_clock::time_point now) const;
+    void restore_channel(CheckpointReader& in, Channel& channel,
+                         std::chrono::steady_clock::time_point now);
 
     Config config_;
     std::mt19937 rng_;
-    std::mutex rng_mutex_;  // Protect RNG for thread safety
+    mutable std::mutex rng_mutex_;  // Protect RNG, deferred delivery ordering and arrival hooks
 
     // Queues for each direction
-    ThreadSafeQueue<Packet> sat_to_gs_;
-    ThreadSafeQueue<Packet> gs_to_sat_;
+    Channel sat_to_gs_;
+    Channel gs_to_sat_;
 
     // Metrics
-    std::atomic<uint64_t> packets_dropped_{0};
-    std::atomic<uint64_t> packets_sent_{0};
+    ShardedCounter packets_dropped_;  // Both directions' senders increment these
+    ShardedCounter packets_sent_;
 };
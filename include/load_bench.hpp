@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * End-to-end load benchmark over the constellation pipeline
+ * (ConstellationEngine → deferred Links → MultiGroundStation).
+ * Each step builds a fresh pipeline, offers a fixed telemetry load
+ * (packets/s summed over all satellites) plus a steady stream of commands,
+ * and measures, after a warm-up, what actually came out: delivered
+ * telemetry/s, command round-trip percentiles, retransmissions, engine
+ * tick overruns and process CPU time per delivered packet.
+ *
+ * A ramp multiplies the offered load each step and stops at the first
+ * saturated step, i.e. one delivering less than saturation_ratio of what
+ * the loss rate allows. The last unsaturated step is the saturation point.
+ */
+class LoadBench {
+public:
+    struct Config {
+        size_t num_satellites = 1000;
+        double start_load = 1000.0;    // Offered telemetry/s at the first step
+        double load_factor = 2.0;      // Offered load multiplier per step
+        int max_steps = 8;             // 1 = single fixed load
+        double step_sec = 3.0;         // Measured window per step
+        double warmup_sec = 0.5;
+        double command_rate_hz = 20.0; // Commands/s, round-robin over satellites
+        double saturation_ratio = 0.9;
+
+        double loss = 0.05;
+        int latency_ms = 100;
+        int jitter_ms = 30;
+        int ack_timeout_ms = 410;
+        int max_retries = 3;
+        unsigned int seed = 42;
+        size_t workers = 0;            // Engine workers (0 = all cores)
+        size_t gs_workers = 0;         // Ground station shards (0 = all cores)
+    };
+
+    struct Step {
+        double offered_per_sec = 0.0;
+        double telemetry_rate_hz = 0.0;  // Per satellite
+        double sent_per_sec = 0.0;       // Telemetry the engine actually emitted
+        double delivered_per_sec = 0.0;  // Telemetry accepted by the ground station
+        uint64_t retransmissions = 0;    // Telemetry and command retries
+        uint64_t ticks = 0;
+        uint64_t tick_overruns = 0;
+        double cpu_us_per_packet = 0.0;  // Process user+sys time per delivered packet
+        uint64_t commands_acked = 0;
+        double rtt_p50_ms = 0.0;
+        double rtt_p90_ms = 0.0;
+        double rtt_p99_ms = 0.0;
+        double rtt_max_ms = 0.0;
+        bool saturated = false;
+    };
+
+    explicit LoadBench(const Config& config);
+
+    /**
+     * Run one step at the given offered load (telemetry/s).
+     */
+    Step run_step(double offered_per_sec) const;
+
+    /**
+     * Run the ramp; on_step is called after each step.
+     */
+    std::vector<Step> run(std::function<void(const Step&)> on_step = {}) const;
+
+    /**
+     * Nearest-rank percentile (p in [0, 100]) of unsorted samples.
+     */
+    static double percentile(std::vector<double> samples, double p);
+
+    static void write_json(std::ostream& out, const Config& config, const std::vector<Step>& steps);
+
+private:
+    Config config_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Simulated time shared by agents running in lockstep.
+ * Reads are lock-free; the clock is advanced only between epochs (at the
+ * tick barrier), so every agent sees the same time throughout a tick.
+ * Time points are steady_clock values counted from the clock's epoch, so
+ * code written against steady_clock deadlines works unchanged.
+ */
+class LogicalClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point now() const {
+        return Clock::time_point(std::chrono::nanoseconds(now_ns_.load(std::memory_order_acquire)));
+    }
+
+    uint64_t now_ns() const { return static_cast<uint64_t>(now_ns_.load(std::memory_order_acquire)); }
+
+    /**
+     * Move time forward (single writer, between epochs).
+     */
+    void advance(Clock::duration d) {
+        now_ns_.store(now_ns_.load(std::memory_order_relaxed) +
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(),
+                      std::memory_order_release);
+    }
+
+private:
+    std::atomic<int64_t> now_ns_{0};
+};
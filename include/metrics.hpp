@@ -0,0 +1,112 @@
+#pragma once
+
+#include "hdr_histogram.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Registry of live metrics, rendered in the Prometheus text exposition
+ * format (version 0.0.4).
+ *
+ * Components register read callbacks over the counters they already
+ * keep (relaxed atomics, per-thread histogram shards), so nothing changes
+ * on the hot paths: a scrape reads and aggregates, it never takes a lock
+ * a packet path also takes. The registry's own mutex only orders
+ * registration against scrapes.
+ *
+ * Registered objects must outlive scrapes: stop any MetricsServer before
+ * destroying them.
+ */
+class MetricsRegistry {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * Monotonic count; name should end in _total.
+     */
+    void counter(const std::string& name, const std::string& help, Labels labels,
+                 std::function<uint64_t()> read);
+
+    void gauge(const std::string& name, const std::string& help, Labels labels,
+               std::function<double()> read);
+
+    /**
+     * Latency histogram of nanosecond values, exported in seconds with
+     * fixed buckets from 100 µs to 10 s.
+     */
+    void histogram(const std::string& name, const std::string& help, Labels labels,
+                   std::function<HdrHistogram()> read);
+
+    /**
+     * Write every family (HELP and TYPE once, then one sample per series)
+     * in registration order of first appearance.
+     */
+    void write_prometheus(std::ostream& out) const;
+
+    size_t size() const;
+
+    static const std::vector<double>& histogram_bounds_sec();
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        Labels labels;
+        std::function<uint64_t()> read_counter;
+        std::function<double()> read_gauge;
+        std::function<HdrHistogram()> read_histogram;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Type type);
+
+    mutable std::mutex mutex_;
+    std::vector<Family> families_;
+};
+
+/**
+ * Minimal HTTP/1.0 listener serving GET /metrics from a registry on
+ * 127.0.0.1. One background thread accepts and answers connections one at
+ * a time (scrapes are rare and small); any other path gets 404.
+ */
+class MetricsServer {
+public:
+    /**
+     * Bind and start serving. port 0 picks a free port (see port()).
+     * Throws std::runtime_error if the socket cannot be bound.
+     */
+    MetricsServer(const MetricsRegistry& registry, uint16_t port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void stop();
+
+    uint16_t port() const { return port_; }
+    uint64_t get_scrapes() const { return scrapes_; }
+
+private:
+    void serve();
+    void handle(int client);
+
+    const MetricsRegistry& registry_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> scrapes_{0};
+    std::thread thread_;
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "command_plan.hpp"
+#include "hdr_histogram.hpp"
+#include "link.hpp"
+#include "metrics.hpp"
+#include "logical_clock.hpp"
+#include "telemetry.hpp"
+#include "commands.hpp"
+#include "packet.hpp"
+#include "sequence.hpp"
+#include "sharded_counter.hpp"
+#include "thread_safe_queue.hpp"
+#include "work_stealing_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Ground station serving many satellites, one Link per satellite.
+ * Sessions are sharded across worker threads by satellite ID; each worker
+ * owns its sessions outright, so per-session state needs no locking. All
+ * shards run the same ingest pipeline (CRC → duplicate check → decode →
+ * archive → ACK) and write to a per-shard archive stream tagged by
+ * satellite ID. Commands use non-blocking stop-and-wait per session, so
+ * one slow satellite never stalls the others on its shard.
+ *
+ * Shards run either on dedicated threads (start()) or as agents on a shared
+ * WorkStealingPool (start(pool)); in pool mode an idle shard sleeps on a
+ * pool timer instead of holding a thread.
+ *
+ * Links should use deferred delivery, otherwise every ACK blocks the
+ * worker for the link latency.
+ *
+ * With a logical clock the station is not started at all: a lockstep
+ * driver calls step_shard() for every shard once per tick, and ACK
+ * deadlines are measured in logical time.
+ *
+ * With a command plan each shard runs its own PlanScheduler over its own
+ * satellites, all timed from one station-wide epoch (the first shard pass
+ * to dispatch), so a plan step is due at the same instant on every shard. Commands due for one
+ * satellite in the same pass go out as one CommandBatchPkt. Telemetry
+ * ingested in a pass is queued for the plan's triggers and evaluated in
+ * one batch at the end of the pass.
+ */
+class MultiGroundStation {
+public:
+    struct Config {
+        size_t num_workers = 4;
+        int ack_timeout_ms = 150;
+        int max_retries = 3;
+        std::string archive_dir;  // Writes <dir>/gs_shard_<n>.log if set
+        bool verbose = false;
+        const LogicalClock* clock = nullptr;  // Lockstep: time source for ACK deadlines
+        const CommandPlan* plan = nullptr;    // Must outlive the station
+    };
+
+    /**
+     * Per-session counters (snapshot).
+     */
+    struct SessionStats {
+        uint64_t telemetry_received = 0;
+        uint64_t duplicates = 0;
+        uint64_t commands_sent = 0;
+        uint64_t commands_failed = 0;
+        uint64_t events_received = 0;
+    };
+
+    explicit MultiGroundStation(const Config& config);
+    ~MultiGroundStation();
+
+    /**
+     * Register a satellite session. Must be called before start().
+     * Throws std::runtime_error on duplicate IDs.
+     */
+    void add_session(uint32_t sat_id, Link& link);
+
+    // Start/stop worker threads
+    void start();
+    void stop();
+
+    /**
+     * Run each shard as an agent on the given pool instead of a dedicated
+     * thread. The pool must outlive the station (or at least stop()).
+     */
+    void start(WorkStealingPool& pool);
+
+    /**
+     * Run one pass of a shard on the calling thread (station not started).
+     * Each shard must be stepped by one thread at a time.
+     */
+    void step_shard(size_t shard) { shard_pass(*shards_.at(shard)); }
+
+    /**
+     * Queue a command for a satellite (thread-safe).
+     *
+     * @return false if the satellite ID is unknown
+     */
+    bool send_command(uint32_t sat_id, const Command& cmd);
+
+    /**
+     * Queue commands for a satellite as one CommandBatchPkt (thread-safe):
+     * one ACK, executed all or none. Encoding happens on the caller.
+     * Throws std::runtime_error if the batch cannot be encoded.
+     *
+     * @return false if the satellite ID is unknown
+     */
+    bool send_batch(uint32_t sat_id, std::vector<Command> commands);
+
+    size_t session_count() const { return session_shard_.size(); }
+    size_t worker_count() const { return shards_.size(); }
+
+    /**
+     * Counters for one session (read after stop()).
+     */
+    std::optional<SessionStats> get_session_stats(uint32_t sat_id) const;
+
+    /**
+     * Command round-trip times in milliseconds, first transmission to
+     * ACK (retransmissions included), for every delivered command.
+     * Read after stop().
+     */
+    std::vector<double> get_command_rtts_ms() const;
+
+    // Latency distributions across all sessions (snapshots)
+    HdrHistogram get_telemetry_age() const { return telemetry_age_.snapshot(); }  // Ingest time - Telemetry::ts
+    HdrHistogram get_ack_rtt() const { return ack_rtt_.snapshot(); }              // Command ACK RTT per attempt
+
+    // Aggregate metrics (summed across shards)
+    uint64_t get_telemetry_received() const;
+    uint64_t get_commands_sent() const;
+    uint64_t get_retries() const;
+    uint64_t get_naks_sent() const;
+    uint64_t get_events_received() const;
+    uint64_t get_plan_commands() const;  // Queued by the command plan
+
+    /**
+     * Register this ground station's counters and histograms for live export; labels
+     * are added to every series.
+     */
+    void register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels = {}) const;
+
+private:
+    // One queued uplink packet (seq assigned at transmission)
+    struct Uplink {
+        PacketType type;
+        std::string payload;
+        size_t commands;
+    };
+
+    struct Session {
+        uint32_t sat_id;
+        Link* link;
+        uint32_t tx_seq = 0;
+        ReplayWindow<128> rx_window;  // Telemetry already ingested
+
+        // Outstanding command (stop-and-wait) and backlog behind it
+        std::deque<Uplink> backlog;
+        std::optional<Packet> in_flight;
+        size_t in_flight_commands = 0;
+        std::chrono::steady_clock::time_point ack_deadline;
+        std::chrono::steady_clock::time_point first_sent;
+        std::chrono::steady_clock::time_point last_sent;
+        int attempts = 0;
+
+        SessionStats stats;
+    };
+
+    struct Shard {
+        size_t index = 0;
+        std::vector<std::unique_ptr<Session>> sessions;
+        std::unordered_map<uint32_t, Session*> by_id;
+        ThreadSafeQueue<std::pair<uint32_t, Uplink>> command_requests;
+        std::ofstream archive;
+        std::thread thread;
+        std::vector<double> command_rtts_ms;
+        std::unique_ptr<PlanScheduler> plan;  // Built on the first pass
+        std::unordered_map<uint32_t, std::vector<Command>> plan_due;
+
+        ShardedCounter telemetry_received;
+        ShardedCounter commands_sent;
+        ShardedCounter retries;
+        ShardedCounter naks_sent;
+        ShardedCounter events_received;
+        ShardedCounter plan_commands;
+    };
+
+    size_t shard_of(uint32_t sat_id) const { return sat_id % shards_.size(); }
+    std::chrono::steady_clock::time_point now() const {
+        return config_.clock ? config_.clock->now() : std::chrono::steady_clock::now();
+    }
+
+    void run_shard(Shard& shard);
+    bool shard_pass(Shard& shard);
+    bool poll_session(Shard& shard, Session& session);
+    void ingest(Shard& shard, Session& session, const Packet& pkt);
+    void dispatch_plan(Shard& shard, std::chrono::steady_clock::time_point now);
+    double plan_seconds(std::chrono::steady_clock::time_point now) const {
+        return std::chrono::duration<double>(now - plan_epoch_).count();
+    }
+    void queue_triggered(Shard& shard, uint32_t sat_id, const Command& cmd);
+    void service_commands(Shard& shard, Session& session, std::chrono::steady_clock::time_point now);
+    void transmit_command(Session& session, std::chrono::steady_clock::time_point now);
+    void reply(Session& session, PacketType type, uint32_t seq);
+
+    Config config_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> active_agents_{0};  // Shards still running in pool mode
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unordered_map<uint32_t, size_t> session_shard_;
+    std::once_flag plan_epoch_once_;
+    std::chrono::steady_clock::time_point plan_epoch_;  // Shared by every shard's plan
+    LatencyHistogram telemetry_age_;
+    LatencyHistogram ack_rtt_;
+};
@@ -12,7 +12,10 @@ enum class PacketType : uint8_t {
     TelemetryPkt = 1,
     CommandPkt = 2,
     AckPkt = 3,
-    NakPkt = 4
+    NakPkt = 4,
+    EventPkt = 5,
+    CommandBatchPkt = 6,  // Several commands, one ACK, executed all or none
+    ParityPkt = 7         // Erasure-code parity for a packet group (fec.hpp); never ACKed
 };
 
 /**
@@ -63,6 +66,9 @@ struct Packet {
             case PacketType::CommandPkt: return "Command";
             case PacketType::AckPkt: return "ACK";
             case PacketType::NakPkt: return "NAK";
+            case PacketType::EventPkt: return "Event";
+            case PacketType::CommandBatchPkt: return "CommandBatch";
+            case PacketType::ParityPkt: return "Parity";
             default: return "Unknown";
         }
     }
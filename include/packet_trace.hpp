@@ -0,0 +1,155 @@
+#pragma once
+
+#include "packet.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Packet lifecycle tracing, exported as Chrome trace-event JSON (loads in
+ * chrome://tracing and Perfetto).
+ *
+ * Instrumentation points use SATCOM_TRACE(...), which compiles to nothing
+ * unless the build defines SATCOM_TRACING (CMake -DSATCOM_TRACING=ON,
+ * make TRACING=1). When compiled in, recording is off until
+ * Tracer::start(); an idle probe is one atomic load.
+ *
+ * Each thread appends fixed-size records to its own single-producer ring;
+ * a background thread drains the rings and streams JSON to the file. A
+ * full ring drops the event (counted) rather than block the simulation.
+ *
+ * Events are instant events: pid is the component (satellite, link,
+ * ground station), tid the recording thread, and args carry the stream
+ * (satellite/link ID), packet type, sequence number and an event-specific
+ * value (delay or residency in µs, CRC result, attempt number).
+ */
+namespace trace {
+
+enum class Actor : uint8_t { Satellite = 1, Link = 2, GroundStation = 3 };
+
+enum class Event : uint8_t {
+    Created,        // Packet built by its sender
+    Sent,           // Handed to the link
+    Dropped,        // Lost on the link
+    Delayed,        // Latency assigned (arg: µs)
+    Enqueued,       // Placed in the link queue
+    Dequeued,       // Taken by the receiver (arg: µs waited once deliverable)
+    CrcChecked,     // Receiver verified CRC (arg: 1 ok, 0 bad)
+    Acked,          // Sender got its ACK (arg: attempt)
+    Retransmitted   // Sender gave up waiting and resent (arg: attempt)
+};
+
+const char* actor_name(Actor actor);
+const char* event_name(Event event);
+
+constexpr bool compiled_in() {
+#ifdef SATCOM_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * One trace event as stored in the per-thread rings (24 bytes).
+ */
+struct Record {
+    uint64_t ts_ns;
+    uint32_t stream;
+    uint32_t seq;
+    uint32_t arg;
+    Actor actor;
+    Event event;
+    PacketType type;
+};
+static_assert(sizeof(Record) == 24, "trace records are fixed-size");
+
+class Tracer {
+public:
+    static Tracer& instance();
+
+    /**
+     * Open path and start the background flusher. Throws
+     * std::runtime_error if the file cannot be opened or a trace is
+     * already running.
+     */
+    void start(const std::string& path,
+               std::chrono::milliseconds flush_interval = std::chrono::milliseconds(50));
+
+    /**
+     * Flush everything recorded so far and close the file. Recording
+     * threads should be quiescent; later events are ignored.
+     */
+    void stop();
+
+    bool active() const { return active_.load(std::memory_order_acquire); }
+
+    void emit(Actor actor, Event event, PacketType type, uint32_t stream, uint32_t seq, uint32_t arg) {
+        if (active()) {
+            record(Record{0, stream, seq, arg, actor, event, type});
+        }
+    }
+
+    uint64_t get_events_written() const { return events_written_; }
+    uint64_t get_events_dropped() const { return events_dropped_; }
+
+private:
+    struct Ring {
+        SpscRing<Record, 8192> records;
+        uint32_t tid = 0;
+    };
+
+    Tracer() = default;
+    ~Tracer();
+
+    void record(Record rec);
+    Ring* local_ring();
+    void flush_loop(std::chrono::milliseconds interval);
+    void drain();
+
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> generation_{0};
+    std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    uint32_t next_tid_ = 1;
+
+    std::mutex flush_mutex_;  // Serializes drain() and protects out_
+    std::condition_variable flush_cv_;
+    bool stopping_ = false;
+    std::thread flusher_;
+    std::ofstream out_;
+    bool first_event_ = true;
+
+    std::atomic<uint64_t> events_written_{0};
+    std::atomic<uint64_t> events_dropped_{0};
+};
+
+inline void emit(Actor actor, Event event, PacketType type, uint32_t stream, uint32_t seq, uint32_t arg = 0) {
+    Tracer::instance().emit(actor, event, type, stream, seq, arg);
+}
+
+} // namespace trace
+
+#ifdef SATCOM_TRACING
+// Arguments are only evaluated while a trace is running
+#define SATCOM_TRACE(actor, event, type, stream, seq, arg)                                   \
+    do {                                                                                     \
+        if (::trace::Tracer::instance().active()) {                                          \
+            ::trace::emit(::trace::Actor::actor, ::trace::Event::event, (type),              \
+                          static_cast<uint32_t>(stream), static_cast<uint32_t>(seq),         \
+                          static_cast<uint32_t>(arg));                                       \
+        }                                                                                    \
+    } while (0)
+#else
+#define SATCOM_TRACE(actor, event, type, stream, seq, arg) ((void)0)
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+/**
+ * Hardware performance counters for the calling thread (Linux
+ * perf_event_open): cycles, instructions, cache misses and branch misses,
+ * opened as one group so they cover exactly the same instructions.
+ *
+ * Counters are often unavailable (containers, VMs without a virtual PMU,
+ * kernel.perf_event_paranoid > 2, non-Linux builds). Construction never
+ * fails: available() is false and unavailable_reason() says why, and any
+ * single counter the CPU lacks reads as missing while the rest still work.
+ * Counts are scaled when the kernel had to multiplex the group.
+ */
+class PerfCounters {
+public:
+    enum Counter { Cycles, Instructions, CacheMisses, BranchMisses, kNumCounters };
+
+    struct Sample {
+        std::array<uint64_t, kNumCounters> values{};
+        std::array<bool, kNumCounters> valid{};
+
+        bool has(Counter c) const { return valid[c]; }
+        uint64_t operator[](Counter c) const { return values[c]; }
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return leader_ >= 0; }
+    const std::string& unavailable_reason() const { return reason_; }
+
+    /**
+     * Zero and enable the group.
+     */
+    void start();
+
+    /**
+     * Disable the group and read the counts since start(). All counters
+     * are invalid when unavailable.
+     */
+    Sample stop();
+
+    static const char* name(Counter c);
+
+private:
+    std::array<int, kNumCounters> fds_;
+    int leader_ = -1;
+    std::string reason_;
+};
+
+} // namespace bench
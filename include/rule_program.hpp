@@ -0,0 +1,107 @@
+#pragma once
+
+#include "commands.hpp"
+#include "telemetry.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Ground-side telemetry rules ("battery_pct < 15 → ENTER_SAFE_MODE")
+ * compiled into a flat evaluation program.
+ *
+ * A rule compares one telemetry field, or its rate of change per second,
+ * against a threshold. It fires when the comparison becomes true and
+ * re-arms once the value is back past its clear level (the threshold
+ * itself unless a hysteresis level is given); with a cooldown it also
+ * fires again every cooldown seconds while the comparison holds.
+ *
+ * Samples are queued in struct-of-arrays columns, at most one per
+ * satellite, and evaluate() runs every rule over the whole batch. Each
+ * rule is reduced to a sign and two levels so '<' and '>' share one
+ * branch-free kernel over contiguous columns that the compiler can
+ * vectorize across satellites; only commands that actually fire take the
+ * scalar path. Per-rule state (armed flag, last firing) lives in flat
+ * rule-by-satellite arrays. Not thread-safe: one owner (e.g. one shard).
+ */
+class RuleProgram {
+public:
+    enum class Field : uint8_t { TemperatureC, BatteryPct, OrbitAltitudeKm, PitchDeg, YawDeg, RollDeg };
+    static constexpr size_t kNumFields = 6;
+
+    struct Rule {
+        Field field = Field::TemperatureC;
+        bool rate = false;   // Compare the change per second instead of the value
+        bool above = true;   // '>' (else '<')
+        double threshold = 0.0;
+        double clear = std::numeric_limits<double>::quiet_NaN();  // Re-arm level; NaN = threshold
+        double cooldown_sec = std::numeric_limits<double>::infinity();  // Default: once per crossing
+        Command cmd;
+    };
+
+    using Dispatch = std::function<void(uint32_t sat_id, const Command& cmd)>;
+    using Applies = std::function<bool(size_t rule, uint32_t sat_id)>;
+
+    /**
+     * Compile rules for the given satellites; applies(r, id) selects the
+     * satellites rule r watches. Rules that watch none are dropped.
+     */
+    RuleProgram(std::vector<Rule> rules, const std::vector<uint32_t>& sat_ids, const Applies& applies);
+
+    /**
+     * Queue one sample. A second sample for a satellite already in the
+     * batch evaluates the batch first, so no crossing is lost. Unknown
+     * satellites are ignored. Returns the number of commands fired.
+     */
+    size_t add_sample(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn);
+
+    /**
+     * Run every rule over the queued samples and clear the batch. Returns
+     * the number of commands fired.
+     */
+    size_t evaluate(const Dispatch& fn);
+
+    size_t rule_count() const { return rows_.size(); }
+    size_t queued() const { return batch_slot_.size(); }
+
+private:
+    // One compiled rule: fire when sign * x > trip, re-arm when sign * x <= release
+    struct Row {
+        size_t column;  // Field, or kNumFields + field for its rate
+        double sign;
+        double trip;
+        double release;
+        double cooldown_sec;
+        size_t rule;  // Index into rules_
+    };
+
+    std::vector<Rule> rules_;
+    std::vector<Row> rows_;
+    std::vector<uint32_t> sat_ids_;  // By slot
+    std::unordered_map<uint32_t, uint32_t> slot_of_;
+
+    // Previous sample per slot, for rates
+    std::array<std::vector<double>, kNumFields> prev_value_;
+    std::vector<double> prev_time_;
+
+    // Queued batch: one entry per satellite
+    std::vector<uint8_t> queued_;  // By slot
+    std::vector<uint32_t> batch_slot_;
+    std::vector<double> batch_time_;
+    std::array<std::vector<double>, 2 * kNumFields> columns_;
+
+    // Rule state, [row * slots + slot]
+    std::vector<uint8_t> watch_;
+    std::vector<uint8_t> armed_;
+    std::vector<double> last_fired_;
+
+    // Per-rule scratch, gathered for the batch
+    std::vector<double> scratch_watch_;
+    std::vector<double> scratch_armed_;
+    std::vector<double> scratch_last_;
+    std::vector<double> fire_;
+};
@@ -4,13 +4,28 @@
 #include "telemetry.hpp"
 #include "commands.hpp"
 #include "packet.hpp"
+#include "command_schedule.hpp"
+#include "telemetry_recorder.hpp"
+#include "tx_scheduler.hpp"
+#include "hdr_histogram.hpp"
+#include "metrics.hpp"
+#include "sharded_counter.hpp"
+#include "coroutine_runtime.hpp"
+#include "sequence.hpp"
 #include <atomic>
 #include <thread>
 #include <random>
+#include <vector>
 
 /**
  * Satellite simulator running in its own thread.
  * Periodically emits telemetry and responds to ground station commands.
+ * Commands that arrive during an ACK wait are handled in place rather
+ * than discarded.
+ *
+ * start(runtime) runs the same logic as a coroutine agent instead: ACK
+ * waits suspend rather than block, so thousands of satellites can share
+ * a few threads. Requires a deferred-delivery link.
  */
 class Satellite {
 public:
@@ -18,6 +33,22 @@ public:
         double telemetry_rate_hz = 5.0;
         int ack_timeout_ms = 150;
         int max_retries = 3;
+        size_t max_scheduled_commands = 4096;  // Stored-command capacity
+        size_t recorder_capacity = 4096;       // Store-and-forward telemetry records
+        std::string recorder_file;             // mmap-backed recorder if set
+        int playback_burst = 16;               // Max recorded packets per playback pass
+        // Recorded packets in flight per playback ACK wait: a window is sent
+        // back to back and ACKed as a whole, and only members still unACKed
+        // at the timeout fall back to stop-and-wait. 1 = stop-and-wait.
+        size_t playback_window = 8;
+        // With FEC, play back in groups of fec_group packets (instead of
+        // playback_window) plus fec_parity erasure parity packets (fec.hpp),
+        // so the ground rebuilds up to fec_parity losses per group without a
+        // retransmission. 0 = no parity.
+        size_t fec_group = 0;
+        size_t fec_parity = 2;
+        double downlink_rate_bps = 0.0;        // Downlink shaping rate (bits/s); 0 = unlimited
+        bool weighted_fair_tx = false;         // Weighted fair instead of strict priority
         bool verbose = false;
         unsigned int seed = 42;
     };
@@ -29,30 +60,128 @@ public:
     void start();
     void stop();
 
+    /**
+     * Run as a coroutine agent on the given runtime (must outlive stop()).
+     */
+    void start(CoroutineRuntime& runtime);
+
+    /**
+     * Ask the thread or agent to finish without waiting for it; stop()
+     * still has to be called. Lets many instances wind down together.
+     */
+    void request_stop();
+
+    /**
+     * Save satellite state: sequence numbers, safe mode, telemetry state,
+     * RNG, stored commands, recorder contents, queued downlink packets and
+     * counters. Throws std::runtime_error while running.
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * Replace satellite state with a saved one before start(). Throws
+     * std::runtime_error while running or if the checkpoint is invalid.
+     */
+    void restore(CheckpointReader& in);
+
     // Metrics
     uint64_t get_telemetry_sent() const { return telemetry_sent_; }
     uint64_t get_commands_received() const { return commands_received_; }
     uint64_t get_retries() const { return retries_; }
     uint64_t get_naks_received() const { return naks_received_; }
+    uint64_t get_commands_scheduled() const { return commands_scheduled_; }
+    uint64_t get_scheduled_executed() const { return scheduled_executed_; }
+    uint64_t get_recorder_fill() const { return recorder_fill_; }
+    uint64_t get_recorder_capacity() const { return config_.recorder_capacity; }
+    uint64_t get_records_stored() const { return records_stored_; }
+    uint64_t get_records_played_back() const { return records_played_back_; }
+    uint64_t get_records_overwritten() const { return records_overwritten_; }
+    uint64_t get_records_rejected() const { return records_rejected_; }
+    uint64_t get_playback_bytes() const { return playback_bytes_; }
+    uint64_t get_parity_sent() const { return parity_sent_; }
+
+    /**
+     * Playback throughput while draining the recorder (bytes/s).
+     */
+    double get_playback_rate_bps() const {
+        uint64_t ns = playback_ns_;
+        return ns ? playback_bytes_ * 1e9 / static_cast<double>(ns) : 0.0;
+    }
+
+    /**
+     * Telemetry/playback ACK round trip per attempt, from handing the
+     * packet to the downlink queue to its ACK (snapshot).
+     */
+    HdrHistogram get_ack_rtt() const { return ack_rtt_.snapshot(); }
+
+    /**
+     * Register this satellite's counters and histograms for live export; labels
+     * are added to every series.
+     */
+    void register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels = {}) const;
+
+    /**
+     * Downlink queue statistics per traffic class (read after stop()).
+     */
+    TxScheduler::ClassStats get_tx_stats(TrafficClass cls) const { return tx_.stats(cls); }
 
 private:
+    TxScheduler::Config tx_config() const;
     void run();
+    bool update(std::chrono::steady_clock::time_point now);
+    Packet make_telemetry_packet();
+    bool finish_telemetry(const Packet& pkt, bool delivered);
+    Packet make_playback_packet(std::string payload);
+    std::vector<Packet> next_playback_group(size_t max_packets);
+    std::chrono::steady_clock::time_point transmit_group(const std::vector<Packet>& group);
+    bool note_group_reply(const std::vector<Packet>& group, std::vector<uint8_t>& acked, size_t& remaining,
+                          const Packet& pkt, std::chrono::steady_clock::time_point sent_at);
+    bool send_group(const std::vector<Packet>& group);
+    void finish_playback(const Packet& pkt, size_t position = 0);
+    void drop_acked_after(const std::vector<Packet>& group, const std::vector<uint8_t>& acked, size_t failed);
+    void note_retry(uint32_t seq, int retry);
     void send_telemetry();
+    bool send_with_retry(const Packet& pkt, TrafficClass cls);
+    void transmit(TrafficClass cls, Packet pkt);
+    void service_tx();
+    void record_telemetry(const std::string& payload);
+    void playback_recorded();
     void process_commands();
+    void handle_uplink(const Packet& pkt);
+    void accept_batch(uint32_t seq, const CommandBatch& batch);  // All or none; throws to reject
+    void execute_due_commands(std::chrono::steady_clock::time_point now);
+    void execute_command(const Command& cmd, const std::string& label);  // label prefixes the verbose line
+    bool rebooting(std::chrono::steady_clock::time_point now);  // Finishes the reboot once it is due
     void update_state(double dt);
     void check_anomalies();
     bool wait_for_ack(uint32_t seq, std::chrono::milliseconds timeout);
 
+    // Coroutine agent versions of the blocking paths above
+    Task<void> run_async(CoroutineRuntime& rt);
+    Task<void> send_telemetry_async(CoroutineRuntime& rt);
+    Task<bool> send_with_retry_async(CoroutineRuntime& rt, const Packet& pkt, TrafficClass cls);
+    Task<void> playback_recorded_async(CoroutineRuntime& rt);
+    Task<bool> send_group_async(CoroutineRuntime& rt, const std::vector<Packet>& group);
+    Task<bool> wait_for_ack_async(CoroutineRuntime& rt, uint32_t seq, std::chrono::milliseconds timeout);
+
     Link& link_;
     Config config_;
     std::atomic<bool> running_{false};
     std::thread thread_;
+    std::atomic<bool> agent_running_{false};
     std::mt19937 rng_;
 
     // State
     uint32_t tx_seq_{0};
-    uint32_t rx_seq_expected_{0};
+    ReplayWindow<> rx_window_;  // Commands already executed
     bool safe_mode_{false};
+    bool link_up_{true};
+    std::chrono::steady_clock::time_point last_telemetry_;
+    std::chrono::steady_clock::time_point last_update_;
+    std::chrono::steady_clock::time_point reboot_until_;  // Epoch = not rebooting
+    CommandSchedule schedule_;
+    TelemetryRecorder recorder_;
+    TxScheduler tx_;
 
     // Telemetry state
     double temperature_c_{50.0};
@@ -63,8 +192,19 @@ private:
     double roll_deg_{0.0};
 
     // Metrics
-    std::atomic<uint64_t> telemetry_sent_{0};
-    std::atomic<uint64_t> commands_received_{0};
-    std::atomic<uint64_t> retries_{0};
-    std::atomic<uint64_t> naks_received_{0};
+    ShardedCounter telemetry_sent_;
+    ShardedCounter commands_received_;
+    ShardedCounter retries_;
+    ShardedCounter naks_received_;
+    ShardedCounter commands_scheduled_;
+    ShardedCounter scheduled_executed_;
+    std::atomic<uint64_t> recorder_fill_{0};
+    ShardedCounter records_stored_;
+    ShardedCounter records_played_back_;
+    ShardedCounter records_overwritten_;
+    ShardedCounter records_rejected_;
+    ShardedCounter playback_bytes_;
+    ShardedCounter playback_ns_;
+    ShardedCounter parity_sent_;
+    LatencyHistogram ack_rtt_;
 };
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Packet sequence number with serial-number arithmetic (RFC 1982) over the
+ * 32-bit space: a precedes b when b - a, taken mod 2^32, lies in
+ * (0, 2^31). Ordering therefore survives the wrap from 0xFFFFFFFF to 0,
+ * provided compared numbers are less than 2^31 apart (exactly 2^31 apart
+ * is undefined, as in the RFC).
+ */
+struct SeqNum {
+    uint32_t value = 0;
+
+    constexpr SeqNum() = default;
+    constexpr explicit SeqNum(uint32_t v) : value(v) {}
+
+    /**
+     * Signed distance from other to this: positive when this is newer.
+     */
+    constexpr int32_t operator-(SeqNum other) const { return static_cast<int32_t>(value - other.value); }
+
+    constexpr SeqNum operator+(uint32_t n) const { return SeqNum(value + n); }
+    constexpr SeqNum& operator++() {
+        ++value;
+        return *this;
+    }
+
+    friend constexpr bool operator==(SeqNum a, SeqNum b) { return a.value == b.value; }
+    friend constexpr bool operator<(SeqNum a, SeqNum b) { return (a - b) < 0; }
+    friend constexpr bool operator>(SeqNum a, SeqNum b) { return b < a; }
+    friend constexpr bool operator<=(SeqNum a, SeqNum b) { return !(b < a); }
+    friend constexpr bool operator>=(SeqNum a, SeqNum b) { return !(a < b); }
+};
+
+/**
+ * Receive-side duplicate detection over the last Bits sequence numbers,
+ * like the IPsec/DTLS anti-replay window: the newest number accepted plus
+ * a bitmap of which of the Bits numbers ending at it were accepted.
+ *
+ * Unlike "seq < expected", a packet that arrives late or out of order but
+ * inside the window is still accepted (once), and comparisons use SeqNum
+ * so the window slides across the 2^32 wrap. Numbers older than the window
+ * are Stale: whether they were seen is no longer known. check() and
+ * accept() are O(1), branch-light and never allocate; the whole window is
+ * a few words and trivially copyable, so checkpoints store it verbatim.
+ */
+template<size_t Bits = 64>
+class ReplayWindow {
+    static_assert(Bits > 0 && Bits % 64 == 0, "window is a whole number of 64-bit words");
+
+public:
+    static constexpr size_t kBits = Bits;
+
+    enum class Verdict : uint8_t {
+        New,        // Not seen: process, then accept() on success
+        Duplicate,  // Accepted before
+        Stale       // Older than the window
+    };
+
+    Verdict check(uint32_t seq) const {
+        if (!started_) {
+            return Verdict::New;
+        }
+        const int64_t ahead = SeqNum(seq) - SeqNum(newest_);
+        if (ahead > 0) {
+            return Verdict::New;
+        }
+        const uint64_t back = static_cast<uint64_t>(-ahead);
+        if (back >= Bits) {
+            return Verdict::Stale;
+        }
+        return (words_[back / 64] >> (back % 64)) & 1 ? Verdict::Duplicate : Verdict::New;
+    }
+
+    /**
+     * Record seq as processed. A newer number slides the window forward;
+     * a Stale one is ignored.
+     */
+    void accept(uint32_t seq) {
+        if (!started_) {
+            started_ = 1;
+            newest_ = seq;
+            words_ = {};
+            words_[0] = 1;
+            return;
+        }
+        const int64_t ahead = SeqNum(seq) - SeqNum(newest_);
+        if (ahead > 0) {
+            slide(static_cast<uint64_t>(ahead));
+            newest_ = seq;
+            words_[0] |= 1;
+            return;
+        }
+        const uint64_t back = static_cast<uint64_t>(-ahead);
+        if (back < Bits) {
+            words_[back / 64] |= uint64_t{1} << (back % 64);
+        }
+    }
+
+    bool empty() const { return !started_; }
+    SeqNum newest() const { return SeqNum(newest_); }
+
+private:
+    static constexpr size_t kWords = Bits / 64;
+
+    // Bit k (word k / 64) stands for newest_ - k; move every bit up by n
+    void slide(uint64_t n) {
+        if (n >= Bits) {
+            words_ = {};
+            return;
+        }
+        const size_t word_shift = n / 64;
+        const unsigned bit_shift = n % 64;
+        for (size_t w = kWords; w-- > 0;) {
+            uint64_t value = 0;
+            if (w >= word_shift) {
+                value = words_[w - word_shift] << bit_shift;
+                if (bit_shift != 0 && w > word_shift) {
+                    value |= words_[w - word_shift - 1] >> (64 - bit_shift);
+                }
+            }
+            words_[w] = value;
+        }
+    }
+
+    uint32_t newest_ = 0;
+    uint32_t started_ = 0;  // Word-sized so the layout has no padding
+    std::array<uint64_t, kWords> words_{};
+};
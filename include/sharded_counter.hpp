@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Small dense index for the calling thread, assigned on first use.
+ * Shared by the per-thread shards of ShardedCounter and LatencyHistogram.
+ */
+inline size_t this_thread_index() {
+    static std::atomic<size_t> next{0};
+    thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+/**
+ * Monotonic metric counter incremented from many threads.
+ *
+ * A single std::atomic bounces its cache line between every core that
+ * increments it. Here each thread adds into its own cache-line-padded slot
+ * (a relaxed add on a line no other thread writes) and load() sums the
+ * slots. Threads beyond kSlots share slots, which stays correct (every add
+ * is atomic) at the cost of some contention.
+ *
+ * Reads are meant for reporting: a load() concurrent with adds sees each
+ * slot at some recent value, not one instant across all of them.
+ */
+class ShardedCounter {
+public:
+    static constexpr size_t kSlots = 16;
+
+    ShardedCounter() = default;
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void add(uint64_t n) {
+        slots_[this_thread_index() % kSlots].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void operator++(int) { add(1); }
+    ShardedCounter& operator++() {
+        add(1);
+        return *this;
+    }
+    ShardedCounter& operator+=(uint64_t n) {
+        add(n);
+        return *this;
+    }
+
+    uint64_t load() const {
+        uint64_t total = 0;
+        for (const auto& slot : slots_) {
+            total += slot.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    operator uint64_t() const { return load(); }
+
+    /**
+     * Set the total, e.g. on reset or checkpoint restore. Not atomic with
+     * respect to concurrent adds.
+     */
+    void store(uint64_t value) {
+        for (auto& slot : slots_) {
+            slot.value.store(0, std::memory_order_relaxed);
+        }
+        slots_[0].value.store(value, std::memory_order_relaxed);
+    }
+
+    ShardedCounter& operator=(uint64_t value) {
+        store(value);
+        return *this;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Slot, kSlots> slots_{};
+};
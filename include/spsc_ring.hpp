@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Bounded single-producer / single-consumer ring of trivially copyable
+ * records. The producer never blocks: try_push() fails when the ring is
+ * full and the caller decides what to drop. Head and tail live on separate
+ * cache lines so producer and consumer do not false-share.
+ *
+ * Used for the per-thread buffers of the packet tracer and the async
+ * logger, where each recording thread owns one ring and a background
+ * thread drains them all.
+ */
+template<typename T, size_t Capacity>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing requires trivially copyable T");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr size_t kCapacity = Capacity;
+
+    /**
+     * Append a record (producer thread only). False when full.
+     */
+    bool try_push(const T& value) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        slots_[head & (Capacity - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Hand every record published so far to fn, oldest first, then free
+     * their slots (consumer thread only). Returns the number consumed.
+     */
+    template<typename Fn>
+    size_t drain(Fn&& fn) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i != head; ++i) {
+            fn(slots_[i & (Capacity - 1)]);
+        }
+        tail_.store(head, std::memory_order_release);
+        return static_cast<size_t>(head - tail);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> slots_;
+    alignas(64) std::atomic<uint64_t> head_{0};  // Written by the producer
+    alignas(64) std::atomic<uint64_t> tail_{0};  // Written by the consumer
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Monte Carlo parameter sweep over the satellite/ground-station simulation.
+ * Expands a grid or random-sampling spec into parameter points, runs
+ * several independently seeded simulations per point concurrently as
+ * coroutine agents on one pool spanning all cores, and summarizes each
+ * metric per point as mean with a 95% confidence interval.
+ *
+ * Runs are wall-clock (the simulation has no virtual clock); parallelism
+ * comes from packing many runs onto the pool at once.
+ *
+ * Spec format, one "key = value" per line, '#' starts a comment:
+ *
+ *   mode = grid                    # grid | random
+ *   samples = 20                   # random mode: points to draw
+ *   replicas = 5                   # seeded runs per point
+ *   duration_sec = 5
+ *   loss = 0.01, 0.05, 0.1         # explicit values
+ *   ack_timeout_ms = 200..600 step 100
+ *   latency_ms = uniform(50, 200)  # random mode only
+ *
+ * Swept parameters: telemetry_rate_hz, loss, latency_ms, jitter_ms,
+ * ack_timeout_ms, max_retries. Unlisted parameters keep the base value.
+ */
+class ParameterSweep {
+public:
+    /**
+     * One simulation configuration.
+     */
+    struct Point {
+        double telemetry_rate_hz = 5.0;
+        double loss = 0.05;
+        double latency_ms = 100;
+        double jitter_ms = 30;
+        double ack_timeout_ms = 410;
+        double max_retries = 3;
+    };
+
+    struct Axis {
+        std::string name;
+        std::vector<double> values;  // Grid values / random choices
+        bool uniform = false;        // Random mode: draw from [lo, hi)
+        double lo = 0.0;
+        double hi = 0.0;
+    };
+
+    struct Spec {
+        enum class Mode { Grid, Random };
+        Mode mode = Mode::Grid;
+        size_t samples = 16;
+        size_t replicas = 5;
+        double duration_sec = 5.0;
+        size_t max_concurrent = 64;  // Runs in flight at once
+        size_t num_workers = 0;      // 0 = hardware concurrency
+        unsigned int seed = 42;
+        Point base;
+        std::vector<Axis> axes;
+    };
+
+    // Per-run metrics, in CSV column order
+    enum Metric {
+        TelemetrySent,
+        TelemetryReceived,
+        TelemetryPerSec,
+        SatRetries,
+        NaksReceived,
+        CommandsSent,
+        GsRetries,
+        PacketsSent,
+        PacketsDropped,
+        DropRate,
+        RecordsStored,
+        kNumMetrics
+    };
+    static const char* metric_name(Metric m);
+
+    struct Stat {
+        double mean = 0.0;
+        double stddev = 0.0;
+        double ci95 = 0.0;  // Half-width (Student t)
+    };
+
+    struct Summary {
+        Point point;
+        size_t runs = 0;
+        std::array<Stat, kNumMetrics> stats;
+    };
+
+    /**
+     * Parse a spec, starting from base. Throws std::runtime_error on
+     * unknown keys or malformed values.
+     */
+    static Spec parse_spec(std::istream& in, const Point& base);
+
+    /**
+     * Mean, sample standard deviation and 95% CI half-width.
+     */
+    static Stat summarize(const std::vector<double>& samples);
+
+    explicit ParameterSweep(const Spec& spec);
+
+    const std::vector<Point>& points() const { return points_; }
+    size_t total_runs() const { return points_.size() * spec_.replicas; }
+
+    /**
+     * Run every (point, replica) and summarize per point. progress is
+     * called after each batch with (runs done, total runs).
+     */
+    std::vector<Summary> run(std::function<void(size_t, size_t)> progress = {});
+
+    static void write_csv(std::ostream& out, const std::vector<Summary>& summaries);
+
+private:
+    static void set_param(Point& point, const std::string& name, double value);
+
+    Spec spec_;
+    std::vector<Point> points_;
+};
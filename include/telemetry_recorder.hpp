@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Onboard store-and-forward telemetry recorder.
+ * Bounded FIFO of fixed-size records in a single preallocated arena,
+ * optionally backed by a memory-mapped file so stored telemetry survives
+ * a restart. When full, the oldest record is overwritten.
+ * Not thread-safe (owned by the satellite thread).
+ */
+class TelemetryRecorder {
+public:
+    struct Config {
+        size_t capacity = 4096;     // Maximum stored records
+        size_t record_size = 256;   // Slot size in bytes, including 2-byte length prefix
+        std::string backing_file;   // mmap-backed store if set, heap arena otherwise
+    };
+
+    /**
+     * Create recorder. Throws std::runtime_error if the backing file
+     * cannot be created or mapped. A resumed recording with an invalid
+     * header or record length is discarded (counted in rejected()).
+     */
+    explicit TelemetryRecorder(const Config& config);
+    ~TelemetryRecorder();
+
+    // Non-copyable, non-movable (owns the arena mapping)
+    TelemetryRecorder(const TelemetryRecorder&) = delete;
+    TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+
+    /**
+     * Append a record, overwriting the oldest one when full.
+     *
+     * @return false if the record does not fit in a slot (counted in rejected())
+     */
+    bool store(const std::string& record);
+
+    /**
+     * Copy the oldest record into out without removing it.
+     *
+     * @return false if the recorder is empty
+     */
+    bool peek(std::string& out) const;
+
+    /**
+     * Copy the index-th oldest record into out.
+     *
+     * @return false if index is past the newest record
+     */
+    bool peek(size_t index, std::string& out) const;
+
+    /**
+     * Discard the oldest record.
+     */
+    void pop();
+
+    /**
+     * Discard the index-th oldest record, keeping the others in order.
+     * Shifts the index records before it, so meant for small indices.
+     */
+    void erase(size_t index);
+
+    /**
+     * Discard every record and reset the overwrite count.
+     */
+    void clear();
+
+    size_t size() const { return header_->count; }
+    size_t capacity() const { return config_.capacity; }
+    bool empty() const { return header_->count == 0; }
+    double fill_ratio() const;
+    uint64_t overwritten() const { return header_->overwritten; }
+    uint64_t rejected() const { return rejected_; }  // Too large for a slot or corrupt on resume, this session
+    bool file_backed() const { return mapping_ != nullptr; }
+
+    /**
+     * Largest record that fits in a slot.
+     */
+    size_t max_record_size() const { return config_.record_size - kLengthPrefix; }
+
+private:
+    // Arena header; persisted at the start of the file mapping
+    struct Header {
+        uint32_t magic;
+        uint32_t record_size;
+        uint64_t capacity;
+        uint64_t head;         // Index of oldest record
+        uint64_t count;        // Number of stored records
+        uint64_t overwritten;  // Records lost to wraparound
+    };
+
+    static constexpr uint32_t kMagic = 0x54524543;  // "TREC"
+    static constexpr size_t kLengthPrefix = 2;
+
+    uint8_t* slot(size_t index) const;
+    size_t length_at(size_t index) const;  // Stored length of the index-th oldest record
+    void map_file();
+
+    Config config_;
+    size_t arena_bytes_{0};
+    uint8_t* arena_{nullptr};   // Header followed by capacity * record_size bytes
+    std::unique_ptr<uint8_t[]> heap_arena_;
+    void* mapping_{nullptr};    // Non-null when file-backed
+    Header* header_{nullptr};
+    uint64_t rejected_{0};
+};
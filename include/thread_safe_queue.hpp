@@ -5,6 +5,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <optional>
+#include <vector>
 
 /**
  * Thread-safe MPMC queue for inter-thread communication.
@@ -70,6 +71,55 @@ public:
         return value;
     }
 
+    /**
+     * Pop the front item only if it satisfies pred, without blocking.
+     */
+    template<typename Pred>
+    std::optional<T> try_pop_if(Pred pred) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty() || !pred(queue_.front())) {
+            return std::nullopt;
+        }
+        T value = std::move(queue_.front());
+        queue_.pop();
+        return value;
+    }
+
+    /**
+     * Apply fn to the front item without removing it (nullopt if empty).
+     */
+    template<typename Fn>
+    auto peek(Fn fn) const -> std::optional<decltype(fn(std::declval<const T&>()))> {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return std::nullopt;
+        }
+        return fn(queue_.front());
+    }
+
+    /**
+     * Copy of every queued item, front first.
+     */
+    std::vector<T> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::queue<T> copy = queue_;
+        std::vector<T> items;
+        items.reserve(copy.size());
+        while (!copy.empty()) {
+            items.push_back(std::move(copy.front()));
+            copy.pop();
+        }
+        return items;
+    }
+
+    /**
+     * Discard every queued item.
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_ = std::queue<T>();
+    }
+
     /**
      * Check if queue is empty (snapshot, may change immediately).
      */
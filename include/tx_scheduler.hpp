@@ -0,0 +1,137 @@
+#pragma once
+
+#include "hdr_histogram.hpp"
+#include "packet.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+/**
+ * Traffic classes for satellite downlink, highest priority first.
+ */
+enum class TrafficClass : uint8_t {
+    Ack = 0,           // ACK/NAK responses to uplinked commands
+    Event = 1,         // Anomaly and state-change events
+    Housekeeping = 2,  // Periodic telemetry
+    Playback = 3       // Recorder playback (bulk)
+};
+
+constexpr size_t kNumTrafficClasses = 4;
+
+/**
+ * Get human-readable traffic class name.
+ */
+inline const char* traffic_class_name(TrafficClass cls) {
+    switch (cls) {
+        case TrafficClass::Ack: return "ack";
+        case TrafficClass::Event: return "event";
+        case TrafficClass::Housekeeping: return "housekeeping";
+        case TrafficClass::Playback: return "playback";
+        default: return "unknown";
+    }
+}
+
+/**
+ * QoS transmit scheduler in front of the downlink.
+ * Per-class FIFO queues served by strict priority or deficit round robin
+ * (weighted fair), shaped by a token bucket when a rate limit is set.
+ * Records per-class queue residency for tail-latency reporting.
+ * Not thread-safe (owned by the sending thread).
+ */
+class TxScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Policy {
+        StrictPriority,  // Always serve the highest non-empty class
+        WeightedFair     // Deficit round robin by class weight
+    };
+
+    struct Config {
+        Policy policy = Policy::StrictPriority;
+        std::array<uint32_t, kNumTrafficClasses> weights = {8, 4, 2, 1};
+        double rate_bytes_per_sec = 0.0;  // Token bucket rate; 0 = unlimited
+        size_t burst_bytes = 512;         // Token bucket depth
+        size_t queue_limit = 1024;        // Per-class limit; oldest dropped beyond
+    };
+
+    /**
+     * Queue residency statistics for one traffic class.
+     */
+    struct ClassStats {
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        double p50_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+    };
+
+    explicit TxScheduler(const Config& config);
+
+    /**
+     * Queue a packet for transmission in the given class.
+     */
+    void enqueue(TrafficClass cls, Packet pkt, Clock::time_point now);
+
+    /**
+     * Next packet to transmit, or nullopt if all queues are empty or the
+     * token bucket has no credit at this time.
+     */
+    std::optional<Packet> dequeue(Clock::time_point now);
+
+    /**
+     * Check whether a packet with this sequence number is still queued.
+     */
+    bool queued(TrafficClass cls, uint32_t seq) const;
+
+    /**
+     * Copy of the packets queued in one class, oldest first.
+     */
+    std::vector<Packet> queued_packets(TrafficClass cls) const;
+
+    /**
+     * Drop all queued packets and statistics, as if freshly constructed.
+     */
+    void reset();
+
+    size_t pending() const;
+    size_t pending(TrafficClass cls) const { return queues_[index(cls)].size(); }
+
+    /**
+     * Residency statistics (snapshot; call from the owning thread or after it stops).
+     */
+    ClassStats stats(TrafficClass cls) const;
+
+private:
+    struct Entry {
+        Packet pkt;
+        Clock::time_point enqueued;
+    };
+
+    static constexpr size_t kQuantumBytes = 256;
+
+    static size_t index(TrafficClass cls) { return static_cast<size_t>(cls); }
+    static size_t wire_size(const Packet& pkt) { return 13 + pkt.payload.size(); }
+
+    void refill(Clock::time_point now);
+
+    Config config_;
+    std::array<std::deque<Entry>, kNumTrafficClasses> queues_;
+
+    // Deficit round robin state
+    std::array<size_t, kNumTrafficClasses> deficit_{};
+    size_t rr_{0};
+    bool granted_{false};
+
+    // Token bucket (may go negative to admit packets larger than the burst)
+    double tokens_{0.0};
+    std::optional<Clock::time_point> last_refill_;
+
+    // Per-class metrics; residency covers every packet sent in fixed memory
+    std::array<uint64_t, kNumTrafficClasses> sent_{};
+    std::array<uint64_t, kNumTrafficClasses> dropped_{};
+    std::array<LatencyHistogram, kNumTrafficClasses> residency_;
+};
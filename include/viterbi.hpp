@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The standard K=7, rate 1/2 convolutional code (generators 171 and 133
+ * octal, as flown since Voyager and used in CCSDS telemetry) with a
+ * soft-decision Viterbi decoder.
+ *
+ * Frames are terminated: the encoder appends K-1 zero bits, so a frame of
+ * n data bytes becomes encoded_symbols(n) channel symbols and the decoder
+ * traces back from the known final state. Neither output is inverted (CCSDS
+ * inverts the second one).
+ *
+ * Symbols are soft values, one per byte: 0 is a confident 0, 255 a
+ * confident 1 and 128 no information (an erasure). The decoder keeps 64
+ * path metrics as 16-bit integers and runs the add-compare-select
+ * butterflies 8 (SSE2) or 16 (AVX2) states at a time; every kernel makes
+ * the same decisions as the scalar reference, bit for bit.
+ */
+namespace viterbi {
+
+constexpr unsigned kConstraint = 7;
+constexpr unsigned kPolyA = 0171;
+constexpr unsigned kPolyB = 0133;
+
+/**
+ * Channel symbols for a frame of data_bytes bytes, tail included.
+ */
+constexpr size_t encoded_symbols(size_t data_bytes) {
+    return 2 * (8 * data_bytes + kConstraint - 1);
+}
+
+/**
+ * Encode n bytes, most significant bit first. Returns encoded_symbols(n)
+ * symbols, each 0 or 255: the soft values of a noiseless channel.
+ */
+std::vector<uint8_t> encode(const uint8_t* data, size_t n);
+
+enum class Kernel : uint8_t { Scalar, Sse2, Avx2 };
+
+/**
+ * Whether this CPU (and build) can run the kernel.
+ */
+bool supported(Kernel kernel);
+
+/**
+ * Kernel decode() uses by default: the widest supported.
+ */
+Kernel best_kernel();
+
+const char* kernel_name(Kernel kernel);
+
+/**
+ * Decode encoded_symbols(n) soft symbols into n bytes: the most likely
+ * transmitted frame, whatever the noise.
+ */
+void decode(const uint8_t* symbols, size_t n, uint8_t* out);
+void decode(const uint8_t* symbols, size_t n, uint8_t* out, Kernel kernel);
+
+} // namespace viterbi
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "chase_lev_deque.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size work-stealing thread pool.
+ * Each worker owns a Chase-Lev deque: tasks spawned from a worker go to its
+ * own deque (LIFO, cache-warm), idle workers steal from the top of other
+ * workers' deques. Tasks submitted from outside the pool, and agents that
+ * yield, go through a shared FIFO injection queue so they cannot starve
+ * local work. Delayed tasks wait in a timer heap until due.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * What an agent wants after one step.
+     */
+    struct AgentStep {
+        enum class Kind { Yield, Sleep, Done };
+        Kind kind;
+        Clock::time_point wake;
+
+        static AgentStep yield() { return {Kind::Yield, {}}; }
+        static AgentStep sleep_until(Clock::time_point t) { return {Kind::Sleep, t}; }
+        static AgentStep sleep_for(Clock::duration d) { return {Kind::Sleep, Clock::now() + d}; }
+        static AgentStep done() { return {Kind::Done, {}}; }
+    };
+
+    using Agent = std::function<AgentStep()>;
+
+    /**
+     * Create pool with num_workers threads (0 = hardware concurrency).
+     */
+    explicit WorkStealingPool(size_t num_workers = 0);
+
+    /**
+     * Stops workers; tasks not yet started are discarded.
+     */
+    ~WorkStealingPool();
+
+    // Non-copyable, non-movable
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * Run a task as soon as possible (thread-safe).
+     */
+    void submit(Task task);
+
+    /**
+     * Run a task after work that is already runnable (thread-safe). Goes
+     * through the shared FIFO rather than the caller's LIFO deque, so a
+     * task that keeps resubmitting itself cannot starve its neighbours.
+     */
+    void submit_fair(Task task);
+
+    /**
+     * Run a task no earlier than the given time (thread-safe).
+     */
+    void submit_at(Clock::time_point when, Task task);
+
+    /**
+     * Run an agent: step() is called repeatedly as a task, rescheduled
+     * according to its AgentStep result until it returns done().
+     */
+    void spawn_agent(Agent agent);
+
+    /**
+     * Block until no tasks are queued, running or waiting on a timer.
+     */
+    void wait_idle();
+
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * Index of the calling worker, or -1 when called from outside the pool.
+     */
+    int current_worker() const;
+
+    // Metrics
+    uint64_t get_tasks_executed() const { return tasks_executed_; }
+    uint64_t get_steals() const { return steals_; }
+
+private:
+    struct Worker {
+        ChaseLevDeque<Task*> deque;
+        std::thread thread;
+    };
+
+    struct Timer {
+        Clock::time_point when;
+        uint64_t order;
+        Task* task;
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : order > other.order;
+        }
+    };
+
+    void run_worker(size_t index);
+    Task* find_task(size_t index, uint64_t& rng);
+    void fire_due_timers(size_t index);
+    void inject(Task* task);
+    void wake_one();
+    void run_agent_step(std::shared_ptr<Agent> agent);
+    void task_finished();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{true};
+
+    // Injection queue for external submissions and yielded agents
+    std::mutex inject_mutex_;
+    std::deque<Task*> injected_;
+    std::atomic<size_t> injected_count_{0};
+
+    // Timer heap; next_timer_ns_ lets workers skip the lock when nothing is due
+    std::mutex timer_mutex_;
+    std::vector<Timer> timers_;
+    uint64_t timer_order_{0};
+    std::atomic<int64_t> next_timer_ns_{INT64_MAX};
+
+    // Idle workers park here; work_epoch_ counts pushes so a worker can tell
+    // whether anything arrived between its last search and parking
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<int> sleeping_{0};
+    std::atomic<uint64_t> work_epoch_{0};
+
+    // Outstanding work for wait_idle()
+    std::atomic<int64_t> outstanding_{0};
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+
+    std::atomic<uint64_t> tasks_executed_{0};
+    std::atomic<uint64_t> steals_{0};
+};
@@ -0,0 +1,225 @@
+#include "async_logger.hpp"
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace logging {
+
+namespace {
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+template<typename... Values>
+void append_printf(std::string& out, const std::string& spec, Values... values) {
+    char buf[128];
+    int len = std::snprintf(buf, sizeof(buf), spec.c_str(), values...);
+    if (len > 0) {
+        out.append(buf, std::min<size_t>(static_cast<size_t>(len), sizeof(buf) - 1));
+    }
+}
+
+} // namespace
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+}
+
+void AsyncLogger::format(const Record& rec, std::string& out) {
+    size_t next_arg = 0;
+    for (const char* p = rec.fmt; *p; ++p) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            ++p;
+            continue;
+        }
+
+        // Flags, width and precision pass through; length modifiers are
+        // dropped since arguments are stored widened
+        std::string spec = "%";
+        const char* q = p + 1;
+        while (*q && std::strchr("-+ #0123456789.", *q)) {
+            spec += *q++;
+        }
+        while (*q && std::strchr("hlLqjzt", *q)) {
+            ++q;
+        }
+        const char conv = *q;
+        if (!conv) {
+            break;
+        }
+        p = q;
+
+        if (next_arg >= rec.nargs) {
+            out += "<?>";
+            continue;
+        }
+        const Arg& arg = rec.args[next_arg];
+        const Kind kind = rec.kinds[next_arg++];
+        switch (conv) {
+            case 'd':
+            case 'i':
+                append_printf(out, spec + "lld",
+                              kind == Kind::Double ? static_cast<long long>(arg.d) : static_cast<long long>(arg.i));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                append_printf(out, spec + "ll" + conv,
+                              kind == Kind::Double ? static_cast<unsigned long long>(arg.d)
+                                                   : static_cast<unsigned long long>(arg.u));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                append_printf(out, spec + conv,
+                              kind == Kind::Double ? arg.d
+                              : kind == Kind::Int  ? static_cast<double>(arg.i)
+                                                   : static_cast<double>(arg.u));
+                break;
+            case 'c':
+                out += static_cast<char>(arg.i);
+                break;
+            default:  // 's', or anything else: print the value as is
+                if (kind == Kind::String) {
+                    append_printf(out, spec + ".*s", static_cast<int>(arg.s.length), rec.text + arg.s.offset);
+                } else if (kind == Kind::Double) {
+                    append_printf(out, "%g", arg.d);
+                } else if (kind == Kind::Int) {
+                    append_printf(out, "%lld", static_cast<long long>(arg.i));
+                } else {
+                    append_printf(out, "%llu", static_cast<unsigned long long>(arg.u));
+                }
+                break;
+        }
+    }
+}
+
+void AsyncLogger::start(std::ostream& out, std::chrono::milliseconds flush_interval) {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    if (active_ || flusher_.joinable()) {
+        throw std::runtime_error("Logger already running");
+    }
+    out_ = &out;
+    lines_written_ = 0;
+    lines_dropped_ = 0;
+    stopping_ = false;
+    generation_++;
+    active_ = true;
+    flusher_ = std::thread(&AsyncLogger::flush_loop, this, flush_interval);
+}
+
+void AsyncLogger::stop() {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        if (!flusher_.joinable()) {
+            return;
+        }
+        active_ = false;
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    flusher_.join();
+
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    drain();
+    out_ = nullptr;
+
+    // Threads still holding a ring re-register on the next start()
+    generation_++;
+    std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+    rings_.clear();
+}
+
+void AsyncLogger::submit(Record& rec) {
+    rec.ts_ns = now_ns();
+    if (!active()) {
+        // No writer: format inline so the line is not lost
+        static std::mutex cout_mutex;
+        std::string line;
+        format(rec, line);
+        std::lock_guard<std::mutex> lock(cout_mutex);
+        std::cout << line << std::endl;
+        return;
+    }
+    if (!local_ring()->records.try_push(rec)) {
+        lines_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AsyncLogger::Ring* AsyncLogger::local_ring() {
+    struct Local {
+        std::shared_ptr<Ring> ring;
+        uint64_t generation = 0;
+    };
+    thread_local Local local;
+
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (local.generation != generation || !local.ring) {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+        local.ring = std::move(ring);
+        local.generation = generation;
+    }
+    return local.ring.get();
+}
+
+void AsyncLogger::flush_loop(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    while (!stopping_) {
+        flush_cv_.wait_for(lock, interval, [this] { return stopping_; });
+        drain();
+    }
+}
+
+void AsyncLogger::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    // Interleave threads in the order their lines were logged
+    batch_.clear();
+    for (const auto& ring : rings) {
+        ring->records.drain([this](const Record& rec) { batch_.push_back(rec); });
+    }
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const Record& a, const Record& b) { return a.ts_ns < b.ts_ns; });
+
+    if (!batch_.empty()) {
+        std::string text;
+        for (const Record& rec : batch_) {
+            format(rec, text);
+            text += '\n';
+        }
+        out_->write(text.data(), static_cast<std::streamsize>(text.size()));
+        out_->flush();
+        lines_written_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    }
+    rings.clear();
+
+    // Forget rings whose threads have exited once they are empty
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    std::erase_if(rings_, [](const std::shared_ptr<Ring>& ring) {
+        return ring.use_count() == 1 && ring->records.empty();
+    });
+}
+
+} // namespace logging
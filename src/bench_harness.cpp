@@ -0,0 +1,213 @@
+#include "bench_harness.hpp"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace bench {
+
+namespace {
+
+double elapsed_ns(const Harness::Body& body, uint64_t iters) {
+    auto start = std::chrono::steady_clock::now();
+    body(iters);
+    auto end = std::chrono::steady_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+void Harness::add(std::string name, Body body, double bytes_per_op) {
+    entries_.push_back({std::move(name), std::move(body), bytes_per_op});
+}
+
+std::vector<Harness::Result> Harness::run() const {
+    std::vector<Result> results;
+    for (const auto& entry : entries_) {
+        if (!options_.filter.empty() && entry.name.find(options_.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(measure(entry.name, entry.body, entry.bytes_per_op));
+    }
+    return results;
+}
+
+Harness::Result Harness::measure(const std::string& name, const Body& body, double bytes_per_op) const {
+    // Grow the iteration count until one repetition is long enough to
+    // swamp timer overhead
+    const double target = static_cast<double>(options_.min_rep_time.count());
+    uint64_t iters = 1;
+    for (double ns = elapsed_ns(body, iters); ns < target; ns = elapsed_ns(body, iters)) {
+        double scale = ns > 0.0 ? std::min(10.0, std::max(2.0, 1.2 * target / ns)) : 10.0;
+        iters = static_cast<uint64_t>(static_cast<double>(iters) * scale);
+    }
+
+    for (int i = 0; i < options_.warmup_reps; ++i) {
+        body(iters);
+    }
+
+    // Counters bracket each timed repetition and are summed over them
+    std::unique_ptr<PerfCounters> counters;
+    if (options_.counters) {
+        counters = std::make_unique<PerfCounters>();
+    }
+    Result result;
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(std::max(1, options_.reps)));
+    for (int i = 0; i < std::max(1, options_.reps); ++i) {
+        if (counters && counters->available()) {
+            counters->start();
+            samples.push_back(elapsed_ns(body, iters) / static_cast<double>(iters));
+            PerfCounters::Sample rep = counters->stop();
+            for (int c = 0; c < PerfCounters::kNumCounters; ++c) {
+                result.counters.values[c] += rep.values[c];
+                result.counters.valid[c] = rep.valid[c];
+            }
+            result.counted_ops += iters;
+        } else {
+            samples.push_back(elapsed_ns(body, iters) / static_cast<double>(iters));
+        }
+    }
+
+    result.name = name;
+    result.iters_per_rep = iters;
+    result.bytes_per_op = bytes_per_op;
+    summarize(std::move(samples), result);
+    return result;
+}
+
+void Harness::summarize(std::vector<double> samples, Result& result) {
+    result.reps = static_cast<int>(samples.size());
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    result.median_ns = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    // Nearest-rank percentile
+    size_t rank = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(n)));
+    result.p99_ns = samples[std::max<size_t>(rank, 1) - 1];
+    result.min_ns = samples.front();
+    result.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(n);
+    if (result.bytes_per_op > 0.0 && result.median_ns > 0.0) {
+        result.bytes_per_sec = result.bytes_per_op * 1e9 / result.median_ns;
+    }
+}
+
+void Harness::print_table(std::ostream& out, const std::vector<Result>& results) {
+    size_t width = 9;
+    bool counted = false;
+    for (const auto& r : results) {
+        width = std::max(width, r.name.size());
+        counted = counted || r.counted_ops > 0;
+    }
+
+    auto flags = out.flags();
+    out << std::left << std::setw(static_cast<int>(width)) << "benchmark" << std::right
+        << std::setw(14) << "median ns/op" << std::setw(12) << "p99 ns/op"
+        << std::setw(12) << "MB/s" << std::setw(12) << "iters/rep";
+    if (counted) {
+        out << std::setw(8) << "IPC" << std::setw(14) << "cache-miss/op" << std::setw(12) << "br-miss/op";
+    }
+    out << "\n";
+    out << std::fixed;
+    for (const auto& r : results) {
+        out << std::left << std::setw(static_cast<int>(width)) << r.name << std::right
+            << std::setprecision(1) << std::setw(14) << r.median_ns << std::setw(12) << r.p99_ns;
+        if (r.bytes_per_sec > 0.0) {
+            out << std::setw(12) << r.bytes_per_sec / 1e6;
+        } else {
+            out << std::setw(12) << "-";
+        }
+        out << std::setw(12) << r.iters_per_rep;
+        if (counted) {
+            auto column = [&](int w, int precision, bool valid, double value) {
+                if (valid) {
+                    out << std::setprecision(precision) << std::setw(w) << value;
+                } else {
+                    out << std::setw(w) << "-";
+                }
+            };
+            column(8, 2, r.ipc() > 0.0, r.ipc());
+            column(14, 3, r.has(PerfCounters::CacheMisses), r.per_op(PerfCounters::CacheMisses));
+            column(12, 3, r.has(PerfCounters::BranchMisses), r.per_op(PerfCounters::BranchMisses));
+        }
+        out << "\n";
+    }
+    out.flags(flags);
+}
+
+void Harness::write_json(std::ostream& out, const std::string& suite, const std::vector<Result>& results) {
+    bool counted = false;
+    for (const auto& r : results) counted = counted || r.counted_ops > 0;
+
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    auto flags = out.flags();
+    out << std::setprecision(6);
+    out << "{\n  \"context\": {\n"
+        << "    \"suite\": \"" << json_escape(suite) << "\",\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#if defined(__clang__)
+        << "    \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n"
+#elif defined(__GNUC__)
+        << "    \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n"
+#else
+        << "    \"compiler\": \"unknown\",\n"
+#endif
+        << "    \"hardware_counters\": " << (counted ? "true" : "false") << ",\n"
+#ifdef NDEBUG
+        << "    \"assertions\": false\n"
+#else
+        << "    \"assertions\": true\n"
+#endif
+        << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << json_escape(r.name) << "\""
+            << ", \"iterations\": " << r.iters_per_rep
+            << ", \"repetitions\": " << r.reps
+            << ", \"median_ns\": " << r.median_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"min_ns\": " << r.min_ns
+            << ", \"mean_ns\": " << r.mean_ns;
+        if (r.bytes_per_op > 0.0) {
+            out << ", \"bytes_per_op\": " << r.bytes_per_op
+                << ", \"bytes_per_second\": " << r.bytes_per_sec;
+        }
+        if (r.ipc() > 0.0) {
+            out << ", \"ipc\": " << r.ipc();
+        }
+        static constexpr const char* kPerOpKeys[PerfCounters::kNumCounters] = {
+            "cycles_per_op", "instructions_per_op", "cache_misses_per_op", "branch_misses_per_op"};
+        for (int c = 0; c < PerfCounters::kNumCounters; ++c) {
+            auto counter = static_cast<PerfCounters::Counter>(c);
+            if (r.has(counter)) {
+                out << ", \"" << kPerOpKeys[c] << "\": " << r.per_op(counter);
+            }
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace bench
@@ -0,0 +1,170 @@
+#include "checkpoint.hpp"
+#include "crc.hpp"
+#include <algorithm>
+#include <bit>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+namespace {
+
+constexpr char kMagic[7] = {'S', 'A', 'T', 'C', 'K', 'P', 'T'};
+constexpr uint8_t kVersion = 3;
+constexpr uint8_t kLittleEndian = 1;
+constexpr uint8_t kBigEndian = 2;
+constexpr uint8_t kHostOrder = std::endian::native == std::endian::little ? kLittleEndian : kBigEndian;
+constexpr char kEndTag[4] = {'E', 'N', 'D', ' '};
+
+} // namespace
+
+CheckpointWriter::CheckpointWriter(std::ostream& out) : out_(out) {
+    write(kMagic, sizeof(kMagic));
+    write(&kVersion, 1);
+    write(&kHostOrder, 1);
+}
+
+void CheckpointWriter::write(const void* data, size_t len) {
+    out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+    bytes_written_ += len;
+}
+
+void CheckpointWriter::begin(const char* tag) {
+    if (open_) {
+        throw std::logic_error("Checkpoint section already open");
+    }
+    std::memcpy(tag_, tag, sizeof(tag_));
+    buffer_.clear();
+    open_ = true;
+}
+
+void CheckpointWriter::end() {
+    if (!open_) {
+        throw std::logic_error("No checkpoint section open");
+    }
+    uint64_t len = buffer_.size();
+    uint16_t crc = crc::crc16_ccitt(reinterpret_cast<const uint8_t*>(buffer_.data()), buffer_.size());
+    write(tag_, sizeof(tag_));
+    write(&len, sizeof(len));
+    write(buffer_.data(), buffer_.size());
+    write(&crc, sizeof(crc));
+    open_ = false;
+}
+
+void CheckpointWriter::finish() {
+    begin(kEndTag);
+    end();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("Checkpoint write failed");
+    }
+}
+
+void CheckpointWriter::put_string(const std::string& s) {
+    put<uint32_t>(static_cast<uint32_t>(s.size()));
+    buffer_.append(s);
+}
+
+void CheckpointWriter::put_packet(const Packet& pkt) {
+    put_string(pkt.to_bytes());
+}
+
+void CheckpointWriter::put_rng(const std::mt19937& rng) {
+    // The standard only exposes engine state as text; store it as words.
+    // The word count is implementation-defined (libstdc++ appends the position).
+    std::stringstream ss;
+    ss << rng;
+    std::vector<uint32_t> words;
+    uint32_t word = 0;
+    while (ss >> word) {
+        words.push_back(word);
+    }
+    put_vector(words);
+}
+
+CheckpointReader::CheckpointReader(std::istream& in) : in_(in) {
+    char magic[sizeof(kMagic)];
+    uint8_t version = 0, order = 0;
+    read(magic, sizeof(magic));
+    read(&version, 1);
+    read(&order, 1);
+    if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a checkpoint file");
+    }
+    if (version != kVersion) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version));
+    }
+    if (order != kHostOrder) {
+        throw std::runtime_error("Checkpoint was written on a host of different byte order");
+    }
+}
+
+void CheckpointReader::read(void* data, size_t len) {
+    in_.read(static_cast<char*>(data), static_cast<std::streamsize>(len));
+    if (static_cast<size_t>(in_.gcount()) != len) {
+        throw std::runtime_error("Checkpoint file truncated");
+    }
+}
+
+void CheckpointReader::begin(const char* tag) {
+    char found[4];
+    uint64_t len = 0;
+    read(found, sizeof(found));
+    read(&len, sizeof(len));
+    if (std::memcmp(found, tag, sizeof(found)) != 0) {
+        throw std::runtime_error("Expected checkpoint section '" + std::string(tag, 4) +
+                                 "', found '" + std::string(found, 4) + "'");
+    }
+
+    // Grow the buffer only as bytes arrive, so a corrupt length fails as
+    // truncation instead of allocating whatever it claims up front
+    constexpr uint64_t kChunk = uint64_t{1} << 20;
+    buffer_.clear();
+    while (buffer_.size() < len) {
+        const size_t at = buffer_.size();
+        const size_t n = static_cast<size_t>(std::min(kChunk, len - at));
+        buffer_.resize(at + n);
+        read(buffer_.data() + at, n);
+    }
+    pos_ = 0;
+
+    uint16_t crc = 0;
+    read(&crc, sizeof(crc));
+    if (crc != crc::crc16_ccitt(reinterpret_cast<const uint8_t*>(buffer_.data()), buffer_.size())) {
+        throw std::runtime_error("Checkpoint section '" + std::string(tag, 4) + "' is corrupt");
+    }
+}
+
+void CheckpointReader::end() {
+    if (pos_ != buffer_.size()) {
+        throw std::runtime_error("Checkpoint section has trailing data");
+    }
+}
+
+const char* CheckpointReader::take(size_t len) {
+    if (len > buffer_.size() - pos_) {
+        throw std::runtime_error("Checkpoint section truncated");
+    }
+    const char* p = buffer_.data() + pos_;
+    pos_ += len;
+    return p;
+}
+
+std::string CheckpointReader::get_string() {
+    uint32_t len = get<uint32_t>();
+    return std::string(take(len), len);
+}
+
+Packet CheckpointReader::get_packet() {
+    return Packet::from_bytes(get_string());
+}
+
+void CheckpointReader::get_rng(std::mt19937& rng) {
+    std::stringstream ss;
+    for (uint32_t word : get_vector<uint32_t>()) {
+        ss << word << ' ';
+    }
+    ss >> rng;
+    if (!ss) {
+        throw std::runtime_error("Invalid RNG state in checkpoint");
+    }
+}
@@ -0,0 +1,321 @@
+#include "command_plan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::runtime_error plan_error(uint32_t line, const std::string& what) {
+    return std::runtime_error("Plan line " + std::to_string(line) + ": " + what);
+}
+
+double parse_number(const std::string& text, uint32_t line) {
+    size_t used = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (text.empty() || used != text.size() || !std::isfinite(value)) {
+        throw plan_error(line, "invalid number '" + text + "'");
+    }
+    return value;
+}
+
+uint32_t parse_id(const std::string& text, uint32_t line) {
+    const double value = parse_number(text, line);
+    if (value < 0 || value > UINT32_MAX || value != std::floor(value)) {
+        throw plan_error(line, "invalid satellite ID '" + text + "'");
+    }
+    return static_cast<uint32_t>(value);
+}
+
+CommandPlan::Selector parse_selector(const std::string& text, uint32_t line) {
+    CommandPlan::Selector sel;
+    if (text == "all") {
+        sel.all = true;
+        return sel;
+    }
+    std::istringstream items(text);
+    for (std::string item; std::getline(items, item, ',');) {
+        const size_t dash = item.find('-');
+        const uint32_t lo = parse_id(item.substr(0, dash), line);
+        const uint32_t hi = dash == std::string::npos ? lo : parse_id(item.substr(dash + 1), line);
+        if (hi < lo) {
+            throw plan_error(line, "empty satellite range '" + item + "'");
+        }
+        sel.ranges.emplace_back(lo, hi);
+    }
+    if (sel.ranges.empty()) {
+        throw plan_error(line, "missing satellite selector");
+    }
+    return sel;
+}
+
+CommandPlan::Field parse_field(const std::string& name, uint32_t line) {
+    static const std::pair<const char*, CommandPlan::Field> kFields[] = {
+        {"temperature_c", CommandPlan::Field::TemperatureC},
+        {"battery_pct", CommandPlan::Field::BatteryPct},
+        {"orbit_altitude_km", CommandPlan::Field::OrbitAltitudeKm},
+        {"pitch_deg", CommandPlan::Field::PitchDeg},
+        {"yaw_deg", CommandPlan::Field::YawDeg},
+        {"roll_deg", CommandPlan::Field::RollDeg},
+    };
+    for (const auto& [field_name, field] : kFields) {
+        if (name == field_name) {
+            return field;
+        }
+    }
+    throw plan_error(line, "unknown telemetry field '" + name + "'");
+}
+
+/**
+ * Consume "KEYWORD arg..." up to the first modifier word and parse it with
+ * the command registry.
+ */
+Command parse_command(const std::vector<std::string>& words, size_t& pos, uint32_t line) {
+    if (pos >= words.size()) {
+        throw plan_error(line, "missing command");
+    }
+    std::string text = words[pos++];
+    while (pos < words.size() && words[pos] != "every" && words[pos] != "times" && words[pos] != "until" &&
+           words[pos] != "cooldown") {
+        text += '|' + words[pos++];
+    }
+    try {
+        return Command::deserialize(text);
+    } catch (const std::exception& e) {
+        throw plan_error(line, e.what());
+    }
+}
+
+std::vector<RuleProgram::Rule> trigger_rules(const CommandPlan& plan) {
+    std::vector<RuleProgram::Rule> rules;
+    for (const auto& trigger : plan.triggers()) {
+        rules.push_back(trigger.rule);
+    }
+    return rules;
+}
+
+// Heap order: earliest first; ties by plan order, then satellite
+bool later(const CommandPlan::Event& a, const CommandPlan::Event& b) {
+    if (a.at_sec != b.at_sec) return a.at_sec > b.at_sec;
+    if (a.timeline != b.timeline) return a.timeline > b.timeline;
+    return a.sat_id > b.sat_id;
+}
+
+} // namespace
+
+bool CommandPlan::Selector::matches(uint32_t sat_id) const {
+    if (all) {
+        return true;
+    }
+    for (const auto& [lo, hi] : ranges) {
+        if (sat_id >= lo && sat_id <= hi) {
+            return true;
+        }
+    }
+    return false;
+}
+
+CommandPlan CommandPlan::parse(std::istream& in) {
+    CommandPlan plan;
+    std::string text;
+    uint32_t line = 0;
+    while (std::getline(in, text)) {
+        line++;
+        std::istringstream tokens(text.substr(0, text.find('#')));
+        std::vector<std::string> words;
+        for (std::string w; tokens >> w;) {
+            words.push_back(w);
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        size_t pos = 0;
+        auto expect = [&](const char* word) {
+            if (pos >= words.size() || words[pos] != word) {
+                throw plan_error(line, std::string("expected '") + word + "'");
+            }
+            pos++;
+        };
+        auto value_after = [&](const std::string& keyword) {
+            if (++pos >= words.size()) {
+                throw plan_error(line, "missing value after '" + keyword + "'");
+            }
+            return parse_number(words[pos++], line);
+        };
+
+        if (words[0] == "at") {
+            Timeline tl;
+            tl.line = line;
+            pos = 1;
+            if (pos >= words.size()) {
+                throw plan_error(line, "missing time");
+            }
+            tl.at_sec = parse_number(words[pos++], line);
+            expect("sat");
+            if (pos >= words.size()) {
+                throw plan_error(line, "missing satellite selector");
+            }
+            tl.sats = parse_selector(words[pos++], line);
+            tl.cmd = parse_command(words, pos, line);
+            while (pos < words.size()) {
+                const std::string keyword = words[pos];
+                if (keyword == "every") {
+                    tl.every_sec = value_after(keyword);
+                } else if (keyword == "times") {
+                    const double times = value_after(keyword);
+                    if (times < 1 || times > UINT32_MAX - 1 || times != std::floor(times)) {
+                        throw plan_error(line, "times must be a positive integer");
+                    }
+                    tl.times = static_cast<uint32_t>(times);
+                } else if (keyword == "until") {
+                    tl.until_sec = value_after(keyword);
+                } else {
+                    throw plan_error(line, "unexpected '" + keyword + "'");
+                }
+            }
+            if (tl.at_sec < 0) {
+                throw plan_error(line, "negative time");
+            }
+            if (tl.every_sec < 0 || ((tl.times > 0 || tl.until_sec != kForever) && tl.every_sec <= 0)) {
+                throw plan_error(line, "repeat needs a positive 'every'");
+            }
+            plan.timelines_.push_back(std::move(tl));
+        } else if (words[0] == "when") {
+            Trigger tr;
+            tr.line = line;
+            RuleProgram::Rule& rule = tr.rule;
+            pos = 1;
+            if (pos >= words.size()) {
+                throw plan_error(line, "missing telemetry field");
+            }
+            rule.field = parse_field(words[pos++], line);
+            if (pos < words.size() && words[pos] == "rate") {
+                rule.rate = true;
+                pos++;
+            }
+            if (pos + 1 >= words.size() || (words[pos] != "<" && words[pos] != ">")) {
+                throw plan_error(line, "expected '<' or '>' and a threshold");
+            }
+            rule.above = words[pos++] == ">";
+            rule.threshold = parse_number(words[pos++], line);
+            if (pos < words.size() && words[pos] == "clear") {
+                rule.clear = value_after("clear");
+                if (rule.above ? rule.clear > rule.threshold : rule.clear < rule.threshold) {
+                    throw plan_error(line, "clear level must be on the far side of the threshold");
+                }
+            }
+            expect("sat");
+            if (pos >= words.size()) {
+                throw plan_error(line, "missing satellite selector");
+            }
+            tr.sats = parse_selector(words[pos++], line);
+            rule.cmd = parse_command(words, pos, line);
+            while (pos < words.size()) {
+                const std::string keyword = words[pos];
+                if (keyword == "cooldown") {
+                    rule.cooldown_sec = value_after(keyword);
+                    if (rule.cooldown_sec <= 0) {
+                        throw plan_error(line, "cooldown must be positive");
+                    }
+                } else {
+                    throw plan_error(line, "unexpected '" + keyword + "'");
+                }
+            }
+            plan.triggers_.push_back(std::move(tr));
+        } else {
+            throw plan_error(line, "expected 'at' or 'when', got '" + words[0] + "'");
+        }
+    }
+    return plan;
+}
+
+std::vector<CommandPlan::Event> CommandPlan::compile(const std::vector<uint32_t>& sat_ids) const {
+    std::vector<uint32_t> sorted = sat_ids;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    std::vector<Event> events;
+    for (uint32_t t = 0; t < timelines_.size(); ++t) {
+        const Timeline& tl = timelines_[t];
+        if (tl.at_sec > tl.until_sec) {
+            continue;
+        }
+        const uint32_t remaining = tl.every_sec <= 0 ? 0 : tl.times == 0 ? UINT32_MAX : tl.times - 1;
+        auto add = [&](uint32_t sat_id) { events.push_back(Event{tl.at_sec, sat_id, t, remaining}); };
+        if (tl.sats.all) {
+            for (uint32_t id : sorted) add(id);
+            continue;
+        }
+        for (const auto& [lo, hi] : tl.sats.ranges) {
+            // Walk only the listed IDs inside the range
+            for (auto it = std::lower_bound(sorted.begin(), sorted.end(), lo); it != sorted.end() && *it <= hi; ++it) {
+                add(*it);
+            }
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return later(b, a); });
+    return events;
+}
+
+PlanScheduler::PlanScheduler(const CommandPlan& plan, const std::vector<uint32_t>& sat_ids)
+    : plan_(plan),
+      heap_(plan.compile(sat_ids)),  // Ascending order already satisfies the min-heap invariant
+      rules_(trigger_rules(plan), sat_ids,
+             [&plan](size_t r, uint32_t sat_id) { return plan.triggers()[r].sats.matches(sat_id); }) {}
+
+size_t PlanScheduler::dispatch(double now_sec, const Dispatch& fn) {
+    size_t n = 0;
+    while (!heap_.empty() && heap_.front().at_sec <= now_sec) {
+        std::pop_heap(heap_.begin(), heap_.end(), later);
+        CommandPlan::Event event = heap_.back();
+        heap_.pop_back();
+        const CommandPlan::Timeline& tl = plan_.timelines()[event.timeline];
+        fn(event.sat_id, tl.cmd);
+        n++;
+
+        if (event.remaining > 0 && event.at_sec + tl.every_sec <= tl.until_sec) {
+            event.at_sec += tl.every_sec;
+            if (event.remaining != UINT32_MAX) {
+                event.remaining--;
+            }
+            heap_.push_back(event);
+            std::push_heap(heap_.begin(), heap_.end(), later);
+        }
+    }
+    dispatched_ += n;
+    return n;
+}
+
+void PlanScheduler::resume(std::vector<CommandPlan::Event> events, uint64_t dispatched) {
+    for (const CommandPlan::Event& event : events) {
+        if (event.timeline >= plan_.timelines().size()) {
+            throw std::runtime_error("Plan event for unknown timeline " + std::to_string(event.timeline));
+        }
+    }
+    heap_ = std::move(events);
+    std::make_heap(heap_.begin(), heap_.end(), later);
+    dispatched_ = dispatched;
+}
+
+size_t PlanScheduler::on_telemetry(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn) {
+    return queue_telemetry(sat_id, t, now_sec, fn) + evaluate_triggers(fn);
+}
+
+size_t PlanScheduler::queue_telemetry(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn) {
+    const size_t n = rules_.add_sample(sat_id, t, now_sec, fn);
+    dispatched_ += n;
+    return n;
+}
+
+size_t PlanScheduler::evaluate_triggers(const Dispatch& fn) {
+    const size_t n = rules_.evaluate(fn);
+    dispatched_ += n;
+    return n;
+}
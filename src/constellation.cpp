@@ -0,0 +1,694 @@
+#include "constellation.hpp"
+#include "checkpoint.hpp"
+#include "counter_rng.hpp"
+#include "packet_trace.hpp"
+#include "telemetry.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+using counter_rng::mix64;
+
+/**
+ * Counter-based uniform noise in [-0.5, 0.5) keyed by (seed, satellite, tick, stream).
+ */
+inline double noise(uint64_t seed, uint64_t sat, uint64_t tick, uint64_t stream) {
+    uint64_t h = mix64(seed ^ mix64(sat * 4 + stream) ^ (tick * 0xD1B54A32D192ED03ULL));
+    return static_cast<double>(h >> 11) * 0x1.0p-53 - 0.5;
+}
+
+} // namespace
+
+ConstellationEngine::ConstellationEngine(const Config& config, std::vector<Link*> links)
+    : config_(config), links_(std::move(links)) {
+    const size_t n = config_.num_satellites;
+    if (!links_.empty() && links_.size() != n) {
+        throw std::runtime_error("Constellation needs one link per satellite");
+    }
+    if (config_.tick_hz <= 0.0 || config_.telemetry_rate_hz <= 0.0) {
+        throw std::runtime_error("Constellation rates must be positive");
+    }
+
+    num_workers_ = config_.num_workers ? config_.num_workers
+                                       : std::max(1u, std::thread::hardware_concurrency());
+    num_workers_ = std::max<size_t>(1, std::min(num_workers_, std::max<size_t>(1, n)));
+    dt_ = 1.0 / config_.tick_hz;
+    telemetry_period_ticks_ = std::max<uint64_t>(
+        1, static_cast<uint64_t>(config_.tick_hz / config_.telemetry_rate_hz + 0.5));
+    ack_timeout_ticks_ = std::max<uint64_t>(
+        1, static_cast<uint64_t>(config_.ack_timeout_ms * config_.tick_hz / 1000.0 + 0.999));
+
+    temperature_c_.assign(n, 50.0);
+    battery_pct_.assign(n, 90.0);
+    orbit_altitude_km_.assign(n, 400.0);
+    pitch_deg_.assign(n, 0.0);
+    yaw_deg_.assign(n, 0.0);
+    roll_deg_.assign(n, 0.0);
+    safe_mode_.assign(n, 0);
+    safe_mode_prev_.assign(n, 0);
+    tx_seq_.assign(n, 0);
+    rx_window_.assign(n, ReplayWindow<>{});
+    awaiting_ack_.assign(n, 0);
+    attempts_.assign(n, 0);
+    ack_deadline_tick_.assign(n, 0);
+    pending_.resize(links_.empty() ? 0 : n);
+    pending_dirty_.assign(pending_.size(), 1);
+
+
+    // Everything is dirty until the first capture
+    num_blocks_ = (n + kDirtyBlock - 1) / kDirtyBlock;
+    dirty_ = std::make_unique<std::atomic<uint8_t>[]>(num_blocks_);
+    for (size_t b = 0; b < num_blocks_; ++b) {
+        dirty_[b].store(1, std::memory_order_relaxed);
+    }
+}
+
+ConstellationEngine::~ConstellationEngine() {
+    stop();
+}
+
+void ConstellationEngine::start() {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    exit_requested_ = false;
+    {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        ticking_ = true;
+    }
+    barrier_ = std::make_unique<std::barrier<TickDone>>(
+        static_cast<std::ptrdiff_t>(num_workers_), TickDone{this});
+    tick_start_ = std::chrono::steady_clock::now();
+    next_tick_ = tick_start_;
+    for (size_t w = 0; w < num_workers_; ++w) {
+        workers_.emplace_back(&ConstellationEngine::run_worker, this, w);
+    }
+}
+
+void ConstellationEngine::start(WorkStealingPool& pool) {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    exit_requested_ = false;
+    {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        ticking_ = true;
+    }
+    pool_ = &pool;
+    pool_active_ = true;
+    tick_start_ = std::chrono::steady_clock::now();
+    next_tick_ = tick_start_;
+    launch_pool_tick();
+}
+
+void ConstellationEngine::stop() {
+    if (running_.exchange(false)) {
+        if (pool_) {
+            // The in-progress tick finishes and does not re-arm
+            pool_active_.wait(true);
+            pool_ = nullptr;
+        }
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers_.clear();
+        barrier_.reset();
+    }
+}
+
+void ConstellationEngine::step() {
+    if (running_) {
+        throw std::runtime_error("step() requires a stopped engine");
+    }
+    auto start = std::chrono::steady_clock::now();
+    step_slice(0, config_.num_satellites, ticks_);
+    if (tick_peer_) {
+        tick_peer_(0, 1);
+    }
+    busy_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    ticks_++;
+    if (config_.clock) {
+        config_.clock->advance(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(dt_)));
+    }
+}
+
+void ConstellationEngine::run(uint64_t ticks) {
+    if (running_) {
+        throw std::runtime_error("run() requires a stopped engine");
+    }
+    if (ticks == 0) {
+        return;
+    }
+    tick_limit_ = ticks_ + ticks;
+    start();
+    for (auto& worker : workers_) {
+        worker.join();  // Workers leave after the last tick
+    }
+    stop();
+    tick_limit_ = UINT64_MAX;
+}
+
+std::chrono::steady_clock::time_point ConstellationEngine::end_tick() {
+    auto now = std::chrono::steady_clock::now();
+    busy_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(now - tick_start_).count();
+    ticks_++;
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(dt_));
+    if (config_.clock) {
+        config_.clock->advance(period);
+    }
+
+    exit_requested_ = !running_ || ticks_ >= tick_limit_;
+    {
+        // Every worker is parked here, so state is consistent
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        if (capture_requested_) {
+            copy_to_shadow();
+            capture_requested_ = false;
+            capture_cv_.notify_all();
+        }
+        if (exit_requested_) {
+            ticking_ = false;
+        }
+    }
+    if (exit_requested_ || config_.clock) {
+        return now;  // Lockstep ticks run back to back
+    }
+
+    next_tick_ += period;
+    if (now > next_tick_) {
+        tick_overruns_++;
+        next_tick_ = now;
+    }
+    return next_tick_;
+}
+
+void ConstellationEngine::TickDone::operator()() noexcept {
+    auto next = engine->end_tick();
+    if (engine->exit_requested_) {
+        return;
+    }
+
+    // Hold every worker until the next tick boundary
+    std::this_thread::sleep_until(next);
+    engine->tick_start_ = std::chrono::steady_clock::now();
+}
+
+void ConstellationEngine::launch_pool_tick() {
+    const size_t n = config_.num_satellites;
+    const size_t chunks = std::max<size_t>(1, (n + kPoolChunk - 1) / kPoolChunk);
+    const uint64_t tick = ticks_.load(std::memory_order_relaxed);
+    chunks_remaining_ = chunks;
+
+    for (size_t c = 0; c < chunks; ++c) {
+        pool_->submit([this, c, n, tick] {
+            step_slice(c * kPoolChunk, std::min(n, (c + 1) * kPoolChunk), tick);
+            if (--chunks_remaining_ != 0) {
+                return;
+            }
+
+            // Last chunk closes the tick
+            auto next = end_tick();
+            if (exit_requested_) {
+                pool_active_ = false;
+                pool_active_.notify_all();
+                return;
+            }
+            pool_->submit_at(next, [this] {
+                tick_start_ = std::chrono::steady_clock::now();
+                launch_pool_tick();
+            });
+        });
+    }
+}
+
+void ConstellationEngine::run_worker(size_t worker) {
+    const size_t n = config_.num_satellites;
+    const size_t begin = n * worker / num_workers_;
+    const size_t end = n * (worker + 1) / num_workers_;
+
+    while (true) {
+        step_slice(begin, end, ticks_.load(std::memory_order_relaxed));
+        if (tick_peer_) {
+            tick_peer_(worker, num_workers_);
+        }
+        barrier_->arrive_and_wait();
+        if (exit_requested_) {
+            break;
+        }
+    }
+}
+
+void ConstellationEngine::step_slice(size_t begin, size_t end, uint64_t tick) {
+    update_state(begin, end, tick);
+    check_anomalies(begin, end);
+    for (size_t i = begin; i < end; ++i) {
+        service_link(i, tick);
+    }
+}
+
+void ConstellationEngine::update_state(size_t begin, size_t end, uint64_t tick) {
+    const double dt = dt_;
+    const uint64_t seed = config_.seed;
+    double* temp = temperature_c_.data();
+    double* batt = battery_pct_.data();
+    double* alt = orbit_altitude_km_.data();
+    double* pitch = pitch_deg_.data();
+    double* yaw = yaw_deg_.data();
+    double* roll = roll_deg_.data();
+    const uint8_t* safe = safe_mode_.data();
+
+    // Thermal random walk
+    for (size_t i = begin; i < end; ++i) {
+        temp[i] += noise(seed, i, tick, 0) * dt;
+    }
+
+    // Battery drain (doubled in safe mode for heaters) and drag decay
+    for (size_t i = begin; i < end; ++i) {
+        batt[i] = std::max(0.0, batt[i] - (0.1 + 0.1 * safe[i]) * dt);
+        alt[i] -= 0.001 * dt;
+    }
+
+    // Attitude drift
+    for (size_t i = begin; i < end; ++i) {
+        pitch[i] += noise(seed, i, tick, 1) * 0.1 * dt;
+        yaw[i] += noise(seed, i, tick, 2) * 0.1 * dt;
+        roll[i] += noise(seed, i, tick, 3) * 0.1 * dt;
+    }
+}
+
+void ConstellationEngine::check_anomalies(size_t begin, size_t end) {
+    const double* temp = temperature_c_.data();
+    const double* batt = battery_pct_.data();
+    uint8_t* safe = safe_mode_.data();
+    uint8_t* prev = safe_mode_prev_.data();
+
+    for (size_t i = begin; i < end; ++i) {
+        safe[i] |= static_cast<uint8_t>((temp[i] > 85.0) | (batt[i] < 10.0));
+    }
+
+    // Rare path: report fresh safe-mode entries, which only a threshold
+    // can cause here
+    for (size_t i = begin; i < end; ++i) {
+        if (safe[i] == prev[i]) {
+            continue;
+        }
+        mark_dirty(i);
+        if (safe[i] & ~prev[i] & 1) {
+            safe_mode_entries_++;
+            if (!links_.empty()) {
+                Packet event;
+                event.type = PacketType::EventPkt;
+                event.seq = tx_seq_[i]++;
+                event.payload = temp[i] > 85.0 && batt[i] < 10.0 ? "SAFE_MODE|high temp, low battery"
+                                : temp[i] > 85.0                  ? "SAFE_MODE|high temp"
+                                                                  : "SAFE_MODE|low battery";
+                event.payload_size = static_cast<uint32_t>(event.payload.size());
+                event.compute_crc();
+                links_[i]->send_sat_to_gs(std::move(event));
+            }
+        }
+        prev[i] = safe[i];
+    }
+}
+
+void ConstellationEngine::service_link(size_t i, uint64_t tick) {
+
+    if (!links_.empty()) {
+        Link& link = *links_[i];
+        Packet pkt;
+        while (link.recv_gs_to_sat(pkt, std::chrono::milliseconds(0))) {
+            const bool crc_ok = pkt.verify_crc();
+            SATCOM_TRACE(Satellite, CrcChecked, pkt.type, i, pkt.seq, crc_ok);
+            if (!crc_ok) {
+                reply(i, PacketType::NakPkt, pkt.seq);
+                continue;
+            }
+
+            if (pkt.type == PacketType::AckPkt || pkt.type == PacketType::NakPkt) {
+                if (awaiting_ack_[i] && pending_[i].seq == pkt.seq) {
+                    if (pkt.type == PacketType::AckPkt) {
+                        // The latest attempt went out one timeout before its deadline
+                        const uint64_t sent_tick = ack_deadline_tick_[i] - ack_timeout_ticks_;
+                        ack_rtt_.record(std::chrono::duration<double>((tick - sent_tick) * dt_));
+                        awaiting_ack_[i] = 0;
+                        telemetry_acked_++;
+                        SATCOM_TRACE(Satellite, Acked, pending_[i].type, i, pkt.seq, attempts_[i]);
+                    } else {
+                        ack_deadline_tick_[i] = tick;  // Retry now
+                    }
+                }
+            } else if (pkt.type == PacketType::CommandPkt || pkt.type == PacketType::CommandBatchPkt) {
+                // Already executed, or older than the window: ACK only
+                if (rx_window_[i].check(pkt.seq) != ReplayWindow<>::Verdict::New) {
+                    reply(i, PacketType::AckPkt, pkt.seq);
+                    continue;
+                }
+                mark_dirty(i);  // Replay window and possibly safe mode
+                // A rejected command is not marked seen, so its retransmission
+                // is processed again rather than ACKed as a duplicate
+                try {
+                    if (pkt.type == PacketType::CommandBatchPkt) {
+                        // All or none: nothing runs unless every command can
+                        const CommandBatch batch = CommandBatch::decode(pkt.payload);
+                        batch.check_runnable(safe_mode_[i] != 0);
+                        for (const Command& cmd : batch.commands) {
+                            execute_command(i, cmd);
+                        }
+                        commands_received_ += batch.commands.size();
+                    } else {
+                        execute_command(i, Command::decode(pkt.payload));
+                        commands_received_++;
+                    }
+                    rx_window_[i].accept(pkt.seq);
+                    reply(i, PacketType::AckPkt, pkt.seq);
+                } catch (const std::exception&) {
+                    reply(i, PacketType::NakPkt, pkt.seq);
+                }
+            }
+        }
+
+        // Retransmit on ACK timeout
+        if (awaiting_ack_[i] && tick >= ack_deadline_tick_[i]) {
+            if (attempts_[i] > config_.max_retries) {
+                awaiting_ack_[i] = 0;
+                telemetry_unacked_++;
+            } else {
+                retries_++;
+                attempts_[i]++;
+                ack_deadline_tick_[i] = tick + ack_timeout_ticks_;
+                SATCOM_TRACE(Satellite, Retransmitted, pending_[i].type, i, pending_[i].seq, attempts_[i]);
+                link.send_sat_to_gs(pending_[i]);
+            }
+        }
+    }
+
+    // Telemetry phases are staggered by satellite index
+    if ((tick + i) % telemetry_period_ticks_ == 0) {
+        send_telemetry(i, tick);
+    }
+}
+
+void ConstellationEngine::send_telemetry(size_t i, uint64_t tick) {
+
+    Telemetry telem;
+    telem.ts = config_.clock ? config_.clock->now() : std::chrono::steady_clock::now();
+    telem.temperature_c = temperature_c_[i];
+    telem.battery_pct = battery_pct_[i];
+    telem.orbit_altitude_km = orbit_altitude_km_[i];
+    telem.pitch_deg = pitch_deg_[i];
+    telem.yaw_deg = yaw_deg_[i];
+    telem.roll_deg = roll_deg_[i];
+
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.seq = tx_seq_[i]++;
+    pkt.payload = telem.to_json();
+    pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+    pkt.compute_crc();
+    telemetry_sent_++;
+    SATCOM_TRACE(Satellite, Created, pkt.type, i, pkt.seq, 0);
+
+    if (links_.empty()) {
+        return;  // State-only simulation
+    }
+
+    if (awaiting_ack_[i]) {
+        telemetry_unacked_++;  // Superseded by the fresh sample
+    }
+    links_[i]->send_sat_to_gs(pkt);
+    pending_[i] = std::move(pkt);
+    pending_dirty_[i] = 1;
+    awaiting_ack_[i] = 1;
+    attempts_[i] = 1;
+    ack_deadline_tick_[i] = tick + ack_timeout_ticks_;
+}
+
+void ConstellationEngine::execute_command(size_t i, const Command& cmd) {
+    switch (cmd.type) {
+        case CommandType::AdjustOrientation:
+            pitch_deg_[i] += cmd.d_pitch;
+            yaw_deg_[i] += cmd.d_yaw;
+            roll_deg_[i] += cmd.d_roll;
+            break;
+        case CommandType::ThrustBurn:
+            if (!safe_mode_[i]) {
+                orbit_altitude_km_[i] += cmd.burn_seconds * 0.5;
+                battery_pct_[i] -= cmd.burn_seconds * 2.0;
+            }
+            break;
+        // Commanded mode changes are not anomalies: check_anomalies only
+        // reports transitions it has not already seen
+        case CommandType::EnterSafeMode:
+            safe_mode_[i] = safe_mode_prev_[i] = 1;
+            break;
+        case CommandType::Reboot:
+            safe_mode_[i] = safe_mode_prev_[i] = 0;
+            break;
+    }
+}
+
+void ConstellationEngine::reply(size_t i, PacketType type, uint32_t seq) {
+    Packet pkt;
+    pkt.type = type;
+    pkt.seq = seq;
+    pkt.payload = "";
+    pkt.payload_size = 0;
+    pkt.compute_crc();
+    links_[i]->send_sat_to_gs(std::move(pkt));
+}
+
+std::shared_ptr<const ConstellationEngine::Snapshot> ConstellationEngine::capture() {
+    std::lock_guard<std::mutex> serial(capture_serial_);
+
+    // Copy-on-write, done here so the simulation is not paused for it
+    if (!shadow_) {
+        shadow_ = std::make_shared<Snapshot>();
+    } else if (shadow_.use_count() > 1) {
+        shadow_ = std::make_shared<Snapshot>(*shadow_);
+    }
+
+    std::unique_lock<std::mutex> lock(capture_mutex_);
+    if (!ticking_) {
+        copy_to_shadow();
+    } else {
+        capture_requested_ = true;
+        capture_cv_.wait(lock, [this] { return !capture_requested_; });
+    }
+    return shadow_;
+}
+
+void ConstellationEngine::copy_to_shadow() {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t n = config_.num_satellites;
+    Snapshot& snap = *shadow_;
+
+    snap.tick = ticks_.load(std::memory_order_relaxed);
+    snap.temperature_c = temperature_c_;
+    snap.battery_pct = battery_pct_;
+    snap.orbit_altitude_km = orbit_altitude_km_;
+    snap.pitch_deg = pitch_deg_;
+    snap.yaw_deg = yaw_deg_;
+    snap.roll_deg = roll_deg_;
+    snap.tx_seq = tx_seq_;
+    snap.awaiting_ack = awaiting_ack_;
+    snap.attempts = attempts_;
+    snap.ack_deadline_tick = ack_deadline_tick_;
+
+    // Only packets replaced since the last capture
+    if (snap.pending.size() != pending_.size()) {
+        snap.pending.resize(pending_.size());
+    }
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        if (pending_dirty_[i]) {
+            if (awaiting_ack_[i]) {
+                snap.pending[i] = pending_[i];
+            }
+            pending_dirty_[i] = 0;
+        }
+    }
+
+    if (snap.safe_mode.size() != n) {
+        snap.safe_mode.resize(n);
+        snap.safe_mode_prev.resize(n);
+        snap.rx_window.resize(n);
+    }
+
+    uint64_t blocks = 0;
+    for (size_t b = 0; b < num_blocks_; ++b) {
+        if (!dirty_[b].exchange(0, std::memory_order_relaxed)) {
+            continue;
+        }
+        blocks++;
+        const size_t begin = b * kDirtyBlock;
+        const size_t end = std::min(n, begin + kDirtyBlock);
+        std::copy(safe_mode_.begin() + begin, safe_mode_.begin() + end, snap.safe_mode.begin() + begin);
+        std::copy(safe_mode_prev_.begin() + begin, safe_mode_prev_.begin() + end, snap.safe_mode_prev.begin() + begin);
+        std::copy(rx_window_.begin() + begin, rx_window_.begin() + end, snap.rx_window.begin() + begin);
+    }
+
+    snap.telemetry_sent = get_telemetry_sent();
+    snap.telemetry_acked = get_telemetry_acked();
+    snap.telemetry_unacked = get_telemetry_unacked();
+    snap.retries = get_retries();
+    snap.commands_received = get_commands_received();
+    snap.safe_mode_entries = get_safe_mode_entries();
+
+    last_capture_blocks_ = blocks;
+    last_capture_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void ConstellationEngine::Snapshot::save(CheckpointWriter& out) const {
+    out.begin("CONS");
+    out.put<uint64_t>(tx_seq.size());
+    out.put(tick);
+    out.put_vector(temperature_c);
+    out.put_vector(battery_pct);
+    out.put_vector(orbit_altitude_km);
+    out.put_vector(pitch_deg);
+    out.put_vector(yaw_deg);
+    out.put_vector(roll_deg);
+    out.put_vector(safe_mode);
+    out.put_vector(safe_mode_prev);
+    out.put_vector(tx_seq);
+    out.put_vector(rx_window);
+    out.put_vector(awaiting_ack);
+    out.put_vector(attempts);
+    out.put_vector(ack_deadline_tick);
+
+    uint32_t in_flight = 0;
+    if (!pending.empty()) {
+        for (uint8_t a : awaiting_ack) in_flight += a ? 1 : 0;
+    }
+    out.put(in_flight);
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (awaiting_ack[i]) {
+            out.put<uint32_t>(static_cast<uint32_t>(i));
+            out.put_packet(pending[i]);
+        }
+    }
+
+    for (uint64_t v : {telemetry_sent, telemetry_acked, telemetry_unacked, retries,
+                       commands_received, safe_mode_entries}) {
+        out.put(v);
+    }
+    out.end();
+}
+
+void ConstellationEngine::restore(CheckpointReader& in) {
+    if (running_) {
+        throw std::runtime_error("restore() requires a stopped engine");
+    }
+    const size_t n = config_.num_satellites;
+
+    in.begin("CONS");
+    if (in.get<uint64_t>() != n) {
+        throw std::runtime_error("Checkpoint is from a constellation of a different size");
+    }
+    uint64_t tick = in.get<uint64_t>();
+
+    auto load = [&](auto& dest) {
+        using T = typename std::decay_t<decltype(dest)>::value_type;
+        auto values = in.template get_vector<T>();
+        if (values.size() != n) {
+            throw std::runtime_error("Checkpoint array has the wrong length");
+        }
+        dest = std::move(values);
+    };
+    load(temperature_c_);
+    load(battery_pct_);
+    load(orbit_altitude_km_);
+    load(pitch_deg_);
+    load(yaw_deg_);
+    load(roll_deg_);
+    load(safe_mode_);
+    load(safe_mode_prev_);
+    load(tx_seq_);
+    load(rx_window_);
+    load(awaiting_ack_);
+    load(attempts_);
+    load(ack_deadline_tick_);
+
+    for (uint32_t count = in.get<uint32_t>(); count > 0; --count) {
+        uint32_t i = in.get<uint32_t>();
+        Packet pkt = in.get_packet();
+        if (i >= n) {
+            throw std::runtime_error("Checkpoint pending packet out of range");
+        }
+        if (!pending_.empty()) {
+            pending_[i] = std::move(pkt);
+        }
+    }
+    if (pending_.empty()) {
+        std::fill(awaiting_ack_.begin(), awaiting_ack_.end(), 0);  // State-only engine
+    }
+
+    for (ShardedCounter* counter : {&telemetry_sent_, &telemetry_acked_, &telemetry_unacked_, &retries_,
+                                    &commands_received_, &safe_mode_entries_}) {
+        *counter = in.get<uint64_t>();
+    }
+    in.end();
+
+    ticks_ = tick;
+    std::lock_guard<std::mutex> serial(capture_serial_);
+    shadow_.reset();
+    std::fill(pending_dirty_.begin(), pending_dirty_.end(), 1);
+    for (size_t b = 0; b < num_blocks_; ++b) {
+        dirty_[b].store(1, std::memory_order_relaxed);
+    }
+}
+
+double ConstellationEngine::get_mean_tick_ms() const {
+    uint64_t ticks = ticks_;
+    return ticks ? busy_ns_ / 1e6 / static_cast<double>(ticks) : 0.0;
+}
+
+void ConstellationEngine::register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels) const {
+    registry.counter("satcom_engine_ticks_total", "Simulation ticks completed", labels,
+                     [this] { return get_ticks(); });
+    registry.counter("satcom_engine_tick_overruns_total", "Ticks that ran past their deadline", labels,
+                     [this] { return get_tick_overruns(); });
+    registry.counter("satcom_engine_telemetry_sent_total", "Telemetry samples sent by all satellites", labels,
+                     [this] { return get_telemetry_sent(); });
+    registry.counter("satcom_engine_telemetry_acked_total", "Telemetry samples ACKed", labels,
+                     [this] { return get_telemetry_acked(); });
+    registry.counter("satcom_engine_retries_total", "Telemetry retransmissions", labels,
+                     [this] { return get_retries(); });
+    registry.counter("satcom_engine_commands_received_total", "Commands executed onboard", labels,
+                     [this] { return get_commands_received(); });
+    registry.gauge("satcom_engine_mean_tick_ms", "Mean tick compute time", labels,
+                   [this] { return get_mean_tick_ms(); });
+    registry.histogram("satcom_engine_ack_rtt_seconds", "Telemetry ACK round trip per attempt", labels,
+                       [this] { return get_ack_rtt(); });
+}
+
+uint64_t ConstellationEngine::get_telemetry_sent() const {
+    return telemetry_sent_;
+}
+
+uint64_t ConstellationEngine::get_telemetry_acked() const {
+    return telemetry_acked_;
+}
+
+uint64_t ConstellationEngine::get_telemetry_unacked() const {
+    return telemetry_unacked_;
+}
+
+uint64_t ConstellationEngine::get_retries() const {
+    return retries_;
+}
+
+uint64_t ConstellationEngine::get_commands_received() const {
+    return commands_received_;
+}
+
+uint64_t ConstellationEngine::get_safe_mode_entries() const {
+    return safe_mode_entries_;
+}
@@ -0,0 +1,95 @@
+#include "coroutine_runtime.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+/**
+ * Self-destroying wrapper that owns a spawned agent.
+ */
+struct DetachedAgent {
+    struct promise_type {
+        DetachedAgent get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }  // Body catches everything
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+DetachedAgent run_detached(Task<void> agent, std::function<void()> on_done) {
+    try {
+        co_await agent;
+    } catch (const std::exception& e) {
+        std::cerr << "[RT ] ERROR: agent failed: " << e.what() << std::endl;
+    }
+    if (on_done) {
+        on_done();
+    }
+}
+
+} // namespace
+
+CoroutineRuntime::CoroutineRuntime(const Config& config)
+    : config_(config), pool_(config.num_workers) {}
+
+void CoroutineRuntime::spawn(Task<void> agent, std::function<void()> on_done) {
+    auto handle = run_detached(std::move(agent), std::move(on_done)).handle;
+    pool_.submit([handle] { handle.resume(); });
+}
+
+CoroutineRuntime::RecvAwaiter::RecvAwaiter(CoroutineRuntime* runtime, Link* link, RecvFn recv,
+                                           NotifyFn notify, Clock::time_point deadline)
+    : state_(std::make_shared<State>()) {
+    state_->runtime = runtime;
+    state_->link = link;
+    state_->recv = recv;
+    state_->notify = notify;
+    state_->deadline = deadline;
+}
+
+bool CoroutineRuntime::RecvAwaiter::await_ready() {
+    State& s = *state_;
+    s.received = (s.link->*s.recv)(s.pkt, std::chrono::milliseconds(0));
+    return s.received || Clock::now() >= s.deadline;
+}
+
+void CoroutineRuntime::RecvAwaiter::await_suspend(std::coroutine_handle<> h) {
+    state_->handle = h;
+    auto state = state_;  // The agent may resume (and destroy *this) before we return
+    state->runtime->pool_.submit_at(state->deadline, [state] { attempt(state); });
+    arm(state);
+}
+
+std::optional<Packet> CoroutineRuntime::RecvAwaiter::await_resume() {
+    if (!state_->received) {
+        return std::nullopt;
+    }
+    return std::move(state_->pkt);
+}
+
+void CoroutineRuntime::RecvAwaiter::arm(const std::shared_ptr<State>& state) {
+    (state->link->*state->notify)([state](Clock::time_point deliver_at) {
+        auto when = std::min(deliver_at, state->deadline);
+        state->runtime->pool_.submit_at(when, [state] { attempt(state); });
+    });
+}
+
+void CoroutineRuntime::RecvAwaiter::attempt(const std::shared_ptr<State>& state) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->resumed) {
+            return;  // Stale wakeup
+        }
+        state->received = (state->link->*state->recv)(state->pkt, std::chrono::milliseconds(0));
+        if (!state->received && Clock::now() < state->deadline) {
+            arm(state);  // Head not due yet or taken: wait for the next arrival
+            return;
+        }
+        state->resumed = true;
+    }
+    state->handle.resume();
+}
@@ -0,0 +1,560 @@
+#include "fec.hpp"
+#include "gf256.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace fec {
+namespace {
+
+// g(x) = (x + alpha^1)(x + alpha^2)...(x + alpha^32), lowest degree first
+std::array<uint8_t, kRsParity + 1> make_generator() {
+    std::array<uint8_t, kRsParity + 1> g{};
+    g[0] = 1;
+    for (unsigned i = 1; i <= kRsParity; ++i) {
+        const uint8_t root = gf256::exp(i);
+        for (size_t j = i; j > 0; --j) {
+            g[j] = g[j - 1] ^ gf256::mul(g[j], root);
+        }
+        g[0] = gf256::mul(g[0], root);
+    }
+    return g;
+}
+
+// Row fb: what a feedback byte fb adds to each check byte, highest degree
+// first, packed eight bytes to a word (check byte j in bits 8 * (j % 8) of
+// word j / 8) so one encoder step is a 32-byte shift plus XOR in registers
+constexpr size_t kRsWords = kRsParity / 8;
+using GenRows = std::array<std::array<uint64_t, kRsWords>, 256>;
+
+GenRows make_gen_rows() {
+    const auto g = make_generator();
+    GenRows rows{};
+    for (unsigned fb = 0; fb < 256; ++fb) {
+        for (size_t i = 0; i < kRsParity; ++i) {
+            const uint64_t b = gf256::mul(static_cast<uint8_t>(fb), g[kRsParity - 1 - i]);
+            rows[fb][i / 8] |= b << (8 * (i % 8));
+        }
+    }
+    return rows;
+}
+
+const GenRows& gen_rows() {
+    static const GenRows rows = make_gen_rows();
+    return rows;
+}
+
+// Evaluate a polynomial given highest degree first at x
+uint8_t eval_descending(const uint8_t* coeffs, size_t n, uint8_t x) {
+    uint8_t y = 0;
+    for (size_t i = 0; i < n; ++i) {
+        y = gf256::mul(y, x) ^ coeffs[i];
+    }
+    return y;
+}
+
+uint32_t get_u32(std::string_view bytes, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(bytes[pos])) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(bytes[pos + 1])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(bytes[pos + 2])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(bytes[pos + 3]));
+}
+
+void put_u32(std::string& out, uint32_t v) {
+    out.push_back(static_cast<char>(v >> 24));
+    out.push_back(static_cast<char>((v >> 16) & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+    out.push_back(static_cast<char>(v & 0xFF));
+}
+
+uint8_t* bytes_of(std::string& s) {
+    return reinterpret_cast<uint8_t*>(s.data());
+}
+
+} // namespace
+
+void rs_encode(const uint8_t* data, size_t k, uint8_t* parity) {
+    const GenRows& rows = gen_rows();
+    std::array<uint64_t, kRsWords> p{};
+    for (size_t i = 0; i < k; ++i) {
+        const auto& row = rows[data[i] ^ static_cast<uint8_t>(p[0])];
+        for (size_t w = 0; w + 1 < kRsWords; ++w) {
+            p[w] = ((p[w] >> 8) | (p[w + 1] << 56)) ^ row[w];
+        }
+        p[kRsWords - 1] = (p[kRsWords - 1] >> 8) ^ row[kRsWords - 1];
+    }
+    for (size_t j = 0; j < kRsParity; ++j) {
+        parity[j] = static_cast<uint8_t>(p[j / 8] >> (8 * (j % 8)));
+    }
+}
+
+std::optional<size_t> rs_decode(uint8_t* block, size_t n) {
+    if (n <= kRsParity || n > kRsBlock) {
+        return std::nullopt;
+    }
+    const size_t k = n - kRsParity;
+
+    // r(x) mod g(x) is the recomputed parity XOR the received one; zero
+    // means a valid codeword, the common case
+    std::array<uint8_t, kRsParity> rem;
+    rs_encode(block, k, rem.data());
+    bool clean = true;
+    for (size_t i = 0; i < kRsParity; ++i) {
+        rem[i] ^= block[k + i];
+        clean &= rem[i] == 0;
+    }
+    if (clean) {
+        return 0;
+    }
+
+    // Syndromes S_j = r(alpha^j) = rem(alpha^j), since g(alpha^j) = 0
+    std::array<uint8_t, kRsParity> syn;
+    for (size_t j = 0; j < kRsParity; ++j) {
+        syn[j] = eval_descending(rem.data(), kRsParity, gf256::exp(static_cast<unsigned>(j + 1)));
+    }
+
+    // Berlekamp-Massey: error locator lambda(x), lowest degree first
+    std::array<uint8_t, kRsParity + 1> lambda{}, prev{}, tmp{};
+    lambda[0] = prev[0] = 1;
+    size_t errors = 0;
+    size_t shift = 1;
+    uint8_t prev_disc = 1;
+    for (size_t r = 0; r < kRsParity; ++r) {
+        uint8_t disc = syn[r];
+        for (size_t i = 1; i <= errors; ++i) {
+            disc ^= gf256::mul(lambda[i], syn[r - i]);
+        }
+        if (disc == 0) {
+            shift++;
+            continue;
+        }
+        const uint8_t scale = gf256::div(disc, prev_disc);
+        tmp = lambda;
+        for (size_t i = 0; i + shift <= kRsParity; ++i) {
+            lambda[i + shift] ^= gf256::mul(scale, prev[i]);
+        }
+        if (2 * errors <= r) {
+            errors = r + 1 - errors;
+            prev = tmp;
+            prev_disc = disc;
+            shift = 1;
+        } else {
+            shift++;
+        }
+    }
+    if (errors > kRsParity / 2) {
+        return std::nullopt;
+    }
+
+    // Error evaluator omega(x) = S(x) lambda(x) mod x^32
+    std::array<uint8_t, kRsParity> omega{};
+    for (size_t i = 0; i < kRsParity; ++i) {
+        for (size_t j = 0; j <= std::min(i, errors); ++j) {
+            omega[i] ^= gf256::mul(lambda[j], syn[i - j]);
+        }
+    }
+
+    // Chien search over the positions this (possibly shortened) block has;
+    // byte p is the coefficient of x^(n-1-p), so its locator is alpha^(n-1-p)
+    std::array<size_t, kRsParity / 2> positions;
+    std::array<uint8_t, kRsParity / 2> values;
+    size_t found = 0;
+    for (size_t p = 0; p < n; ++p) {
+        const unsigned power = static_cast<unsigned>(n - 1 - p);
+        const uint8_t x_inv = gf256::exp(255 - power);
+        uint8_t sum = 0;
+        for (size_t i = errors + 1; i-- > 0;) {
+            sum = gf256::mul(sum, x_inv) ^ lambda[i];
+        }
+        if (sum != 0) {
+            continue;
+        }
+        if (found == errors) {
+            return std::nullopt;
+        }
+
+        // Forney (first root alpha^1): e = omega(X^-1) / lambda'(X^-1)
+        uint8_t num = 0;
+        for (size_t i = kRsParity; i-- > 0;) {
+            num = gf256::mul(num, x_inv) ^ omega[i];
+        }
+        // lambda' keeps the odd terms: sum of lambda_i x^(i-1), i odd
+        const uint8_t x_inv2 = gf256::mul(x_inv, x_inv);
+        uint8_t den = 0;
+        uint8_t power_of_x = 1;
+        for (size_t i = 1; i <= errors; i += 2) {
+            den ^= gf256::mul(lambda[i], power_of_x);
+            power_of_x = gf256::mul(power_of_x, x_inv2);
+        }
+        if (den == 0) {
+            return std::nullopt;
+        }
+        positions[found] = p;
+        values[found] = gf256::div(num, den);
+        found++;
+    }
+    if (found != errors) {
+        return std::nullopt;  // Locator roots fall outside the block
+    }
+
+    for (size_t e = 0; e < found; ++e) {
+        block[positions[e]] ^= values[e];
+    }
+
+    // A pattern beyond the code's reach can still look correctable; only
+    // keep the correction if it yields a codeword
+    rs_encode(block, k, rem.data());
+    if (std::memcmp(rem.data(), block + k, kRsParity) != 0) {
+        for (size_t e = 0; e < found; ++e) {
+            block[positions[e]] ^= values[e];
+        }
+        return std::nullopt;
+    }
+    return found;
+}
+
+std::string encode_frame(std::string_view frame) {
+    std::string out;
+    out.reserve(frame.size() + (frame.size() + kRsData - 1) / kRsData * kRsParity);
+    uint8_t parity[kRsParity];
+    for (size_t pos = 0; pos < frame.size(); pos += kRsData) {
+        const size_t k = std::min(kRsData, frame.size() - pos);
+        out.append(frame.substr(pos, k));
+        rs_encode(reinterpret_cast<const uint8_t*>(frame.data() + pos), k, parity);
+        out.append(reinterpret_cast<const char*>(parity), kRsParity);
+    }
+    return out;
+}
+
+std::string decode_frame(std::string_view coded, size_t* corrected) {
+    std::string out;
+    out.reserve(coded.size());
+    uint8_t block[kRsBlock];
+    size_t fixed = 0;
+    for (size_t pos = 0; pos < coded.size(); pos += kRsBlock) {
+        const size_t n = std::min(kRsBlock, coded.size() - pos);
+        if (n <= kRsParity) {
+            throw std::runtime_error("FEC frame truncated");
+        }
+        std::memcpy(block, coded.data() + pos, n);
+        auto result = rs_decode(block, n);
+        if (!result) {
+            throw std::runtime_error("FEC block " + std::to_string(pos / kRsBlock) + " uncorrectable");
+        }
+        fixed += *result;
+        out.append(reinterpret_cast<const char*>(block), n - kRsParity);
+    }
+    if (corrected) {
+        *corrected = fixed;
+    }
+    return out;
+}
+
+ErasureCode::ErasureCode(size_t data_shards, size_t parity_shards)
+    : k_(data_shards), m_(parity_shards) {
+    if (k_ == 0 || m_ == 0 || k_ + m_ > kMaxShards) {
+        throw std::runtime_error("Erasure code needs 1+ data and 1+ parity shards, at most " +
+                                 std::to_string(kMaxShards) + " in total");
+    }
+    // Cauchy rows 1 / (x_i + y_j) with x_i = k + i and y_j = j: all distinct
+    matrix_.resize(m_ * k_);
+    for (size_t i = 0; i < m_; ++i) {
+        for (size_t j = 0; j < k_; ++j) {
+            matrix_[i * k_ + j] = gf256::inv(static_cast<uint8_t>((k_ + i) ^ j));
+        }
+    }
+}
+
+uint8_t ErasureCode::coefficient(size_t parity_row, size_t data_col) const {
+    return matrix_[parity_row * k_ + data_col];
+}
+
+void ErasureCode::encode(const uint8_t* const* data, uint8_t* const* parity, size_t len) const {
+    for (size_t i = 0; i < m_; ++i) {
+        gf256::mul_region(parity[i], data[0], coefficient(i, 0), len);
+        for (size_t j = 1; j < k_; ++j) {
+            gf256::mul_add_region(parity[i], data[j], coefficient(i, j), len);
+        }
+    }
+}
+
+bool ErasureCode::reconstruct(uint8_t* const* shards, const bool* present, size_t len) const {
+    // Use every present data shard and as many parity shards as needed
+    std::vector<size_t> rows;
+    std::vector<size_t> missing;
+    rows.reserve(k_);
+    for (size_t j = 0; j < k_; ++j) {
+        if (present[j]) {
+            rows.push_back(j);
+        } else {
+            missing.push_back(j);
+        }
+    }
+    for (size_t i = 0; i < m_ && rows.size() < k_; ++i) {
+        if (present[k_ + i]) {
+            rows.push_back(k_ + i);
+        }
+    }
+    if (rows.size() < k_) {
+        return false;
+    }
+    if (missing.empty()) {
+        return true;
+    }
+
+    // Invert the generator rows we hold: [A | I] -> [I | A^-1]
+    const size_t w = 2 * k_;
+    std::vector<uint8_t> a(k_ * w, 0);
+    for (size_t r = 0; r < k_; ++r) {
+        uint8_t* row = &a[r * w];
+        if (rows[r] < k_) {
+            row[rows[r]] = 1;
+        } else {
+            for (size_t j = 0; j < k_; ++j) {
+                row[j] = coefficient(rows[r] - k_, j);
+            }
+        }
+        row[k_ + r] = 1;
+    }
+    for (size_t col = 0; col < k_; ++col) {
+        size_t pivot = col;
+        while (a[pivot * w + col] == 0) {
+            ++pivot;  // Cauchy rows keep the matrix invertible
+        }
+        if (pivot != col) {
+            std::swap_ranges(&a[pivot * w], &a[pivot * w] + w, &a[col * w]);
+        }
+        uint8_t* prow = &a[col * w];
+        gf256::mul_region(prow, prow, gf256::inv(prow[col]), w);
+        for (size_t r = 0; r < k_; ++r) {
+            if (r != col && a[r * w + col] != 0) {
+                gf256::mul_add_region(&a[r * w], prow, a[r * w + col], w);
+            }
+        }
+    }
+
+    // Missing data shard j is row j of A^-1 applied to the shards held
+    for (size_t j : missing) {
+        const uint8_t* inverse = &a[j * w + k_];
+        gf256::mul_region(shards[j], shards[rows[0]], inverse[0], len);
+        for (size_t r = 1; r < k_; ++r) {
+            gf256::mul_add_region(shards[j], shards[rows[r]], inverse[r], len);
+        }
+    }
+    return true;
+}
+
+std::string ParityShard::encode() const {
+    if (seqs.empty() || parity_count == 0 || seqs.size() + parity_count > ErasureCode::kMaxShards ||
+        index >= parity_count || shard.size() > 0xFFFF) {
+        throw std::runtime_error("Invalid parity shard");
+    }
+    std::string out;
+    out.reserve(5 + 4 * seqs.size() + shard.size());
+    out.push_back(static_cast<char>(seqs.size()));
+    out.push_back(static_cast<char>(parity_count));
+    out.push_back(static_cast<char>(index));
+    out.push_back(static_cast<char>(shard.size() >> 8));
+    out.push_back(static_cast<char>(shard.size() & 0xFF));
+    for (uint32_t seq : seqs) {
+        put_u32(out, seq);
+    }
+    out += shard;
+    return out;
+}
+
+ParityShard ParityShard::decode(std::string_view bytes) {
+    if (bytes.size() < 5) {
+        throw std::runtime_error("Parity shard too short");
+    }
+    const size_t members = static_cast<uint8_t>(bytes[0]);
+    ParityShard ps;
+    ps.parity_count = static_cast<uint8_t>(bytes[1]);
+    ps.index = static_cast<uint8_t>(bytes[2]);
+    const size_t shard_len = (static_cast<size_t>(static_cast<uint8_t>(bytes[3])) << 8) |
+                             static_cast<uint8_t>(bytes[4]);
+    if (members == 0 || ps.parity_count == 0 || members + ps.parity_count > ErasureCode::kMaxShards ||
+        ps.index >= ps.parity_count) {
+        throw std::runtime_error("Invalid parity shard header");
+    }
+    if (bytes.size() != 5 + 4 * members + shard_len) {
+        throw std::runtime_error("Parity shard length mismatch");
+    }
+    ps.seqs.resize(members);
+    for (size_t i = 0; i < members; ++i) {
+        ps.seqs[i] = get_u32(bytes, 5 + 4 * i);
+    }
+    ps.shard.assign(bytes.substr(5 + 4 * members));
+    return ps;
+}
+
+std::vector<Packet> make_parity_packets(const std::vector<Packet>& group, size_t parity) {
+    const size_t n = group.size();
+    if (n == 0 || parity == 0 || n + parity > ErasureCode::kMaxShards) {
+        throw std::runtime_error("Parity group needs 1+ packets and 1+ parity, at most " +
+                                 std::to_string(ErasureCode::kMaxShards) + " in total");
+    }
+
+    std::vector<std::string> shards;
+    shards.reserve(n);
+    size_t shard_len = 0;
+    for (const Packet& pkt : group) {
+        shards.push_back(pkt.to_bytes());
+        shard_len = std::max(shard_len, shards.back().size());
+    }
+    std::vector<const uint8_t*> data(n);
+    for (size_t j = 0; j < n; ++j) {
+        shards[j].resize(shard_len, '\0');
+        data[j] = reinterpret_cast<const uint8_t*>(shards[j].data());
+    }
+
+    ParityShard ps;
+    ps.seqs.reserve(n);
+    for (const Packet& pkt : group) {
+        ps.seqs.push_back(pkt.seq);
+    }
+    ps.parity_count = static_cast<uint8_t>(parity);
+
+    std::vector<std::string> rows(parity, std::string(shard_len, '\0'));
+    std::vector<uint8_t*> out(parity);
+    for (size_t i = 0; i < parity; ++i) {
+        out[i] = bytes_of(rows[i]);
+    }
+    ErasureCode(n, parity).encode(data.data(), out.data(), shard_len);
+
+    std::vector<Packet> packets(parity);
+    for (size_t i = 0; i < parity; ++i) {
+        ps.index = static_cast<uint8_t>(i);
+        ps.shard = std::move(rows[i]);
+        Packet& pkt = packets[i];
+        pkt.type = PacketType::ParityPkt;
+        pkt.seq = group.front().seq;
+        pkt.payload = ps.encode();
+        pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+        pkt.compute_crc();
+    }
+    return packets;
+}
+
+PacketRecovery::PacketRecovery(size_t window_packets, size_t max_groups)
+    : window_(std::max<size_t>(window_packets, 1)), max_groups_(std::max<size_t>(max_groups, 1)) {}
+
+std::vector<Packet> PacketRecovery::add(const Packet& pkt) {
+    std::vector<Packet> out;
+
+    if (pkt.type != PacketType::ParityPkt) {
+        if (received_.count(pkt.seq)) {
+            return out;
+        }
+        remember(pkt.seq, pkt.to_bytes());
+        for (auto it = groups_.begin(); it != groups_.end();) {
+            if (std::find(it->seqs.begin(), it->seqs.end(), pkt.seq) != it->seqs.end() && try_rebuild(*it, out)) {
+                it = groups_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return out;
+    }
+
+    ParityShard ps;
+    try {
+        ps = ParityShard::decode(pkt.payload);
+    } catch (const std::exception&) {
+        return out;
+    }
+
+    auto it = std::find_if(groups_.begin(), groups_.end(),
+                           [&ps](const Group& g) { return g.seqs == ps.seqs; });
+    if (it == groups_.end()) {
+        Group group;
+        group.seqs = std::move(ps.seqs);
+        group.parity_count = ps.parity_count;
+        group.shard_len = ps.shard.size();
+        group.parity.resize(ps.parity_count);
+        groups_.push_back(std::move(group));
+        if (groups_.size() > max_groups_) {
+            groups_.pop_front();
+        }
+        it = std::prev(groups_.end());
+    }
+    Group& group = *it;
+    if (group.parity_count != ps.parity_count || group.shard_len != ps.shard.size() ||
+        !group.parity[ps.index].empty()) {
+        return out;
+    }
+    group.parity[ps.index] = std::move(ps.shard);
+    group.parity_received++;
+    if (try_rebuild(group, out)) {
+        groups_.erase(it);
+    }
+    return out;
+}
+
+void PacketRecovery::remember(uint32_t seq, std::string bytes) {
+    received_[seq] = std::move(bytes);
+    received_order_.push_back(seq);
+    while (received_order_.size() > window_) {
+        received_.erase(received_order_.front());
+        received_order_.pop_front();
+    }
+}
+
+bool PacketRecovery::try_rebuild(Group& group, std::vector<Packet>& out) {
+    const size_t n = group.seqs.size();
+    std::vector<size_t> missing;
+    for (size_t j = 0; j < n; ++j) {
+        if (!received_.count(group.seqs[j])) {
+            missing.push_back(j);
+        }
+    }
+    if (missing.empty()) {
+        return true;
+    }
+    if (missing.size() > group.parity_received) {
+        return false;  // Wait for more data or parity
+    }
+
+    std::vector<std::string> shards(n + group.parity_count);
+    std::vector<uint8_t*> ptrs(shards.size());
+    std::unique_ptr<bool[]> present(new bool[shards.size()]);
+    for (size_t s = 0; s < shards.size(); ++s) {
+        if (s < n) {
+            auto found = received_.find(group.seqs[s]);
+            present[s] = found != received_.end();
+            if (present[s]) {
+                if (found->second.size() > group.shard_len) {
+                    return true;  // Not the packet the parity was computed over
+                }
+                shards[s] = found->second;
+            }
+        } else {
+            present[s] = !group.parity[s - n].empty();
+            if (present[s]) {
+                shards[s] = group.parity[s - n];
+            }
+        }
+        shards[s].resize(group.shard_len, '\0');
+        ptrs[s] = bytes_of(shards[s]);
+    }
+    ErasureCode(n, group.parity_count).reconstruct(ptrs.data(), present.get(), group.shard_len);
+
+    for (size_t j : missing) {
+        try {
+            Packet pkt = Packet::from_bytes(shards[j]);
+            if (pkt.seq != group.seqs[j] || !pkt.verify_crc()) {
+                continue;
+            }
+            remember(pkt.seq, pkt.to_bytes());
+            rebuilt_++;
+            out.push_back(std::move(pkt));
+        } catch (const std::exception&) {
+            // A shard from a different packet; nothing to rebuild
+        }
+    }
+    return true;
+}
+
+} // namespace fec
@@ -0,0 +1,229 @@
+#include "gf256.hpp"
+#include <array>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SATCOM_GF256_X86 1
+#include <immintrin.h>
+#endif
+
+namespace gf256 {
+namespace {
+
+constexpr unsigned kPoly = 0x11D;
+
+struct LogTables {
+    std::array<uint8_t, 512> exp{};  // Doubled so exp[log a + log b] needs no reduction
+    std::array<uint8_t, 256> log{};
+};
+
+constexpr LogTables make_log_tables() {
+    LogTables t;
+    unsigned x = 1;
+    for (unsigned i = 0; i < 255; ++i) {
+        t.exp[i] = t.exp[i + 255] = static_cast<uint8_t>(x);
+        t.log[x] = static_cast<uint8_t>(i);
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= kPoly;
+        }
+    }
+    return t;
+}
+
+constexpr LogTables kLog = make_log_tables();
+static_assert(kLog.exp[8] == 0x1D, "alpha^8 reduces by the field polynomial");
+
+using MulTable = std::array<std::array<uint8_t, 256>, 256>;
+
+// Too large to build at compile time on every compiler; filled on first
+// use, which also makes it safe to use from other static initializers
+MulTable make_mul_table() {
+    MulTable t{};
+    for (unsigned a = 1; a < 256; ++a) {
+        for (unsigned b = 1; b < 256; ++b) {
+            t[a][b] = kLog.exp[kLog.log[a] + kLog.log[b]];
+        }
+    }
+    return t;
+}
+
+const MulTable& mul_table() {
+    static const MulTable table = make_mul_table();
+    return table;
+}
+
+template<bool Accumulate>
+void region_scalar(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n) {
+    const uint8_t* row = mul_table()[c].data();
+    for (size_t i = 0; i < n; ++i) {
+        if constexpr (Accumulate) {
+            dst[i] ^= row[src[i]];
+        } else {
+            dst[i] = row[src[i]];
+        }
+    }
+}
+
+#ifdef SATCOM_GF256_X86
+
+// Products of c with every low nibble and every high nibble
+struct NibbleTables {
+    alignas(16) uint8_t lo[16];
+    alignas(16) uint8_t hi[16];
+};
+
+NibbleTables nibble_tables(uint8_t c) {
+    const MulTable& mul = mul_table();
+    NibbleTables t;
+    for (unsigned i = 0; i < 16; ++i) {
+        t.lo[i] = mul[c][i];
+        t.hi[i] = mul[c][i << 4];
+    }
+    return t;
+}
+
+template<bool Accumulate>
+__attribute__((target("ssse3")))
+void region_ssse3(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n) {
+    const NibbleTables t = nibble_tables(c);
+    const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(t.lo));
+    const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(t.hi));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(x, mask)),
+                                  _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(x, 4), mask)));
+        if constexpr (Accumulate) {
+            p = _mm_xor_si128(p, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), p);
+    }
+    region_scalar<Accumulate>(dst + i, src + i, c, n - i);
+}
+
+template<bool Accumulate>
+__attribute__((target("avx2")))
+void region_avx2(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n) {
+    const NibbleTables t = nibble_tables(c);
+    // vpshufb looks up within each 128-bit lane, so both lanes get the table
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.lo)));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.hi)));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(x, mask)),
+                                     _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask)));
+        if constexpr (Accumulate) {
+            p = _mm256_xor_si256(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), p);
+    }
+    region_ssse3<Accumulate>(dst + i, src + i, c, n - i);
+}
+
+#endif
+
+template<bool Accumulate>
+void region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n, Kernel kernel) {
+    // Trivial constants need no lookups
+    if (c == 0) {
+        if constexpr (!Accumulate) {
+            std::memset(dst, 0, n);
+        }
+        return;
+    }
+    if (c == 1 && !Accumulate) {
+        std::memmove(dst, src, n);
+        return;
+    }
+
+#ifdef SATCOM_GF256_X86
+    switch (kernel) {
+        case Kernel::Avx2: return region_avx2<Accumulate>(dst, src, c, n);
+        case Kernel::Ssse3: return region_ssse3<Accumulate>(dst, src, c, n);
+        case Kernel::Scalar: break;
+    }
+#else
+    (void)kernel;
+#endif
+    region_scalar<Accumulate>(dst, src, c, n);
+}
+
+Kernel detect_kernel() {
+#ifdef SATCOM_GF256_X86
+    __builtin_cpu_init();  // May run before libgcc's own constructor
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::Avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return Kernel::Ssse3;
+    }
+#endif
+    return Kernel::Scalar;
+}
+
+} // namespace
+
+uint8_t exp(unsigned i) {
+    return kLog.exp[i % 255];
+}
+
+uint8_t log(uint8_t a) {
+    return kLog.log[a];
+}
+
+uint8_t mul(uint8_t a, uint8_t b) {
+    return a == 0 || b == 0 ? 0 : kLog.exp[kLog.log[a] + kLog.log[b]];
+}
+
+uint8_t inv(uint8_t a) {
+    return kLog.exp[255 - kLog.log[a]];
+}
+
+uint8_t div(uint8_t a, uint8_t b) {
+    return a == 0 ? 0 : kLog.exp[kLog.log[a] + 255 - kLog.log[b]];
+}
+
+bool supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return true;
+        case Kernel::Ssse3: return best_kernel() != Kernel::Scalar;
+        case Kernel::Avx2: return best_kernel() == Kernel::Avx2;
+    }
+    return false;
+}
+
+Kernel best_kernel() {
+    static const Kernel kernel = detect_kernel();
+    return kernel;
+}
+
+const char* kernel_name(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::Ssse3: return "ssse3";
+        case Kernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void mul_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n) {
+    region<false>(dst, src, c, n, best_kernel());
+}
+
+void mul_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n, Kernel kernel) {
+    region<false>(dst, src, c, n, supported(kernel) ? kernel : Kernel::Scalar);
+}
+
+void mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n) {
+    region<true>(dst, src, c, n, best_kernel());
+}
+
+void mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t c, size_t n, Kernel kernel) {
+    region<true>(dst, src, c, n, supported(kernel) ? kernel : Kernel::Scalar);
+}
+
+} // namespace gf256
@@ -1,9 +1,13 @@
 #include "ground_station.hpp"
-#include <iostream>
-#include <iomanip>
+#include "async_logger.hpp"
+#include "checkpoint.hpp"
+#include "packet_trace.hpp"
 
 GroundStation::GroundStation(Link& link, const Config& config)
     : link_(link), config_(config), rng_(config.seed + 1000) {
+    if (config_.fec) {
+        fec_ = std::make_unique<fec::PacketRecovery>();
+    }
     // Open log file
     log_file_.open(config_.log_file, std::ios::out | std::ios::trunc);
     if (log_file_.is_open()) {
@@ -18,27 +22,153 @@ GroundStation::~GroundStation() {
     }
 }
 
+void GroundStation::register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels) const {
+    registry.counter("satcom_gs_telemetry_received_total", "Telemetry packets accepted", labels,
+                     [this] { return get_telemetry_received(); });
+    registry.counter("satcom_gs_commands_sent_total", "Commands ACKed by the satellite", labels,
+                     [this] { return get_commands_sent(); });
+    registry.counter("satcom_gs_retries_total", "Command retransmissions", labels,
+                     [this] { return get_retries(); });
+    registry.counter("satcom_gs_naks_sent_total", "NAKs sent for corrupt or unparsable packets", labels,
+                     [this] { return get_naks_sent(); });
+    registry.counter("satcom_gs_events_received_total", "Satellite event packets received", labels,
+                     [this] { return get_events_received(); });
+    registry.counter("satcom_gs_plan_commands_total", "Commands queued by the command plan", labels,
+                     [this] { return get_plan_commands(); });
+    registry.counter("satcom_gs_packets_recovered_total", "Lost packets rebuilt from erasure parity", labels,
+                     [this] { return get_packets_recovered(); });
+    registry.histogram("satcom_gs_telemetry_age_seconds", "Telemetry age at ingest", labels,
+                       [this] { return get_telemetry_age(); });
+    registry.histogram("satcom_gs_ack_rtt_seconds", "Command ACK round trip per attempt", labels,
+                       [this] { return get_ack_rtt(); });
+}
+
 void GroundStation::start() {
     if (running_.exchange(true)) {
         return;  // Already running
     }
     start_time_ = std::chrono::steady_clock::now();
     last_command_time_ = start_time_;
+    start_plan();
     thread_ = std::thread(&GroundStation::run, this);
 }
 
+void GroundStation::start(CoroutineRuntime& runtime) {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    start_time_ = std::chrono::steady_clock::now();
+    last_command_time_ = start_time_;
+    start_plan();
+    agent_running_ = true;
+    runtime.spawn(run_async(runtime), [this] {
+        agent_running_ = false;
+        agent_running_.notify_all();
+    });
+}
+
+void GroundStation::request_stop() {
+    running_ = false;
+}
+
 void GroundStation::stop() {
-    if (running_.exchange(false)) {
-        if (thread_.joinable()) {
-            thread_.join();
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    agent_running_.wait(true);
+    if (plan_clock_running_) {
+        plan_offset_sec_ = plan_seconds();  // Frozen for save()
+        plan_clock_running_ = false;
+    }
+}
+
+void GroundStation::start_plan() {
+    // A fresh plan unless restore() left one to continue
+    if (config_.plan && !plan_restored_) {
+        plan_ = std::make_unique<PlanScheduler>(*config_.plan, std::vector<uint32_t>{0});
+        plan_due_.clear();
+        plan_offset_sec_ = 0.0;
+    }
+    plan_restored_ = false;
+    plan_clock_running_ = true;
+}
+
+double GroundStation::plan_seconds() const {
+    if (!plan_clock_running_) {
+        return plan_offset_sec_;
+    }
+    return plan_offset_sec_ + std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+}
+
+void GroundStation::save(CheckpointWriter& out) const {
+    if (running_) {
+        throw std::runtime_error("Ground station must be stopped to save");
+    }
+
+    out.begin("GSTN");
+    out.put(tx_seq_);
+    out.put(rx_window_);
+    out.put_rng(rng_);
+    for (const auto* counter : {&telemetry_received_, &commands_sent_, &retries_, &naks_sent_,
+                                &events_received_, &packets_recovered_, &plan_commands_}) {
+        out.put<uint64_t>(*counter);
+    }
+
+    // Plan progress, so a restored run does not resend what already went out
+    out.put<uint8_t>(plan_ ? 1 : 0);
+    if (plan_) {
+        out.put(plan_seconds());
+        out.put<uint64_t>(plan_->get_dispatched());
+        out.put_vector(plan_->queued());
+        out.put<uint32_t>(static_cast<uint32_t>(plan_due_.size()));
+        for (const Command& cmd : plan_due_) {
+            out.put_string(cmd.encode());
+        }
+    }
+    out.end();
+}
+
+void GroundStation::restore(CheckpointReader& in) {
+    if (running_) {
+        throw std::runtime_error("Ground station must be stopped to restore");
+    }
+
+    in.begin("GSTN");
+    tx_seq_ = in.get<uint32_t>();
+    rx_window_ = in.get<ReplayWindow<128>>();
+    in.get_rng(rng_);
+    for (auto* counter : {&telemetry_received_, &commands_sent_, &retries_, &naks_sent_,
+                          &events_received_, &packets_recovered_, &plan_commands_}) {
+        *counter = in.get<uint64_t>();
+    }
+
+    if (in.get<uint8_t>()) {
+        const double plan_sec = in.get<double>();
+        const uint64_t dispatched = in.get<uint64_t>();
+        auto events = in.get_vector<CommandPlan::Event>();
+        std::vector<Command> due;
+        for (uint32_t n = in.get<uint32_t>(); n > 0; --n) {
+            due.push_back(Command::decode(in.get_string()));
+        }
+        // Without a configured plan the saved progress is dropped
+        if (config_.plan) {
+            plan_ = std::make_unique<PlanScheduler>(*config_.plan, std::vector<uint32_t>{0});
+            plan_->resume(std::move(events), dispatched);
+            plan_due_ = std::move(due);
+            plan_offset_sec_ = plan_sec;
+            plan_clock_running_ = false;
+            plan_restored_ = true;
         }
     }
+    in.end();
 }
 
 void GroundStation::run() {
     while (running_) {
         receive_telemetry();
         send_periodic_commands();
+        send_queued_batches();
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
@@ -46,11 +176,84 @@ void GroundStation::run() {
 void GroundStation::receive_telemetry() {
     Packet pkt;
     while (link_.recv_sat_to_gs(pkt, std::chrono::milliseconds(0))) {
-        if (!pkt.verify_crc()) {
+        handle_downlink(pkt);
+    }
+}
+
+void GroundStation::handle_downlink(const Packet& pkt) {
+    const bool crc_ok = pkt.verify_crc();
+    SATCOM_TRACE(GroundStation, CrcChecked, pkt.type, 0, pkt.seq, crc_ok);
+    if (!crc_ok) {
+        if (config_.verbose) {
+            logging::log("[GS ] NAK seq=%u (bad CRC)", pkt.seq);
+        }
+        naks_sent_++;
+        // Send NAK
+        Packet nak;
+        nak.type = PacketType::NakPkt;
+        nak.seq = pkt.seq;
+        nak.payload = "";
+        nak.payload_size = 0;
+        nak.compute_crc();
+        link_.send_gs_to_sat(nak);
+        return;
+    }
+
+    if (pkt.type == PacketType::TelemetryPkt) {
+        // Already ingested, or too old to tell: still ACK
+        if (rx_window_.check(pkt.seq) != ReplayWindow<128>::Verdict::New) {
             if (config_.verbose) {
-                std::cout << "[GS ] NAK seq=" << pkt.seq << " (bad CRC)" << std::endl;
+                logging::log("[GS ] RX Telemetry seq=%u (duplicate) → ACK", pkt.seq);
+            }
+            Packet ack;
+            ack.type = PacketType::AckPkt;
+            ack.seq = pkt.seq;
+            ack.payload = "";
+            ack.payload_size = 0;
+            ack.compute_crc();
+            link_.send_gs_to_sat(ack);
+            return;
+        }
+
+        try {
+            Telemetry telem = Telemetry::from_json(pkt.payload);
+            // Marked seen only once parsed, so a NAKed packet's
+            // retransmission is ingested rather than ACKed as a duplicate
+            rx_window_.accept(pkt.seq);
+            telemetry_received_++;
+            telemetry_age_.record(std::chrono::steady_clock::now() - telem.ts);
+
+            if (config_.verbose) {
+                logging::log("[GS ] RX Telemetry seq=%u temp=%.1fC batt=%.1f%% alt=%.1fkm → ACK", pkt.seq,
+                             telem.temperature_c, telem.battery_pct, telem.orbit_altitude_km);
+            }
+
+            // Log telemetry
+            log_telemetry(telem);
+
+            if (plan_) {
+                plan_->on_telemetry(0, telem, plan_seconds(), [this](uint32_t, const Command& cmd) {
+                    plan_due_.push_back(cmd);
+                });
+            }
+
+            // Send ACK
+            Packet ack;
+            ack.type = PacketType::AckPkt;
+            ack.seq = pkt.seq;
+            ack.payload = "";
+            ack.payload_size = 0;
+            ack.compute_crc();
+            link_.send_gs_to_sat(ack);
+
+            if (fec_) {
+                recover(pkt);
+            }
+
+        } catch (const std::exception& e) {
+            if (config_.verbose) {
+                logging::log("[GS ] ERROR: failed to parse telemetry: %s", e.what());
             }
-            naks_sent_++;
             // Send NAK
             Packet nak;
             nak.type = PacketType::NakPkt;
@@ -59,161 +262,207 @@ void GroundStation::receive_telemetry() {
             nak.payload_size = 0;
             nak.compute_crc();
             link_.send_gs_to_sat(nak);
-            continue;
+            naks_sent_++;
         }
+    } else if (pkt.type == PacketType::EventPkt) {
+        // Best-effort notification, no ACK
+        events_received_++;
+        if (config_.verbose) {
+            logging::log("[GS ] RX EVENT seq=%u %s", pkt.seq, pkt.payload);
+        }
+    } else if (pkt.type == PacketType::ParityPkt && fec_) {
+        recover(pkt);
+    }
+}
 
-        if (pkt.type == PacketType::TelemetryPkt) {
-            // Check for duplicate
-            if (pkt.seq < rx_seq_expected_) {
-                // Duplicate, but still ACK
-                if (config_.verbose) {
-                    std::cout << "[GS ] RX Telemetry seq=" << pkt.seq << " (duplicate) → ACK" << std::endl;
-                }
-                Packet ack;
-                ack.type = PacketType::AckPkt;
-                ack.seq = pkt.seq;
-                ack.payload = "";
-                ack.payload_size = 0;
-                ack.compute_crc();
-                link_.send_gs_to_sat(ack);
-                continue;
-            }
-
-            rx_seq_expected_ = pkt.seq + 1;
-
-            try {
-                Telemetry telem = Telemetry::from_json(pkt.payload);
-                telemetry_received_++;
-
-                if (config_.verbose) {
-                    std::cout << std::fixed << std::setprecision(1);
-                    std::cout << "[GS ] RX Telemetry seq=" << pkt.seq
-                              << " temp=" << telem.temperature_c << "C"
-                              << " batt=" << telem.battery_pct << "%"
-                              << " alt=" << telem.orbit_altitude_km << "km"
-                              << " → ACK" << std::endl;
-                }
-
-                // Log telemetry
-                log_telemetry(telem);
-
-                // Send ACK
-                Packet ack;
-                ack.type = PacketType::AckPkt;
-                ack.seq = pkt.seq;
-                ack.payload = "";
-                ack.payload_size = 0;
-                ack.compute_crc();
-                link_.send_gs_to_sat(ack);
-
-            } catch (const std::exception& e) {
-                if (config_.verbose) {
-                    std::cout << "[GS ] ERROR: failed to parse telemetry: " << e.what() << std::endl;
-                }
-                // Send NAK
-                Packet nak;
-                nak.type = PacketType::NakPkt;
-                nak.seq = pkt.seq;
-                nak.payload = "";
-                nak.payload_size = 0;
-                nak.compute_crc();
-                link_.send_gs_to_sat(nak);
-                naks_sent_++;
-            }
+void GroundStation::recover(const Packet& pkt) {
+    // Rebuilt members are ingested and ACKed as if they had arrived, so
+    // the satellite never retransmits them
+    for (const Packet& rebuilt : fec_->add(pkt)) {
+        packets_recovered_++;
+        if (config_.verbose) {
+            logging::log("[GS ] REBUILT seq=%u from parity", rebuilt.seq);
         }
+        handle_downlink(rebuilt);
     }
 }
 
-void GroundStation::send_periodic_commands() {
+std::optional<Command> GroundStation::next_periodic_command() {
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start_time_).count();
     auto since_last_cmd = std::chrono::duration_cast<std::chrono::seconds>(now - last_command_time_).count();
 
     // Send commands at intervals
-    if (since_last_cmd >= 4) {
-        if (elapsed < 8) {
-            // First 8 seconds: adjust orientation
-            Command cmd;
-            cmd.type = CommandType::AdjustOrientation;
-            std::uniform_real_distribution<double> angle_dist(-2.0, 2.0);
-            cmd.d_pitch = angle_dist(rng_);
-            cmd.d_yaw = angle_dist(rng_);
-            cmd.d_roll = angle_dist(rng_);
-            send_command_with_retry(cmd);
-        } else if (elapsed >= 8 && elapsed < 12) {
-            // Mid-run: thrust burn
-            Command cmd;
-            cmd.type = CommandType::ThrustBurn;
-            cmd.burn_seconds = 2.0;
-            send_command_with_retry(cmd);
-        }
-        last_command_time_ = now;
-    }
-}
-
-void GroundStation::send_command_with_retry(const Command& cmd) {
+    if (since_last_cmd < 4) {
+        return std::nullopt;
+    }
+    last_command_time_ = now;
+
+    if (elapsed < 8) {
+        // First 8 seconds: adjust orientation
+        Command cmd;
+        cmd.type = CommandType::AdjustOrientation;
+        std::uniform_real_distribution<double> angle_dist(-2.0, 2.0);
+        cmd.d_pitch = angle_dist(rng_);
+        cmd.d_yaw = angle_dist(rng_);
+        cmd.d_roll = angle_dist(rng_);
+        return cmd;
+    } else if (elapsed >= 8 && elapsed < 12) {
+        // Mid-run: thrust burn
+        Command cmd;
+        cmd.type = CommandType::ThrustBurn;
+        cmd.burn_seconds = 2.0;
+        return cmd;
+    }
+    return std::nullopt;
+}
+
+std::optional<Packet> GroundStation::next_command_packet(size_t& commands) {
+    if (!plan_) {
+        auto cmd = next_periodic_command();
+        if (!cmd) {
+            return std::nullopt;
+        }
+        commands = 1;
+        return make_command_packet(*cmd);
+    }
+
+    // Plan mode: due timeline commands join any triggered ones
+    plan_->dispatch(plan_seconds(), [this](uint32_t, const Command& cmd) { plan_due_.push_back(cmd); });
+    if (plan_due_.empty()) {
+        return std::nullopt;
+    }
+    commands = plan_due_.size();
+    plan_commands_ += commands;
+    std::optional<Packet> pkt;
+    if (commands == 1) {
+        pkt = make_command_packet(plan_due_.front());
+    } else {
+        pkt = make_batch_packet(CommandBatch{std::move(plan_due_)}.encode(), commands);
+    }
+    plan_due_.clear();
+    return pkt;
+}
+
+void GroundStation::send_periodic_commands() {
+    size_t commands = 0;
+    if (auto pkt = next_command_packet(commands)) {
+        send_with_retry(*pkt, commands);
+    }
+}
+
+void GroundStation::send_batch(std::vector<Command> commands) {
+    CommandBatch batch{std::move(commands)};
+    std::string payload = batch.encode();
+    batches_.push({std::move(payload), batch.commands.size()});
+}
+
+void GroundStation::send_queued_batches() {
+    while (running_) {
+        auto batch = batches_.try_pop();
+        if (!batch) {
+            break;
+        }
+        send_with_retry(make_batch_packet(std::move(batch->first), batch->second), batch->second);
+    }
+}
+
+Packet GroundStation::make_command_packet(const Command& cmd) {
     Packet pkt;
     pkt.type = PacketType::CommandPkt;
     pkt.seq = tx_seq_++;
-    pkt.payload = cmd.serialize();
+    pkt.payload = cmd.encode();
     pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
     pkt.compute_crc();
+    SATCOM_TRACE(GroundStation, Created, pkt.type, 0, pkt.seq, 0);
 
     if (config_.verbose) {
-        std::cout << "[GS ] CMD TX " << cmd.name() << " seq=" << pkt.seq;
         if (cmd.type == CommandType::AdjustOrientation) {
-            std::cout << " d=(" << std::fixed << std::setprecision(1)
-                      << cmd.d_pitch << "," << cmd.d_yaw << "," << cmd.d_roll << ")";
+            logging::log("[GS ] CMD TX %s seq=%u d=(%.1f,%.1f,%.1f)", cmd.name(), pkt.seq,
+                         cmd.d_pitch, cmd.d_yaw, cmd.d_roll);
         } else if (cmd.type == CommandType::ThrustBurn) {
-            std::cout << " t=" << cmd.burn_seconds << "s";
+            logging::log("[GS ] CMD TX %s seq=%u t=%.1fs", cmd.name(), pkt.seq, cmd.burn_seconds);
+        } else {
+            logging::log("[GS ] CMD TX %s seq=%u", cmd.name(), pkt.seq);
         }
-        std::cout << std::endl;
     }
+    return pkt;
+}
 
+Packet GroundStation::make_batch_packet(std::string payload, size_t commands) {
+    Packet pkt;
+    pkt.type = PacketType::CommandBatchPkt;
+    pkt.seq = tx_seq_++;
+    pkt.payload = std::move(payload);
+    pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+    pkt.compute_crc();
+    SATCOM_TRACE(GroundStation, Created, pkt.type, 0, pkt.seq, 0);
+
+    if (config_.verbose) {
+        logging::log("[GS ] CMD TX batch seq=%u (%zu commands, %zu bytes)", pkt.seq, commands, pkt.payload.size());
+    }
+    return pkt;
+}
+
+void GroundStation::note_retry(uint32_t seq, int retry) {
+    retries_++;
+    SATCOM_TRACE(GroundStation, Retransmitted, PacketType::CommandPkt, 0, seq, retry);
+    if (config_.verbose) {
+        logging::log("[GS ] WARN: missed ACK for cmd seq=%u → retry %d/%d", seq, retry, config_.max_retries);
+    }
+}
+
+void GroundStation::finish_command(uint32_t seq, bool delivered, size_t commands) {
+    if (delivered) {
+        commands_sent_ += commands;
+    } else if (config_.verbose && running_) {
+        logging::log("[GS ] ERROR: failed to send command seq=%u after %d retries", seq, config_.max_retries);
+    }
+}
+
+void GroundStation::send_with_retry(const Packet& pkt, size_t commands) {
     // Send with retry logic
     bool success = false;
     for (int retry = 0; retry <= config_.max_retries && running_; ++retry) {
         if (retry > 0) {
-            retries_++;
-            if (config_.verbose) {
-                std::cout << "[GS ] WARN: missed ACK for cmd seq=" << pkt.seq
-                          << " → retry " << retry << "/" << config_.max_retries << std::endl;
-            }
+            note_retry(pkt.seq, retry);
         }
 
+        auto sent_at = std::chrono::steady_clock::now();
         link_.send_gs_to_sat(pkt);
 
         // Wait for ACK
         if (wait_for_ack(pkt.seq, std::chrono::milliseconds(config_.ack_timeout_ms))) {
+            ack_rtt_.record(std::chrono::steady_clock::now() - sent_at);
+            SATCOM_TRACE(GroundStation, Acked, pkt.type, 0, pkt.seq, retry);
             success = true;
             break;
         }
     }
 
-    if (success) {
-        commands_sent_++;
-    } else if (config_.verbose && running_) {
-        std::cout << "[GS ] ERROR: failed to send command seq=" << pkt.seq
-                  << " after " << config_.max_retries << " retries" << std::endl;
-    }
+    finish_command(pkt.seq, success, commands);
 }
 
 bool GroundStation::wait_for_ack(uint32_t seq, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
     Packet pkt;
-    if (link_.recv_sat_to_gs(pkt, timeout)) {
-        if (pkt.type == PacketType::AckPkt && pkt.seq == seq) {
-            if (config_.verbose) {
-                std::cout << "[GS ] RX ACK seq=" << seq << std::endl;
-            }
-            return true;
-        } else if (pkt.type == PacketType::NakPkt && pkt.seq == seq) {
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        if (!link_.recv_sat_to_gs(pkt, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now))) {
+            continue;
+        }
+        if ((pkt.type == PacketType::AckPkt || pkt.type == PacketType::NakPkt) && pkt.seq == seq) {
             if (config_.verbose) {
-                std::cout << "[GS ] RX NAK seq=" << seq << std::endl;
+                logging::log("[GS ] RX %s seq=%u", pkt.type == PacketType::AckPkt ? "ACK" : "NAK", seq);
             }
-            return false;
+            return pkt.type == PacketType::AckPkt;
         }
+        handle_downlink(pkt);  // Telemetry keeps flowing while we wait
     }
-    return false;
 }
 
 void GroundStation::log_telemetry(const Telemetry& t) {
@@ -221,3 +470,56 @@ void GroundStation::log_telemetry(const Telemetry& t) {
         log_file_ << t.to_csv() << std::endl;
     }
 }
+
+Task<void> GroundStation::run_async(CoroutineRuntime& rt) {
+    while (running_) {
+        receive_telemetry();
+        size_t commands = 0;
+        if (auto pkt = next_command_packet(commands)) {
+            co_await send_async(rt, std::move(*pkt), commands);
+        }
+        while (running_) {
+            auto batch = batches_.try_pop();
+            if (!batch) {
+                break;
+            }
+            co_await send_async(rt, make_batch_packet(std::move(batch->first), batch->second), batch->second);
+        }
+        co_await rt.sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+Task<void> GroundStation::send_async(CoroutineRuntime& rt, Packet pkt, size_t commands) {
+    bool success = false;
+    for (int retry = 0; retry <= config_.max_retries && running_; ++retry) {
+        if (retry > 0) {
+            note_retry(pkt.seq, retry);
+        }
+        auto sent_at = std::chrono::steady_clock::now();
+        link_.send_gs_to_sat(pkt);
+        if (co_await wait_for_ack_async(rt, pkt.seq, std::chrono::milliseconds(config_.ack_timeout_ms))) {
+            ack_rtt_.record(std::chrono::steady_clock::now() - sent_at);
+            SATCOM_TRACE(GroundStation, Acked, pkt.type, 0, pkt.seq, retry);
+            success = true;
+            break;
+        }
+    }
+
+    finish_command(pkt.seq, success, commands);
+}
+
+Task<bool> GroundStation::wait_for_ack_async(CoroutineRuntime& rt, uint32_t seq,
+                                             std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (auto pkt = co_await rt.recv_sat_to_gs(link_, deadline)) {
+        if ((pkt->type == PacketType::AckPkt || pkt->type == PacketType::NakPkt) && pkt->seq == seq) {
+            if (config_.verbose) {
+                logging::log("[GS ] RX %s seq=%u", pkt->type == PacketType::AckPkt ? "ACK" : "NAK", seq);
+            }
+            co_return pkt->type == PacketType::AckPkt;
+        }
+        handle_downlink(*pkt);  // Telemetry keeps flowing while we wait
+    }
+    co_return false;
+}
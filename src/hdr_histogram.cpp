@@ -0,0 +1,115 @@
+#include "hdr_histogram.hpp"
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+void HdrHistogram::record(uint64_t value, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    counts_[bucket_index(value)] += count;
+    count_ += count;
+    sum_ += value * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void HdrHistogram::clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+uint64_t HdrHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const double clamped = std::clamp(p, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::clamp(bucket_highest(i), min(), max_);
+        }
+    }
+    return max_;
+}
+
+void HdrHistogram::print(std::ostream& out, const std::string& label) const {
+    auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(3)
+        << label << ": p50 " << ms(percentile(50.0)) << "ms, p99 " << ms(percentile(99.0))
+        << "ms, p999 " << ms(percentile(99.9)) << "ms, max " << ms(max()) << "ms (n=" << count_ << ")";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+LatencyHistogram::~LatencyHistogram() {
+    for (auto& slot : shards_) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::Shard& LatencyHistogram::local_shard() {
+    const size_t slot = this_thread_index() % kMaxShards;
+    Shard* shard = shards_[slot].load(std::memory_order_acquire);
+    if (!shard) {
+        auto* fresh = new Shard;
+        if (shards_[slot].compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)) {
+            shard = fresh;
+        } else {
+            delete fresh;  // Another thread on this slot won
+        }
+    }
+    return *shard;
+}
+
+HdrHistogram LatencyHistogram::snapshot() const {
+    HdrHistogram merged;
+    for (const auto& slot : shards_) {
+        const Shard* shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (size_t i = 0; i < HdrHistogram::kBucketCount; ++i) {
+            uint64_t c = shard->counts[i].load(std::memory_order_relaxed);
+            merged.counts_[i] += c;
+            merged.count_ += c;
+        }
+        merged.sum_ += shard->sum.load(std::memory_order_relaxed);
+        merged.min_ = std::min(merged.min_, shard->min.load(std::memory_order_relaxed));
+        merged.max_ = std::max(merged.max_, shard->max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& slot : shards_) {
+        Shard* shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (auto& c : shard->counts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+        shard->sum.store(0, std::memory_order_relaxed);
+        shard->min.store(UINT64_MAX, std::memory_order_relaxed);
+        shard->max.store(0, std::memory_order_relaxed);
+    }
+}
@@ -1,20 +1,22 @@
 #include "link.hpp"
+#include "checkpoint.hpp"
+#include "counter_rng.hpp"
+#include "packet_trace.hpp"
 #include <algorithm>
+#include <utility>
 
 Link::Link(const Config& config)
-    : config_(config), rng_(config.seed) {}
+    : config_(config), rng_(config.seed) {
+    sat_to_gs_.residency = config_.sat_to_gs_residency;
+    gs_to_sat_.residency = config_.gs_to_sat_residency;
+}
 
 void Link::send_sat_to_gs(Packet pkt) {
     apply_impairments_and_send(std::move(pkt), sat_to_gs_);
 }
 
 bool Link::recv_sat_to_gs(Packet& out, std::chrono::milliseconds timeout) {
-    auto opt = sat_to_gs_.try_pop(timeout);
-    if (opt) {
-        out = std::move(*opt);
-        return true;
-    }
-    return false;
+    return receive(sat_to_gs_, out, timeout);
 }
 
 void Link::send_gs_to_sat(Packet pkt) {
@@ -22,46 +24,239 @@ void Link::send_gs_to_sat(Packet pkt) {
 }
 
 bool Link::recv_gs_to_sat(Packet& out, std::chrono::milliseconds timeout) {
-    auto opt = gs_to_sat_.try_pop(timeout);
-    if (opt) {
-        out = std::move(*opt);
-        return true;
+    return receive(gs_to_sat_, out, timeout);
+}
+
+void Link::notify_sat_to_gs(ArrivalHook hook) {
+    arm(sat_to_gs_, std::move(hook));
+}
+
+void Link::notify_gs_to_sat(ArrivalHook hook) {
+    arm(gs_to_sat_, std::move(hook));
+}
+
+void Link::arm(Channel& channel, ArrivalHook hook) {
+    std::optional<std::chrono::steady_clock::time_point> head;
+    {
+        std::lock_guard<std::mutex> lock(rng_mutex_);
+        head = channel.queue.peek([](const InFlight& f) { return f.deliver_at; });
+        if (!head) {
+            channel.arrival_hook = std::move(hook);
+            return;
+        }
+        channel.arrival_hook = nullptr;
+    }
+    hook(*head);
+}
+
+void Link::enqueue(Channel& channel, InFlight in_flight) {
+    ArrivalHook hook;
+    auto deliver_at = in_flight.deliver_at;
+    {
+        std::lock_guard<std::mutex> lock(rng_mutex_);
+        if (deferred()) {
+            // Never overtake earlier packets
+            deliver_at = std::max(deliver_at, channel.last_deliver_at);
+            channel.last_deliver_at = deliver_at;
+            in_flight.deliver_at = deliver_at;
+        }
+        SATCOM_TRACE(Link, Enqueued, in_flight.pkt.type, config_.trace_id, in_flight.pkt.seq, 0);
+        channel.queue.push(std::move(in_flight));
+        hook = std::move(channel.arrival_hook);
+        channel.arrival_hook = nullptr;
+    }
+    if (hook) {
+        hook(deliver_at);
+    }
+}
+
+bool Link::receive(Channel& channel, Packet& out, std::chrono::milliseconds timeout) {
+    if (config_.clock) {
+        // Logical time stands still while we wait, so never block
+        const auto now = config_.clock->now();
+        auto opt = channel.queue.try_pop_if(
+            [now](const InFlight& f) { return f.deliver_at <= now; });
+        if (opt) {
+            take(channel, *opt, out);
+            return true;
+        }
+        return false;
+    }
+
+    if (!config_.deferred_delivery) {
+        auto opt = channel.queue.try_pop(timeout);
+        if (opt) {
+            take(channel, *opt, out);
+            return true;
+        }
+        return false;
+    }
+
+    // Deferred: only the head is eligible, once its delivery time has passed
+    auto now = std::chrono::steady_clock::now();
+    const auto deadline = now + timeout;
+    while (true) {
+        auto opt = channel.queue.try_pop_if(
+            [now](const InFlight& f) { return f.deliver_at <= now; });
+        if (opt) {
+            take(channel, *opt, out);
+            return true;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            deadline - now, std::chrono::milliseconds(1)));
+        now = std::chrono::steady_clock::now();
+    }
+}
+
+void Link::take(Channel& channel, InFlight& in_flight, Packet& out) {
+    if (channel.residency) {
+        channel.residency->record(now() - in_flight.deliver_at);
+    }
+    SATCOM_TRACE(Link, Dequeued, in_flight.pkt.type, config_.trace_id, in_flight.pkt.seq,
+                 std::chrono::duration_cast<std::chrono::microseconds>(now() - in_flight.deliver_at).count());
+    out = std::move(in_flight.pkt);
+}
+
+void Link::draw_impairments(Channel& channel, double& loss_value, double& delay_ms) {
+    if (config_.clock) {
+        // Key by what the draw is for, not by how many draws came before
+        const uint64_t now_ns = config_.clock->now_ns();
+        if (channel.draw_ns != now_ns) {
+            channel.draw_ns = now_ns;
+            channel.draw_index = 0;
+        }
+        const uint64_t direction = &channel == &sat_to_gs_ ? 0 : 1;
+        const uint64_t key = channel.draw_index++ * 3;
+        using namespace counter_rng;
+        loss_value = unit(hash(config_.seed, direction, now_ns, key));
+        delay_ms = std::max(0.0, config_.latency_ms + config_.jitter_ms *
+            normal(hash(config_.seed, direction, now_ns, key + 1),
+                   hash(config_.seed, direction, now_ns, key + 2)));
+        return;
     }
-    return false;
+
+    // Apply packet loss
+    std::uniform_real_distribution<double> loss_dist(0.0, 1.0);
+    loss_value = loss_dist(rng_);
+
+    // Apply latency with jitter (normal distribution)
+    std::normal_distribution<double> latency_dist(
+        static_cast<double>(config_.latency_ms),
+        static_cast<double>(config_.jitter_ms)
+    );
+    delay_ms = std::max(0.0, latency_dist(rng_));
 }
 
-void Link::apply_impairments_and_send(Packet pkt, ThreadSafeQueue<Packet>& queue) {
+void Link::apply_impairments_and_send(Packet pkt, Channel& channel) {
     packets_sent_++;
+    SATCOM_TRACE(Link, Sent, pkt.type, config_.trace_id, pkt.seq, 0);
 
     // Thread-safe random number generation
     double loss_value, delay_ms;
     {
         std::lock_guard<std::mutex> lock(rng_mutex_);
-
-        // Apply packet loss
-        std::uniform_real_distribution<double> loss_dist(0.0, 1.0);
-        loss_value = loss_dist(rng_);
-
-        // Apply latency with jitter (normal distribution)
-        std::normal_distribution<double> latency_dist(
-            static_cast<double>(config_.latency_ms),
-            static_cast<double>(config_.jitter_ms)
-        );
-        delay_ms = std::max(0.0, latency_dist(rng_));
+        draw_impairments(channel, loss_value, delay_ms);
     }
 
     if (loss_value < config_.loss_prob) {
         packets_dropped_++;
+        SATCOM_TRACE(Link, Dropped, pkt.type, config_.trace_id, pkt.seq, 0);
         return;  // Packet lost
     }
+    SATCOM_TRACE(Link, Delayed, pkt.type, config_.trace_id, pkt.seq, delay_ms * 1000.0);
+
+    auto delay = std::chrono::milliseconds(static_cast<long long>(delay_ms));
+
+    if (config_.clock) {
+        // Never deliverable in the instant it was sent
+        std::chrono::steady_clock::duration lockstep_delay = delay;
+        lockstep_delay = std::max(lockstep_delay, std::chrono::steady_clock::duration(1));
+        enqueue(channel, InFlight{std::move(pkt), now() + lockstep_delay});
+        return;
+    }
+
+    if (config_.deferred_delivery) {
+        // Timestamp and return immediately
+        enqueue(channel, InFlight{std::move(pkt), std::chrono::steady_clock::now() + delay});
+        return;
+    }
 
     // Sleep to simulate latency (inline, simple approach)
     if (delay_ms > 0) {
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(static_cast<long long>(delay_ms))
-        );
+        std::this_thread::sleep_for(delay);
     }
 
     // Enqueue packet
-    queue.push(std::move(pkt));
+    enqueue(channel, InFlight{std::move(pkt), std::chrono::steady_clock::now()});
+}
+
+void Link::register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels) const {
+    registry.counter("satcom_link_packets_sent_total", "Packets offered to the link", labels,
+                     [this] { return get_packets_sent(); });
+    registry.counter("satcom_link_packets_dropped_total", "Packets lost to simulated impairments", labels,
+                     [this] { return get_packets_dropped(); });
+}
+
+void Link::save(CheckpointWriter& out) const {
+    const auto now = this->now();
+    std::lock_guard<std::mutex> lock(rng_mutex_);
+    out.begin("LINK");
+    out.put_rng(rng_);
+    out.put<uint64_t>(packets_sent_);
+    out.put<uint64_t>(packets_dropped_);
+    save_channel(out, sat_to_gs_, now);
+    save_channel(out, gs_to_sat_, now);
+    out.end();
+}
+
+void Link::save_channel(CheckpointWriter& out, const Channel& channel,
+                        std::chrono::steady_clock::time_point now) const {
+    auto in_flight = channel.queue.snapshot();
+    out.put<uint32_t>(static_cast<uint32_t>(in_flight.size()));
+    for (const InFlight& f : in_flight) {
+        auto remaining = std::max(std::chrono::steady_clock::duration::zero(), f.deliver_at - now);
+        out.put<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+        out.put_packet(f.pkt);
+    }
+}
+
+void Link::restore(CheckpointReader& in) {
+    const auto now = this->now();
+    ArrivalHook sat_to_gs_hook, gs_to_sat_hook;
+    {
+        std::lock_guard<std::mutex> lock(rng_mutex_);
+        in.begin("LINK");
+        in.get_rng(rng_);
+        packets_sent_ = in.get<uint64_t>();
+        packets_dropped_ = in.get<uint64_t>();
+        restore_channel(in, sat_to_gs_, now);
+        restore_channel(in, gs_to_sat_, now);
+        in.end();
+        sat_to_gs_hook = std::exchange(sat_to_gs_.arrival_hook, nullptr);
+        gs_to_sat_hook = std::exchange(gs_to_sat_.arrival_hook, nullptr);
+    }
+
+    // Re-arm waiting receivers so they see restored packets
+    if (sat_to_gs_hook) {
+        arm(sat_to_gs_, std::move(sat_to_gs_hook));
+    }
+    if (gs_to_sat_hook) {
+        arm(gs_to_sat_, std::move(gs_to_sat_hook));
+    }
+}
+
+void Link::restore_channel(CheckpointReader& in, Channel& channel,
+                           std::chrono::steady_clock::time_point now) {
+    channel.queue.clear();
+    channel.last_deliver_at = {};
+    uint32_t count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) {
+        auto deliver_at = now + std::chrono::nanoseconds(in.get<int64_t>());
+        Packet pkt = in.get_packet();
+        channel.last_deliver_at = std::max(channel.last_deliver_at, deliver_at);
+        channel.queue.push(InFlight{std::move(pkt), deliver_at});
+    }
 }
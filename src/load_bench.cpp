@@ -0,0 +1,202 @@
+#include "load_bench.hpp"
+#include "constellation.hpp"
+#include "multi_ground_station.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <sys/resource.h>
+
+namespace {
+
+double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto secs = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) + tv.tv_usec / 1e6; };
+    return secs(usage.ru_utime) + secs(usage.ru_stime);
+}
+
+} // namespace
+
+LoadBench::LoadBench(const Config& config) : config_(config) {
+    if (config_.num_satellites == 0 || config_.start_load <= 0.0 || config_.step_sec <= 0.0) {
+        throw std::runtime_error("Load bench needs satellites, a positive load and step time");
+    }
+}
+
+LoadBench::Step LoadBench::run_step(double offered_per_sec) const {
+    const size_t n = config_.num_satellites;
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    Step step;
+    step.offered_per_sec = offered_per_sec;
+    step.telemetry_rate_hz = offered_per_sec / static_cast<double>(n);
+
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    links.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        Link::Config link_config;
+        link_config.latency_ms = config_.latency_ms;
+        link_config.jitter_ms = config_.jitter_ms;
+        link_config.loss_prob = config_.loss;
+        link_config.seed = config_.seed + static_cast<unsigned int>(i);
+        link_config.deferred_delivery = true;
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+    }
+
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = config_.gs_workers ? config_.gs_workers : cores;
+    gs_config.ack_timeout_ms = config_.ack_timeout_ms;
+    gs_config.max_retries = config_.max_retries;
+    MultiGroundStation ground_station(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        ground_station.add_session(static_cast<uint32_t>(i), *links[i]);
+    }
+
+    // Telemetry goes out every whole number of ticks, so tick at an exact
+    // multiple of the per-satellite rate (and at least 10 Hz)
+    ConstellationEngine::Config engine_config;
+    engine_config.num_satellites = n;
+    engine_config.num_workers = config_.workers;
+    engine_config.tick_hz = step.telemetry_rate_hz * std::ceil(10.0 / step.telemetry_rate_hz);
+    engine_config.telemetry_rate_hz = step.telemetry_rate_hz;
+    engine_config.ack_timeout_ms = config_.ack_timeout_ms;
+    engine_config.max_retries = config_.max_retries;
+    engine_config.seed = config_.seed;
+    ConstellationEngine engine(engine_config, link_ptrs);
+
+    ground_station.start();
+    engine.start();
+
+    // Commands go out round-robin at a steady rate for the whole step
+    Command cmd;
+    cmd.type = CommandType::AdjustOrientation;
+    cmd.d_pitch = 0.5;
+    uint32_t next_sat = 0;
+    auto pace_commands = [&](std::chrono::steady_clock::time_point until) {
+        if (config_.command_rate_hz <= 0.0) {
+            std::this_thread::sleep_until(until);
+            return;
+        }
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / config_.command_rate_hz));
+        for (auto next = std::chrono::steady_clock::now(); next < until; next += period) {
+            std::this_thread::sleep_until(next);
+            ground_station.send_command(next_sat, cmd);
+            next_sat = static_cast<uint32_t>((next_sat + 1) % n);
+        }
+        std::this_thread::sleep_until(until);
+    };
+
+    auto window_start = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(config_.warmup_sec));
+    pace_commands(window_start);
+
+    const uint64_t sent0 = engine.get_telemetry_sent();
+    const uint64_t delivered0 = ground_station.get_telemetry_received();
+    const uint64_t retries0 = engine.get_retries() + ground_station.get_retries();
+    const uint64_t ticks0 = engine.get_ticks();
+    const uint64_t overruns0 = engine.get_tick_overruns();
+    const double cpu0 = cpu_seconds();
+    window_start = std::chrono::steady_clock::now();
+
+    pace_commands(window_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(config_.step_sec)));
+
+    const double cpu = cpu_seconds() - cpu0;
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - window_start).count();
+    const uint64_t delivered = ground_station.get_telemetry_received() - delivered0;
+    step.sent_per_sec = static_cast<double>(engine.get_telemetry_sent() - sent0) / elapsed;
+    step.delivered_per_sec = static_cast<double>(delivered) / elapsed;
+    step.retransmissions = engine.get_retries() + ground_station.get_retries() - retries0;
+    step.ticks = engine.get_ticks() - ticks0;
+    step.tick_overruns = engine.get_tick_overruns() - overruns0;
+    step.cpu_us_per_packet = delivered ? cpu * 1e6 / static_cast<double>(delivered) : 0.0;
+
+    engine.stop();
+    ground_station.stop();
+
+    std::vector<double> rtts = ground_station.get_command_rtts_ms();
+    step.commands_acked = rtts.size();
+    step.rtt_p50_ms = percentile(rtts, 50.0);
+    step.rtt_p90_ms = percentile(rtts, 90.0);
+    step.rtt_p99_ms = percentile(rtts, 99.0);
+    step.rtt_max_ms = percentile(rtts, 100.0);
+
+    step.saturated = step.delivered_per_sec <
+        config_.saturation_ratio * offered_per_sec * (1.0 - config_.loss);
+    return step;
+}
+
+std::vector<LoadBench::Step> LoadBench::run(std::function<void(const Step&)> on_step) const {
+    std::vector<Step> steps;
+    double load = config_.start_load;
+    for (int i = 0; i < std::max(1, config_.max_steps); ++i) {
+        steps.push_back(run_step(load));
+        if (on_step) {
+            on_step(steps.back());
+        }
+        if (steps.back().saturated) {
+            break;
+        }
+        load *= config_.load_factor;
+    }
+    return steps;
+}
+
+double LoadBench::percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+    return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+void LoadBench::write_json(std::ostream& out, const Config& config, const std::vector<Step>& steps) {
+    const Step* knee = nullptr;
+    for (const auto& step : steps) {
+        if (!step.saturated) knee = &step;
+    }
+
+    auto flags = out.flags();
+    out << std::setprecision(6);
+    out << "{\n  \"config\": {"
+        << "\"satellites\": " << config.num_satellites
+        << ", \"step_sec\": " << config.step_sec
+        << ", \"command_rate_hz\": " << config.command_rate_hz
+        << ", \"loss\": " << config.loss
+        << ", \"latency_ms\": " << config.latency_ms
+        << ", \"jitter_ms\": " << config.jitter_ms
+        << ", \"ack_timeout_ms\": " << config.ack_timeout_ms
+        << ", \"max_retries\": " << config.max_retries
+        << ", \"seed\": " << config.seed << "},\n"
+        << "  \"saturation_offered_per_sec\": " << (knee ? knee->offered_per_sec : 0.0) << ",\n"
+        << "  \"steps\": [";
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const auto& s = steps[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"offered_per_sec\": " << s.offered_per_sec
+            << ", \"telemetry_rate_hz\": " << s.telemetry_rate_hz
+            << ", \"sent_per_sec\": " << s.sent_per_sec
+            << ", \"delivered_per_sec\": " << s.delivered_per_sec
+            << ", \"retransmissions\": " << s.retransmissions
+            << ", \"ticks\": " << s.ticks
+            << ", \"tick_overruns\": " << s.tick_overruns
+            << ", \"cpu_us_per_packet\": " << s.cpu_us_per_packet
+            << ", \"commands_acked\": " << s.commands_acked
+            << ", \"rtt_p50_ms\": " << s.rtt_p50_ms
+            << ", \"rtt_p90_ms\": " << s.rtt_p90_ms
+            << ", \"rtt_p99_ms\": " << s.rtt_p99_ms
+            << ", \"rtt_max_ms\": " << s.rtt_max_ms
+            << ", \"saturated\": " << (s.saturated ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
@@ -1,10 +1,26 @@
 #include "satellite.hpp"
+#include "async_logger.hpp"
 #include "ground_station.hpp"
+#include "multi_ground_station.hpp"
+#include "constellation.hpp"
+#include "load_bench.hpp"
 #include "link.hpp"
+#include "work_stealing_pool.hpp"
+#include "coroutine_runtime.hpp"
+#include "sweep.hpp"
+#include "checkpoint.hpp"
+#include "command_plan.hpp"
+#include "hdr_histogram.hpp"
+#include "metrics.hpp"
+#include "packet_trace.hpp"
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <cstring>
 #include <iomanip>
+#include <memory>
+#include <vector>
 
 struct SimConfig {
     int duration_sec = 20;
@@ -13,7 +29,36 @@ struct SimConfig {
     int latency_ms = 100;
     int jitter_ms = 30;
     int ack_timeout_ms = 150;
+    bool ack_timeout_set = false;
     int max_retries = 3;
+    size_t constellation = 0;
+    size_t workers = 0;
+    size_t gs_workers = 0;
+    bool use_pool = false;
+    bool coroutines = false;
+    bool deterministic = false;
+    size_t pool_threads = 0;
+    std::string sweep_file;
+    std::string sweep_out = "sweep.csv";
+    std::string checkpoint_file;
+    double checkpoint_every_sec = 0.0;
+    std::string restore_file;
+    bool bench = false;
+    double bench_load = 1000.0;
+    int bench_steps = 8;
+    double bench_step_sec = 3.0;
+    double bench_cmd_hz = 20.0;
+    std::string bench_out = "bench.json";
+    std::string trace_file;
+    int metrics_port = 0;
+    std::string plan_file;
+    size_t recorder_capacity = 4096;
+    size_t playback_window = 8;
+    std::string recorder_file;
+    double downlink_bps = 0.0;
+    bool weighted_fair_tx = false;
+    size_t fec_group = 0;
+    size_t fec_parity = 2;
     unsigned int seed = 42;
     std::string log_file = "telemetry.log";
     bool verbose = false;
@@ -31,6 +76,42 @@ void print_help(const char* prog_name) {
               << "  --jitter-ms N          Latency jitter (std dev) in ms (default: 30)\n"
               << "  --ack-timeout-ms N     ACK timeout in ms (default: 150)\n"
               << "  --max-retries N        Maximum retry attempts (default: 3)\n"
+              << "  --recorder-capacity N  Onboard telemetry recorder records (default: 4096)\n"
+              << "  --recorder-file PATH   Back the recorder with a memory-mapped file\n"
+              << "  --playback-window N    Recorded packets in flight per playback ACK wait (default: 8)\n"
+              << "  --downlink-bps F       Satellite downlink shaping rate in bits/s (default: unlimited)\n"
+              << "  --tx-policy P          Downlink QoS policy: strict | wfq (default: strict)\n"
+              << "  --fec N[:M]            Play back recorded telemetry in groups of N packets plus\n"
+              << "                         M erasure parity packets (default M: 2); the ground\n"
+              << "                         rebuilds up to M losses per group without retransmission\n"
+              << "  --constellation N      Simulate N satellites with the SoA constellation engine\n"
+              << "  --workers N            Constellation engine worker threads (default: all cores)\n"
+              << "  --gs-workers N         Ground station shard threads (default: all cores)\n"
+              << "  --pool N               Run engine and ground station on one work-stealing pool\n"
+              << "                         of N threads (0 = all cores)\n"
+              << "  --deterministic        Constellation: run in lockstep on simulated time so\n"
+              << "                         results depend only on the seed, not on threads\n"
+              << "  --coroutines           Run satellite and ground station as coroutine agents\n"
+              << "                         on a work-stealing pool (deferred-delivery link)\n"
+              << "  --sweep FILE           Run a Monte Carlo parameter sweep described by FILE\n"
+              << "  --sweep-out PATH       Sweep summary CSV path (default: sweep.csv)\n"
+              << "  --checkpoint PATH      Save simulation state to PATH when the run ends\n"
+              << "  --checkpoint-every F   Constellation: also checkpoint every F seconds while running\n"
+              << "  --restore PATH         Resume from a checkpoint written with the same options\n"
+              << "  --bench                Ramp offered telemetry load through the constellation\n"
+              << "                         pipeline until it saturates (--constellation N sets\n"
+              << "                         the satellite count, default 1000)\n"
+              << "  --bench-load F         Offered telemetry/s at the first step (default: 1000)\n"
+              << "  --bench-steps N        Maximum ramp steps, doubling the load (default: 8;\n"
+              << "                         1 = fixed load)\n"
+              << "  --bench-step-sec F     Measured seconds per step (default: 3)\n"
+              << "  --bench-cmd-hz F       Commands/s sent during each step (default: 20)\n"
+              << "  --bench-out PATH       Benchmark results JSON path (default: bench.json)\n"
+              << "  --metrics-port N       Serve live Prometheus metrics on 127.0.0.1:N/metrics\n"
+              << "  --plan FILE            Send commands from the command plan in FILE instead of\n"
+              << "                         the built-in schedule (see README)\n"
+              << "  --trace PATH           Write a Chrome trace of packet lifecycle events to PATH\n"
+              << "                         (needs a build with SATCOM_TRACING)\n"
               << "  --seed N               Random seed for determinism (default: 42)\n"
               << "  --log-file PATH        Telemetry log file path (default: telemetry.log)\n"
               << "  --verbose              Enable verbose logging\n"
@@ -58,8 +139,80 @@ bool parse_args(int argc, char* argv[], SimConfig& config) {
             config.jitter_ms = std::atoi(argv[++i]);
         } else if (arg == "--ack-timeout-ms" && i + 1 < argc) {
             config.ack_timeout_ms = std::atoi(argv[++i]);
+            config.ack_timeout_set = true;
         } else if (arg == "--max-retries" && i + 1 < argc) {
             config.max_retries = std::atoi(argv[++i]);
+        } else if (arg == "--recorder-capacity" && i + 1 < argc) {
+            config.recorder_capacity = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--recorder-file" && i + 1 < argc) {
+            config.recorder_file = argv[++i];
+        } else if (arg == "--playback-window" && i + 1 < argc) {
+            config.playback_window = static_cast<size_t>(std::atol(argv[++i]));
+            if (config.playback_window == 0) {
+                std::cerr << "Invalid --playback-window: need N >= 1\n";
+                return false;
+            }
+        } else if (arg == "--downlink-bps" && i + 1 < argc) {
+            config.downlink_bps = std::atof(argv[++i]);
+        } else if (arg == "--tx-policy" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy != "strict" && policy != "wfq") {
+                std::cerr << "Unknown tx policy: " << policy << "\n";
+                return false;
+            }
+            config.weighted_fair_tx = (policy == "wfq");
+        } else if (arg == "--fec" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            const size_t colon = spec.find(':');
+            config.fec_group = static_cast<size_t>(std::atol(spec.substr(0, colon).c_str()));
+            if (colon != std::string::npos) {
+                config.fec_parity = static_cast<size_t>(std::atol(spec.substr(colon + 1).c_str()));
+            }
+            if (config.fec_group == 0 || config.fec_parity == 0 || config.fec_group + config.fec_parity > 256) {
+                std::cerr << "Invalid --fec " << spec << ": need N >= 1, M >= 1 and N + M <= 256\n";
+                return false;
+            }
+        } else if (arg == "--constellation" && i + 1 < argc) {
+            config.constellation = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.workers = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--gs-workers" && i + 1 < argc) {
+            config.gs_workers = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--pool" && i + 1 < argc) {
+            config.use_pool = true;
+            config.pool_threads = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--coroutines") {
+            config.coroutines = true;
+        } else if (arg == "--deterministic") {
+            config.deterministic = true;
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            config.sweep_file = argv[++i];
+        } else if (arg == "--sweep-out" && i + 1 < argc) {
+            config.sweep_out = argv[++i];
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            config.checkpoint_file = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            config.checkpoint_every_sec = std::atof(argv[++i]);
+        } else if (arg == "--restore" && i + 1 < argc) {
+            config.restore_file = argv[++i];
+        } else if (arg == "--bench") {
+            config.bench = true;
+        } else if (arg == "--bench-load" && i + 1 < argc) {
+            config.bench_load = std::atof(argv[++i]);
+        } else if (arg == "--bench-steps" && i + 1 < argc) {
+            config.bench_steps = std::atoi(argv[++i]);
+        } else if (arg == "--bench-step-sec" && i + 1 < argc) {
+            config.bench_step_sec = std::atof(argv[++i]);
+        } else if (arg == "--bench-cmd-hz" && i + 1 < argc) {
+            config.bench_cmd_hz = std::atof(argv[++i]);
+        } else if (arg == "--bench-out" && i + 1 < argc) {
+            config.bench_out = argv[++i];
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            config.metrics_port = std::atoi(argv[++i]);
+        } else if (arg == "--plan" && i + 1 < argc) {
+            config.plan_file = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            config.trace_file = argv[++i];
         } else if (arg == "--seed" && i + 1 < argc) {
             config.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
         } else if (arg == "--log-file" && i + 1 < argc) {
@@ -72,6 +225,521 @@ bool parse_args(int argc, char* argv[], SimConfig& config) {
     return true;
 }
 
+/**
+ * Print one latency distribution line under a metrics section.
+ */
+void print_latency(const std::string& label, const HdrHistogram& histogram) {
+    std::cout << "  ";
+    histogram.print(std::cout, label);
+    std::cout << std::endl;
+}
+
+/**
+ * Start the packet trace if one was requested. A build without tracing
+ * compiled in warns and runs untraced.
+ */
+bool start_trace(const SimConfig& sim_config) {
+    if (sim_config.trace_file.empty()) {
+        return true;
+    }
+    if (!trace::compiled_in()) {
+        std::cerr << "Warning: --trace ignored; rebuild with -DSATCOM_TRACING=ON (make TRACING=1)"
+                  << std::endl;
+        return true;
+    }
+    try {
+        trace::Tracer::instance().start(sim_config.trace_file);
+    } catch (const std::exception& e) {
+        std::cerr << "Trace failed: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void stop_trace(const SimConfig& sim_config) {
+    auto& tracer = trace::Tracer::instance();
+    if (sim_config.trace_file.empty() || !tracer.active()) {
+        return;
+    }
+    tracer.stop();
+    std::cout << "[TRC] Wrote " << tracer.get_events_written() << " events to " << sim_config.trace_file;
+    if (tracer.get_events_dropped() > 0) {
+        std::cout << " (" << tracer.get_events_dropped() << " dropped: rings full)";
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * Serve registry on --metrics-port. Null when the option is off, or after
+ * printing why the port could not be bound (error set).
+ */
+std::unique_ptr<MetricsServer> serve_metrics(const SimConfig& sim_config, const MetricsRegistry& registry,
+                                             bool& error) {
+    error = false;
+    if (sim_config.metrics_port <= 0) {
+        return nullptr;
+    }
+    try {
+        auto server = std::make_unique<MetricsServer>(registry, static_cast<uint16_t>(sim_config.metrics_port));
+        std::cout << "Metrics: http://127.0.0.1:" << server->port() << "/metrics ("
+                  << registry.size() << " series)" << std::endl;
+        return server;
+    } catch (const std::exception& e) {
+        std::cerr << "Metrics server failed: " << e.what() << std::endl;
+        error = true;
+        return nullptr;
+    }
+}
+
+/**
+ * Load --plan. Null when the option is off, or after printing why the plan
+ * could not be loaded (error set).
+ */
+std::unique_ptr<CommandPlan> load_plan(const SimConfig& sim_config, bool& error) {
+    error = false;
+    if (sim_config.plan_file.empty()) {
+        return nullptr;
+    }
+    std::ifstream in(sim_config.plan_file);
+    if (!in) {
+        std::cerr << "Cannot open command plan: " << sim_config.plan_file << std::endl;
+        error = true;
+        return nullptr;
+    }
+    try {
+        auto plan = std::make_unique<CommandPlan>(CommandPlan::parse(in));
+        std::cout << "Command plan: " << sim_config.plan_file << " (" << plan->timelines().size()
+                  << " timelines, " << plan->triggers().size() << " triggers)" << std::endl;
+        return plan;
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid command plan: " << e.what() << std::endl;
+        error = true;
+        return nullptr;
+    }
+}
+
+/**
+ * Queue residency histograms are shared by all links, so they are
+ * registered once per run rather than by each link.
+ */
+void register_residency(MetricsRegistry& registry, const LatencyHistogram& downlink,
+                        const LatencyHistogram& uplink) {
+    registry.histogram("satcom_link_queue_residency_seconds", "Time a deliverable packet waits for its receiver",
+                       {{"direction", "downlink"}}, [&downlink] { return downlink.snapshot(); });
+    registry.histogram("satcom_link_queue_residency_seconds", "Time a deliverable packet waits for its receiver",
+                       {{"direction", "uplink"}}, [&uplink] { return uplink.snapshot(); });
+}
+
+/**
+ * --verbose protocol lines go through the async logger so console I/O
+ * stays off the agent threads.
+ */
+void start_logger(const SimConfig& sim_config) {
+    if (sim_config.verbose) {
+        logging::AsyncLogger::instance().start(std::cout);
+    }
+}
+
+void stop_logger() {
+    auto& logger = logging::AsyncLogger::instance();
+    if (!logger.active()) {
+        return;
+    }
+    logger.stop();
+    if (logger.get_lines_dropped() > 0) {
+        std::cout << "[LOG] " << logger.get_lines_dropped() << " verbose lines dropped (buffers full)"
+                  << std::endl;
+    }
+}
+
+/**
+ * Write a checkpoint through a temporary file so an interrupted save never
+ * replaces the previous checkpoint with a torn one.
+ */
+template<typename SaveFn>
+bool write_checkpoint(const std::string& path, SaveFn save) {
+    const std::string tmp = path + ".tmp";
+    try {
+        uint64_t bytes = 0;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("cannot open " + tmp);
+            }
+            CheckpointWriter writer(out);
+            save(writer);
+            writer.finish();
+            bytes = writer.bytes_written();
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("cannot rename " + tmp);
+        }
+        std::cout << "[CKP] Wrote " << path << " (" << bytes / 1024 << " KiB)" << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Checkpoint failed: " << e.what() << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+}
+
+template<typename RestoreFn>
+bool read_checkpoint(const std::string& path, RestoreFn restore) {
+    try {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        CheckpointReader reader(in);
+        restore(reader);
+        reader.begin("END ");
+        reader.end();
+        std::cout << "[CKP] Restored from " << path << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Restore failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+int run_constellation(const SimConfig& sim_config) {
+    const size_t n = sim_config.constellation;
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    // Deferred links deliver after latency, so the ACK round trip is two hops
+    int ack_timeout_ms = sim_config.ack_timeout_set
+        ? sim_config.ack_timeout_ms
+        : 2 * (sim_config.latency_ms + 2 * sim_config.jitter_ms) + 50;
+
+    std::cout << "=== Constellation Simulation ===" << std::endl;
+    std::cout << "Satellites: " << n << std::endl;
+    std::cout << "Duration: " << sim_config.duration_sec << "s" << std::endl;
+    std::cout << "Telemetry rate: " << sim_config.telemetry_rate_hz << " Hz per satellite" << std::endl;
+    std::cout << "Loss probability: " << (sim_config.loss * 100.0) << "%" << std::endl;
+    std::cout << "Link latency: " << sim_config.latency_ms << "ms ± " << sim_config.jitter_ms << "ms" << std::endl;
+    std::cout << "ACK timeout: " << ack_timeout_ms << "ms" << std::endl;
+    std::cout << "Random seed: " << sim_config.seed << std::endl;
+    if (sim_config.deterministic) {
+        std::cout << "Mode: deterministic lockstep (simulated time)" << std::endl;
+    }
+    std::cout << "================================\n" << std::endl;
+
+    // Lockstep runs share one simulated clock across links, ground station
+    // and engine; the engine advances it at every tick barrier
+    LogicalClock clock;
+    LogicalClock* lockstep_clock = sim_config.deterministic ? &clock : nullptr;
+
+    // One deferred-delivery link per satellite
+    // Residency histograms are shared by all links
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    LatencyHistogram downlink_residency, uplink_residency;
+    links.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        Link::Config link_config;
+        link_config.sat_to_gs_residency = &downlink_residency;
+        link_config.gs_to_sat_residency = &uplink_residency;
+        link_config.latency_ms = sim_config.latency_ms;
+        link_config.jitter_ms = sim_config.jitter_ms;
+        link_config.loss_prob = sim_config.loss;
+        link_config.seed = sim_config.seed + static_cast<unsigned int>(i);
+        link_config.deferred_delivery = true;
+        link_config.clock = lockstep_clock;
+        link_config.trace_id = static_cast<uint32_t>(i);
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+    }
+
+    bool plan_error = false;
+    auto plan = load_plan(sim_config, plan_error);
+    if (plan_error) {
+        return 1;
+    }
+
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = sim_config.gs_workers ? sim_config.gs_workers : cores;
+    gs_config.ack_timeout_ms = ack_timeout_ms;
+    gs_config.max_retries = sim_config.max_retries;
+    gs_config.verbose = sim_config.verbose;
+    gs_config.clock = lockstep_clock;
+    gs_config.plan = plan.get();
+    MultiGroundStation ground_station(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        ground_station.add_session(static_cast<uint32_t>(i), *links[i]);
+    }
+
+    ConstellationEngine::Config engine_config;
+    engine_config.num_satellites = n;
+    engine_config.num_workers = sim_config.workers;
+    engine_config.telemetry_rate_hz = sim_config.telemetry_rate_hz;
+    engine_config.ack_timeout_ms = ack_timeout_ms;
+    engine_config.max_retries = sim_config.max_retries;
+    engine_config.seed = sim_config.seed;
+    engine_config.clock = lockstep_clock;
+    ConstellationEngine engine(engine_config, link_ptrs);
+
+    MetricsRegistry metrics;
+    engine.register_metrics(metrics);
+    ground_station.register_metrics(metrics);
+    for (size_t i = 0; i < n; ++i) {
+        links[i]->register_metrics(metrics, {{"sat", std::to_string(i)}});
+    }
+    register_residency(metrics, downlink_residency, uplink_residency);
+
+    // Constellation checkpoints hold engine state; packets in flight on
+    // the links are not saved and are recovered by retransmission. Ground
+    // station state is not saved either, so a plan would start over and
+    // resend every command that already ran.
+    if (plan && !sim_config.restore_file.empty()) {
+        std::cerr << "--plan cannot be combined with --restore in constellation mode" << std::endl;
+        return 1;
+    }
+    if (!sim_config.restore_file.empty() &&
+        !read_checkpoint(sim_config.restore_file, [&](CheckpointReader& in) { engine.restore(in); })) {
+        return 1;
+    }
+
+    bool metrics_error = false;
+    auto metrics_server = serve_metrics(sim_config, metrics, metrics_error);
+    if (metrics_error) {
+        return 1;
+    }
+
+    std::cout << "Starting simulation..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<WorkStealingPool> pool;
+    if (sim_config.deterministic) {
+        // Ground station shards step inside the engine's tick, striped
+        // over its workers
+        engine.set_tick_peer([&ground_station](size_t worker, size_t num_workers) {
+            for (size_t s = worker; s < ground_station.worker_count(); s += num_workers) {
+                ground_station.step_shard(s);
+            }
+        });
+        engine.run(static_cast<uint64_t>(sim_config.duration_sec * engine_config.tick_hz));
+    } else if (sim_config.use_pool) {
+        pool = std::make_unique<WorkStealingPool>(sim_config.pool_threads);
+        ground_station.start(*pool);
+        engine.start(*pool);
+    } else {
+        ground_station.start();
+        engine.start();
+    }
+
+    const auto end = start + std::chrono::seconds(sim_config.duration_sec);
+    if (!sim_config.deterministic && !sim_config.checkpoint_file.empty() &&
+        sim_config.checkpoint_every_sec > 0.0) {
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(sim_config.checkpoint_every_sec));
+        for (auto next = start + period; next < end; next += period) {
+            std::this_thread::sleep_until(next);
+            auto snapshot = engine.capture();
+            std::cout << "[CKP] Tick " << snapshot->tick << ": paused "
+                      << engine.get_last_capture_ns() / 1000 << " us, "
+                      << engine.get_last_capture_blocks() << " dirty blocks" << std::endl;
+            write_checkpoint(sim_config.checkpoint_file,
+                             [&](CheckpointWriter& out) { snapshot->save(out); });
+        }
+    }
+    if (!sim_config.deterministic) {
+        std::this_thread::sleep_until(end);
+    }
+
+    std::cout << "\nStopping simulation..." << std::endl;
+    engine.stop();
+    ground_station.stop();
+    stop_logger();
+    if (metrics_server) {
+        metrics_server->stop();
+    }
+    if (!sim_config.checkpoint_file.empty()) {
+        auto snapshot = engine.capture();
+        write_checkpoint(sim_config.checkpoint_file,
+                         [&](CheckpointWriter& out) { snapshot->save(out); });
+    }
+    // Lockstep rates are per simulated second
+    double elapsed = sim_config.deterministic
+        ? std::chrono::duration<double>(clock.now().time_since_epoch()).count()
+        : std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n=== Constellation Metrics ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Engine:" << std::endl;
+    std::cout << "  Ticks: " << engine.get_ticks()
+              << " (overruns: " << engine.get_tick_overruns() << ")" << std::endl;
+    std::cout << "  Mean tick time: " << std::setprecision(3) << engine.get_mean_tick_ms() << "ms"
+              << std::setprecision(1) << std::endl;
+    std::cout << "  Telemetry sent: " << engine.get_telemetry_sent()
+              << " (" << engine.get_telemetry_sent() / elapsed << "/s)" << std::endl;
+    std::cout << "  Telemetry ACKed: " << engine.get_telemetry_acked() << std::endl;
+    std::cout << "  Telemetry unACKed: " << engine.get_telemetry_unacked() << std::endl;
+    std::cout << "  Retries: " << engine.get_retries() << std::endl;
+    std::cout << "  Safe mode entries: " << engine.get_safe_mode_entries() << std::endl;
+    print_latency("Telemetry ACK RTT", engine.get_ack_rtt());
+    if (pool) {
+        std::cout << "\nWork-stealing pool (" << pool->size() << " threads):" << std::endl;
+        std::cout << "  Tasks executed: " << pool->get_tasks_executed() << std::endl;
+        std::cout << "  Steals: " << pool->get_steals() << std::endl;
+    }
+    std::cout << "\nGround Station (" << ground_station.worker_count() << " shards):" << std::endl;
+    std::cout << "  Telemetry received: " << ground_station.get_telemetry_received()
+              << " (" << ground_station.get_telemetry_received() / elapsed << "/s)" << std::endl;
+    std::cout << "  NAKs sent: " << ground_station.get_naks_sent() << std::endl;
+    std::cout << "  Events received: " << ground_station.get_events_received() << std::endl;
+    if (plan) {
+        std::cout << "  Plan commands: " << ground_station.get_plan_commands() << std::endl;
+    }
+    print_latency("Telemetry age", ground_station.get_telemetry_age());
+    print_latency("Command ACK RTT", ground_station.get_ack_rtt());
+
+    uint64_t sent = 0, dropped = 0;
+    for (const auto& link : links) {
+        sent += link->get_packets_sent();
+        dropped += link->get_packets_dropped();
+    }
+    std::cout << "\nLinks:" << std::endl;
+    std::cout << "  Packets sent: " << sent << std::endl;
+    std::cout << "  Packets dropped: " << dropped << std::endl;
+    print_latency("Downlink queue residency", downlink_residency.snapshot());
+    print_latency("Uplink queue residency", uplink_residency.snapshot());
+    std::cout << "=============================\n" << std::endl;
+
+    return 0;
+}
+
+int run_bench(const SimConfig& sim_config) {
+    LoadBench::Config config;
+    config.num_satellites = sim_config.constellation ? sim_config.constellation : 1000;
+    config.start_load = sim_config.bench_load;
+    config.max_steps = sim_config.bench_steps;
+    config.step_sec = sim_config.bench_step_sec;
+    config.command_rate_hz = sim_config.bench_cmd_hz;
+    config.loss = sim_config.loss;
+    config.latency_ms = sim_config.latency_ms;
+    config.jitter_ms = sim_config.jitter_ms;
+    config.ack_timeout_ms = sim_config.ack_timeout_set
+        ? sim_config.ack_timeout_ms
+        : 2 * (sim_config.latency_ms + 2 * sim_config.jitter_ms) + 50;
+    config.max_retries = sim_config.max_retries;
+    config.seed = sim_config.seed;
+    config.workers = sim_config.workers;
+    config.gs_workers = sim_config.gs_workers;
+
+    std::cout << "=== Load Benchmark ===" << std::endl;
+    std::cout << "Satellites: " << config.num_satellites << std::endl;
+    std::cout << "Offered load: " << config.start_load << " telemetry/s, x" << config.load_factor
+              << " per step, up to " << config.max_steps << " steps" << std::endl;
+    std::cout << "Step: " << config.warmup_sec << "s warm-up + " << config.step_sec << "s measured, "
+              << config.command_rate_hz << " commands/s" << std::endl;
+    std::cout << "======================\n" << std::endl;
+
+    std::cout << "   offered      sent  delivered  retrans  overruns  cpu us/pkt"
+                 "   rtt p50    p90    p99    max" << std::endl;
+    std::vector<LoadBench::Step> steps;
+    try {
+        LoadBench bench(config);
+        steps = bench.run([](const LoadBench::Step& s) {
+            std::cout << std::fixed << std::setprecision(0)
+                      << std::setw(10) << s.offered_per_sec
+                      << std::setw(10) << s.sent_per_sec
+                      << std::setw(11) << s.delivered_per_sec
+                      << std::setw(9) << s.retransmissions
+                      << std::setw(10) << s.tick_overruns
+                      << std::setprecision(1) << std::setw(12) << s.cpu_us_per_packet
+                      << std::setw(10) << s.rtt_p50_ms << std::setw(7) << s.rtt_p90_ms
+                      << std::setw(7) << s.rtt_p99_ms << std::setw(7) << s.rtt_max_ms
+                      << (s.saturated ? "  SATURATED" : "") << std::endl;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const LoadBench::Step* knee = nullptr;
+    for (const auto& step : steps) {
+        if (!step.saturated) knee = &step;
+    }
+    if (knee) {
+        std::cout << "\nSaturation point: " << std::setprecision(0) << knee->offered_per_sec
+                  << " telemetry/s offered, " << knee->delivered_per_sec << " delivered" << std::endl;
+    } else {
+        std::cout << "\nSaturated at the first step; lower --bench-load" << std::endl;
+    }
+
+    std::ofstream out(sim_config.bench_out);
+    if (!out) {
+        std::cerr << "Cannot write benchmark output: " << sim_config.bench_out << std::endl;
+        return 1;
+    }
+    LoadBench::write_json(out, config, steps);
+    std::cout << "Results written to " << sim_config.bench_out << std::endl;
+    return 0;
+}
+
+int run_sweep(const SimConfig& sim_config) {
+    // Unswept parameters come from the command line
+    ParameterSweep::Point base;
+    base.telemetry_rate_hz = sim_config.telemetry_rate_hz;
+    base.loss = sim_config.loss;
+    base.latency_ms = sim_config.latency_ms;
+    base.jitter_ms = sim_config.jitter_ms;
+    base.ack_timeout_ms = sim_config.ack_timeout_set
+        ? sim_config.ack_timeout_ms
+        : 2 * (sim_config.latency_ms + 2 * sim_config.jitter_ms) + 50;
+    base.max_retries = sim_config.max_retries;
+
+    std::ifstream in(sim_config.sweep_file);
+    if (!in) {
+        std::cerr << "Cannot open sweep spec: " << sim_config.sweep_file << std::endl;
+        return 1;
+    }
+
+    std::vector<ParameterSweep::Summary> summaries;
+    try {
+        ParameterSweep::Spec spec = ParameterSweep::parse_spec(in, base);
+        if (sim_config.use_pool) {
+            spec.num_workers = sim_config.pool_threads;
+        }
+        ParameterSweep sweep(spec);
+
+        std::cout << "=== Parameter Sweep ===" << std::endl;
+        std::cout << "Spec: " << sim_config.sweep_file << std::endl;
+        std::cout << "Points: " << sweep.points().size() << " x " << spec.replicas << " replicas" << std::endl;
+        std::cout << "Run duration: " << spec.duration_sec << "s, "
+                  << spec.max_concurrent << " runs in flight" << std::endl;
+        std::cout << "=======================\n" << std::endl;
+
+        summaries = sweep.run([](size_t done, size_t total) {
+            std::cout << "[SWP] " << done << "/" << total << " runs complete" << std::endl;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Sweep failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(sim_config.sweep_out);
+    if (!out) {
+        std::cerr << "Cannot write sweep output: " << sim_config.sweep_out << std::endl;
+        return 1;
+    }
+    ParameterSweep::write_csv(out, summaries);
+
+    std::cout << "\n  rate   loss  lat  ack  retr   telem/s (95% CI)   drop rate" << std::endl;
+    for (const auto& s : summaries) {
+        const auto& tps = s.stats[ParameterSweep::TelemetryPerSec];
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(6) << s.point.telemetry_rate_hz
+                  << std::setw(7) << s.point.loss
+                  << std::setw(5) << static_cast<int>(s.point.latency_ms)
+                  << std::setw(5) << static_cast<int>(s.point.ack_timeout_ms)
+                  << std::setw(6) << static_cast<int>(s.point.max_retries)
+                  << std::setw(10) << tps.mean << " +/- " << std::setw(5) << tps.ci95
+                  << std::setw(12) << s.stats[ParameterSweep::DropRate].mean << std::endl;
+    }
+    std::cout << "\nSummary written to " << sim_config.sweep_out << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     SimConfig sim_config;
 
@@ -85,6 +753,32 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (!sim_config.sweep_file.empty()) {
+        return run_sweep(sim_config);
+    }
+    if (sim_config.bench) {
+        return run_bench(sim_config);
+    }
+
+    if (sim_config.deterministic && sim_config.constellation == 0) {
+        std::cerr << "--deterministic requires --constellation" << std::endl;
+        return 1;
+    }
+    if (!start_trace(sim_config)) {
+        return 1;
+    }
+    start_logger(sim_config);
+    if (sim_config.constellation > 0) {
+        int result = run_constellation(sim_config);
+        stop_trace(sim_config);
+        return result;
+    }
+
+    // Coroutine agents need deferred delivery, whose ACK round trip is two hops
+    if (sim_config.coroutines && !sim_config.ack_timeout_set) {
+        sim_config.ack_timeout_ms = 2 * (sim_config.latency_ms + 2 * sim_config.jitter_ms) + 50;
+    }
+
     std::cout << "=== Satellite Telemetry & Command Simulator ===" << std::endl;
     std::cout << "Duration: " << sim_config.duration_sec << "s" << std::endl;
     std::cout << "Telemetry rate: " << sim_config.telemetry_rate_hz << " Hz" << std::endl;
@@ -95,6 +789,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Random seed: " << sim_config.seed << std::endl;
     std::cout << "Log file: " << sim_config.log_file << std::endl;
     std::cout << "Verbose: " << (sim_config.verbose ? "yes" : "no") << std::endl;
+    std::cout << "Execution: " << (sim_config.coroutines ? "coroutine agents" : "threads") << std::endl;
     std::cout << "===============================================\n" << std::endl;
 
     // Create link
@@ -103,6 +798,10 @@ int main(int argc, char* argv[]) {
     link_config.jitter_ms = sim_config.jitter_ms;
     link_config.loss_prob = sim_config.loss;
     link_config.seed = sim_config.seed;
+    link_config.deferred_delivery = sim_config.coroutines;
+    LatencyHistogram downlink_residency, uplink_residency;
+    link_config.sat_to_gs_residency = &downlink_residency;
+    link_config.gs_to_sat_residency = &uplink_residency;
     Link link(link_config);
 
     // Create satellite
@@ -110,23 +809,66 @@ int main(int argc, char* argv[]) {
     sat_config.telemetry_rate_hz = sim_config.telemetry_rate_hz;
     sat_config.ack_timeout_ms = sim_config.ack_timeout_ms;
     sat_config.max_retries = sim_config.max_retries;
+    sat_config.recorder_capacity = sim_config.recorder_capacity;
+    sat_config.playback_window = sim_config.playback_window;
+    sat_config.recorder_file = sim_config.recorder_file;
+    sat_config.downlink_rate_bps = sim_config.downlink_bps;
+    sat_config.weighted_fair_tx = sim_config.weighted_fair_tx;
+    sat_config.fec_group = sim_config.fec_group;
+    sat_config.fec_parity = sim_config.fec_parity;
     sat_config.verbose = sim_config.verbose;
     sat_config.seed = sim_config.seed;
     Satellite satellite(link, sat_config);
 
     // Create ground station
+    bool plan_error = false;
+    auto plan = load_plan(sim_config, plan_error);
+    if (plan_error) {
+        return 1;
+    }
     GroundStation::Config gs_config;
     gs_config.ack_timeout_ms = sim_config.ack_timeout_ms;
     gs_config.max_retries = sim_config.max_retries;
     gs_config.log_file = sim_config.log_file;
     gs_config.verbose = sim_config.verbose;
     gs_config.seed = sim_config.seed;
+    gs_config.plan = plan.get();
+    gs_config.fec = sim_config.fec_group > 0;
     GroundStation ground_station(link, gs_config);
 
+    if (!sim_config.restore_file.empty() &&
+        !read_checkpoint(sim_config.restore_file, [&](CheckpointReader& in) {
+            link.restore(in);
+            satellite.restore(in);
+            ground_station.restore(in);
+        })) {
+        return 1;
+    }
+
+    MetricsRegistry metrics;
+    link.register_metrics(metrics);
+    satellite.register_metrics(metrics);
+    ground_station.register_metrics(metrics);
+    register_residency(metrics, downlink_residency, uplink_residency);
+    bool metrics_error = false;
+    auto metrics_server = serve_metrics(sim_config, metrics, metrics_error);
+    if (metrics_error) {
+        return 1;
+    }
+
     // Start simulation
     std::cout << "Starting simulation..." << std::endl;
-    satellite.start();
-    ground_station.start();
+    std::unique_ptr<CoroutineRuntime> runtime;
+    if (sim_config.coroutines) {
+        CoroutineRuntime::Config rt_config;
+        rt_config.num_workers = sim_config.use_pool ? sim_config.pool_threads : 1;
+        runtime = std::make_unique<CoroutineRuntime>(rt_config);
+        satellite.start(*runtime);
+        ground_station.start(*runtime);
+    } else {
+        satellite.start();
+        ground_station.start();
+    }
 
     // Run for specified duration
     std::this_thread::sleep_for(std::chrono::seconds(sim_config.duration_sec));
@@ -135,6 +877,19 @@ int main(int argc, char* argv[]) {
     std::cout << "\nStopping simulation..." << std::endl;
     satellite.stop();
     ground_station.stop();
+    stop_logger();
+    stop_trace(sim_config);
+    if (metrics_server) {
+        metrics_server->stop();
+    }
+
+    if (!sim_config.checkpoint_file.empty()) {
+        write_checkpoint(sim_config.checkpoint_file, [&](CheckpointWriter& out) {
+            link.save(out);
+            satellite.save(out);
+            ground_station.save(out);
+        });
+    }
 
     // Print metrics
     std::cout << "\n=== Simulation Metrics ===" << std::endl;
@@ -143,17 +898,51 @@ int main(int argc, char* argv[]) {
     std::cout << "  Commands received: " << satellite.get_commands_received() << std::endl;
     std::cout << "  Retries: " << satellite.get_retries() << std::endl;
     std::cout << "  NAKs received: " << satellite.get_naks_received() << std::endl;
+    std::cout << "  Time-tagged commands: " << satellite.get_scheduled_executed()
+              << "/" << satellite.get_commands_scheduled() << " executed" << std::endl;
+    std::cout << "  Recorder fill: " << satellite.get_recorder_fill() << "/"
+              << satellite.get_recorder_capacity() << std::endl;
+    std::cout << "  Recorded: " << satellite.get_records_stored()
+              << " (played back: " << satellite.get_records_played_back()
+              << ", overwritten: " << satellite.get_records_overwritten()
+              << ", rejected: " << satellite.get_records_rejected() << ")" << std::endl;
+    std::cout << "  Playback throughput: " << std::fixed << std::setprecision(1)
+              << satellite.get_playback_rate_bps() / 1024.0 << " KiB/s" << std::endl;
+    if (sim_config.fec_group > 0) {
+        std::cout << "  Parity packets sent: " << satellite.get_parity_sent() << std::endl;
+    }
+    std::cout << "  Downlink queue latency (p50/p99/max ms):" << std::endl;
+    for (size_t i = 0; i < kNumTrafficClasses; ++i) {
+        auto cls = static_cast<TrafficClass>(i);
+        auto stats = satellite.get_tx_stats(cls);
+        std::cout << "    " << std::left << std::setw(13) << traffic_class_name(cls) << std::right
+                  << std::fixed << std::setprecision(2)
+                  << stats.p50_ms << " / " << stats.p99_ms << " / " << stats.max_ms
+                  << "  (sent " << stats.sent << ", dropped " << stats.dropped << ")" << std::endl;
+    }
+    print_latency("ACK RTT", satellite.get_ack_rtt());
     std::cout << "\nGround Station:" << std::endl;
     std::cout << "  Telemetry received: " << ground_station.get_telemetry_received() << std::endl;
     std::cout << "  Commands sent: " << ground_station.get_commands_sent() << std::endl;
     std::cout << "  Retries: " << ground_station.get_retries() << std::endl;
     std::cout << "  NAKs sent: " << ground_station.get_naks_sent() << std::endl;
+    std::cout << "  Events received: " << ground_station.get_events_received() << std::endl;
+    if (plan) {
+        std::cout << "  Plan commands: " << ground_station.get_plan_commands() << std::endl;
+    }
+    if (sim_config.fec_group > 0) {
+        std::cout << "  Packets rebuilt from parity: " << ground_station.get_packets_recovered() << std::endl;
+    }
+    print_latency("Telemetry age", ground_station.get_telemetry_age());
+    print_latency("Command ACK RTT", ground_station.get_ack_rtt());
     std::cout << "\nLink:" << std::endl;
     std::cout << "  Packets sent: " << link.get_packets_sent() << std::endl;
     std::cout << "  Packets dropped: " << link.get_packets_dropped() << std::endl;
     std::cout << "  Drop rate: " << std::fixed << std::setprecision(2)
-              << (100.0 * link.get_packets_dropped() / std::max(1ULL, link.get_packets_sent())) << "%"
+              << (100.0 * link.get_packets_dropped() / std::max<uint64_t>(1, link.get_packets_sent())) << "%"
               << std::endl;
+    print_latency("Downlink queue residency", downlink_residency.snapshot());
+    print_latency("Uplink queue residency", uplink_residency.snapshot());
     std::cout << "==========================\n" << std::endl;
 
     std::cout << "Telemetry logged to: " << sim_config.log_file << std::endl;
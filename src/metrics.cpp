@@ -0,0 +1,243 @@
+#include "metrics.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+void write_labels(std::ostream& out, const MetricsRegistry::Labels& labels,
+                  const char* le = nullptr) {
+    if (labels.empty() && !le) {
+        return;
+    }
+    out << '{';
+    bool first = true;
+    auto write_one = [&](const std::string& key, const std::string& value) {
+        out << (first ? "" : ",") << key << "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                out << '\\' << c;
+            } else if (c == '\n') {
+                out << "\\n";
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+        first = false;
+    };
+    for (const auto& [key, value] : labels) {
+        write_one(key, value);
+    }
+    if (le) {
+        write_one("le", le);
+    }
+    out << '}';
+}
+
+} // namespace
+
+const std::vector<double>& MetricsRegistry::histogram_bounds_sec() {
+    static const std::vector<double> bounds = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+        0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+    return bounds;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    for (auto& f : families_) {
+        if (f.name == name) {
+            if (f.type != type) {
+                throw std::runtime_error("Metric " + name + " registered with two types");
+            }
+            return f;
+        }
+    }
+    families_.push_back(Family{name, help, type, {}});
+    return families_.back();
+}
+
+void MetricsRegistry::counter(const std::string& name, const std::string& help, Labels labels,
+                              std::function<uint64_t()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    family(name, help, Type::Counter).series.push_back(Series{std::move(labels), std::move(read), {}, {}});
+}
+
+void MetricsRegistry::gauge(const std::string& name, const std::string& help, Labels labels,
+                            std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    family(name, help, Type::Gauge).series.push_back(Series{std::move(labels), {}, std::move(read), {}});
+}
+
+void MetricsRegistry::histogram(const std::string& name, const std::string& help, Labels labels,
+                                std::function<HdrHistogram()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    family(name, help, Type::Histogram).series.push_back(Series{std::move(labels), {}, {}, std::move(read)});
+}
+
+size_t MetricsRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (const auto& f : families_) n += f.series.size();
+    return n;
+}
+
+void MetricsRegistry::write_prometheus(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::setprecision(9);
+    for (const auto& f : families_) {
+        static constexpr const char* kTypeNames[] = {"counter", "gauge", "histogram"};
+        out << "# HELP " << f.name << ' ' << f.help << '\n'
+            << "# TYPE " << f.name << ' ' << kTypeNames[static_cast<int>(f.type)] << '\n';
+        for (const auto& s : f.series) {
+            switch (f.type) {
+                case Type::Counter:
+                    out << f.name;
+                    write_labels(out, s.labels);
+                    out << ' ' << s.read_counter() << '\n';
+                    break;
+                case Type::Gauge:
+                    out << f.name;
+                    write_labels(out, s.labels);
+                    out << ' ' << s.read_gauge() << '\n';
+                    break;
+                case Type::Histogram: {
+                    // Cumulative counts per bound; a bound falls inside one
+                    // log-linear bucket, so each is exact to ~1.6%
+                    const HdrHistogram h = s.read_histogram();
+                    const auto& counts = h.counts();
+                    uint64_t cumulative = 0;
+                    size_t next = 0;
+                    for (double bound : histogram_bounds_sec()) {
+                        const size_t last = HdrHistogram::bucket_index(static_cast<uint64_t>(bound * 1e9));
+                        for (; next <= last; ++next) cumulative += counts[next];
+                        std::ostringstream le;
+                        le << bound;
+                        out << f.name << "_bucket";
+                        write_labels(out, s.labels, le.str().c_str());
+                        out << ' ' << cumulative << '\n';
+                    }
+                    out << f.name << "_bucket";
+                    write_labels(out, s.labels, "+Inf");
+                    out << ' ' << h.count() << '\n';
+                    out << f.name << "_sum";
+                    write_labels(out, s.labels);
+                    out << ' ' << static_cast<double>(h.sum()) / 1e9 << '\n';
+                    out << f.name << "_count";
+                    write_labels(out, s.labels);
+                    out << ' ' << h.count() << '\n';
+                    break;
+                }
+            }
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry, uint16_t port) : registry_(registry) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("Metrics socket: ") + std::strerror(errno));
+    }
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 8) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        const std::string error = std::strerror(errno);
+        close(listen_fd_);
+        throw std::runtime_error("Cannot listen on 127.0.0.1:" + std::to_string(port) + ": " + error);
+    }
+    port_ = ntohs(addr.sin_port);
+
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void MetricsServer::serve() {
+    while (running_) {
+        // Wake periodically to notice stop()
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        int client = accept(listen_fd_, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        handle(client);
+        close(client);
+    }
+}
+
+void MetricsServer::handle(int client) {
+    timeval timeout{1, 0};  // A stalled client cannot wedge the exporter
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    const std::string line = request.substr(0, request.find("\r\n"));
+    std::string status = "404 Not Found";
+    std::string content_type = "text/plain";
+    std::string body = "Not found; metrics are at /metrics\n";
+    if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET /metrics?", 0) == 0) {
+        std::ostringstream metrics;
+        registry_.write_prometheus(metrics);
+        status = "200 OK";
+        content_type = "text/plain; version=0.0.4; charset=utf-8";
+        body = metrics.str();
+        scrapes_++;
+    }
+
+    const std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + content_type +
+                                 "\r\nContent-Length: " + std::to_string(body.size()) +
+                                 "\r\nConnection: close\r\n\r\n" + body;
+    for (size_t sent = 0; sent < response.size();) {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
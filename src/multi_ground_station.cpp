@@ -0,0 +1,396 @@
+#include "multi_ground_station.hpp"
+#include "async_logger.hpp"
+#include "packet_trace.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+MultiGroundStation::MultiGroundStation(const Config& config) : config_(config) {
+    size_t workers = std::max<size_t>(1, config_.num_workers);
+    for (size_t i = 0; i < workers; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = i;
+        if (!config_.archive_dir.empty()) {
+            std::string path = config_.archive_dir + "/gs_shard_" + std::to_string(i) + ".log";
+            shard->archive.open(path, std::ios::out | std::ios::trunc);
+            if (shard->archive.is_open()) {
+                shard->archive << "sat_id," << Telemetry::csv_header() << "\n";
+            }
+        }
+        shards_.push_back(std::move(shard));
+    }
+}
+
+MultiGroundStation::~MultiGroundStation() {
+    stop();
+}
+
+void MultiGroundStation::add_session(uint32_t sat_id, Link& link) {
+    if (running_) {
+        throw std::runtime_error("Cannot add sessions while running");
+    }
+    if (session_shard_.count(sat_id)) {
+        throw std::runtime_error("Duplicate satellite ID: " + std::to_string(sat_id));
+    }
+
+    Shard& shard = *shards_[shard_of(sat_id)];
+    auto session = std::make_unique<Session>();
+    session->sat_id = sat_id;
+    session->link = &link;
+    shard.by_id[sat_id] = session.get();
+    shard.sessions.push_back(std::move(session));
+    session_shard_[sat_id] = shard.index;
+}
+
+void MultiGroundStation::start() {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    for (auto& shard : shards_) {
+        shard->thread = std::thread(&MultiGroundStation::run_shard, this, std::ref(*shard));
+    }
+}
+
+void MultiGroundStation::start(WorkStealingPool& pool) {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    active_agents_ = shards_.size();
+    for (auto& shard : shards_) {
+        Shard* s = shard.get();
+        pool.spawn_agent([this, s] {
+            if (!running_) {
+                if (--active_agents_ == 0) {
+                    active_agents_.notify_all();
+                }
+                return WorkStealingPool::AgentStep::done();
+            }
+            if (shard_pass(*s)) {
+                return WorkStealingPool::AgentStep::yield();
+            }
+            return WorkStealingPool::AgentStep::sleep_for(std::chrono::milliseconds(1));
+        });
+    }
+}
+
+void MultiGroundStation::stop() {
+    if (running_.exchange(false)) {
+        // Pool-mode shards notice on their next step
+        for (size_t n = active_agents_; n != 0; n = active_agents_) {
+            active_agents_.wait(n);
+        }
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+            if (shard->archive.is_open()) {
+                shard->archive.flush();
+            }
+        }
+    }
+}
+
+bool MultiGroundStation::send_command(uint32_t sat_id, const Command& cmd) {
+    auto it = session_shard_.find(sat_id);
+    if (it == session_shard_.end()) {
+        return false;
+    }
+    shards_[it->second]->command_requests.push({sat_id, Uplink{PacketType::CommandPkt, cmd.encode(), 1}});
+    return true;
+}
+
+bool MultiGroundStation::send_batch(uint32_t sat_id, std::vector<Command> commands) {
+    auto it = session_shard_.find(sat_id);
+    if (it == session_shard_.end()) {
+        return false;
+    }
+    CommandBatch batch{std::move(commands)};
+    std::string payload = batch.encode();
+    shards_[it->second]->command_requests.push(
+        {sat_id, Uplink{PacketType::CommandBatchPkt, std::move(payload), batch.commands.size()}});
+    return true;
+}
+
+void MultiGroundStation::run_shard(Shard& shard) {
+    while (running_) {
+        if (!shard_pass(shard)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+bool MultiGroundStation::shard_pass(Shard& shard) {
+    // Hand queued command requests to their sessions
+    while (auto request = shard.command_requests.try_pop()) {
+        shard.by_id.at(request->first)->backlog.push_back(std::move(request->second));
+    }
+
+    bool busy = false;
+    auto now = this->now();
+    if (config_.plan) {
+        dispatch_plan(shard, now);
+    }
+    for (auto& session : shard.sessions) {
+        busy |= poll_session(shard, *session);
+        service_commands(shard, *session, now);
+    }
+    if (shard.plan) {
+        shard.plan->evaluate_triggers([&](uint32_t sat_id, const Command& cmd) {
+            queue_triggered(shard, sat_id, cmd);
+        });
+    }
+    return busy;
+}
+
+void MultiGroundStation::dispatch_plan(Shard& shard, std::chrono::steady_clock::time_point now) {
+    if (!shard.plan) {
+        std::vector<uint32_t> sat_ids;
+        for (const auto& session : shard.sessions) {
+            sat_ids.push_back(session->sat_id);
+        }
+        shard.plan = std::make_unique<PlanScheduler>(*config_.plan, sat_ids);
+        std::call_once(plan_epoch_once_, [&] { plan_epoch_ = now; });
+    }
+    const double now_sec = plan_seconds(now);
+    if (shard.plan->next_due_sec() > now_sec) {
+        return;
+    }
+
+    shard.plan->dispatch(now_sec, [&](uint32_t sat_id, const Command& cmd) {
+        shard.plan_due[sat_id].push_back(cmd);
+    });
+    for (auto& [sat_id, commands] : shard.plan_due) {
+        if (commands.empty()) {
+            continue;
+        }
+        Session& session = *shard.by_id.at(sat_id);
+        shard.plan_commands += commands.size();
+        if (commands.size() == 1) {
+            session.backlog.push_back(Uplink{PacketType::CommandPkt, commands.front().encode(), 1});
+        } else {
+            CommandBatch batch{std::move(commands)};
+            session.backlog.push_back(Uplink{PacketType::CommandBatchPkt, batch.encode(), batch.commands.size()});
+        }
+        commands.clear();
+    }
+}
+
+void MultiGroundStation::queue_triggered(Shard& shard, uint32_t sat_id, const Command& cmd) {
+    shard.plan_commands++;
+    shard.by_id.at(sat_id)->backlog.push_back(Uplink{PacketType::CommandPkt, cmd.encode(), 1});
+}
+
+bool MultiGroundStation::poll_session(Shard& shard, Session& session) {
+    // Bounded batch per pass keeps sessions on a shard fair
+    constexpr int kMaxBatch = 64;
+    Packet pkt;
+    int received = 0;
+    while (received < kMaxBatch &&
+           session.link->recv_sat_to_gs(pkt, std::chrono::milliseconds(0))) {
+        ingest(shard, session, pkt);
+        received++;
+    }
+    return received > 0;
+}
+
+void MultiGroundStation::ingest(Shard& shard, Session& session, const Packet& pkt) {
+    const bool crc_ok = pkt.verify_crc();
+    SATCOM_TRACE(GroundStation, CrcChecked, pkt.type, session.sat_id, pkt.seq, crc_ok);
+    if (!crc_ok) {
+        shard.naks_sent++;
+        reply(session, PacketType::NakPkt, pkt.seq);
+        return;
+    }
+
+    switch (pkt.type) {
+        case PacketType::TelemetryPkt: {
+            // Already ingested, or older than the window: still ACK
+            if (session.rx_window.check(pkt.seq) != ReplayWindow<128>::Verdict::New) {
+                session.stats.duplicates++;
+                reply(session, PacketType::AckPkt, pkt.seq);
+                return;
+            }
+
+            try {
+                Telemetry telem = Telemetry::from_json(pkt.payload);
+                session.rx_window.accept(pkt.seq);
+                telemetry_age_.record(now() - telem.ts);
+                session.stats.telemetry_received++;
+                shard.telemetry_received++;
+                if (shard.archive.is_open()) {
+                    shard.archive << session.sat_id << ',' << telem.to_csv() << '\n';
+                }
+                reply(session, PacketType::AckPkt, pkt.seq);
+                if (shard.plan) {
+                    // Evaluated with the rest of the pass's samples
+                    shard.plan->queue_telemetry(session.sat_id, telem, plan_seconds(now()),
+                                                [&](uint32_t sat_id, const Command& cmd) {
+                                                    queue_triggered(shard, sat_id, cmd);
+                                                });
+                }
+            } catch (const std::exception& e) {
+                if (config_.verbose) {
+                    logging::log("[GS%u] ERROR: failed to parse telemetry: %s", session.sat_id, e.what());
+                }
+                shard.naks_sent++;
+                reply(session, PacketType::NakPkt, pkt.seq);
+            }
+            break;
+        }
+
+        case PacketType::AckPkt:
+        case PacketType::NakPkt:
+            if (session.in_flight && session.in_flight->seq == pkt.seq) {
+                if (pkt.type == PacketType::AckPkt) {
+                    const auto acked_at = now();
+                    session.stats.commands_sent += session.in_flight_commands;
+                    shard.commands_sent += session.in_flight_commands;
+                    ack_rtt_.record(acked_at - session.last_sent);
+                    SATCOM_TRACE(GroundStation, Acked, session.in_flight->type, session.sat_id, pkt.seq,
+                                 session.attempts);
+                    shard.command_rtts_ms.push_back(
+                        std::chrono::duration<double, std::milli>(acked_at - session.first_sent).count());
+                    session.in_flight.reset();
+                } else {
+                    // NAK: retransmit on the next service pass
+                    session.ack_deadline = std::chrono::steady_clock::time_point::min();
+                }
+            }
+            break;
+
+        case PacketType::EventPkt:
+            session.stats.events_received++;
+            shard.events_received++;
+            if (config_.verbose) {
+                logging::log("[GS%u] RX EVENT %s", session.sat_id, pkt.payload);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void MultiGroundStation::service_commands(Shard& shard, Session& session,
+                                          std::chrono::steady_clock::time_point now) {
+    if (session.in_flight && now >= session.ack_deadline) {
+        if (session.attempts > config_.max_retries) {
+            session.stats.commands_failed += session.in_flight_commands;
+            if (config_.verbose) {
+                logging::log("[GS%u] ERROR: failed to send command seq=%u after %d retries", session.sat_id,
+                             session.in_flight->seq, config_.max_retries);
+            }
+            session.in_flight.reset();
+        } else {
+            shard.retries++;
+            SATCOM_TRACE(GroundStation, Retransmitted, session.in_flight->type, session.sat_id,
+                         session.in_flight->seq, session.attempts + 1);
+            transmit_command(session, now);
+        }
+    }
+
+    if (!session.in_flight && !session.backlog.empty()) {
+        Uplink& next = session.backlog.front();
+        Packet pkt;
+        pkt.type = next.type;
+        pkt.seq = session.tx_seq++;
+        pkt.payload = std::move(next.payload);
+        pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+        pkt.compute_crc();
+        SATCOM_TRACE(GroundStation, Created, pkt.type, session.sat_id, pkt.seq, 0);
+        session.in_flight_commands = next.commands;
+        session.backlog.pop_front();
+
+        session.in_flight = std::move(pkt);
+        session.attempts = 0;
+        session.first_sent = now;
+        transmit_command(session, now);
+    }
+}
+
+void MultiGroundStation::transmit_command(Session& session, std::chrono::steady_clock::time_point now) {
+    session.link->send_gs_to_sat(*session.in_flight);
+    session.last_sent = now;
+    session.attempts++;
+    session.ack_deadline = now + std::chrono::milliseconds(config_.ack_timeout_ms);
+}
+
+void MultiGroundStation::reply(Session& session, PacketType type, uint32_t seq) {
+    Packet pkt;
+    pkt.type = type;
+    pkt.seq = seq;
+    pkt.payload = "";
+    pkt.payload_size = 0;
+    pkt.compute_crc();
+    session.link->send_gs_to_sat(std::move(pkt));
+}
+
+std::optional<MultiGroundStation::SessionStats> MultiGroundStation::get_session_stats(uint32_t sat_id) const {
+    auto it = session_shard_.find(sat_id);
+    if (it == session_shard_.end()) {
+        return std::nullopt;
+    }
+    return shards_[it->second]->by_id.at(sat_id)->stats;
+}
+
+std::vector<double> MultiGroundStation::get_command_rtts_ms() const {
+    std::vector<double> rtts;
+    for (const auto& shard : shards_) {
+        rtts.insert(rtts.end(), shard->command_rtts_ms.begin(), shard->command_rtts_ms.end());
+    }
+    return rtts;
+}
+
+void MultiGroundStation::register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels) const {
+    registry.counter("satcom_gs_telemetry_received_total", "Telemetry packets accepted", labels,
+                     [this] { return get_telemetry_received(); });
+    registry.counter("satcom_gs_commands_sent_total", "Commands ACKed by the satellite", labels,
+                     [this] { return get_commands_sent(); });
+    registry.counter("satcom_gs_retries_total", "Command retransmissions", labels,
+                     [this] { return get_retries(); });
+    registry.counter("satcom_gs_naks_sent_total", "NAKs sent for corrupt or unparsable packets", labels,
+                     [this] { return get_naks_sent(); });
+    registry.counter("satcom_gs_events_received_total", "Satellite event packets received", labels,
+                     [this] { return get_events_received(); });
+    registry.counter("satcom_gs_plan_commands_total", "Commands queued by the command plan", labels,
+                     [this] { return get_plan_commands(); });
+    registry.histogram("satcom_gs_telemetry_age_seconds", "Telemetry age at ingest", labels,
+                       [this] { return get_telemetry_age(); });
+    registry.histogram("satcom_gs_ack_rtt_seconds", "Command ACK round trip per attempt", labels,
+                       [this] { return get_ack_rtt(); });
+}
+
+uint64_t MultiGroundStation::get_telemetry_received() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->telemetry_received;
+    return total;
+}
+
+uint64_t MultiGroundStation::get_commands_sent() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->commands_sent;
+    return total;
+}
+
+uint64_t MultiGroundStation::get_retries() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->retries;
+    return total;
+}
+
+uint64_t MultiGroundStation::get_naks_sent() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->naks_sent;
+    return total;
+}
+
+uint64_t MultiGroundStation::get_events_received() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->events_received;
+    return total;
+}
+
+uint64_t MultiGroundStation::get_plan_commands() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard->plan_commands;
+    return total;
+}
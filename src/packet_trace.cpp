@@ -0,0 +1,179 @@
+#include "packet_trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace trace {
+
+const char* actor_name(Actor actor) {
+    switch (actor) {
+        case Actor::Satellite: return "Satellite";
+        case Actor::Link: return "Link";
+        case Actor::GroundStation: return "GroundStation";
+    }
+    return "Unknown";
+}
+
+const char* event_name(Event event) {
+    switch (event) {
+        case Event::Created: return "created";
+        case Event::Sent: return "sent";
+        case Event::Dropped: return "dropped";
+        case Event::Delayed: return "delayed";
+        case Event::Enqueued: return "enqueued";
+        case Event::Dequeued: return "dequeued";
+        case Event::CrcChecked: return "crc_checked";
+        case Event::Acked: return "acked";
+        case Event::Retransmitted: return "retransmitted";
+    }
+    return "unknown";
+}
+
+namespace {
+
+const char* type_name(PacketType type) {
+    switch (type) {
+        case PacketType::TelemetryPkt: return "Telemetry";
+        case PacketType::CommandPkt: return "Command";
+        case PacketType::AckPkt: return "ACK";
+        case PacketType::NakPkt: return "NAK";
+        case PacketType::EventPkt: return "Event";
+        case PacketType::CommandBatchPkt: return "CommandBatch";
+        case PacketType::ParityPkt: return "Parity";
+    }
+    return "Unknown";
+}
+
+} // namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::~Tracer() {
+    stop();
+}
+
+void Tracer::start(const std::string& path, std::chrono::milliseconds flush_interval) {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    if (active_ || flusher_.joinable()) {
+        throw std::runtime_error("Trace already running");
+    }
+    out_.open(path, std::ios::out | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    out_ << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    first_event_ = true;
+    for (Actor actor : {Actor::Satellite, Actor::Link, Actor::GroundStation}) {
+        out_ << (first_event_ ? "\n" : ",\n")
+             << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << static_cast<int>(actor)
+             << ", \"args\": {\"name\": \"" << actor_name(actor) << "\"}}";
+        first_event_ = false;
+    }
+
+    events_written_ = 0;
+    events_dropped_ = 0;
+    epoch_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    generation_++;
+    active_ = true;
+    flusher_ = std::thread(&Tracer::flush_loop, this, flush_interval);
+}
+
+void Tracer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        if (!flusher_.joinable()) {
+            return;
+        }
+        active_ = false;
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    flusher_.join();
+
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    drain();
+    out_ << "\n]}\n";
+    out_.close();
+
+    // Threads still holding a ring re-register on the next start()
+    generation_++;
+    std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+    rings_.clear();
+}
+
+Tracer::Ring* Tracer::local_ring() {
+    struct Local {
+        std::shared_ptr<Ring> ring;
+        uint64_t generation = 0;
+    };
+    thread_local Local local;
+
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (local.generation != generation || !local.ring) {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        ring->tid = next_tid_++;
+        rings_.push_back(ring);
+        local.ring = std::move(ring);
+        local.generation = generation;
+    }
+    return local.ring.get();
+}
+
+void Tracer::record(Record rec) {
+    rec.ts_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count());
+    if (!local_ring()->records.try_push(rec)) {
+        events_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::flush_loop(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    while (!stopping_) {
+        flush_cv_.wait_for(lock, interval, [this] { return stopping_; });
+        drain();
+    }
+}
+
+void Tracer::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    std::string buf;
+    for (const auto& ring : rings) {
+        const size_t drained = ring->records.drain([&](const Record& r) {
+            char line[320];
+            int len = std::snprintf(
+                line, sizeof(line),
+                "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"i\", \"s\": \"t\", "
+                "\"ts\": %llu.%03llu, \"pid\": %d, \"tid\": %u, \"args\": {\"stream\": %u, "
+                "\"type\": \"%s\", \"seq\": %u, \"arg\": %u}}",
+                first_event_ ? "" : ",", event_name(r.event), actor_name(r.actor),
+                static_cast<unsigned long long>(r.ts_ns / 1000),
+                static_cast<unsigned long long>(r.ts_ns % 1000), static_cast<int>(r.actor), ring->tid,
+                r.stream, type_name(r.type), r.seq, r.arg);
+            buf.append(line, static_cast<size_t>(std::min<int>(len, sizeof(line) - 1)));
+            first_event_ = false;
+        });
+        events_written_.fetch_add(drained, std::memory_order_relaxed);
+    }
+    out_ << buf;
+    out_.flush();
+    rings.clear();
+
+    // Forget rings whose threads have exited once they are empty
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    std::erase_if(rings_, [](const std::shared_ptr<Ring>& ring) {
+        return ring.use_count() == 1 && ring->records.empty();
+    });
+}
+
+} // namespace trace
@@ -0,0 +1,128 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+#ifdef __linux__
+
+namespace {
+
+int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd < 0 ? 1 : 0;  // The leader gates the group
+    attr.exclude_kernel = 1;               // Allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    static constexpr std::array<uint64_t, kNumCounters> kConfigs = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    fds_.fill(-1);
+    for (int c = 0; c < kNumCounters; ++c) {
+        fds_[c] = open_counter(kConfigs[c], leader_);
+        if (fds_[c] < 0) {
+            if (reason_.empty()) {
+                reason_ = std::string(name(static_cast<Counter>(c))) + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+        if (leader_ < 0) {
+            leader_ = fds_[c];
+        }
+    }
+    if (available()) {
+        reason_.clear();
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void PerfCounters::start() {
+    if (leader_ < 0) {
+        return;
+    }
+    ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::Sample PerfCounters::stop() {
+    Sample sample;
+    if (leader_ < 0) {
+        return sample;
+    }
+    ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // {nr, time_enabled, time_running, value[nr]} in group open order
+    std::array<uint64_t, 3 + kNumCounters> buf{};
+    if (read(leader_, buf.data(), sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return sample;
+    }
+    const uint64_t enabled = buf[1];
+    const uint64_t running = buf[2];
+    if (running == 0) {
+        return sample;  // Never scheduled onto the PMU
+    }
+    const double scale = static_cast<double>(enabled) / static_cast<double>(running);
+    size_t slot = 0;
+    for (int c = 0; c < kNumCounters && slot < buf[0]; ++c) {
+        if (fds_[c] < 0) {
+            continue;
+        }
+        sample.values[c] = static_cast<uint64_t>(static_cast<double>(buf[3 + slot++]) * scale);
+        sample.valid[c] = true;
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() : reason_("perf_event_open is Linux-only") {
+    fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::start() {}
+
+PerfCounters::Sample PerfCounters::stop() {
+    return Sample{};
+}
+
+#endif
+
+const char* PerfCounters::name(Counter c) {
+    switch (c) {
+        case Cycles: return "cycles";
+        case Instructions: return "instructions";
+        case CacheMisses: return "cache-misses";
+        case BranchMisses: return "branch-misses";
+        case kNumCounters: break;
+    }
+    return "unknown";
+}
+
+} // namespace bench
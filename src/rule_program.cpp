@@ -0,0 +1,140 @@
+#include "rule_program.hpp"
+#include <cmath>
+
+RuleProgram::RuleProgram(std::vector<Rule> rules, const std::vector<uint32_t>& sat_ids, const Applies& applies)
+    : rules_(std::move(rules)) {
+    for (uint32_t id : sat_ids) {
+        if (slot_of_.emplace(id, static_cast<uint32_t>(sat_ids_.size())).second) {
+            sat_ids_.push_back(id);
+        }
+    }
+    const size_t n = sat_ids_.size();
+
+    std::vector<uint8_t> watch(n);
+    for (size_t r = 0; r < rules_.size(); ++r) {
+        bool any = false;
+        for (size_t s = 0; s < n; ++s) {
+            watch[s] = applies(r, sat_ids_[s]);
+            any |= watch[s] != 0;
+        }
+        if (!any) {
+            continue;
+        }
+        const Rule& rule = rules_[r];
+        const double sign = rule.above ? 1.0 : -1.0;
+        const double clear = std::isnan(rule.clear) ? rule.threshold : rule.clear;
+        rows_.push_back(Row{static_cast<size_t>(rule.field) + (rule.rate ? kNumFields : 0), sign,
+                            sign * rule.threshold, sign * clear, rule.cooldown_sec, r});
+        watch_.insert(watch_.end(), watch.begin(), watch.end());
+    }
+    armed_.assign(watch_.size(), 1);
+    last_fired_.assign(watch_.size(), -std::numeric_limits<double>::infinity());
+
+    for (auto& prev : prev_value_) {
+        prev.assign(n, 0.0);
+    }
+    prev_time_.assign(n, std::numeric_limits<double>::quiet_NaN());
+    queued_.assign(n, 0);
+}
+
+size_t RuleProgram::add_sample(uint32_t sat_id, const Telemetry& t, double now_sec, const Dispatch& fn) {
+    auto it = slot_of_.find(sat_id);
+    if (it == slot_of_.end() || rows_.empty()) {
+        return 0;
+    }
+    const uint32_t slot = it->second;
+    const size_t fired = queued_[slot] ? evaluate(fn) : 0;
+
+    // Same order as Field
+    const double values[kNumFields] = {t.temperature_c, t.battery_pct, t.orbit_altitude_km,
+                                       t.pitch_deg, t.yaw_deg, t.roll_deg};
+    const double dt = now_sec - prev_time_[slot];
+    for (size_t f = 0; f < kNumFields; ++f) {
+        // No rate before a second sample (NaN never trips or re-arms)
+        const double rate = dt > 0.0 ? (values[f] - prev_value_[f][slot]) / dt
+                                     : std::numeric_limits<double>::quiet_NaN();
+        columns_[f].push_back(values[f]);
+        columns_[kNumFields + f].push_back(rate);
+        prev_value_[f][slot] = values[f];
+    }
+    prev_time_[slot] = now_sec;
+    queued_[slot] = 1;
+    batch_slot_.push_back(slot);
+    batch_time_.push_back(now_sec);
+    return fired;
+}
+
+size_t RuleProgram::evaluate(const Dispatch& fn) {
+    const size_t m = batch_slot_.size();
+    if (m == 0) {
+        return 0;
+    }
+    const size_t n = sat_ids_.size();
+    const uint32_t* slot = batch_slot_.data();
+    const double* now = batch_time_.data();
+    scratch_watch_.resize(m);
+    scratch_armed_.resize(m);
+    scratch_last_.resize(m);
+    fire_.resize(m);
+    double* watch = scratch_watch_.data();
+    double* armed = scratch_armed_.data();
+    double* last = scratch_last_.data();
+    double* fire = fire_.data();
+
+    size_t total = 0;
+    for (size_t r = 0; r < rows_.size(); ++r) {
+        const Row& row = rows_[r];
+        const size_t base = r * n;
+
+        for (size_t i = 0; i < m; ++i) {
+            watch[i] = watch_[base + slot[i]];
+            armed[i] = armed_[base + slot[i]];
+            last[i] = last_fired_[base + slot[i]];
+        }
+
+        // Branch-free kernel over the batch. Masks are 0.0/1.0 doubles so
+        // every lane has the width of the telemetry columns, and only two
+        // arrays are written so the compiler can vectorize behind a
+        // runtime alias check.
+        const double* x = columns_[row.column].data();
+        const double sign = row.sign, trip_level = row.trip, release_level = row.release;
+        const double cooldown = row.cooldown_sec;
+        double fired = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            const double v = sign * x[i];
+            const bool trip = (v > trip_level) & (watch[i] != 0.0);
+            const bool release = (v <= release_level) & (watch[i] != 0.0);
+            const bool ready = (armed[i] != 0.0) | (now[i] - last[i] >= cooldown);
+            const bool f = trip & ready;
+            armed[i] = ((armed[i] != 0.0) | release) & !f ? 1.0 : 0.0;
+            fire[i] = f ? 1.0 : 0.0;
+            fired += fire[i];
+        }
+
+        for (size_t i = 0; i < m; ++i) {
+            armed_[base + slot[i]] = static_cast<uint8_t>(armed[i]);
+            last_fired_[base + slot[i]] = fire[i] != 0.0 ? now[i] : last[i];
+        }
+
+        // Rare path: hand out fired commands
+        if (fired == 0.0) {
+            continue;
+        }
+        for (size_t i = 0; i < m; ++i) {
+            if (fire[i] != 0.0) {
+                fn(sat_ids_[slot[i]], rules_[row.rule].cmd);
+            }
+        }
+        total += static_cast<size_t>(fired);
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+        queued_[slot[i]] = 0;
+    }
+    batch_slot_.clear();
+    batch_time_.clear();
+    for (auto& column : columns_) {
+        column.clear();
+    }
+    return total;
+}
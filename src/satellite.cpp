@@ -1,10 +1,34 @@
 #include "satellite.hpp"
-#include <iostream>
-#include <iomanip>
+#include "async_logger.hpp"
+#include "checkpoint.hpp"
+#include "fec.hpp"
+#include "packet_trace.hpp"
+#include <algorithm>
 #include <cmath>
 
 Satellite::Satellite(Link& link, const Config& config)
-    : link_(link), config_(config), rng_(config.seed) {}
+    : link_(link), config_(config), rng_(config.seed),
+      schedule_(config.max_scheduled_commands),
+      recorder_(TelemetryRecorder::Config{config.recorder_capacity, 256, config.recorder_file}),
+      tx_(tx_config()) {
+    if (config_.fec_group > 0 &&
+        (config_.fec_parity == 0 || config_.fec_group + config_.fec_parity > fec::ErasureCode::kMaxShards)) {
+        throw std::runtime_error("Playback FEC needs 1+ parity packets and at most " +
+                                 std::to_string(fec::ErasureCode::kMaxShards) + " packets per group");
+    }
+    if (config_.playback_window == 0) {
+        throw std::runtime_error("Playback window must be at least 1 packet");
+    }
+    records_rejected_ += recorder_.rejected();  // Corrupt recording dropped on resume
+    recorder_fill_ = recorder_.size();
+}
+
+TxScheduler::Config Satellite::tx_config() const {
+    return TxScheduler::Config{
+        config_.weighted_fair_tx ? TxScheduler::Policy::WeightedFair
+                                 : TxScheduler::Policy::StrictPriority,
+        {8, 4, 2, 1}, config_.downlink_rate_bps / 8.0, 512, 1024};
+}
 
 Satellite::~Satellite() {
     stop();
@@ -17,48 +41,192 @@ void Satellite::start() {
     thread_ = std::thread(&Satellite::run, this);
 }
 
+void Satellite::start(CoroutineRuntime& runtime) {
+    if (running_.exchange(true)) {
+        return;  // Already running
+    }
+    agent_running_ = true;
+    runtime.spawn(run_async(runtime), [this] {
+        agent_running_ = false;
+        agent_running_.notify_all();
+    });
+}
+
+void Satellite::request_stop() {
+    running_ = false;
+}
+
 void Satellite::stop() {
-    if (running_.exchange(false)) {
-        if (thread_.joinable()) {
-            thread_.join();
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    agent_running_.wait(true);
+}
+
+void Satellite::save(CheckpointWriter& out) const {
+    if (running_) {
+        throw std::runtime_error("Satellite must be stopped to save");
+    }
+
+    out.begin("SATL");
+    out.put(tx_seq_);
+    out.put(rx_window_);
+    out.put<uint8_t>(safe_mode_);
+    out.put<uint8_t>(link_up_);
+    for (double v : {temperature_c_, battery_pct_, orbit_altitude_km_, pitch_deg_, yaw_deg_, roll_deg_}) {
+        out.put(v);
+    }
+    out.put_rng(rng_);
+
+    auto commands = schedule_.pending();
+    out.put<uint32_t>(static_cast<uint32_t>(commands.size()));
+    for (const Command& cmd : commands) {
+        out.put_string(cmd.serialize());
+    }
+
+    std::string record;
+    out.put<uint32_t>(static_cast<uint32_t>(recorder_.size()));
+    for (size_t i = 0; recorder_.peek(i, record); ++i) {
+        out.put_string(record);
+    }
+
+    for (size_t c = 0; c < kNumTrafficClasses; ++c) {
+        auto queued = tx_.queued_packets(static_cast<TrafficClass>(c));
+        out.put<uint32_t>(static_cast<uint32_t>(queued.size()));
+        for (const Packet& pkt : queued) {
+            out.put_packet(pkt);
         }
     }
+
+    for (const auto* counter : {&telemetry_sent_, &commands_received_, &retries_, &naks_received_,
+                                &commands_scheduled_, &scheduled_executed_, &records_stored_,
+                                &records_played_back_, &records_overwritten_, &records_rejected_,
+                                &playback_bytes_, &playback_ns_, &parity_sent_}) {
+        out.put<uint64_t>(*counter);
+    }
+    out.end();
 }
 
-void Satellite::run() {
-    auto last_telemetry = std::chrono::steady_clock::now();
-    auto last_update = std::chrono::steady_clock::now();
+void Satellite::restore(CheckpointReader& in) {
+    if (running_) {
+        throw std::runtime_error("Satellite must be stopped to restore");
+    }
 
-    const auto telemetry_period = std::chrono::milliseconds(
-        static_cast<long long>(1000.0 / config_.telemetry_rate_hz)
-    );
+    in.begin("SATL");
+    tx_seq_ = in.get<uint32_t>();
+    rx_window_ = in.get<ReplayWindow<>>();
+    safe_mode_ = in.get<uint8_t>() != 0;
+    link_up_ = in.get<uint8_t>() != 0;
+    for (double* v : {&temperature_c_, &battery_pct_, &orbit_altitude_km_, &pitch_deg_, &yaw_deg_, &roll_deg_}) {
+        *v = in.get<double>();
+    }
+    in.get_rng(rng_);
 
-    while (running_) {
-        auto now = std::chrono::steady_clock::now();
+    schedule_.clear();
+    for (uint32_t n = in.get<uint32_t>(); n > 0; --n) {
+        if (!schedule_.schedule(Command::deserialize(in.get_string()))) {
+            throw std::runtime_error("Checkpoint holds more stored commands than fit");
+        }
+    }
 
-        // Update state
-        auto dt = std::chrono::duration<double>(now - last_update).count();
-        update_state(dt);
-        last_update = now;
+    recorder_.clear();
+    for (uint32_t n = in.get<uint32_t>(); n > 0; --n) {
+        recorder_.store(in.get_string());
+    }
+    recorder_fill_ = recorder_.size();
+
+    // Queued downlink packets restart their queue residency now
+    const auto now = std::chrono::steady_clock::now();
+    tx_.reset();
+    for (size_t c = 0; c < kNumTrafficClasses; ++c) {
+        for (uint32_t n = in.get<uint32_t>(); n > 0; --n) {
+            tx_.enqueue(static_cast<TrafficClass>(c), in.get_packet(), now);
+        }
+    }
 
-        // Check for anomalies
-        check_anomalies();
+    for (auto* counter : {&telemetry_sent_, &commands_received_, &retries_, &naks_received_,
+                          &commands_scheduled_, &scheduled_executed_, &records_stored_,
+                          &records_played_back_, &records_overwritten_, &records_rejected_,
+                          &playback_bytes_, &playback_ns_, &parity_sent_}) {
+        *counter = in.get<uint64_t>();
+    }
+    in.end();
+}
+
+void Satellite::register_metrics(MetricsRegistry& registry, const MetricsRegistry::Labels& labels) const {
+    registry.counter("satcom_sat_telemetry_sent_total", "Telemetry packets ACKed by the ground", labels,
+                     [this] { return get_telemetry_sent(); });
+    registry.counter("satcom_sat_commands_received_total", "Commands accepted onboard", labels,
+                     [this] { return get_commands_received(); });
+    registry.counter("satcom_sat_retries_total", "Downlink retransmissions", labels,
+                     [this] { return get_retries(); });
+    registry.counter("satcom_sat_naks_received_total", "NAKs received from the ground", labels,
+                     [this] { return get_naks_received(); });
+    registry.counter("satcom_sat_records_stored_total", "Telemetry records written to the recorder", labels,
+                     [this] { return get_records_stored(); });
+    registry.counter("satcom_sat_records_rejected_total", "Telemetry records too large for a recorder slot", labels,
+                     [this] { return get_records_rejected(); });
+    registry.counter("satcom_sat_records_played_back_total", "Recorded telemetry delivered on playback", labels,
+                     [this] { return get_records_played_back(); });
+    registry.counter("satcom_sat_parity_sent_total", "Erasure parity packets sent with playback groups", labels,
+                     [this] { return get_parity_sent(); });
+    registry.gauge("satcom_sat_recorder_fill", "Records waiting in the onboard recorder", labels,
+                   [this] { return static_cast<double>(get_recorder_fill()); });
+    registry.histogram("satcom_sat_ack_rtt_seconds", "Telemetry ACK round trip per attempt", labels,
+                       [this] { return get_ack_rtt(); });
+}
 
-        // Send telemetry at specified rate
-        if (now - last_telemetry >= telemetry_period) {
+void Satellite::run() {
+    last_telemetry_ = last_update_ = std::chrono::steady_clock::now();
+
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        if (rebooting(now)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        // Update state and send telemetry at specified rate
+        if (update(now)) {
             send_telemetry();
-            last_telemetry = now;
         }
 
         // Process incoming commands
         process_commands();
 
+        // Execute stored commands whose time tag has arrived
+        execute_due_commands(now);
+
+        // Drain downlink queue as link capacity allows
+        service_tx();
+
         // Sleep briefly to avoid busy-wait
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
-void Satellite::send_telemetry() {
+bool Satellite::update(std::chrono::steady_clock::time_point now) {
+    const auto telemetry_period = std::chrono::milliseconds(
+        static_cast<long long>(1000.0 / config_.telemetry_rate_hz)
+    );
+
+    // Update state
+    auto dt = std::chrono::duration<double>(now - last_update_).count();
+    update_state(dt);
+    last_update_ = now;
+
+    // Check for anomalies
+    check_anomalies();
+
+    if (now - last_telemetry_ >= telemetry_period) {
+        last_telemetry_ = now;
+        return true;
+    }
+    return false;
+}
+
+Packet Satellite::make_telemetry_packet() {
     Telemetry telem;
     telem.ts = std::chrono::steady_clock::now();
     telem.temperature_c = temperature_c_;
@@ -75,160 +243,433 @@ void Satellite::send_telemetry() {
     pkt.payload = telem.to_json();
     pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
     pkt.compute_crc();
+    SATCOM_TRACE(Satellite, Created, pkt.type, 0, pkt.seq, 0);
+
+    if (config_.verbose) {
+        logging::log("[SAT] TX Telemetry seq=%u crc=0x%x temp=%.1fC batt=%.1f%% alt=%.1fkm "
+                     "euler=(%.1f,%.1f,%.1f)%s",
+                     pkt.seq, pkt.crc16, temperature_c_, battery_pct_, orbit_altitude_km_,
+                     pitch_deg_, yaw_deg_, roll_deg_, safe_mode_ ? " [SAFE MODE]" : "");
+    }
+    return pkt;
+}
+
+bool Satellite::finish_telemetry(const Packet& pkt, bool delivered) {
+    if (delivered) {
+        telemetry_sent_++;
+        link_up_ = true;
+        return true;  // Link is back: drain the recorder
+    }
+
+    if (config_.verbose && running_) {
+        logging::log("[SAT] ERROR: failed to send telemetry seq=%u after %d retries → recorded",
+                     pkt.seq, config_.max_retries);
+    }
+    link_up_ = false;
+    record_telemetry(pkt.payload);
+    return false;
+}
+
+void Satellite::send_telemetry() {
+    Packet pkt = make_telemetry_packet();
+    if (finish_telemetry(pkt, send_with_retry(pkt, TrafficClass::Housekeeping))) {
+        playback_recorded();
+    }
+}
 
+void Satellite::note_retry(uint32_t seq, int retry) {
+    retries_++;
+    SATCOM_TRACE(Satellite, Retransmitted, PacketType::TelemetryPkt, 0, seq, retry);
     if (config_.verbose) {
-        std::cout << std::fixed << std::setprecision(1);
-        std::cout << "[SAT] TX Telemetry seq=" << pkt.seq
-                  << " crc=0x" << std::hex << pkt.crc16 << std::dec
-                  << " temp=" << temperature_c_ << "C"
-                  << " batt=" << battery_pct_ << "%"
-                  << " alt=" << orbit_altitude_km_ << "km"
-                  << " euler=(" << pitch_deg_ << "," << yaw_deg_ << "," << roll_deg_ << ")"
-                  << (safe_mode_ ? " [SAFE MODE]" : "")
-                  << std::endl;
-    }
-
-    // Send with retry logic
-    bool success = false;
+        logging::log("[SAT] WARN: missed ACK for seq=%u → retry %d/%d", seq, retry, config_.max_retries);
+    }
+}
+
+bool Satellite::send_with_retry(const Packet& pkt, TrafficClass cls) {
+    auto sent_at = std::chrono::steady_clock::now();
     for (int retry = 0; retry <= config_.max_retries && running_; ++retry) {
         if (retry > 0) {
-            retries_++;
-            if (config_.verbose) {
-                std::cout << "[SAT] WARN: missed ACK for seq=" << pkt.seq
-                          << " → retry " << retry << "/" << config_.max_retries << std::endl;
-            }
+            note_retry(pkt.seq, retry);
         }
 
-        link_.send_sat_to_gs(pkt);
+        // Re-queue unless the previous copy is still waiting for link capacity
+        if (retry == 0 || !tx_.queued(cls, pkt.seq)) {
+            sent_at = std::chrono::steady_clock::now();
+            transmit(cls, pkt);
+        }
 
         // Wait for ACK
         if (wait_for_ack(pkt.seq, std::chrono::milliseconds(config_.ack_timeout_ms))) {
-            success = true;
+            ack_rtt_.record(std::chrono::steady_clock::now() - sent_at);
+            SATCOM_TRACE(Satellite, Acked, pkt.type, 0, pkt.seq, retry);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Satellite::transmit(TrafficClass cls, Packet pkt) {
+    tx_.enqueue(cls, std::move(pkt), std::chrono::steady_clock::now());
+    service_tx();
+}
+
+void Satellite::service_tx() {
+    while (auto pkt = tx_.dequeue(std::chrono::steady_clock::now())) {
+        link_.send_sat_to_gs(std::move(*pkt));
+    }
+}
+
+void Satellite::record_telemetry(const std::string& payload) {
+    uint64_t lost_before = recorder_.overwritten();
+    if (recorder_.store(payload)) {
+        records_stored_++;
+    } else {
+        records_rejected_++;
+    }
+    records_overwritten_ += recorder_.overwritten() - lost_before;
+    recorder_fill_ = recorder_.size();
+}
+
+void Satellite::playback_recorded() {
+    if (recorder_.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Drain a window at a time while the link holds, bounded per pass so
+    // live telemetry and commands are not starved
+    for (int sent = 0; sent < config_.playback_burst;) {
+        std::vector<Packet> group = next_playback_group(static_cast<size_t>(config_.playback_burst - sent));
+        if (group.empty()) {
+            break;
+        }
+        sent += static_cast<int>(group.size());
+        if (!send_group(group)) {
+            link_up_ = false;
             break;
         }
     }
 
-    if (success) {
-        telemetry_sent_++;
-    } else if (config_.verbose && running_) {
-        std::cout << "[SAT] ERROR: failed to send telemetry seq=" << pkt.seq
-                  << " after " << config_.max_retries << " retries" << std::endl;
+    playback_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    recorder_fill_ = recorder_.size();
+}
+
+Packet Satellite::make_playback_packet(std::string payload) {
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.seq = tx_seq_++;
+    pkt.payload = std::move(payload);
+    pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+    pkt.compute_crc();
+    SATCOM_TRACE(Satellite, Created, pkt.type, 0, pkt.seq, 0);
+    return pkt;
+}
+
+std::vector<Packet> Satellite::next_playback_group(size_t max_packets) {
+    std::vector<Packet> group;
+    std::string payload;
+    const size_t size = std::min(config_.fec_group > 0 ? config_.fec_group : config_.playback_window, max_packets);
+    while (group.size() < size && link_up_ && running_ && recorder_.peek(group.size(), payload)) {
+        group.push_back(make_playback_packet(std::move(payload)));
+    }
+    if (config_.verbose && !group.empty()) {
+        logging::log("[SAT] PLAYBACK seq=%u..%u + %zu parity (%zu remaining)", group.front().seq,
+                     group.back().seq, config_.fec_group > 0 ? config_.fec_parity : 0,
+                     recorder_.size() - group.size());
+    }
+    return group;
+}
+
+std::chrono::steady_clock::time_point Satellite::transmit_group(const std::vector<Packet>& group) {
+    std::vector<Packet> parity;
+    if (config_.fec_group > 0) {
+        parity = fec::make_parity_packets(group, config_.fec_parity);
+    }
+    for (const Packet& pkt : group) {
+        transmit(TrafficClass::Playback, pkt);
+    }
+    for (Packet& pkt : parity) {
+        parity_sent_++;
+        transmit(TrafficClass::Playback, std::move(pkt));
+    }
+    return std::chrono::steady_clock::now();
+}
+
+bool Satellite::note_group_reply(const std::vector<Packet>& group, std::vector<uint8_t>& acked, size_t& remaining,
+                                 const Packet& pkt, std::chrono::steady_clock::time_point sent_at) {
+    if (pkt.type != PacketType::AckPkt && pkt.type != PacketType::NakPkt) {
+        return false;
+    }
+    for (size_t i = 0; i < group.size(); ++i) {
+        if (group[i].seq != pkt.seq) {
+            continue;
+        }
+        if (pkt.type == PacketType::NakPkt) {
+            naks_received_++;  // Parity may still rebuild it; retried after the wait if not
+        } else if (!acked[i]) {
+            acked[i] = 1;
+            remaining--;
+            ack_rtt_.record(std::chrono::steady_clock::now() - sent_at);
+            SATCOM_TRACE(Satellite, Acked, group[i].type, 0, pkt.seq, 0);
+        }
+        break;
+    }
+    return true;
+}
+
+bool Satellite::send_group(const std::vector<Packet>& group) {
+    const auto sent_at = transmit_group(group);
+    const auto deadline = sent_at + std::chrono::milliseconds(config_.ack_timeout_ms);
+    std::vector<uint8_t> acked(group.size(), 0);
+    size_t remaining = group.size();
+    Packet pkt;
+
+    // One wait for the whole window: with FEC, lost members the ground
+    // rebuilt from parity are ACKed like the rest
+    while (remaining > 0 && running_) {
+        service_tx();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        auto slice = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+        if (tx_.pending() > 0) {
+            slice = std::min(slice, std::chrono::milliseconds(2));
+        }
+        if (link_.recv_gs_to_sat(pkt, slice) && !note_group_reply(group, acked, remaining, pkt, sent_at)) {
+            handle_uplink(pkt);  // Commands keep flowing while we wait
+        }
+    }
+
+    // Whatever parity could not cover falls back to stop-and-wait
+    for (size_t i = 0; i < group.size(); ++i) {
+        if (!acked[i] && !send_with_retry(group[i], TrafficClass::Playback)) {
+            drop_acked_after(group, acked, i);
+            return false;
+        }
+        finish_playback(group[i]);
+    }
+    return true;
+}
+
+void Satellite::finish_playback(const Packet& pkt, size_t position) {
+    recorder_.erase(position);
+    records_played_back_++;
+    playback_bytes_ += pkt.payload.size();
+}
+
+void Satellite::drop_acked_after(const std::vector<Packet>& group, const std::vector<uint8_t>& acked, size_t failed) {
+    // The ground already has the ACKed members after the failed one: take
+    // them out so they are not played back again under new sequence
+    // numbers. The failed member and the unACKed ones keep their order.
+    size_t position = 1;
+    for (size_t i = failed + 1; i < group.size(); ++i) {
+        if (acked[i]) {
+            finish_playback(group[i], position);
+        } else {
+            position++;
+        }
     }
 }
 
 void Satellite::process_commands() {
     Packet pkt;
     while (link_.recv_gs_to_sat(pkt, std::chrono::milliseconds(0))) {
-        if (!pkt.verify_crc()) {
-            if (config_.verbose) {
-                std::cout << "[SAT] NAK seq=" << pkt.seq << " (bad CRC)" << std::endl;
-            }
-            // Send NAK
-            Packet nak;
-            nak.type = PacketType::NakPkt;
-            nak.seq = pkt.seq;
-            nak.payload = "";
-            nak.payload_size = 0;
-            nak.compute_crc();
-            link_.send_sat_to_gs(nak);
-            continue;
-        }
+        handle_uplink(pkt);
+    }
+}
 
-        if (pkt.type == PacketType::CommandPkt) {
-            // Check for duplicate
-            if (pkt.seq < rx_seq_expected_) {
-                // Duplicate, but still ACK
-                Packet ack;
-                ack.type = PacketType::AckPkt;
-                ack.seq = pkt.seq;
-                ack.payload = "";
-                ack.payload_size = 0;
-                ack.compute_crc();
-                link_.send_sat_to_gs(ack);
-                continue;
-            }
+void Satellite::handle_uplink(const Packet& pkt) {
+    const bool crc_ok = pkt.verify_crc();
+    SATCOM_TRACE(Satellite, CrcChecked, pkt.type, 0, pkt.seq, crc_ok);
+    if (!crc_ok) {
+        if (config_.verbose) {
+            logging::log("[SAT] NAK seq=%u (bad CRC)", pkt.seq);
+        }
+        // Send NAK
+        Packet nak;
+        nak.type = PacketType::NakPkt;
+        nak.seq = pkt.seq;
+        nak.payload = "";
+        nak.payload_size = 0;
+        nak.compute_crc();
+        transmit(TrafficClass::Ack, std::move(nak));
+        return;
+    }
 
-            rx_seq_expected_ = pkt.seq + 1;
+    if (pkt.type != PacketType::CommandPkt && pkt.type != PacketType::CommandBatchPkt) {
+        return;
+    }
 
-            try {
-                Command cmd = Command::deserialize(pkt.payload);
-                commands_received_++;
+    // Already executed, or too old to tell: ACK so the ground stops
+    // retransmitting, but never execute twice
+    if (rx_window_.check(pkt.seq) != ReplayWindow<>::Verdict::New) {
+        Packet ack;
+        ack.type = PacketType::AckPkt;
+        ack.seq = pkt.seq;
+        ack.payload = "";
+        ack.payload_size = 0;
+        ack.compute_crc();
+        transmit(TrafficClass::Ack, std::move(ack));
+        return;
+    }
 
+    // A rejected command is not marked seen, so its retransmission is
+    // processed again rather than ACKed as a duplicate
+    try {
+        if (pkt.type == PacketType::CommandBatchPkt) {
+            accept_batch(pkt.seq, CommandBatch::decode(pkt.payload));
+        } else {
+            Command cmd = Command::decode(pkt.payload);
+
+            auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+            if (cmd.is_time_tagged() && cmd.exec_time_ns > now_ns) {
+                // Store for later execution
+                if (!schedule_.schedule(cmd)) {
+                    throw std::runtime_error("command schedule full");
+                }
+                commands_scheduled_++;
                 if (config_.verbose) {
-                    std::cout << "[SAT] CMD RX " << cmd.name() << " seq=" << pkt.seq;
+                    logging::log("[SAT] CMD RX %s seq=%u → scheduled in %.1fs (%zu stored)", cmd.name(), pkt.seq,
+                                 static_cast<double>(cmd.exec_time_ns - now_ns) / 1e9, schedule_.size());
                 }
+            } else {
+                execute_command(cmd, config_.verbose ? "CMD RX " + cmd.name() + " seq=" + std::to_string(pkt.seq)
+                                                     : std::string());
+            }
+            commands_received_++;  // Accepted: a command the schedule had no room for is NAKed, not counted
+        }
+        rx_window_.accept(pkt.seq);
+
+        // Send ACK
+        Packet ack;
+        ack.type = PacketType::AckPkt;
+        ack.seq = pkt.seq;
+        ack.payload = "";
+        ack.payload_size = 0;
+        ack.compute_crc();
+        transmit(TrafficClass::Ack, std::move(ack));
+
+    } catch (const std::exception& e) {
+        if (config_.verbose) {
+            logging::log("[SAT] ERROR: failed to process command seq=%u: %s", pkt.seq, e.what());
+        }
+        // Send NAK
+        Packet nak;
+        nak.type = PacketType::NakPkt;
+        nak.seq = pkt.seq;
+        nak.payload = "";
+        nak.payload_size = 0;
+        nak.compute_crc();
+        transmit(TrafficClass::Ack, std::move(nak));
+    }
+}
 
-                // Execute command
-                switch (cmd.type) {
-                    case CommandType::AdjustOrientation:
-                        pitch_deg_ += cmd.d_pitch;
-                        yaw_deg_ += cmd.d_yaw;
-                        roll_deg_ += cmd.d_roll;
-                        if (config_.verbose) {
-                            std::cout << " d=(" << cmd.d_pitch << "," << cmd.d_yaw
-                                      << "," << cmd.d_roll << ") → applied" << std::endl;
-                        }
-                        break;
-
-                    case CommandType::ThrustBurn:
-                        if (safe_mode_) {
-                            if (config_.verbose) {
-                                std::cout << " → BLOCKED (safe mode)" << std::endl;
-                            }
-                        } else {
-                            orbit_altitude_km_ += cmd.burn_seconds * 0.5;
-                            battery_pct_ -= cmd.burn_seconds * 2.0;
-                            if (config_.verbose) {
-                                std::cout << " t=" << cmd.burn_seconds << "s → applied" << std::endl;
-                            }
-                        }
-                        break;
-
-                    case CommandType::EnterSafeMode:
-                        safe_mode_ = true;
-                        if (config_.verbose) {
-                            std::cout << " → SAFE MODE ENABLED" << std::endl;
-                        }
-                        break;
-
-                    case CommandType::Reboot:
-                        if (config_.verbose) {
-                            std::cout << " → rebooting..." << std::endl;
-                        }
-                        safe_mode_ = false;
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                        if (config_.verbose) {
-                            std::cout << "[SAT] Reboot complete" << std::endl;
-                        }
-                        break;
-                }
+void Satellite::accept_batch(uint32_t seq, const CommandBatch& batch) {
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    // Check the whole batch first: a rejected batch must leave no trace
+    size_t to_store = 0;
+    for (const Command& cmd : batch.commands) {
+        to_store += cmd.is_time_tagged() && cmd.exec_time_ns > now_ns;
+    }
+    if (schedule_.size() + to_store > schedule_.capacity()) {
+        throw std::runtime_error("command schedule full");
+    }
+    batch.check_runnable(safe_mode_, now_ns);
+
+    commands_received_ += batch.commands.size();
+    for (size_t k = 0; k < batch.commands.size(); ++k) {
+        const Command& cmd = batch.commands[k];
+        if (cmd.is_time_tagged() && cmd.exec_time_ns > now_ns) {
+            schedule_.schedule(cmd);
+            commands_scheduled_++;
+        } else {
+            execute_command(cmd, config_.verbose ? "CMD RX " + cmd.name() + " seq=" + std::to_string(seq) + " [" +
+                                                       std::to_string(k + 1) + "/" +
+                                                       std::to_string(batch.commands.size()) + "]"
+                                                 : std::string());
+        }
+    }
+    if (config_.verbose) {
+        logging::log("[SAT] CMD BATCH seq=%u: %zu commands accepted (%zu stored)", seq, batch.commands.size(),
+                     to_store);
+    }
+}
 
-                // Send ACK
-                Packet ack;
-                ack.type = PacketType::AckPkt;
-                ack.seq = pkt.seq;
-                ack.payload = "";
-                ack.payload_size = 0;
-                ack.compute_crc();
-                link_.send_sat_to_gs(ack);
+void Satellite::execute_due_commands(std::chrono::steady_clock::time_point now) {
+    auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now.time_since_epoch()).count();
 
-            } catch (const std::exception& e) {
+    while (auto cmd = schedule_.pop_due(now_ns)) {
+        scheduled_executed_++;
+        execute_command(*cmd, config_.verbose ? "CMD EXEC " + cmd->name() + " (time-tagged)" : std::string());
+    }
+}
+
+void Satellite::execute_command(const Command& cmd, const std::string& label) {
+    switch (cmd.type) {
+        case CommandType::AdjustOrientation:
+            pitch_deg_ += cmd.d_pitch;
+            yaw_deg_ += cmd.d_yaw;
+            roll_deg_ += cmd.d_roll;
+            if (config_.verbose) {
+                logging::log("[SAT] %s d=(%.1f,%.1f,%.1f) → applied", label, cmd.d_pitch, cmd.d_yaw, cmd.d_roll);
+            }
+            break;
+
+        case CommandType::ThrustBurn:
+            if (safe_mode_) {
+                if (config_.verbose) {
+                    logging::log("[SAT] %s → BLOCKED (safe mode)", label);
+                }
+            } else {
+                orbit_altitude_km_ += cmd.burn_seconds * 0.5;
+                battery_pct_ -= cmd.burn_seconds * 2.0;
                 if (config_.verbose) {
-                    std::cout << "[SAT] ERROR: failed to process command: " << e.what() << std::endl;
+                    logging::log("[SAT] %s t=%.1fs → applied", label, cmd.burn_seconds);
                 }
-                // Send NAK
-                Packet nak;
-                nak.type = PacketType::NakPkt;
-                nak.seq = pkt.seq;
-                nak.payload = "";
-                nak.payload_size = 0;
-                nak.compute_crc();
-                link_.send_sat_to_gs(nak);
             }
-        }
+            break;
+
+        case CommandType::EnterSafeMode:
+            safe_mode_ = true;
+            if (config_.verbose) {
+                logging::log("[SAT] %s → SAFE MODE ENABLED", label);
+            }
+            break;
+
+        case CommandType::Reboot:
+            if (config_.verbose) {
+                logging::log("[SAT] %s → rebooting...", label);
+            }
+            safe_mode_ = false;
+            // The loop goes quiet until then; never block here, since in
+            // coroutine mode this runs on a shared runtime worker
+            reboot_until_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+            break;
     }
 }
 
+bool Satellite::rebooting(std::chrono::steady_clock::time_point now) {
+    if (reboot_until_ == std::chrono::steady_clock::time_point{}) {
+        return false;
+    }
+    if (now < reboot_until_) {
+        return true;
+    }
+    reboot_until_ = {};
+    if (config_.verbose) {
+        logging::log("[SAT] Reboot complete");
+    }
+    return false;
+}
+
 void Satellite::update_state(double dt) {
     if (dt <= 0 || dt > 1.0) return;  // Sanity check
 
@@ -253,25 +694,189 @@ void Satellite::update_state(double dt) {
 void Satellite::check_anomalies() {
     if (!safe_mode_ && (temperature_c_ > 85.0 || battery_pct_ < 10.0)) {
         safe_mode_ = true;
+
+        std::string reason;
+        if (temperature_c_ > 85.0) reason = "high temp";
+        if (temperature_c_ > 85.0 && battery_pct_ < 10.0) reason += ", ";
+        if (battery_pct_ < 10.0) reason += "low battery";
+
         if (config_.verbose) {
-            std::cout << "[SAT] ENTER SAFE MODE (";
-            if (temperature_c_ > 85.0) std::cout << "high temp";
-            if (temperature_c_ > 85.0 && battery_pct_ < 10.0) std::cout << ", ";
-            if (battery_pct_ < 10.0) std::cout << "low battery";
-            std::cout << ")" << std::endl;
+            logging::log("[SAT] ENTER SAFE MODE (%s)", reason);
         }
+
+        // Notify ground ahead of queued housekeeping
+        Packet event;
+        event.type = PacketType::EventPkt;
+        event.seq = tx_seq_++;
+        event.payload = "SAFE_MODE|" + reason;
+        event.payload_size = static_cast<uint32_t>(event.payload.size());
+        event.compute_crc();
+        transmit(TrafficClass::Event, std::move(event));
     }
 }
 
 bool Satellite::wait_for_ack(uint32_t seq, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
     Packet pkt;
-    if (link_.recv_gs_to_sat(pkt, timeout)) {
+
+    while (true) {
+        service_tx();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+
+        // Poll in short slices while the shaper still holds queued packets
+        auto slice = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+        if (tx_.pending() > 0) {
+            slice = std::min(slice, std::chrono::milliseconds(2));
+        }
+
+        if (!link_.recv_gs_to_sat(pkt, slice)) {
+            continue;
+        }
         if (pkt.type == PacketType::AckPkt && pkt.seq == seq) {
             return true;
-        } else if (pkt.type == PacketType::NakPkt && pkt.seq == seq) {
+        }
+        if (pkt.type == PacketType::NakPkt && pkt.seq == seq) {
             naks_received_++;
             return false;
         }
+        handle_uplink(pkt);  // Commands keep flowing while we wait
+    }
+}
+
+Task<void> Satellite::run_async(CoroutineRuntime& rt) {
+    last_telemetry_ = last_update_ = std::chrono::steady_clock::now();
+
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        if (rebooting(now)) {
+            co_await rt.sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        if (update(now)) {
+            co_await send_telemetry_async(rt);
+        }
+        process_commands();
+        execute_due_commands(now);
+        service_tx();
+        co_await rt.sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+Task<void> Satellite::send_telemetry_async(CoroutineRuntime& rt) {
+    Packet pkt = make_telemetry_packet();
+    bool delivered = co_await send_with_retry_async(rt, pkt, TrafficClass::Housekeeping);
+    if (finish_telemetry(pkt, delivered)) {
+        co_await playback_recorded_async(rt);
+    }
+}
+
+Task<bool> Satellite::send_with_retry_async(CoroutineRuntime& rt, const Packet& pkt, TrafficClass cls) {
+    auto sent_at = std::chrono::steady_clock::now();
+    for (int retry = 0; retry <= config_.max_retries && running_; ++retry) {
+        if (retry > 0) {
+            note_retry(pkt.seq, retry);
+        }
+        if (retry == 0 || !tx_.queued(cls, pkt.seq)) {
+            sent_at = std::chrono::steady_clock::now();
+            transmit(cls, pkt);
+        }
+        if (co_await wait_for_ack_async(rt, pkt.seq, std::chrono::milliseconds(config_.ack_timeout_ms))) {
+            ack_rtt_.record(std::chrono::steady_clock::now() - sent_at);
+            SATCOM_TRACE(Satellite, Acked, pkt.type, 0, pkt.seq, retry);
+            co_return true;
+        }
+    }
+    co_return false;
+}
+
+Task<void> Satellite::playback_recorded_async(CoroutineRuntime& rt) {
+    if (recorder_.empty()) {
+        co_return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int sent = 0; sent < config_.playback_burst;) {
+        std::vector<Packet> group = next_playback_group(static_cast<size_t>(config_.playback_burst - sent));
+        if (group.empty()) {
+            break;
+        }
+        sent += static_cast<int>(group.size());
+        if (!co_await send_group_async(rt, group)) {
+            link_up_ = false;
+            break;
+        }
+    }
+
+    playback_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    recorder_fill_ = recorder_.size();
+}
+
+Task<bool> Satellite::send_group_async(CoroutineRuntime& rt, const std::vector<Packet>& group) {
+    const auto sent_at = transmit_group(group);
+    const auto deadline = sent_at + std::chrono::milliseconds(config_.ack_timeout_ms);
+    std::vector<uint8_t> acked(group.size(), 0);
+    size_t remaining = group.size();
+
+    while (remaining > 0 && running_) {
+        service_tx();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        auto wake = deadline;
+        if (tx_.pending() > 0) {
+            wake = std::min(wake, now + std::chrono::milliseconds(2));
+        }
+        auto pkt = co_await rt.recv_gs_to_sat(link_, wake);
+        if (pkt && !note_group_reply(group, acked, remaining, *pkt, sent_at)) {
+            handle_uplink(*pkt);
+        }
+    }
+
+    for (size_t i = 0; i < group.size(); ++i) {
+        if (!acked[i] && !co_await send_with_retry_async(rt, group[i], TrafficClass::Playback)) {
+            drop_acked_after(group, acked, i);
+            co_return false;
+        }
+        finish_playback(group[i]);
+    }
+    co_return true;
+}
+
+Task<bool> Satellite::wait_for_ack_async(CoroutineRuntime& rt, uint32_t seq,
+                                         std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        service_tx();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            co_return false;
+        }
+
+        // Wake in short slices while the shaper still holds queued packets
+        auto wake = deadline;
+        if (tx_.pending() > 0) {
+            wake = std::min(wake, now + std::chrono::milliseconds(2));
+        }
+
+        auto pkt = co_await rt.recv_gs_to_sat(link_, wake);
+        if (!pkt) {
+            continue;
+        }
+        if (pkt->type == PacketType::AckPkt && pkt->seq == seq) {
+            co_return true;
+        }
+        if (pkt->type == PacketType::NakPkt && pkt->seq == seq) {
+            naks_received_++;
+            co_return false;
+        }
+        handle_uplink(*pkt);  // Commands keep flowing while we wait
     }
-    return false;
 }
@@ -0,0 +1,393 @@
+#include "sweep.hpp"
+#include "coroutine_runtime.hpp"
+#include "ground_station.hpp"
+#include "link.hpp"
+#include "satellite.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Keeps per-run memory small when many runs are in flight
+constexpr size_t kRecorderCapacity = 256;
+
+const char* const kParamNames[] = {
+    "telemetry_rate_hz", "loss", "latency_ms", "jitter_ms", "ack_timeout_ms", "max_retries"};
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+double parse_number(const std::string& text, const std::string& key) {
+    std::string t = trim(text);
+    size_t used = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(t, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (t.empty() || used != t.size()) {
+        throw std::runtime_error("Invalid number for " + key + ": '" + text + "'");
+    }
+    return value;
+}
+
+bool is_param(const std::string& name) {
+    return std::find(std::begin(kParamNames), std::end(kParamNames), name) != std::end(kParamNames);
+}
+
+ParameterSweep::Axis parse_axis(const std::string& name, const std::string& value) {
+    ParameterSweep::Axis axis;
+    axis.name = name;
+
+    if (value.rfind("uniform(", 0) == 0 && value.back() == ')') {
+        std::string args = value.substr(8, value.size() - 9);
+        size_t comma = args.find(',');
+        if (comma == std::string::npos) {
+            throw std::runtime_error("Expected uniform(lo, hi) for " + name);
+        }
+        axis.uniform = true;
+        axis.lo = parse_number(args.substr(0, comma), name);
+        axis.hi = parse_number(args.substr(comma + 1), name);
+        if (axis.hi < axis.lo) {
+            throw std::runtime_error("Empty uniform range for " + name);
+        }
+        return axis;
+    }
+
+    size_t dots = value.find("..");
+    if (dots != std::string::npos) {
+        // lo..hi [step s]
+        std::string rest = value.substr(dots + 2);
+        double step = 1.0;
+        size_t step_pos = rest.find("step");
+        if (step_pos != std::string::npos) {
+            step = parse_number(rest.substr(step_pos + 4), name);
+            rest = rest.substr(0, step_pos);
+        }
+        double lo = parse_number(value.substr(0, dots), name);
+        double hi = parse_number(rest, name);
+        if (step <= 0.0 || hi < lo) {
+            throw std::runtime_error("Invalid range for " + name);
+        }
+        for (double v = lo; v <= hi + step * 1e-9; v += step) {
+            axis.values.push_back(v);
+        }
+        return axis;
+    }
+
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        axis.values.push_back(parse_number(item, name));
+    }
+    if (axis.values.empty()) {
+        throw std::runtime_error("No values for " + name);
+    }
+    return axis;
+}
+
+/**
+ * Two-sided 97.5% Student t quantile for df degrees of freedom: tabulated
+ * up to 30, then the Cornish-Fisher expansion around the normal quantile
+ * (within 1e-3 of the exact value from df 31 on).
+ */
+double t_quantile_975(size_t df) {
+    static const double table[] = {
+        0.0,    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201,  2.179,  2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080,  2.074,  2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < std::size(table)) {
+        return table[df];
+    }
+    const double z = 1.959964;
+    const double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+    const double d = static_cast<double>(df);
+    return z + (z3 + z) / (4 * d) + (5 * z5 + 16 * z3 + 3 * z) / (96 * d * d) +
+           (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * d * d * d);
+}
+
+} // namespace
+
+const char* ParameterSweep::metric_name(Metric m) {
+    switch (m) {
+        case TelemetrySent: return "telemetry_sent";
+        case TelemetryReceived: return "telemetry_received";
+        case TelemetryPerSec: return "telemetry_per_sec";
+        case SatRetries: return "sat_retries";
+        case NaksReceived: return "naks_received";
+        case CommandsSent: return "commands_sent";
+        case GsRetries: return "gs_retries";
+        case PacketsSent: return "packets_sent";
+        case PacketsDropped: return "packets_dropped";
+        case DropRate: return "drop_rate";
+        case RecordsStored: return "records_stored";
+        default: return "unknown";
+    }
+}
+
+ParameterSweep::Spec ParameterSweep::parse_spec(std::istream& in, const Point& base) {
+    Spec spec;
+    spec.base = base;
+
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("Line " + std::to_string(line_no) + ": expected key = value");
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        if (key == "mode") {
+            if (value == "grid") {
+                spec.mode = Spec::Mode::Grid;
+            } else if (value == "random") {
+                spec.mode = Spec::Mode::Random;
+            } else {
+                throw std::runtime_error("Unknown sweep mode: " + value);
+            }
+        } else if (key == "samples") {
+            spec.samples = static_cast<size_t>(parse_number(value, key));
+        } else if (key == "replicas") {
+            spec.replicas = static_cast<size_t>(parse_number(value, key));
+        } else if (key == "duration_sec") {
+            spec.duration_sec = parse_number(value, key);
+        } else if (key == "max_concurrent") {
+            spec.max_concurrent = static_cast<size_t>(parse_number(value, key));
+        } else if (key == "workers") {
+            spec.num_workers = static_cast<size_t>(parse_number(value, key));
+        } else if (key == "seed") {
+            spec.seed = static_cast<unsigned int>(parse_number(value, key));
+        } else if (is_param(key)) {
+            spec.axes.push_back(parse_axis(key, value));
+        } else {
+            throw std::runtime_error("Line " + std::to_string(line_no) + ": unknown key '" + key + "'");
+        }
+    }
+
+    if (spec.replicas == 0 || spec.max_concurrent == 0) {
+        throw std::runtime_error("replicas and max_concurrent must be positive");
+    }
+    return spec;
+}
+
+ParameterSweep::Stat ParameterSweep::summarize(const std::vector<double>& samples) {
+    Stat stat;
+    const size_t n = samples.size();
+    if (n == 0) {
+        return stat;
+    }
+
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    stat.mean = sum / static_cast<double>(n);
+
+    if (n > 1) {
+        double sq = 0.0;
+        for (double v : samples) sq += (v - stat.mean) * (v - stat.mean);
+        stat.stddev = std::sqrt(sq / static_cast<double>(n - 1));
+        stat.ci95 = t_quantile_975(n - 1) * stat.stddev / std::sqrt(static_cast<double>(n));
+    }
+    return stat;
+}
+
+void ParameterSweep::set_param(Point& point, const std::string& name, double value) {
+    if (name == "telemetry_rate_hz") {
+        point.telemetry_rate_hz = value;
+    } else if (name == "loss") {
+        point.loss = value;
+    } else if (name == "latency_ms") {
+        point.latency_ms = std::round(value);
+    } else if (name == "jitter_ms") {
+        point.jitter_ms = std::round(value);
+    } else if (name == "ack_timeout_ms") {
+        point.ack_timeout_ms = std::round(value);
+    } else if (name == "max_retries") {
+        point.max_retries = std::round(value);
+    }
+}
+
+ParameterSweep::ParameterSweep(const Spec& spec) : spec_(spec) {
+    if (spec_.mode == Spec::Mode::Grid) {
+        // Cartesian product, first axis varying slowest
+        points_.push_back(spec_.base);
+        for (const Axis& axis : spec_.axes) {
+            if (axis.uniform) {
+                throw std::runtime_error("uniform() needs mode = random (" + axis.name + ")");
+            }
+            std::vector<Point> expanded;
+            for (const Point& p : points_) {
+                for (double v : axis.values) {
+                    Point q = p;
+                    set_param(q, axis.name, v);
+                    expanded.push_back(q);
+                }
+            }
+            points_ = std::move(expanded);
+        }
+    } else {
+        std::mt19937 rng(spec_.seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        for (size_t i = 0; i < spec_.samples; ++i) {
+            Point p = spec_.base;
+            for (const Axis& axis : spec_.axes) {
+                double v;
+                if (axis.uniform) {
+                    v = axis.lo + unit(rng) * (axis.hi - axis.lo);
+                } else {
+                    v = axis.values[static_cast<size_t>(unit(rng) * axis.values.size()) % axis.values.size()];
+                }
+                set_param(p, axis.name, v);
+            }
+            points_.push_back(p);
+        }
+    }
+}
+
+std::vector<ParameterSweep::Summary> ParameterSweep::run(std::function<void(size_t, size_t)> progress) {
+    struct Run {
+        size_t point;
+        std::unique_ptr<Link> link;
+        std::unique_ptr<Satellite> satellite;
+        std::unique_ptr<GroundStation> ground_station;
+    };
+
+    const size_t total = total_runs();
+    std::vector<std::array<std::vector<double>, kNumMetrics>> samples(points_.size());
+
+    CoroutineRuntime::Config rt_config;
+    rt_config.num_workers = spec_.num_workers;
+    CoroutineRuntime runtime(rt_config);
+
+    for (size_t first = 0; first < total; first += spec_.max_concurrent) {
+        const size_t last = std::min(total, first + spec_.max_concurrent);
+        std::vector<Run> runs;
+        runs.reserve(last - first);
+
+        for (size_t r = first; r < last; ++r) {
+            const size_t point_index = r / spec_.replicas;
+            const Point& p = points_[point_index];
+            // Every run gets its own seed; replicas of a point differ only by seed
+            const unsigned int seed = spec_.seed + static_cast<unsigned int>(r);
+
+            Link::Config link_config;
+            link_config.latency_ms = static_cast<int>(p.latency_ms);
+            link_config.jitter_ms = static_cast<int>(p.jitter_ms);
+            link_config.loss_prob = p.loss;
+            link_config.seed = seed;
+            link_config.deferred_delivery = true;
+
+            Satellite::Config sat_config;
+            sat_config.telemetry_rate_hz = p.telemetry_rate_hz;
+            sat_config.ack_timeout_ms = static_cast<int>(p.ack_timeout_ms);
+            sat_config.max_retries = static_cast<int>(p.max_retries);
+            sat_config.recorder_capacity = kRecorderCapacity;
+            sat_config.seed = seed;
+
+            GroundStation::Config gs_config;
+            gs_config.ack_timeout_ms = static_cast<int>(p.ack_timeout_ms);
+            gs_config.max_retries = static_cast<int>(p.max_retries);
+            gs_config.log_file = "";
+            gs_config.seed = seed;
+
+            Run run;
+            run.point = point_index;
+            run.link = std::make_unique<Link>(link_config);
+            run.satellite = std::make_unique<Satellite>(*run.link, sat_config);
+            run.ground_station = std::make_unique<GroundStation>(*run.link, gs_config);
+            runs.push_back(std::move(run));
+        }
+
+        for (Run& run : runs) {
+            run.satellite->start(runtime);
+            run.ground_station->start(runtime);
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(spec_.duration_sec));
+
+        // Signal everything first so the batch winds down in parallel
+        for (Run& run : runs) {
+            run.satellite->request_stop();
+            run.ground_station->request_stop();
+        }
+        for (Run& run : runs) {
+            run.satellite->stop();
+            run.ground_station->stop();
+
+            auto& m = samples[run.point];
+            double sent = static_cast<double>(run.link->get_packets_sent());
+            double dropped = static_cast<double>(run.link->get_packets_dropped());
+            m[TelemetrySent].push_back(static_cast<double>(run.satellite->get_telemetry_sent()));
+            m[TelemetryReceived].push_back(static_cast<double>(run.ground_station->get_telemetry_received()));
+            m[TelemetryPerSec].push_back(run.ground_station->get_telemetry_received() / spec_.duration_sec);
+            m[SatRetries].push_back(static_cast<double>(run.satellite->get_retries()));
+            m[NaksReceived].push_back(static_cast<double>(run.satellite->get_naks_received()));
+            m[CommandsSent].push_back(static_cast<double>(run.ground_station->get_commands_sent()));
+            m[GsRetries].push_back(static_cast<double>(run.ground_station->get_retries()));
+            m[PacketsSent].push_back(sent);
+            m[PacketsDropped].push_back(dropped);
+            m[DropRate].push_back(sent > 0 ? dropped / sent : 0.0);
+            m[RecordsStored].push_back(static_cast<double>(run.satellite->get_records_stored()));
+        }
+
+        if (progress) {
+            progress(last, total);
+        }
+    }
+
+    std::vector<Summary> summaries;
+    for (size_t i = 0; i < points_.size(); ++i) {
+        Summary summary;
+        summary.point = points_[i];
+        summary.runs = samples[i][0].size();
+        for (int m = 0; m < kNumMetrics; ++m) {
+            summary.stats[m] = summarize(samples[i][m]);
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+void ParameterSweep::write_csv(std::ostream& out, const std::vector<Summary>& summaries) {
+    for (const char* name : kParamNames) {
+        out << name << ',';
+    }
+    out << "runs";
+    for (int m = 0; m < kNumMetrics; ++m) {
+        const char* name = metric_name(static_cast<Metric>(m));
+        out << ',' << name << "_mean," << name << "_ci95";
+    }
+    out << '\n';
+
+    out << std::setprecision(6);
+    for (const Summary& s : summaries) {
+        out << s.point.telemetry_rate_hz << ',' << s.point.loss << ','
+            << s.point.latency_ms << ',' << s.point.jitter_ms << ','
+            << s.point.ack_timeout_ms << ',' << s.point.max_retries << ',' << s.runs;
+        for (const Stat& stat : s.stats) {
+            out << ',' << stat.mean << ',' << stat.ci95;
+        }
+        out << '\n';
+    }
+}
@@ -0,0 +1,163 @@
+#include "telemetry_recorder.hpp"
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define SATCOM_HAVE_MMAP 1
+#endif
+
+TelemetryRecorder::TelemetryRecorder(const Config& config) : config_(config) {
+    if (config_.capacity == 0 || config_.record_size <= kLengthPrefix ||
+        config_.record_size > 0xFFFF + kLengthPrefix) {
+        throw std::runtime_error("Invalid recorder geometry");
+    }
+
+    arena_bytes_ = sizeof(Header) + config_.capacity * config_.record_size;
+
+    if (!config_.backing_file.empty()) {
+        map_file();
+    } else {
+        heap_arena_ = std::make_unique<uint8_t[]>(arena_bytes_);
+        arena_ = heap_arena_.get();
+    }
+
+    header_ = reinterpret_cast<Header*>(arena_);
+
+    // Resume a previous recording only if the geometry matches and the
+    // ring indices are in range; a torn or foreign file starts empty
+    if (header_->magic != kMagic ||
+        header_->record_size != config_.record_size ||
+        header_->capacity != config_.capacity ||
+        header_->head >= config_.capacity ||
+        header_->count > config_.capacity) {
+        header_->magic = kMagic;
+        header_->record_size = static_cast<uint32_t>(config_.record_size);
+        header_->capacity = config_.capacity;
+        header_->head = 0;
+        header_->count = 0;
+        header_->overwritten = 0;
+    } else {
+        // A torn slot's length would read past the slot (or the mapping):
+        // count the recording as rejected and start empty
+        for (size_t i = 0; i < header_->count; ++i) {
+            if (length_at(i) > max_record_size()) {
+                rejected_ += header_->count;
+                header_->head = 0;
+                header_->count = 0;
+                break;
+            }
+        }
+    }
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+#ifdef SATCOM_HAVE_MMAP
+    if (mapping_) {
+        msync(mapping_, arena_bytes_, MS_ASYNC);
+        munmap(mapping_, arena_bytes_);
+    }
+#endif
+}
+
+void TelemetryRecorder::map_file() {
+#ifdef SATCOM_HAVE_MMAP
+    int fd = open(config_.backing_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open recorder file: " + config_.backing_file);
+    }
+    if (ftruncate(fd, static_cast<off_t>(arena_bytes_)) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot size recorder file: " + config_.backing_file);
+    }
+    void* mem = mmap(nullptr, arena_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // Mapping stays valid after close
+    if (mem == MAP_FAILED) {
+        throw std::runtime_error("Cannot map recorder file: " + config_.backing_file);
+    }
+    mapping_ = mem;
+    arena_ = static_cast<uint8_t*>(mem);
+#else
+    throw std::runtime_error("File-backed recorder not supported on this platform");
+#endif
+}
+
+uint8_t* TelemetryRecorder::slot(size_t index) const {
+    return arena_ + sizeof(Header) + index * config_.record_size;
+}
+
+size_t TelemetryRecorder::length_at(size_t index) const {
+    const uint8_t* s = slot((header_->head + index) % config_.capacity);
+    return (static_cast<size_t>(s[0]) << 8) | s[1];
+}
+
+bool TelemetryRecorder::store(const std::string& record) {
+    if (record.size() > max_record_size()) {
+        rejected_++;
+        return false;
+    }
+
+    if (header_->count == config_.capacity) {
+        // Full: drop oldest
+        header_->head = (header_->head + 1) % config_.capacity;
+        header_->count--;
+        header_->overwritten++;
+    }
+
+    size_t tail = (header_->head + header_->count) % config_.capacity;
+    uint8_t* s = slot(tail);
+    s[0] = static_cast<uint8_t>(record.size() >> 8);
+    s[1] = static_cast<uint8_t>(record.size() & 0xFF);
+    std::memcpy(s + kLengthPrefix, record.data(), record.size());
+    header_->count++;
+    return true;
+}
+
+bool TelemetryRecorder::peek(std::string& out) const {
+    return peek(0, out);
+}
+
+bool TelemetryRecorder::peek(size_t index, std::string& out) const {
+    if (index >= header_->count) {
+        return false;
+    }
+    const size_t len = length_at(index);
+    if (len > max_record_size()) {
+        return false;  // Corrupted under the mapping since it was checked
+    }
+    const uint8_t* s = slot((header_->head + index) % config_.capacity);
+    out.assign(reinterpret_cast<const char*>(s + kLengthPrefix), len);
+    return true;
+}
+
+void TelemetryRecorder::pop() {
+    if (header_->count == 0) {
+        return;
+    }
+    header_->head = (header_->head + 1) % config_.capacity;
+    header_->count--;
+}
+
+void TelemetryRecorder::erase(size_t index) {
+    if (index >= header_->count) {
+        return;
+    }
+    // Move the older records up one slot, then drop the vacated oldest one
+    for (size_t i = index; i > 0; --i) {
+        std::memcpy(slot((header_->head + i) % config_.capacity),
+                    slot((header_->head + i - 1) % config_.capacity), config_.record_size);
+    }
+    pop();
+}
+
+void TelemetryRecorder::clear() {
+    header_->head = 0;
+    header_->count = 0;
+    header_->overwritten = 0;
+}
+
+double TelemetryRecorder::fill_ratio() const {
+    return static_cast<double>(header_->count) / static_cast<double>(config_.capacity);
+}
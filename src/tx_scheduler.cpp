@@ -0,0 +1,131 @@
+#include "tx_scheduler.hpp"
+#include <algorithm>
+
+TxScheduler::TxScheduler(const Config& config)
+    : config_(config), tokens_(static_cast<double>(config.burst_bytes)) {}
+
+void TxScheduler::enqueue(TrafficClass cls, Packet pkt, Clock::time_point now) {
+    size_t i = index(cls);
+    auto& queue = queues_[i];
+    if (queue.size() >= config_.queue_limit) {
+        queue.pop_front();  // Drop oldest: fresher data is more useful
+        dropped_[i]++;
+    }
+    queue.push_back(Entry{std::move(pkt), now});
+}
+
+std::optional<Packet> TxScheduler::dequeue(Clock::time_point now) {
+    if (pending() == 0) {
+        return std::nullopt;
+    }
+
+    const bool shaped = config_.rate_bytes_per_sec > 0.0;
+    if (shaped) {
+        refill(now);
+        if (tokens_ <= 0.0) {
+            return std::nullopt;  // Link busy
+        }
+    }
+
+    size_t cls = 0;
+    if (config_.policy == Policy::StrictPriority) {
+        while (queues_[cls].empty()) {
+            ++cls;
+        }
+    } else {
+        // Deficit round robin: each visit grants quantum * weight bytes
+        while (true) {
+            auto& queue = queues_[rr_];
+            if (queue.empty()) {
+                deficit_[rr_] = 0;
+                rr_ = (rr_ + 1) % kNumTrafficClasses;
+                granted_ = false;
+                continue;
+            }
+            if (!granted_) {
+                deficit_[rr_] += kQuantumBytes * std::max<uint32_t>(1, config_.weights[rr_]);
+                granted_ = true;
+            }
+            size_t cost = wire_size(queue.front().pkt);
+            if (cost <= deficit_[rr_]) {
+                deficit_[rr_] -= cost;
+                cls = rr_;
+                break;
+            }
+            rr_ = (rr_ + 1) % kNumTrafficClasses;
+            granted_ = false;
+        }
+    }
+
+    Entry entry = std::move(queues_[cls].front());
+    queues_[cls].pop_front();
+
+    if (shaped) {
+        tokens_ -= static_cast<double>(wire_size(entry.pkt));
+    }
+    sent_[cls]++;
+    residency_[cls].record(now - entry.enqueued);
+    return std::move(entry.pkt);
+}
+
+bool TxScheduler::queued(TrafficClass cls, uint32_t seq) const {
+    const auto& queue = queues_[index(cls)];
+    return std::any_of(queue.begin(), queue.end(),
+                       [seq](const Entry& e) { return e.pkt.seq == seq; });
+}
+
+std::vector<Packet> TxScheduler::queued_packets(TrafficClass cls) const {
+    std::vector<Packet> packets;
+    for (const Entry& e : queues_[index(cls)]) {
+        packets.push_back(e.pkt);
+    }
+    return packets;
+}
+
+void TxScheduler::reset() {
+    for (auto& queue : queues_) {
+        queue.clear();
+    }
+    deficit_ = {};
+    rr_ = 0;
+    granted_ = false;
+    tokens_ = static_cast<double>(config_.burst_bytes);
+    last_refill_.reset();
+    sent_ = {};
+    dropped_ = {};
+    for (auto& residency : residency_) {
+        residency.reset();
+    }
+}
+
+size_t TxScheduler::pending() const {
+    size_t total = 0;
+    for (const auto& queue : queues_) {
+        total += queue.size();
+    }
+    return total;
+}
+
+void TxScheduler::refill(Clock::time_point now) {
+    if (last_refill_ && now > *last_refill_) {
+        double elapsed = std::chrono::duration<double>(now - *last_refill_).count();
+        tokens_ = std::min(static_cast<double>(config_.burst_bytes),
+                           tokens_ + elapsed * config_.rate_bytes_per_sec);
+    }
+    if (!last_refill_ || now > *last_refill_) {
+        last_refill_ = now;
+    }
+}
+
+TxScheduler::ClassStats TxScheduler::stats(TrafficClass cls) const {
+    size_t i = index(cls);
+    ClassStats stats;
+    stats.sent = sent_[i];
+    stats.dropped = dropped_[i];
+
+    HdrHistogram residency = residency_[i].snapshot();
+    stats.p50_ms = static_cast<double>(residency.percentile(50.0)) / 1e6;
+    stats.p99_ms = static_cast<double>(residency.percentile(99.0)) / 1e6;
+    stats.max_ms = static_cast<double>(residency.max()) / 1e6;
+    return stats;
+}
@@ -0,0 +1,293 @@
+#include "viterbi.hpp"
+#include <algorithm>
+#include <array>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SATCOM_VITERBI_X86 1
+#include <immintrin.h>
+#endif
+
+namespace viterbi {
+namespace {
+
+constexpr unsigned kStates = 1u << (kConstraint - 1);
+constexpr unsigned kButterflies = kStates / 2;
+constexpr size_t kTailBits = kConstraint - 1;
+
+// Cost of a symbol pair that disagrees completely with the expected one
+constexpr int16_t kMaxBranch = 2 * 255;
+
+// Metrics of unreachable start states: worse than any real path, which is
+// at most (K - 1) * kMaxBranch behind the best one
+constexpr int16_t kUnreached = 4096;
+
+// Renormalize once state 0 passes this; the spread between states is
+// bounded, so nothing comes near the int16 limit
+constexpr int16_t kRenormAt = 16384;
+
+constexpr unsigned parity(unsigned x) {
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+// Octal generators put the current input bit on top; the shift register
+// here keeps it in bit 0
+constexpr unsigned reverse_taps(unsigned poly) {
+    unsigned taps = 0;
+    for (unsigned i = 0; i < kConstraint; ++i) {
+        taps |= ((poly >> i) & 1) << (kConstraint - 1 - i);
+    }
+    return taps;
+}
+
+constexpr unsigned kTapsA = reverse_taps(kPolyA);
+constexpr unsigned kTapsB = reverse_taps(kPolyB);
+static_assert(kTapsA == 0x4F && kTapsB == 0x6D, "171/133 octal, current bit in bit 0");
+static_assert((kTapsA & kTapsB & 0x41) == 0x41,
+              "both generators tap the newest and oldest bit, so butterflies are symmetric");
+
+// State = last K-1 input bits, newest in bit 0. Butterfly i joins old states
+// i and i + 32 to new states 2i (input 0) and 2i + 1 (input 1). Both outputs
+// flip with the oldest or the newest bit, so one expected symbol pair per
+// butterfly, that of i -> 2i, gives all four branches. Stored as 0 or 255:
+// the cost of soft symbol s against expected e is then s ^ e.
+struct BranchTable {
+    alignas(32) int16_t a[kButterflies];
+    alignas(32) int16_t b[kButterflies];
+};
+
+constexpr BranchTable make_branch_table() {
+    BranchTable t{};
+    for (unsigned i = 0; i < kButterflies; ++i) {
+        t.a[i] = parity((i << 1) & kTapsA) ? 255 : 0;
+        t.b[i] = parity((i << 1) & kTapsB) ? 255 : 0;
+    }
+    return t;
+}
+
+constexpr BranchTable kBranch = make_branch_table();
+
+// One trellis step: fill next from old for symbol pair (s0, s1) and return
+// the decisions, bit i for new state 2i and bit 32 + i for 2i + 1, set when
+// the path through old state i + 32 won (ties go to state i)
+uint64_t step_scalar(const int16_t* old, int16_t* next, uint8_t s0, uint8_t s1) {
+    uint32_t even = 0;
+    uint32_t odd = 0;
+    for (unsigned i = 0; i < kButterflies; ++i) {
+        const int16_t bm = static_cast<int16_t>((s0 ^ kBranch.a[i]) + (s1 ^ kBranch.b[i]));
+        const int16_t inv = static_cast<int16_t>(kMaxBranch - bm);
+        const int16_t e0 = static_cast<int16_t>(old[i] + bm);
+        const int16_t e1 = static_cast<int16_t>(old[i + kButterflies] + inv);
+        const int16_t o0 = static_cast<int16_t>(old[i] + inv);
+        const int16_t o1 = static_cast<int16_t>(old[i + kButterflies] + bm);
+        next[2 * i] = std::min(e0, e1);
+        next[2 * i + 1] = std::min(o0, o1);
+        even |= static_cast<uint32_t>(e0 > e1) << i;
+        odd |= static_cast<uint32_t>(o0 > o1) << i;
+    }
+    return even | static_cast<uint64_t>(odd) << 32;
+}
+
+#ifdef SATCOM_VITERBI_X86
+
+__attribute__((target("sse2")))
+uint64_t step_sse2(const int16_t* old, int16_t* next, uint8_t s0, uint8_t s1) {
+    const __m128i sym0 = _mm_set1_epi16(s0);
+    const __m128i sym1 = _mm_set1_epi16(s1);
+    const __m128i max = _mm_set1_epi16(kMaxBranch);
+    uint32_t decisions[2] = {0, 0};
+    // 16 butterflies per pass so the decision masks pack into 16-bit groups
+    for (unsigned i = 0; i < kButterflies; i += 16) {
+        __m128i de[2];
+        __m128i dodd[2];
+        for (unsigned h = 0; h < 2; ++h) {
+            const unsigned k = i + 8 * h;
+            const __m128i bm = _mm_add_epi16(
+                _mm_xor_si128(sym0, _mm_load_si128(reinterpret_cast<const __m128i*>(kBranch.a + k))),
+                _mm_xor_si128(sym1, _mm_load_si128(reinterpret_cast<const __m128i*>(kBranch.b + k))));
+            const __m128i inv = _mm_sub_epi16(max, bm);
+            const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(old + k));
+            const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(old + k + kButterflies));
+            const __m128i e0 = _mm_add_epi16(lo, bm);
+            const __m128i e1 = _mm_add_epi16(hi, inv);
+            const __m128i o0 = _mm_add_epi16(lo, inv);
+            const __m128i o1 = _mm_add_epi16(hi, bm);
+            const __m128i e = _mm_min_epi16(e0, e1);
+            const __m128i o = _mm_min_epi16(o0, o1);
+            de[h] = _mm_cmpgt_epi16(e0, e1);
+            dodd[h] = _mm_cmpgt_epi16(o0, o1);
+            _mm_store_si128(reinterpret_cast<__m128i*>(next + 2 * k), _mm_unpacklo_epi16(e, o));
+            _mm_store_si128(reinterpret_cast<__m128i*>(next + 2 * k + 8), _mm_unpackhi_epi16(e, o));
+        }
+        decisions[0] |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(de[0], de[1]))) << i;
+        decisions[1] |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(dodd[0], dodd[1]))) << i;
+    }
+    return decisions[0] | static_cast<uint64_t>(decisions[1]) << 32;
+}
+
+__attribute__((target("avx2")))
+uint64_t step_avx2(const int16_t* old, int16_t* next, uint8_t s0, uint8_t s1) {
+    const __m256i sym0 = _mm256_set1_epi16(s0);
+    const __m256i sym1 = _mm256_set1_epi16(s1);
+    const __m256i max = _mm256_set1_epi16(kMaxBranch);
+    __m256i de[2];
+    __m256i dodd[2];
+    for (unsigned h = 0; h < 2; ++h) {
+        const unsigned k = 16 * h;
+        const __m256i bm = _mm256_add_epi16(
+            _mm256_xor_si256(sym0, _mm256_load_si256(reinterpret_cast<const __m256i*>(kBranch.a + k))),
+            _mm256_xor_si256(sym1, _mm256_load_si256(reinterpret_cast<const __m256i*>(kBranch.b + k))));
+        const __m256i inv = _mm256_sub_epi16(max, bm);
+        const __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(old + k));
+        const __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(old + k + kButterflies));
+        const __m256i e0 = _mm256_add_epi16(lo, bm);
+        const __m256i e1 = _mm256_add_epi16(hi, inv);
+        const __m256i o0 = _mm256_add_epi16(lo, inv);
+        const __m256i o1 = _mm256_add_epi16(hi, bm);
+        const __m256i e = _mm256_min_epi16(e0, e1);
+        const __m256i o = _mm256_min_epi16(o0, o1);
+        de[h] = _mm256_cmpgt_epi16(e0, e1);
+        dodd[h] = _mm256_cmpgt_epi16(o0, o1);
+        // Unpacking interleaves within 128-bit lanes; put the lanes back in order
+        const __m256i lo_pairs = _mm256_unpacklo_epi16(e, o);
+        const __m256i hi_pairs = _mm256_unpackhi_epi16(e, o);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(next + 2 * k),
+                           _mm256_permute2x128_si256(lo_pairs, hi_pairs, 0x20));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(next + 2 * k + 16),
+                           _mm256_permute2x128_si256(lo_pairs, hi_pairs, 0x31));
+    }
+    // Packing also works per lane: 64-bit groups come out as 0, 2, 1, 3
+    const uint32_t even = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_permute4x64_epi64(_mm256_packs_epi16(de[0], de[1]), 0xD8)));
+    const uint32_t odd = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_permute4x64_epi64(_mm256_packs_epi16(dodd[0], dodd[1]), 0xD8)));
+    return even | static_cast<uint64_t>(odd) << 32;
+}
+
+#endif
+
+Kernel detect_kernel() {
+#ifdef SATCOM_VITERBI_X86
+    __builtin_cpu_init();  // May run before libgcc's own constructor
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Kernel::Sse2;
+    }
+#endif
+    return Kernel::Scalar;
+}
+
+using StepFn = uint64_t (*)(const int16_t*, int16_t*, uint8_t, uint8_t);
+
+StepFn step_for(Kernel kernel) {
+#ifdef SATCOM_VITERBI_X86
+    switch (kernel) {
+        case Kernel::Avx2: return step_avx2;
+        case Kernel::Sse2: return step_sse2;
+        case Kernel::Scalar: break;
+    }
+#else
+    (void)kernel;
+#endif
+    return step_scalar;
+}
+
+} // namespace
+
+std::vector<uint8_t> encode(const uint8_t* data, size_t n) {
+    // Output pair for every value of the K-bit shift register
+    static constexpr auto kOutputs = [] {
+        std::array<std::array<uint8_t, 2>, 1u << kConstraint> t{};
+        for (unsigned reg = 0; reg < t.size(); ++reg) {
+            t[reg] = {static_cast<uint8_t>(parity(reg & kTapsA) ? 255 : 0),
+                      static_cast<uint8_t>(parity(reg & kTapsB) ? 255 : 0)};
+        }
+        return t;
+    }();
+
+    std::vector<uint8_t> out(encoded_symbols(n));
+    uint8_t* sym = out.data();
+    unsigned reg = 0;
+    auto shift_in = [&](unsigned bit) {
+        reg = ((reg << 1) | bit) & ((1u << kConstraint) - 1);
+        sym[0] = kOutputs[reg][0];
+        sym[1] = kOutputs[reg][1];
+        sym += 2;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            shift_in((data[i] >> b) & 1);
+        }
+    }
+    for (size_t i = 0; i < kTailBits; ++i) {
+        shift_in(0);
+    }
+    return out;
+}
+
+bool supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return true;
+        case Kernel::Sse2: return best_kernel() != Kernel::Scalar;
+        case Kernel::Avx2: return best_kernel() == Kernel::Avx2;
+    }
+    return false;
+}
+
+Kernel best_kernel() {
+    static const Kernel kernel = detect_kernel();
+    return kernel;
+}
+
+const char* kernel_name(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::Sse2: return "sse2";
+        case Kernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void decode(const uint8_t* symbols, size_t n, uint8_t* out) {
+    decode(symbols, n, out, best_kernel());
+}
+
+void decode(const uint8_t* symbols, size_t n, uint8_t* out, Kernel kernel) {
+    const StepFn step = step_for(supported(kernel) ? kernel : Kernel::Scalar);
+    const size_t steps = 8 * n + kTailBits;
+
+    // Forward pass: 64 decision bits per step for the traceback
+    std::vector<uint64_t> decisions(steps);
+    alignas(32) int16_t metrics[2][kStates];
+    std::fill(std::begin(metrics[0]), std::end(metrics[0]), kUnreached);
+    metrics[0][0] = 0;  // The encoder starts in state 0
+    for (size_t t = 0; t < steps; ++t) {
+        int16_t* next = metrics[(t + 1) & 1];
+        decisions[t] = step(metrics[t & 1], next, symbols[2 * t], symbols[2 * t + 1]);
+        if (next[0] > kRenormAt) {
+            const int16_t base = next[0];
+            for (int16_t& m : metrics[(t + 1) & 1]) {
+                m = static_cast<int16_t>(m - base);
+            }
+        }
+    }
+
+    // Traceback from state 0, where the tail leaves the encoder; the newest
+    // bit of each state on the survivor path is the input at that step
+    std::fill(out, out + n, 0);
+    unsigned state = 0;
+    for (size_t t = steps; t-- > 0;) {
+        const unsigned bit = state & 1;
+        if (bit && t < 8 * n) {
+            out[t / 8] |= static_cast<uint8_t>(0x80 >> (t % 8));
+        }
+        const unsigned i = state >> 1;
+        state = i + kButterflies * ((decisions[t] >> (32 * bit + i)) & 1);
+    }
+}
+
+} // namespace viterbi
@@ -0,0 +1,217 @@
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+
+namespace {
+thread_local const WorkStealingPool* tls_pool = nullptr;
+thread_local int tls_worker = -1;
+
+int64_t to_ns(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t num_workers) {
+    size_t n = num_workers ? num_workers : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < n; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < n; ++i) {
+        workers_[i]->thread = std::thread(&WorkStealingPool::run_worker, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // Workers are gone; discard anything left
+    for (auto& worker : workers_) {
+        while (auto task = worker->deque.pop()) {
+            delete *task;
+        }
+    }
+    for (Task* task : injected_) {
+        delete task;
+    }
+    for (const Timer& timer : timers_) {
+        delete timer.task;
+    }
+}
+
+int WorkStealingPool::current_worker() const {
+    return tls_pool == this ? tls_worker : -1;
+}
+
+void WorkStealingPool::submit(Task task) {
+    outstanding_++;
+    Task* t = new Task(std::move(task));
+    int self = current_worker();
+    if (self >= 0) {
+        workers_[static_cast<size_t>(self)]->deque.push(t);
+        wake_one();
+    } else {
+        inject(t);
+    }
+}
+
+void WorkStealingPool::submit_fair(Task task) {
+    outstanding_++;
+    inject(new Task(std::move(task)));
+}
+
+void WorkStealingPool::submit_at(Clock::time_point when, Task task) {
+    outstanding_++;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        timers_.push_back(Timer{when, timer_order_++, new Task(std::move(task))});
+        std::push_heap(timers_.begin(), timers_.end(), std::greater<Timer>{});
+        next_timer_ns_ = to_ns(timers_.front().when);
+    }
+    // A parked worker may need to shorten its wait
+    wake_one();
+}
+
+void WorkStealingPool::spawn_agent(Agent agent) {
+    auto shared = std::make_shared<Agent>(std::move(agent));
+    submit([this, shared] { run_agent_step(shared); });
+}
+
+void WorkStealingPool::run_agent_step(std::shared_ptr<Agent> agent) {
+    AgentStep next = (*agent)();
+    switch (next.kind) {
+        case AgentStep::Kind::Yield:
+            // Back of the shared FIFO so other agents get a turn
+            submit_fair([this, agent] { run_agent_step(agent); });
+            break;
+        case AgentStep::Kind::Sleep:
+            submit_at(next.wake, [this, agent] { run_agent_step(agent); });
+            break;
+        case AgentStep::Kind::Done:
+            break;
+    }
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(done_mutex_);
+    done_cv_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+void WorkStealingPool::inject(Task* task) {
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        injected_.push_back(task);
+        injected_count_++;
+    }
+    wake_one();
+}
+
+void WorkStealingPool::wake_one() {
+    // Every push lands here after the task is visible. A parking worker bumps
+    // sleeping_ and then compares work_epoch_ with the value it saw before
+    // searching, so either it sees this bump and skips the wait or we see it
+    // parked and notify under idle_mutex_
+    work_epoch_++;
+    if (sleeping_ > 0) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_one();
+    }
+}
+
+void WorkStealingPool::task_finished() {
+    if (--outstanding_ == 0) {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        done_cv_.notify_all();
+    }
+}
+
+void WorkStealingPool::run_worker(size_t index) {
+    tls_pool = this;
+    tls_worker = static_cast<int>(index);
+    uint64_t rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+
+    while (running_) {
+        fire_due_timers(index);
+        uint64_t epoch = work_epoch_;
+
+        if (Task* task = find_task(index, rng)) {
+            (*task)();
+            delete task;
+            tasks_executed_++;
+            task_finished();
+            continue;
+        }
+
+        // Park until work arrives or the next timer is due; the 1 ms bound
+        // is only a backstop
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        sleeping_++;
+        auto wake = Clock::now() + std::chrono::milliseconds(1);
+        int64_t next_timer = next_timer_ns_;
+        if (next_timer < to_ns(wake)) {
+            wake = Clock::time_point(std::chrono::nanoseconds(next_timer));
+        }
+        if (running_ && work_epoch_ == epoch) {
+            idle_cv_.wait_until(lock, wake);
+        }
+        sleeping_--;
+    }
+}
+
+WorkStealingPool::Task* WorkStealingPool::find_task(size_t index, uint64_t& rng) {
+    if (auto task = workers_[index]->deque.pop()) {
+        return *task;
+    }
+
+    if (injected_count_ > 0) {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (!injected_.empty()) {
+            Task* task = injected_.front();
+            injected_.pop_front();
+            injected_count_--;
+            return task;
+        }
+    }
+
+    // Steal, starting from a random victim
+    const size_t n = workers_.size();
+    if (n > 1) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        size_t start = static_cast<size_t>(rng % n);
+        for (size_t k = 0; k < n; ++k) {
+            size_t victim = (start + k) % n;
+            if (victim == index) {
+                continue;
+            }
+            if (auto task = workers_[victim]->deque.steal()) {
+                steals_++;
+                return *task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::fire_due_timers(size_t index) {
+    auto now = Clock::now();
+    if (to_ns(now) < next_timer_ns_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    while (!timers_.empty() && timers_.front().when <= now) {
+        std::pop_heap(timers_.begin(), timers_.end(), std::greater<Timer>{});
+        workers_[index]->deque.push(timers_.back().task);
+        timers_.pop_back();
+    }
+    next_timer_ns_ = timers_.empty() ? INT64_MAX : to_ns(timers_.front().when);
+}
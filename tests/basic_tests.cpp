@@ -4,10 +4,51 @@
 #include "../include/link.hpp"
 #include "../include/telemetry.hpp"
 #include "../include/commands.hpp"
+#include "../include/command_plan.hpp"
+#include "../include/command_schedule.hpp"
+#include "../include/telemetry_recorder.hpp"
+#include "../include/tx_scheduler.hpp"
+#include "../include/multi_ground_station.hpp"
+#include "../include/constellation.hpp"
+#include "../include/chase_lev_deque.hpp"
+#include "../include/work_stealing_pool.hpp"
+#include "../include/coroutine_runtime.hpp"
+#include "../include/satellite.hpp"
+#include "../include/ground_station.hpp"
+#include "../include/sweep.hpp"
+#include "../include/checkpoint.hpp"
+#include "../include/logical_clock.hpp"
+#include "../include/bench_harness.hpp"
+#include "../include/load_bench.hpp"
+#include "../include/hdr_histogram.hpp"
+#include "../include/packet_trace.hpp"
+#include "../include/spsc_ring.hpp"
+#include "../include/async_logger.hpp"
+#include "../include/metrics.hpp"
+#include "../include/sharded_counter.hpp"
+#include "../include/sequence.hpp"
+#include "../include/gf256.hpp"
+#include "../include/fec.hpp"
+#include "../include/viterbi.hpp"
 #include <iostream>
+#include <sstream>
+#include <cmath>
 #include <cassert>
 #include <thread>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 // Simple test framework
 int test_count = 0;
@@ -174,6 +215,337 @@ TEST(test_command_serialization) {
     assert(decoded.d_roll == cmd.d_roll);
 }
 
+// Test time-tagged command serialization
+TEST(test_command_time_tag_roundtrip) {
+    Command cmd;
+    cmd.type = CommandType::ThrustBurn;
+    cmd.burn_seconds = 2.5;
+    cmd.exec_time_ns = 1234567890123LL;
+
+    Command decoded = Command::deserialize(cmd.serialize());
+    assert(decoded.type == CommandType::ThrustBurn);
+    assert(decoded.burn_seconds == 2.5);
+    assert(decoded.is_time_tagged());
+    assert(decoded.exec_time_ns == cmd.exec_time_ns);
+
+    // Untagged commands keep the original format
+    Command plain;
+    plain.type = CommandType::Reboot;
+    assert(plain.serialize() == "REBOOT");
+    assert(!Command::deserialize(plain.serialize()).is_time_tagged());
+}
+
+// Test binary command encoding generated from the registry
+TEST(test_command_binary_encoding) {
+    // Every registered command round-trips, tagged or not
+    for (const CommandDef& def : kCommandRegistry) {
+        for (int64_t tag : {int64_t{0}, int64_t{9876543210}}) {
+            Command cmd;
+            cmd.type = def.type;
+            cmd.exec_time_ns = tag;
+            for (size_t a = 0; a < def.num_args; ++a) {
+                cmd.*def.args[a].field = def.args[a].max / 3.0 - static_cast<double>(a);
+            }
+            const std::string wire = cmd.encode();
+            assert(wire.size() == 1 + (tag ? 8 : 0) + 8 * def.num_args);
+            assert(static_cast<uint8_t>(wire[0]) == (def.opcode | (tag ? Command::kTimeTagFlag : 0)));
+            Command back = Command::decode(wire);
+            assert(back.type == cmd.type && back.exec_time_ns == tag && back.name() == def.name);
+            for (size_t a = 0; a < def.num_args; ++a) {
+                assert(back.*def.args[a].field == cmd.*def.args[a].field);  // Bit-exact
+            }
+            Command text = Command::deserialize(cmd.serialize());
+            assert(text.type == cmd.type && text.exec_time_ns == tag);
+        }
+    }
+
+    // Fixed layout, big-endian like the packet header
+    Command burn;
+    burn.type = CommandType::ThrustBurn;
+    burn.burn_seconds = 2.0;
+    assert(burn.encode() == std::string("\x02\x40\x00\x00\x00\x00\x00\x00\x00", 9));
+    assert(burn.serialize() == "THRUST_BURN|2");
+    Command safe;
+    safe.type = CommandType::EnterSafeMode;
+    assert(safe.encode() == "\x03");
+
+    // Malformed or out-of-range input is rejected by both codecs
+    auto rejects = [](auto decode_fn) {
+        try {
+            decode_fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    const std::string wire = burn.encode();
+    assert(rejects([] { Command::decode(""); }));
+    assert(rejects([] { Command::decode(std::string("\x7f", 1)); }));
+    assert(rejects([&] { Command::decode(wire.substr(0, 5)); }));
+    assert(rejects([&] { Command::decode(wire + '\0'); }));
+    Command wild = burn;
+    wild.burn_seconds = 1e6;
+    assert(rejects([&] { Command::decode(wild.encode()); }));
+    assert(rejects([&] { Command::deserialize(wild.serialize()); }));
+    wild.burn_seconds = std::nan("");
+    assert(rejects([&] { Command::decode(wild.encode()); }));
+    assert(rejects([] { Command::deserialize("ADJUST_ORIENTATION|1|2"); }));
+    assert(rejects([] { Command::deserialize("SELF_DESTRUCT"); }));
+}
+
+// Test stored-command schedule ordering and capacity
+TEST(test_command_schedule_ordering) {
+    const size_t num_cmds = 5000;
+    CommandSchedule schedule(num_cmds);
+
+    // Insert in scrambled time order; ties broken by uplink order
+    for (size_t i = 0; i < num_cmds; ++i) {
+        Command cmd;
+        cmd.type = CommandType::AdjustOrientation;
+        cmd.exec_time_ns = 1000 + static_cast<int64_t>((i * 7919) % 1000);
+        cmd.d_pitch = static_cast<double>(i);
+        assert(schedule.schedule(cmd));
+    }
+    assert(schedule.size() == num_cmds);
+
+    Command overflow;
+    overflow.type = CommandType::Reboot;
+    overflow.exec_time_ns = 1;
+    assert(!schedule.schedule(overflow));
+
+    // Nothing due before the earliest tag
+    assert(!schedule.has_due(999));
+    assert(!schedule.pop_due(999).has_value());
+
+    int64_t last_time = 0;
+    double last_order = -1.0;
+    size_t popped = 0;
+    while (auto cmd = schedule.pop_due(5000)) {
+        assert(cmd->exec_time_ns >= last_time);
+        if (cmd->exec_time_ns == last_time) {
+            assert(cmd->d_pitch > last_order);
+        }
+        last_time = cmd->exec_time_ns;
+        last_order = cmd->d_pitch;
+        popped++;
+    }
+    assert(popped == num_cmds);
+    assert(schedule.empty());
+}
+
+// Test telemetry recorder FIFO order and overwrite-oldest policy
+TEST(test_telemetry_recorder_wraparound) {
+    TelemetryRecorder::Config config;
+    config.capacity = 8;
+    config.record_size = 64;
+    TelemetryRecorder recorder(config);
+
+    assert(recorder.empty());
+    assert(!recorder.store(std::string(recorder.max_record_size() + 1, 'x')));
+    assert(recorder.rejected() == 1 && recorder.empty());
+
+    for (int i = 0; i < 20; ++i) {
+        assert(recorder.store("rec" + std::to_string(i)));
+    }
+    assert(recorder.size() == 8);
+    assert(recorder.overwritten() == 12);
+    assert(recorder.fill_ratio() == 1.0);
+
+    // Oldest surviving records come out first
+    std::string out;
+    for (int i = 12; i < 20; ++i) {
+        assert(recorder.peek(out));
+        assert(out == "rec" + std::to_string(i));
+        recorder.pop();
+    }
+    assert(recorder.empty());
+    assert(!recorder.peek(out));
+
+    // Erase from the middle of a wrapped ring keeps the others in order
+    for (int i = 0; i < 10; ++i) {
+        recorder.store("rec" + std::to_string(i));
+    }
+    recorder.erase(1);  // rec3: rec0 and rec1 were overwritten
+    assert(recorder.size() == 7);
+    for (int i : {2, 4, 5, 6, 7, 8, 9}) {
+        assert(recorder.peek(out) && out == "rec" + std::to_string(i));
+        recorder.pop();
+    }
+}
+
+// Test file-backed recorder persists records across instances
+TEST(test_telemetry_recorder_file_backed) {
+    const std::string path = "test_recorder.bin";
+    std::remove(path.c_str());
+
+    TelemetryRecorder::Config config;
+    config.capacity = 16;
+    config.backing_file = path;
+    {
+        TelemetryRecorder recorder(config);
+        assert(recorder.file_backed());
+        recorder.store("ts=1|temp=50.00");
+        recorder.store("ts=2|temp=51.00");
+    }
+    {
+        TelemetryRecorder recorder(config);
+        assert(recorder.size() == 2);
+        std::string out;
+        assert(recorder.peek(out));
+        assert(out == "ts=1|temp=50.00");
+    }
+
+    // Out-of-range ring indices (head at offset 16, count at 24) are not trusted
+    for (std::streamoff offset : {16, 24}) {
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            uint64_t bad = 1000;
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+        }
+        TelemetryRecorder recorder(config);
+        assert(recorder.empty());
+        assert(recorder.store("ts=3|temp=52.00"));
+    }
+
+    // So is a torn slot: the first slot (after the 40-byte header) now
+    // claims 65535 bytes, far past its 256-byte slot
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(40);
+        file.write("\xFF\xFF", 2);
+    }
+    {
+        TelemetryRecorder recorder(config);
+        assert(recorder.empty() && recorder.rejected() == 1);
+    }
+    std::remove(path.c_str());
+}
+
+static Packet make_test_packet(PacketType type, uint32_t seq, size_t payload_bytes) {
+    Packet pkt;
+    pkt.type = type;
+    pkt.seq = seq;
+    pkt.payload = std::string(payload_bytes, 'p');
+    pkt.payload_size = static_cast<uint32_t>(payload_bytes);
+    pkt.compute_crc();
+    return pkt;
+}
+
+// Test strict-priority service order
+TEST(test_tx_scheduler_strict_priority) {
+    TxScheduler tx(TxScheduler::Config{});
+    auto now = std::chrono::steady_clock::now();
+
+    tx.enqueue(TrafficClass::Playback, make_test_packet(PacketType::TelemetryPkt, 1, 80), now);
+    tx.enqueue(TrafficClass::Housekeeping, make_test_packet(PacketType::TelemetryPkt, 2, 80), now);
+    tx.enqueue(TrafficClass::Event, make_test_packet(PacketType::EventPkt, 3, 20), now);
+    tx.enqueue(TrafficClass::Ack, make_test_packet(PacketType::AckPkt, 4, 0), now);
+    assert(tx.pending() == 4);
+    assert(tx.queued(TrafficClass::Housekeeping, 2));
+
+    const uint32_t expected[] = {4, 3, 2, 1};
+    for (uint32_t seq : expected) {
+        auto pkt = tx.dequeue(now);
+        assert(pkt.has_value());
+        assert(pkt->seq == seq);
+    }
+    assert(!tx.dequeue(now).has_value());
+}
+
+// Test residency statistics cover every packet sent and reset() clears them
+TEST(test_tx_scheduler_residency_stats) {
+    TxScheduler tx(TxScheduler::Config{});
+    auto t0 = std::chrono::steady_clock::now();
+
+    // One slow packet first, then far more fast ones than a bounded sample ring holds
+    tx.enqueue(TrafficClass::Housekeeping, make_test_packet(PacketType::TelemetryPkt, 0, 10), t0);
+    tx.dequeue(t0 + std::chrono::milliseconds(500));
+    for (uint32_t i = 1; i <= 100000; ++i) {
+        auto now = t0 + std::chrono::milliseconds(i < 50000 ? 0 : 20);
+        tx.enqueue(TrafficClass::Housekeeping, make_test_packet(PacketType::TelemetryPkt, i, 10), t0);
+        assert(tx.dequeue(now).has_value());
+    }
+
+    auto hk = tx.stats(TrafficClass::Housekeeping);
+    assert(hk.sent == 100001);
+    assert(hk.p50_ms < 20.5);
+    assert(hk.p99_ms > 19.5 && hk.p99_ms < 20.5);
+    assert(hk.max_ms > 499.0 && hk.max_ms < 501.0);
+
+    tx.enqueue(TrafficClass::Ack, make_test_packet(PacketType::AckPkt, 1, 0), t0);
+    tx.reset();
+    assert(tx.pending() == 0);
+    hk = tx.stats(TrafficClass::Housekeeping);
+    assert(hk.sent == 0 && hk.p99_ms == 0.0 && hk.max_ms == 0.0);
+}
+
+// Test weighted-fair shares when every class is backlogged
+TEST(test_tx_scheduler_weighted_fair_shares) {
+    TxScheduler::Config config;
+    config.policy = TxScheduler::Policy::WeightedFair;
+    config.queue_limit = 10000;
+    TxScheduler tx(config);
+    auto now = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < 2000; ++i) {
+        for (size_t c = 0; c < kNumTrafficClasses; ++c) {
+            tx.enqueue(static_cast<TrafficClass>(c), make_test_packet(PacketType::TelemetryPkt, i, 51), now);
+        }
+    }
+
+    std::array<int, kNumTrafficClasses> served{};
+    for (int i = 0; i < 1500; ++i) {
+        auto pkt = tx.dequeue(now);
+        assert(pkt.has_value());
+    }
+    for (size_t c = 0; c < kNumTrafficClasses; ++c) {
+        served[c] = static_cast<int>(tx.stats(static_cast<TrafficClass>(c)).sent);
+    }
+    // Weights 8:4:2:1 with equal packet sizes
+    assert(served[0] > served[1] && served[1] > served[2] && served[2] > served[3]);
+    double ratio = static_cast<double>(served[0]) / served[3];
+    assert(ratio > 6.0 && ratio < 10.0);
+}
+
+// Test per-class tail latency under a saturated, rate-limited downlink
+TEST(test_tx_scheduler_saturated_tail_latency) {
+    TxScheduler::Config config;
+    config.rate_bytes_per_sec = 2000.0;  // 16 kbit/s downlink
+    config.burst_bytes = 256;
+    TxScheduler tx(config);
+
+    // Offered load ~150% of capacity: housekeeping 30 pkt/s of 100 bytes,
+    // plus an event every 250 ms and an ACK every 100 ms
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t seq = 0;
+    for (int ms = 0; ms < 20000; ++ms) {
+        auto now = t0 + std::chrono::milliseconds(ms);
+        if (ms % 33 == 0) {
+            tx.enqueue(TrafficClass::Housekeeping, make_test_packet(PacketType::TelemetryPkt, seq++, 87), now);
+        }
+        if (ms % 250 == 7) {
+            tx.enqueue(TrafficClass::Event, make_test_packet(PacketType::EventPkt, seq++, 20), now);
+        }
+        if (ms % 100 == 3) {
+            tx.enqueue(TrafficClass::Ack, make_test_packet(PacketType::AckPkt, seq++, 0), now);
+        }
+        while (tx.dequeue(now)) {
+        }
+    }
+
+    auto ack = tx.stats(TrafficClass::Ack);
+    auto event = tx.stats(TrafficClass::Event);
+    auto hk = tx.stats(TrafficClass::Housekeeping);
+    std::cout << "  p99 queue latency: ack=" << ack.p99_ms << "ms event=" << event.p99_ms
+              << "ms housekeeping=" << hk.p99_ms << "ms (hk dropped " << hk.dropped << ")" << std::endl;
+
+    // Priority traffic waits at most about one packet time; bulk absorbs the backlog
+    assert(ack.p99_ms < 100.0);
+    assert(event.p99_ms < 100.0);
+    assert(hk.p99_ms > 10.0 * event.p99_ms);
+}
+
 // Test Link packet loss probability
 TEST(test_link_loss_probability) {
     Link::Config config;
@@ -256,6 +628,2344 @@ TEST(test_end_to_end_smoke) {
     std::cout << "  End-to-end smoke test: ACK successfully received" << std::endl;
 }
 
+// Test commands uplinked while the satellite waits for a telemetry ACK are
+// executed and ACKed, not swallowed by the wait
+TEST(test_satellite_commands_during_ack_wait) {
+    Link::Config link_config;
+    link_config.latency_ms = 2;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 50.0;
+    sat_config.ack_timeout_ms = 200;  // No ground station: nearly always waiting
+    sat_config.max_scheduled_commands = 1;
+    Link link(link_config);
+    Satellite sat(link, sat_config);
+    sat.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Seq 4 and 5 are time-tagged an hour out: one fills the schedule, the
+    // other is rejected and must not count as received
+    const int64_t later_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (std::chrono::steady_clock::now() + std::chrono::hours(1)).time_since_epoch()).count();
+    for (uint32_t seq = 1; seq <= 5; ++seq) {
+        Command cmd;
+        cmd.type = CommandType::AdjustOrientation;
+        cmd.d_pitch = 1.0;
+        cmd.exec_time_ns = seq > 3 ? later_ns : 0;
+        Packet pkt;
+        pkt.type = PacketType::CommandPkt;
+        pkt.seq = seq;
+        pkt.payload = cmd.encode();
+        pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+        pkt.compute_crc();
+        link.send_gs_to_sat(pkt);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sat.stop();
+
+    assert(sat.get_commands_received() == 4 && sat.get_commands_scheduled() == 1);
+    size_t acks = 0, naks = 0;
+    Packet pkt;
+    while (link.recv_sat_to_gs(pkt, std::chrono::milliseconds(0))) {
+        acks += pkt.type == PacketType::AckPkt;
+        naks += pkt.type == PacketType::NakPkt && pkt.seq == 5;
+    }
+    assert(acks == 4 && naks == 1);
+
+    // A reboot takes the satellite down for a while but never blocks the
+    // runtime worker it shares with other agents: its ACK goes out at once
+    CoroutineRuntime::Config rt_config;
+    rt_config.num_workers = 1;
+    CoroutineRuntime rt(rt_config);
+    Satellite rebooted(link, sat_config);
+    rebooted.start(rt);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Command reboot;
+    reboot.type = CommandType::Reboot;
+    Packet cmd_pkt;
+    cmd_pkt.type = PacketType::CommandPkt;
+    cmd_pkt.seq = 10;
+    cmd_pkt.payload = reboot.encode();
+    cmd_pkt.payload_size = static_cast<uint32_t>(cmd_pkt.payload.size());
+    cmd_pkt.compute_crc();
+    const auto sent_at = std::chrono::steady_clock::now();
+    link.send_gs_to_sat(cmd_pkt);
+    bool acked = false;
+    while (!acked && link.recv_sat_to_gs(pkt, std::chrono::milliseconds(200))) {
+        acked = pkt.type == PacketType::AckPkt && pkt.seq == 10;
+    }
+    const auto ack_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - sent_at).count();
+    rebooted.stop();
+    assert(acked && rebooted.get_commands_received() == 1);
+    assert(ack_ms < 80);  // The reboot itself lasts 100 ms
+}
+
+static Packet make_telemetry_packet(uint32_t seq, double battery_pct) {
+    Telemetry t;
+    t.ts = std::chrono::steady_clock::now();
+    t.temperature_c = 50.0;
+    t.battery_pct = battery_pct;
+    t.orbit_altitude_km = 400.0;
+    t.pitch_deg = 0.0;
+    t.yaw_deg = 0.0;
+    t.roll_deg = 0.0;
+
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.seq = seq;
+    pkt.payload = t.to_json();
+    pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+    pkt.compute_crc();
+    return pkt;
+}
+
+// Test multi-satellite ground station keeps per-session state apart
+TEST(test_multi_ground_station_sessions) {
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+
+    const uint32_t num_sats = 8;
+    std::vector<std::unique_ptr<Link>> links;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 3;
+    gs_config.ack_timeout_ms = 50;
+    MultiGroundStation gs(gs_config);
+    for (uint32_t id = 0; id < num_sats; ++id) {
+        links.push_back(std::make_unique<Link>(link_config));
+        gs.add_session(id, *links.back());
+    }
+    assert(gs.session_count() == num_sats);
+    gs.start();
+
+    // Every satellite uses the same sequence numbers; sessions must not collide
+    for (uint32_t id = 0; id < num_sats; ++id) {
+        links[id]->send_sat_to_gs(make_telemetry_packet(0, 90.0));
+        links[id]->send_sat_to_gs(make_telemetry_packet(1, 89.0));
+        links[id]->send_sat_to_gs(make_telemetry_packet(1, 89.0));  // Duplicate
+    }
+
+    Command cmd;
+    cmd.type = CommandType::EnterSafeMode;
+    assert(gs.send_command(5, cmd));
+    assert(!gs.send_command(99, cmd));
+
+    // Satellite 5 answers its command; everyone collects ACKs
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    std::vector<int> acks(num_sats, 0);
+    bool command_seen = false;
+    while (std::chrono::steady_clock::now() < deadline &&
+           (gs.get_commands_sent() < 1 || gs.get_telemetry_received() < 2 * num_sats)) {
+        for (uint32_t id = 0; id < num_sats; ++id) {
+            Packet pkt;
+            while (links[id]->recv_gs_to_sat(pkt, std::chrono::milliseconds(0))) {
+                if (pkt.type == PacketType::AckPkt) {
+                    acks[id]++;
+                } else if (pkt.type == PacketType::CommandPkt) {
+                    assert(id == 5);
+                    assert(Command::decode(pkt.payload).type == CommandType::EnterSafeMode);
+                    command_seen = true;
+                    Packet ack;
+                    ack.type = PacketType::AckPkt;
+                    ack.seq = pkt.seq;
+                    ack.payload = "";
+                    ack.payload_size = 0;
+                    ack.compute_crc();
+                    links[id]->send_sat_to_gs(ack);
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gs.stop();
+
+    assert(command_seen);
+    assert(gs.get_commands_sent() == 1);
+    assert(gs.get_telemetry_received() == 2 * num_sats);
+    for (uint32_t id = 0; id < num_sats; ++id) {
+        auto stats = gs.get_session_stats(id);
+        assert(stats.has_value());
+        assert(stats->telemetry_received == 2);
+        assert(stats->duplicates == 1);
+    }
+}
+
+// Test serial-number ordering and the duplicate window across the 2^32 wrap
+TEST(test_sequence_window) {
+    static_assert(std::is_trivially_copyable_v<ReplayWindow<128>>);
+    static_assert(sizeof(ReplayWindow<64>) == 16 && sizeof(ReplayWindow<128>) == 24);
+
+    const SeqNum last(0xFFFFFFFFu);
+    assert(last + 1 == SeqNum(0));
+    assert(last < SeqNum(0) && SeqNum(0) > last);
+    assert(SeqNum(5) - last == 6 && last - SeqNum(5) == -6);
+    assert(SeqNum(0x7FFFFFFFu) > SeqNum(0) && SeqNum(0x80000001u) < SeqNum(0));
+    SeqNum s = last;
+    assert((++s).value == 0);
+
+    using Verdict = ReplayWindow<64>::Verdict;
+    ReplayWindow<64> w;
+    assert(w.empty() && w.check(12345) == Verdict::New);
+    w.accept(0xFFFFFFFEu);
+    assert(w.check(0xFFFFFFFEu) == Verdict::Duplicate);
+    // Newer across the wrap, then a late packet from before it
+    w.accept(1);
+    assert(w.newest() == SeqNum(1));
+    assert(w.check(0xFFFFFFFFu) == Verdict::New && w.check(0) == Verdict::New);
+    w.accept(0xFFFFFFFFu);
+    assert(w.check(0xFFFFFFFFu) == Verdict::Duplicate && w.check(0) == Verdict::New);
+    assert(w.newest() == SeqNum(1));  // Late packets do not move the window
+    // Edge of the window: 63 back is tracked, 64 back is stale
+    w.accept(63);
+    assert(w.check(0) == Verdict::New && w.check(1) == Verdict::Duplicate);
+    assert(w.check(0xFFFFFFFFu) == Verdict::Stale);
+    w.accept(0xFFFFFFFFu);  // Ignored
+    assert(w.newest() == SeqNum(63));
+    // A jump past the whole window forgets everything behind it
+    w.accept(1000);
+    assert(w.check(999) == Verdict::New && w.check(936) == Verdict::Stale);
+
+    // 128 bits: seen bits carry across the word boundary as the window slides
+    ReplayWindow<128> wide;
+    for (uint32_t seq = 0xFFFFFFC0u; seq != 0x10u; ++seq) {
+        if (seq % 3 == 0) wide.accept(seq);
+    }
+    wide.accept(0x50);
+    for (uint32_t back = 0; back < 128; ++back) {
+        const uint32_t seq = 0x50 - back;
+        const bool seen = back == 0 || (SeqNum(seq) < SeqNum(0x10) && seq % 3 == 0);
+        assert(wide.check(seq) == (seen ? ReplayWindow<128>::Verdict::Duplicate : ReplayWindow<128>::Verdict::New));
+    }
+    assert(wide.check(0x50 - 128) == ReplayWindow<128>::Verdict::Stale);
+
+    // High rate through the wrap: 1M packets, reordered within 32 and with
+    // one in eight sent twice, are each accepted exactly once
+    std::mt19937 rng(7);
+    const uint32_t start = 0xFFFFFFFFu - 500000;
+    const uint32_t count = 1000000;
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i) order[i] = i;
+    for (uint32_t i = 0; i + 32 <= count; i += 32) {
+        std::shuffle(order.begin() + i, order.begin() + i + 32, rng);
+    }
+    ReplayWindow<64> rx;
+    std::vector<uint8_t> accepted(count, 0);
+    uint64_t duplicates = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t seq = start + order[i];
+        const int copies = (rng() & 7) == 0 ? 2 : 1;
+        for (int copy = 0; copy < copies; ++copy) {
+            if (rx.check(seq) == Verdict::New) {
+                rx.accept(seq);
+                accepted[order[i]]++;
+            } else {
+                duplicates++;
+            }
+        }
+    }
+    for (uint8_t a : accepted) assert(a == 1);
+    assert(duplicates > count / 10);
+    assert(rx.newest() == SeqNum(start + count - 1));
+}
+
+// Test the ground station keeps late telemetry across the wrap
+TEST(test_multi_ground_station_seq_wraparound) {
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+
+    Link link(link_config);
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 1;
+    MultiGroundStation gs(gs_config);
+    gs.add_session(0, link);
+    gs.start();
+
+    // Reordered across the wrap, then two repeats
+    for (uint32_t seq : {0xFFFFFFFEu, 1u, 0xFFFFFFFFu, 0u, 2u, 0xFFFFFFFFu, 1u}) {
+        link.send_sat_to_gs(make_telemetry_packet(seq, 80.0));
+    }
+
+    std::vector<uint32_t> acked;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline && acked.size() < 7) {
+        Packet pkt;
+        while (link.recv_gs_to_sat(pkt, std::chrono::milliseconds(0))) {
+            if (pkt.type == PacketType::AckPkt) acked.push_back(pkt.seq);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gs.stop();
+
+    assert(acked.size() == 7);  // Duplicates are still ACKed
+    auto stats = gs.get_session_stats(0);
+    assert(stats.has_value());
+    assert(stats->telemetry_received == 5);
+    assert(stats->duplicates == 2);
+}
+
+// Test GF(256) arithmetic and that every region kernel matches the scalar one
+TEST(test_gf256_region_kernels) {
+    assert(gf256::mul(0x80, 2) == 0x1D);  // x^8 reduces by 0x11D
+    assert(gf256::exp(255) == 1 && gf256::exp(8) == 0x1D);
+    for (unsigned a = 1; a < 256; ++a) {
+        const uint8_t x = static_cast<uint8_t>(a);
+        assert(gf256::mul(x, gf256::inv(x)) == 1);
+        assert(gf256::div(gf256::mul(x, 0x53), 0x53) == x);
+        assert(gf256::exp(gf256::log(x)) == x);
+    }
+
+    std::mt19937 rng(11);
+    std::vector<uint8_t> src(1000);
+    for (auto& b : src) b = static_cast<uint8_t>(rng());
+    const gf256::Kernel kernels[] = {gf256::Kernel::Scalar, gf256::Kernel::Ssse3, gf256::Kernel::Avx2};
+    // Odd lengths exercise every kernel's scalar tail
+    for (size_t n : {0u, 1u, 15u, 16u, 31u, 33u, 1000u}) {
+        for (unsigned c : {0u, 1u, 2u, 0x8Eu, 0xFFu}) {
+            std::vector<uint8_t> expect(n), expect_acc(n, 0x5A);
+            for (size_t i = 0; i < n; ++i) {
+                expect[i] = gf256::mul(static_cast<uint8_t>(c), src[i]);
+                expect_acc[i] ^= expect[i];
+            }
+            for (auto kernel : kernels) {
+                std::vector<uint8_t> out(n), acc(n, 0x5A);
+                gf256::mul_region(out.data(), src.data(), static_cast<uint8_t>(c), n, kernel);
+                gf256::mul_add_region(acc.data(), src.data(), static_cast<uint8_t>(c), n, kernel);
+                assert(out == expect && acc == expect_acc);
+            }
+        }
+    }
+    assert(gf256::supported(gf256::Kernel::Scalar) && gf256::supported(gf256::best_kernel()));
+    std::cout << "  best kernel: " << gf256::kernel_name(gf256::best_kernel()) << std::endl;
+}
+
+// Test RS(255,223) corrects up to 16 byte errors, including shortened blocks
+TEST(test_reed_solomon_codec) {
+    std::mt19937 rng(3);
+    for (size_t k : {fec::kRsData, size_t{1}, size_t{100}}) {
+        const size_t n = k + fec::kRsParity;
+        std::vector<uint8_t> block(n);
+        for (size_t i = 0; i < k; ++i) block[i] = static_cast<uint8_t>(rng());
+        fec::rs_encode(block.data(), k, block.data() + k);
+        const std::vector<uint8_t> clean = block;
+
+        auto corrupt = [&](std::vector<uint8_t>& b, size_t errors) {
+            std::vector<size_t> positions(n);
+            for (size_t i = 0; i < n; ++i) positions[i] = i;
+            std::shuffle(positions.begin(), positions.end(), rng);
+            for (size_t e = 0; e < errors; ++e) {
+                b[positions[e]] ^= static_cast<uint8_t>(1 + rng() % 255);
+            }
+        };
+
+        assert(fec::rs_decode(block.data(), n) == 0u);
+        for (size_t errors : {1u, 5u, 16u}) {
+            std::vector<uint8_t> damaged = clean;
+            corrupt(damaged, errors);
+            auto fixed = fec::rs_decode(damaged.data(), n);
+            assert(fixed && *fixed == errors);
+            assert(damaged == clean);
+        }
+
+        // Beyond the code's strength: rejected and left unchanged, or (rarely,
+        // for a nearby codeword) "corrected" into a valid but different block
+        for (int trial = 0; trial < 20; ++trial) {
+            std::vector<uint8_t> damaged = clean;
+            corrupt(damaged, std::min<size_t>(n, 17 + trial));
+            const std::vector<uint8_t> before = damaged;
+            auto fixed = fec::rs_decode(damaged.data(), n);
+            if (!fixed) {
+                assert(damaged == before);
+            } else {
+                assert(damaged != clean && fec::rs_decode(damaged.data(), n) == 0u);
+            }
+        }
+    }
+
+    // Frame codec: multi-block frames round trip through byte errors
+    std::string frame(600, '\0');
+    for (auto& c : frame) c = static_cast<char>(rng());
+    std::string coded = fec::encode_frame(frame);
+    assert(coded.size() == frame.size() + 3 * fec::kRsParity);
+    assert(fec::decode_frame(coded) == frame);
+    for (size_t i = 0; i < coded.size(); i += 37) coded[i] ^= 0x41;  // ~7 errors per block
+    size_t corrected = 0;
+    assert(fec::decode_frame(coded, &corrected) == frame);
+    assert(corrected == (coded.size() + 36) / 37);
+    assert(fec::decode_frame(fec::encode_frame("")).empty());
+
+    bool threw = false;
+    try { fec::decode_frame(std::string(fec::kRsParity, 'x')); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    for (size_t i = 1; i < fec::kRsBlock; i += 5) coded[i] ^= static_cast<char>(1 + rng() % 255);  // 51 errors in block 0
+    threw = false;
+    try { fec::decode_frame(coded); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+// Test the erasure code rebuilds any parity_shards lost shards
+TEST(test_erasure_code_reconstruct) {
+    const size_t k = 6, m = 3, len = 77;
+    fec::ErasureCode code(k, m);
+    std::mt19937 rng(5);
+    std::vector<std::vector<uint8_t>> shards(k + m, std::vector<uint8_t>(len));
+    for (size_t i = 0; i < k; ++i) {
+        for (auto& b : shards[i]) b = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t*> ptrs(k + m);
+    for (size_t i = 0; i < k + m; ++i) ptrs[i] = shards[i].data();
+    code.encode(ptrs.data(), ptrs.data() + k, len);
+    const auto original = shards;
+
+    // Every way of losing exactly m shards
+    for (unsigned mask = 0; mask < (1u << (k + m)); ++mask) {
+        if (__builtin_popcount(mask) != static_cast<int>(m)) continue;
+        auto work = original;
+        std::vector<uint8_t*> wp(k + m);
+        bool present[k + m];
+        for (size_t i = 0; i < k + m; ++i) {
+            wp[i] = work[i].data();
+            present[i] = !(mask & (1u << i));
+            if (!present[i]) std::fill(work[i].begin(), work[i].end(), 0xEE);
+        }
+        assert(code.reconstruct(wp.data(), present, len));
+        for (size_t i = 0; i < k; ++i) assert(work[i] == original[i]);
+    }
+
+    // Too few shards: nothing changes
+    auto work = original;
+    std::vector<uint8_t*> wp(k + m);
+    bool present[k + m];
+    for (size_t i = 0; i < k + m; ++i) {
+        wp[i] = work[i].data();
+        present[i] = i > m;  // m + 1 lost
+    }
+    assert(!code.reconstruct(wp.data(), present, len));
+    assert(work == original);
+
+    bool threw = false;
+    try { fec::ErasureCode bad(200, 57); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+// Test the K=7 convolutional code and that every Viterbi kernel decodes alike
+TEST(test_viterbi_decoder) {
+    static_assert(viterbi::encoded_symbols(1) == 28);
+    // Impulse response: a single 1 bit emits the generator taps, newest first
+    const uint8_t impulse[1] = {0x80};
+    const std::vector<uint8_t> coded = viterbi::encode(impulse, 1);
+    assert(coded.size() == viterbi::encoded_symbols(1));
+    for (unsigned t = 0; t < viterbi::kConstraint; ++t) {
+        const unsigned shift = viterbi::kConstraint - 1 - t;
+        assert(coded[2 * t] == (((viterbi::kPolyA >> shift) & 1) ? 255 : 0));
+        assert(coded[2 * t + 1] == (((viterbi::kPolyB >> shift) & 1) ? 255 : 0));
+    }
+    for (size_t i = 2 * viterbi::kConstraint; i < coded.size(); ++i) assert(coded[i] == 0);
+
+    const viterbi::Kernel kernels[] = {viterbi::Kernel::Scalar, viterbi::Kernel::Sse2, viterbi::Kernel::Avx2};
+    std::mt19937 rng(9);
+    std::vector<uint8_t> data(300);
+    for (auto& b : data) b = static_cast<uint8_t>(rng());
+    const std::vector<uint8_t> clean = viterbi::encode(data.data(), data.size());
+
+    auto decode_all = [&](const std::vector<uint8_t>& symbols) {
+        std::vector<uint8_t> expect(data.size());
+        viterbi::decode(symbols.data(), data.size(), expect.data(), viterbi::Kernel::Scalar);
+        for (auto kernel : kernels) {
+            std::vector<uint8_t> out(data.size(), 0xAA);
+            viterbi::decode(symbols.data(), data.size(), out.data(), kernel);
+            assert(out == expect);
+        }
+        return expect;
+    };
+
+    // Noiseless, and hard-decision symbols with scattered flips
+    assert(decode_all(clean) == data);
+    std::vector<uint8_t> flipped = clean;
+    for (size_t i = 5; i < flipped.size(); i += 23) flipped[i] ^= 0xFF;
+    assert(decode_all(flipped) == data);
+
+    // Erasures carry no information; a punctured third of the symbols is
+    // still recoverable at rate 3/4
+    std::vector<uint8_t> erased = clean;
+    for (size_t i = 2; i < erased.size(); i += 3) erased[i] = 128;
+    assert(decode_all(erased) == data);
+
+    // Soft symbols over Gaussian noise at Eb/N0 = 5 dB: raw symbol errors
+    // around 4%, essentially none after decoding
+    std::normal_distribution<double> noise(0.0, 0.56);
+    std::vector<uint8_t> soft(clean.size());
+    size_t raw_errors = 0;
+    for (size_t i = 0; i < clean.size(); ++i) {
+        const double x = (clean[i] ? 1.0 : -1.0) + noise(rng);
+        raw_errors += (x > 0) != (clean[i] != 0);
+        soft[i] = static_cast<uint8_t>(std::clamp(std::lround(127.5 + x * 64.0), 0L, 255L));
+    }
+    const std::vector<uint8_t> decoded = decode_all(soft);
+    size_t bit_errors = 0;
+    for (size_t i = 0; i < data.size(); ++i) bit_errors += __builtin_popcount(decoded[i] ^ data[i]);
+    assert(raw_errors > clean.size() / 40);
+    assert(bit_errors <= 8);
+
+    // Frames long enough to renormalize the path metrics many times
+    std::vector<uint8_t> longer(5000);
+    for (auto& b : longer) b = static_cast<uint8_t>(rng());
+    std::vector<uint8_t> long_coded = viterbi::encode(longer.data(), longer.size());
+    for (size_t i = 0; i < long_coded.size(); i += 17) long_coded[i] = 255 - long_coded[i] / 2;
+    std::vector<uint8_t> out(longer.size());
+    viterbi::decode(long_coded.data(), longer.size(), out.data());
+    assert(out == longer);
+
+    std::vector<uint8_t> none = viterbi::encode(nullptr, 0);
+    assert(none.size() == viterbi::encoded_symbols(0));
+    viterbi::decode(none.data(), 0, nullptr);
+    std::cout << "  best kernel: " << viterbi::kernel_name(viterbi::best_kernel()) << ", " << raw_errors
+              << " raw symbol errors -> " << bit_errors << " bit errors" << std::endl;
+}
+
+// Test parity packets rebuild lost group members whatever the arrival order
+TEST(test_packet_recovery) {
+    std::vector<Packet> group;
+    for (uint32_t i = 0; i < 5; ++i) {
+        Packet pkt;
+        pkt.type = PacketType::TelemetryPkt;
+        pkt.seq = 0xFFFFFFFDu + i;  // Spans the wrap
+        pkt.payload = "ts=" + std::to_string(i) + "|temp=" + std::string(i * 7, '9');
+        pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+        pkt.compute_crc();
+        group.push_back(pkt);
+    }
+    std::vector<Packet> parity = fec::make_parity_packets(group, 2);
+    assert(parity.size() == 2);
+    for (const auto& p : parity) {
+        assert(p.type == PacketType::ParityPkt && p.verify_crc() && p.seq == group.front().seq);
+        assert(Packet::from_bytes(p.to_bytes()).payload == p.payload);
+    }
+    const fec::ParityShard shard = fec::ParityShard::decode(parity[1].payload);
+    assert(shard.seqs.size() == 5 && shard.parity_count == 2 && shard.index == 1);
+    assert(fec::ParityShard::decode(shard.encode()).shard == shard.shard);
+    bool threw = false;
+    try { fec::ParityShard::decode(parity[0].payload.substr(0, 10)); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    auto same = [](const Packet& a, const Packet& b) {
+        return a.type == b.type && a.seq == b.seq && a.payload == b.payload && a.crc16 == b.crc16;
+    };
+
+    // Lose members 1 and 3; deliver the rest with parity first, in the
+    // middle and last
+    const std::vector<std::vector<int>> orders = {
+        {-1, -2, 0, 2, 4}, {0, -2, 2, -1, 4}, {4, 2, 0, -1, -2}};
+    for (const auto& order : orders) {
+        fec::PacketRecovery recovery;
+        std::vector<Packet> rebuilt;
+        for (int idx : order) {
+            auto out = recovery.add(idx < 0 ? parity[-idx - 1] : group[idx]);
+            rebuilt.insert(rebuilt.end(), out.begin(), out.end());
+        }
+        assert(rebuilt.size() == 2 && recovery.rebuilt() == 2);
+        std::sort(rebuilt.begin(), rebuilt.end(), [](const Packet& a, const Packet& b) {
+            return SeqNum(a.seq) < SeqNum(b.seq);
+        });
+        assert(same(rebuilt[0], group[1]) && same(rebuilt[1], group[3]));
+        assert(rebuilt[0].verify_crc());
+        // A late original of a rebuilt member brings nothing new
+        assert(recovery.add(group[1]).empty());
+    }
+
+    // Three losses, two parity: nothing can be rebuilt
+    fec::PacketRecovery recovery;
+    for (int idx : {-1, 0, -2, 4}) {
+        assert(recovery.add(idx < 0 ? parity[-idx - 1] : group[idx]).empty());
+    }
+    assert(recovery.rebuilt() == 0);
+}
+
+// Test playback groups with parity through a lossy link end to end
+TEST(test_fec_playback_end_to_end) {
+    Link::Config link_config;
+    link_config.latency_ms = 2;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.25;
+    link_config.deferred_delivery = true;
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 100.0;
+    sat_config.ack_timeout_ms = 20;
+    sat_config.max_retries = 1;
+    sat_config.fec_group = 4;
+    sat_config.fec_parity = 2;
+    GroundStation::Config gs_config;
+    gs_config.ack_timeout_ms = 20;
+    gs_config.log_file = "";
+    gs_config.fec = true;
+
+    Link link(link_config);
+    Satellite sat(link, sat_config);
+    GroundStation gs(link, gs_config);
+    sat.start();
+    gs.start();
+    for (int i = 0; i < 60 && (sat.get_parity_sent() < 40 || gs.get_packets_recovered() == 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    sat.stop();
+    gs.stop();
+
+    assert(sat.get_records_played_back() > 0);
+    assert(sat.get_parity_sent() > 0);
+    assert(gs.get_packets_recovered() > 0);
+    std::cout << "  " << sat.get_records_played_back() << " played back, " << sat.get_parity_sent()
+              << " parity sent, " << gs.get_packets_recovered() << " rebuilt" << std::endl;
+}
+
+// Test recorder playback keeps a window in flight instead of one packet per round trip
+TEST(test_playback_send_window) {
+    const std::string path = "test_playback_window.bin";
+    const size_t records = 96;
+    std::remove(path.c_str());
+    {
+        TelemetryRecorder recorder(TelemetryRecorder::Config{4096, 256, path});
+        for (size_t i = 0; i < records; ++i) {
+            recorder.store("ts=" + std::to_string(i) + "|temp=50.00|batt=90.00|alt=400.00");
+        }
+    }
+
+    Link::Config link_config;
+    link_config.latency_ms = 10;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 50.0;
+    sat_config.recorder_file = path;
+    sat_config.playback_window = 8;
+    GroundStation::Config gs_config;
+    gs_config.log_file = "";
+
+    Link link(link_config);
+    Satellite sat(link, sat_config);
+    GroundStation gs(link, gs_config);
+    auto start = std::chrono::steady_clock::now();
+    sat.start();
+    gs.start();
+    while (sat.get_records_played_back() < records &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(3)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sat.stop();
+    gs.stop();
+    std::remove(path.c_str());
+
+    // Stop-and-wait needs a 20 ms round trip per record: at least 1.9 s here
+    assert(sat.get_records_played_back() == records);
+    assert(elapsed < std::chrono::milliseconds(1500));
+    std::cout << "  " << records << " records played back in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms" << std::endl;
+}
+
+// Test a group member that exhausts its retries does not get the ACKed
+// members after it played back again
+TEST(test_playback_failed_member_not_replayed) {
+    const std::string path = "test_playback_failed.bin";
+    const size_t records = 8;
+    std::remove(path.c_str());
+    {
+        TelemetryRecorder recorder(TelemetryRecorder::Config{4096, 256, path});
+        for (size_t i = 0; i < records; ++i) {
+            recorder.store("rec=" + std::to_string(i));
+        }
+    }
+
+    Link::Config link_config;
+    link_config.latency_ms = 1;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 50.0;
+    sat_config.ack_timeout_ms = 20;
+    sat_config.max_retries = 1;
+    sat_config.recorder_file = path;
+    sat_config.fec_group = 4;
+    sat_config.fec_parity = 1;
+
+    // Ground side by hand: every packet is ACKed except the first
+    // transmission of rec=1 (and its retries), so the first group fails
+    // on its second member after the rest were ACKed
+    Link link(link_config);
+    Satellite sat(link, sat_config);
+    sat.start();
+    std::map<std::string, std::set<uint32_t>> acked_seqs;
+    std::optional<uint32_t> refused;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (acked_seqs.size() < records && std::chrono::steady_clock::now() < deadline) {
+        Packet pkt;
+        if (!link.recv_sat_to_gs(pkt, std::chrono::milliseconds(5)) || pkt.type == PacketType::ParityPkt) {
+            continue;
+        }
+        if (pkt.payload == "rec=1" && (!refused || *refused == pkt.seq)) {
+            refused = pkt.seq;
+            continue;
+        }
+        if (pkt.payload.rfind("rec=", 0) == 0) {
+            acked_seqs[pkt.payload].insert(pkt.seq);
+        }
+        Packet ack;
+        ack.type = PacketType::AckPkt;
+        ack.seq = pkt.seq;
+        ack.payload_size = 0;
+        ack.compute_crc();
+        link.send_gs_to_sat(ack);
+    }
+    sat.stop();
+    std::remove(path.c_str());
+
+    assert(refused && acked_seqs.size() == records);
+    for (const auto& [payload, seqs] : acked_seqs) {
+        assert(seqs.size() == 1);  // Delivered under one sequence number: no duplicate sample
+    }
+    assert(sat.get_records_played_back() == records);
+}
+
+// Test telemetry arriving while a threaded ground station waits for a
+// command ACK is ingested instead of dropped
+TEST(test_ground_station_ingests_while_waiting) {
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    GroundStation::Config gs_config;
+    gs_config.ack_timeout_ms = 200;
+    gs_config.log_file = "";
+
+    Link link(link_config);
+    GroundStation gs(link, gs_config);
+    gs.start();
+    Command cmd;
+    cmd.type = CommandType::ThrustBurn;
+    cmd.burn_seconds = 1.0;
+    gs.send_batch({cmd});
+
+    // Play the satellite: telemetry first, then the ACK for the batch
+    Packet batch;
+    assert(link.recv_gs_to_sat(batch, std::chrono::milliseconds(1000)));
+    assert(batch.type == PacketType::CommandBatchPkt);
+    Telemetry t;
+    Packet telem;
+    telem.type = PacketType::TelemetryPkt;
+    telem.seq = 0;
+    telem.payload = t.to_json();
+    telem.payload_size = static_cast<uint32_t>(telem.payload.size());
+    telem.compute_crc();
+    link.send_sat_to_gs(telem);
+    Packet ack;
+    ack.type = PacketType::AckPkt;
+    ack.seq = batch.seq;
+    ack.compute_crc();
+    link.send_sat_to_gs(ack);
+
+    for (int i = 0; i < 100 && gs.get_commands_sent() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    gs.stop();
+
+    assert(gs.get_commands_sent() == 1);
+    assert(gs.get_retries() == 0);
+    assert(gs.get_telemetry_received() == 1);
+}
+
+// Test constellation SoA kernels are seed-deterministic and emit staggered telemetry
+TEST(test_constellation_state_kernels) {
+    ConstellationEngine::Config config;
+    config.num_satellites = 1000;
+    config.tick_hz = 10.0;
+    config.telemetry_rate_hz = 1.0;
+    config.seed = 7;
+
+    ConstellationEngine a(config, {});
+    ConstellationEngine b(config, {});
+    for (int t = 0; t < 20; ++t) {
+        a.step();
+        b.step();
+    }
+
+    // 2 s at 1 Hz: every satellite reported exactly twice
+    assert(a.get_telemetry_sent() == 2000);
+    assert(a.get_ticks() == 20);
+
+    bool diverged = false;
+    for (size_t i = 0; i < config.num_satellites; ++i) {
+        assert(a.temperature_c(i) == b.temperature_c(i));
+        assert(a.battery_pct(i) == b.battery_pct(i));
+        assert(a.battery_pct(i) < 90.0);
+        assert(a.orbit_altitude_km(i) < 400.0);
+        diverged |= a.temperature_c(i) != a.temperature_c(0);
+    }
+    assert(diverged);  // Satellites draw independent noise
+}
+
+// Test constellation telemetry flows to the multi-satellite ground station and is ACKed
+TEST(test_constellation_end_to_end) {
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+
+    const size_t n = 200;
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 2;
+    MultiGroundStation gs(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+        gs.add_session(static_cast<uint32_t>(i), *links.back());
+    }
+
+    ConstellationEngine::Config config;
+    config.num_satellites = n;
+    config.num_workers = 2;
+    config.tick_hz = 50.0;
+    config.telemetry_rate_hz = 10.0;
+    ConstellationEngine engine(config, link_ptrs);
+
+    Command cmd;
+    cmd.type = CommandType::EnterSafeMode;
+    gs.send_command(3, cmd);
+
+    gs.start();
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    engine.stop();
+    gs.stop();
+
+    std::cout << "  " << engine.get_ticks() << " ticks, sent " << engine.get_telemetry_sent()
+              << ", GS received " << gs.get_telemetry_received()
+              << ", ACKed " << engine.get_telemetry_acked() << std::endl;
+    assert(engine.get_telemetry_sent() >= n);
+    assert(gs.get_telemetry_received() > 0);
+    assert(engine.get_telemetry_acked() > 0);
+    assert(engine.get_commands_received() == 1);
+    assert(engine.safe_mode(3));
+    assert(!engine.safe_mode(4));
+    assert(engine.get_safe_mode_entries() == 0);  // Commanded, not an anomaly
+}
+
+// Test command batches: one packet and one ACK, executed all or none
+TEST(test_command_batch_atomic) {
+    auto adjust = [](double d) {
+        Command cmd;
+        cmd.type = CommandType::AdjustOrientation;
+        cmd.d_pitch = d;
+        return cmd;
+    };
+    Command safe, burn, reboot;
+    safe.type = CommandType::EnterSafeMode;
+    burn.type = CommandType::ThrustBurn;
+    burn.burn_seconds = 1.0;
+    reboot.type = CommandType::Reboot;
+
+    // Codec round trip; malformed batches are rejected whole
+    CommandBatch plan;
+    for (int k = 0; k < 50; ++k) plan.commands.push_back(adjust(0.1 * k));
+    const std::string wire = plan.encode();
+    assert(wire.size() == 2 + 50 * 26);
+    CommandBatch back = CommandBatch::decode(wire);
+    assert(back.commands.size() == 50 && back.commands[49].d_pitch == plan.commands[49].d_pitch);
+    auto rejects = [](auto fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    assert(rejects([&] { CommandBatch::decode(wire.substr(0, wire.size() - 1)); }));
+    assert(rejects([&] { CommandBatch::decode(wire + '\x01'); }));
+    assert(rejects([] { CommandBatch{}.encode(); }));
+    assert(rejects([&] { CommandBatch{{adjust(500.0)}}.encode(); }));
+
+    // A burn that safe mode would block fails the batch; a reboot first clears it
+    assert(rejects([&] { CommandBatch{{adjust(1.0), safe, burn}}.check_runnable(false); }));
+    assert(rejects([&] { CommandBatch{{burn}}.check_runnable(true); }));
+    CommandBatch{{safe, reboot, burn}}.check_runnable(false);
+    Command later = burn;
+    later.exec_time_ns = 2000;
+    CommandBatch{{safe, later}}.check_runnable(false, 1000);  // Stored, checked when it runs
+
+    // Constellation: one batch per satellite through the multi-satellite ground station
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    const size_t n = 4;
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 1;
+    gs_config.max_retries = 1;
+    MultiGroundStation gs(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+        gs.add_session(static_cast<uint32_t>(i), *links.back());
+    }
+    ConstellationEngine::Config config;
+    config.num_satellites = n;
+    config.num_workers = 1;
+    config.tick_hz = 100.0;
+    ConstellationEngine engine(config, link_ptrs);
+    const double pitch0 = engine.pitch_deg(0);
+    const double altitude2 = engine.orbit_altitude_km(2);
+
+    assert(gs.send_batch(0, plan.commands));
+    assert(gs.send_batch(1, {adjust(1.0), safe}));
+    assert(gs.send_batch(2, {adjust(1.0), safe, burn}));  // Rejected: nothing may run
+    assert(!gs.send_batch(99, {safe}));
+
+    gs.start();
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    engine.stop();
+    gs.stop();
+
+    assert(engine.get_commands_received() == 52);
+    assert(std::abs(engine.pitch_deg(0) - pitch0 - 122.5) < 1.0);  // 0.1 * (0 + ... + 49), plus drift
+    assert(engine.safe_mode(1));
+    assert(!engine.safe_mode(2) && engine.orbit_altitude_km(2) <= altitude2);
+    auto stats0 = gs.get_session_stats(0);
+    auto stats2 = gs.get_session_stats(2);
+    assert(stats0->commands_sent == 50 && stats0->commands_failed == 0);
+    std::cout << "  batch 2: sent " << stats2->commands_sent << " failed " << stats2->commands_failed << std::endl;
+    assert(stats2->commands_sent == 0 && stats2->commands_failed == 3);
+    assert(gs.get_command_rtts_ms().size() == 2);  // One round trip per delivered batch
+
+    // Single pair on coroutine agents: batch ACKed once, time-tagged entries stored
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 5.0;
+    sat_config.ack_timeout_ms = 100;
+    GroundStation::Config station_config;
+    station_config.ack_timeout_ms = 100;
+    station_config.max_retries = 1;
+    station_config.log_file = "";
+    link_config.latency_ms = 5;
+    Link link(link_config);
+    Satellite satellite(link, sat_config);
+    GroundStation station(link, station_config);
+    CoroutineRuntime::Config rt_config;
+    rt_config.num_workers = 1;
+    CoroutineRuntime rt(rt_config);
+    Command stored = adjust(1.0);
+    stored.exec_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (std::chrono::steady_clock::now() + std::chrono::hours(1)).time_since_epoch()).count();
+    station.send_batch({adjust(1.0), stored, adjust(-1.0)});
+    station.send_batch({safe, burn});
+    satellite.start(rt);
+    station.start(rt);
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    satellite.stop();
+    station.stop();
+    assert(satellite.get_commands_received() == 3 && satellite.get_commands_scheduled() == 1);
+    assert(station.get_commands_sent() == 3);
+}
+
+// Test command plans: DSL errors, compiled order, heap dispatch at scale, triggers, and a constellation run
+TEST(test_command_plan) {
+    auto parse = [](const std::string& text) {
+        std::istringstream in(text);
+        return CommandPlan::parse(in);
+    };
+    auto rejects = [&](const std::string& text) {
+        try {
+            parse(text);
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what()).find("line 2") != std::string::npos;
+        }
+        return false;
+    };
+    assert(rejects("# header\nfly 5 sat 0 REBOOT"));
+    assert(rejects("\nat 5 sat 0 ADJUST_ORIENTATION 500 0 0"));  // Out of range
+    assert(rejects("\nat 5 sat 0 REBOOT times 3"));               // Repeat without every
+    assert(rejects("\nat 5 sat 3-1 REBOOT"));
+    assert(rejects("\nwhen voltage < 3 sat all ENTER_SAFE_MODE"));
+    assert(rejects("\nwhen battery_pct = 3 sat all ENTER_SAFE_MODE"));
+
+    // Compile: selectors expand over the listed satellites, sorted by time then plan order
+    CommandPlan plan = parse(
+        "at 2 sat all REBOOT\n"
+        "at 1 sat 5-7,9 ADJUST_ORIENTATION 1 0 0  # comment\n"
+        "at 1 sat 3 THRUST_BURN 2 every 0.5 times 3\n");
+    const std::vector<uint32_t> ids = {9, 3, 6, 42};
+    auto events = plan.compile(ids);
+    assert(events.size() == 7);
+    assert(events[0].sat_id == 6 && events[1].sat_id == 9 && events[2].sat_id == 3);
+    assert(events[2].timeline == 2 && events[2].remaining == 2);
+    assert(events[3].at_sec == 2.0 && events[3].sat_id == 3 && events[6].sat_id == 42);
+
+    PlanScheduler small(plan, ids);
+    std::vector<std::pair<uint32_t, CommandType>> sent;
+    auto record = [&](uint32_t sat, const Command& cmd) { sent.emplace_back(sat, cmd.type); };
+    assert(small.dispatch(0.9, record) == 0);
+    assert(small.dispatch(1.0, record) == 3 && small.next_due_sec() == 1.5);
+    assert(small.dispatch(10.0, record) == 6 && small.pending() == 0);
+    assert(sent[3] == std::make_pair(3u, CommandType::ThrustBurn));  // 1.5 s repeat precedes 2 s reboots
+    assert(sent.back() == std::make_pair(3u, CommandType::ThrustBurn));
+
+    // 100k events across 1000 satellites; dispatch stays in time order
+    std::ostringstream big_text;
+    for (int t = 0; t < 100; ++t) {
+        big_text << "at " << (99 - t) * 0.25 << " sat all ADJUST_ORIENTATION 0.1 0 0\n";
+    }
+    big_text << "at 0 sat 0-9 REBOOT every 1 until 24\n";
+    CommandPlan big = parse(big_text.str());
+    std::vector<uint32_t> fleet(1000);
+    for (uint32_t i = 0; i < fleet.size(); ++i) fleet[i] = i;
+    PlanScheduler scheduler(big, fleet);
+    assert(scheduler.pending() == 100010);
+    size_t total = 0;
+    for (double now = 0.0; now <= 30.0; now += 0.1) {
+        total += scheduler.dispatch(now, [&](uint32_t, const Command&) {});
+    }
+    assert(total == 100000 + 10 * 25 && scheduler.get_dispatched() == total && scheduler.pending() == 0);
+
+    // Triggers: once per crossing by default, every cooldown while held otherwise
+    CommandPlan guards = parse(
+        "when battery_pct < 20 sat all ENTER_SAFE_MODE\n"
+        "when temperature_c > 80 sat 1 REBOOT cooldown 10\n");
+    PlanScheduler watch(guards, {0, 1});
+    Telemetry t{};
+    t.battery_pct = 50;
+    t.temperature_c = 20;
+    size_t fired = 0;
+    auto count = [&](uint32_t, const Command&) { fired++; };
+    auto sample = [&](uint32_t sat, double battery, double temp, double now) {
+        t.battery_pct = battery;
+        t.temperature_c = temp;
+        return watch.on_telemetry(sat, t, now, count);
+    };
+    assert(sample(0, 50, 90, 0) == 0);   // Temperature trigger is only for sat 1
+    assert(sample(0, 10, 20, 1) == 1);
+    assert(sample(0, 10, 20, 2) == 0);
+    assert(sample(0, 30, 20, 3) == 0);
+    assert(sample(0, 10, 20, 4) == 1);   // New crossing
+    assert(sample(1, 50, 90, 0) == 1);
+    assert(sample(1, 50, 90, 5) == 0);
+    assert(sample(1, 50, 90, 10) == 1);  // Cooldown elapsed
+    assert(sample(1, 50, 90, 11) == 0);
+    assert(sample(7, 0, 100, 0) == 0);  // Not watched
+    assert(fired == 4 && watch.get_dispatched() == 4);
+
+    // Constellation: same-pass commands for one satellite go out as one batch
+    CommandPlan mission = parse(
+        "at 0 sat all ADJUST_ORIENTATION 1 0 0\n"
+        "at 0 sat 1 ENTER_SAFE_MODE\n"
+        "at 0.05 sat 2 ADJUST_ORIENTATION 1 0 0 every 0.05 times 3\n"
+        "at 3600 sat all REBOOT\n");
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    const size_t n = 4;
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 2;
+    gs_config.plan = &mission;
+    MultiGroundStation gs(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+        gs.add_session(static_cast<uint32_t>(i), *links.back());
+    }
+    ConstellationEngine::Config config;
+    config.num_satellites = n;
+    config.num_workers = 1;
+    config.tick_hz = 100.0;
+    ConstellationEngine engine(config, link_ptrs);
+
+    gs.start();
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    engine.stop();
+    gs.stop();
+
+    assert(gs.get_plan_commands() == 8);
+    assert(engine.get_commands_received() == 8 && engine.safe_mode(1));
+    assert(gs.get_session_stats(1)->commands_sent == 2);
+    assert(gs.get_session_stats(2)->commands_sent == 4);
+    assert(gs.get_command_rtts_ms().size() == 7);  // Sat 1's pair shared one round trip
+
+    // Shards first stepped at different times still share one plan clock
+    CommandPlan reboot = parse("at 1 sat all REBOOT\n");
+    LogicalClock clock;
+    link_config.clock = &clock;
+    Link link0(link_config), link1(link_config);
+    gs_config.clock = &clock;
+    gs_config.plan = &reboot;
+    MultiGroundStation stepped(gs_config);
+    stepped.add_session(0, link0);
+    stepped.add_session(1, link1);
+    stepped.step_shard(0);
+    clock.advance(std::chrono::milliseconds(600));
+    stepped.step_shard(1);
+    clock.advance(std::chrono::milliseconds(500));
+    stepped.step_shard(0);
+    stepped.step_shard(1);
+    assert(stepped.get_plan_commands() == 2);
+}
+
+// Test the ground-side rule program: hysteresis, rates, and batched evaluation across satellites
+TEST(test_rule_program) {
+    std::istringstream text(
+        "when battery_pct < 15 clear 25 sat all ENTER_SAFE_MODE\n"
+        "when temperature_c rate > 2 sat 0-1 REBOOT\n"
+        "when pitch_deg > 10 sat 99 REBOOT\n");  // Watches nobody here
+    CommandPlan plan = CommandPlan::parse(text);
+    assert(plan.triggers()[0].rule.clear == 25 && plan.triggers()[1].rule.rate);
+    std::istringstream bad("when battery_pct < 15 clear 5 sat all REBOOT\n");
+    bool rejected = false;
+    try {
+        CommandPlan::parse(bad);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    std::vector<RuleProgram::Rule> rules;
+    for (const auto& trigger : plan.triggers()) rules.push_back(trigger.rule);
+    const std::vector<uint32_t> ids = {0, 1, 2};
+    RuleProgram program(rules, ids, [&](size_t r, uint32_t id) { return plan.triggers()[r].sats.matches(id); });
+    assert(program.rule_count() == 2);
+
+    std::vector<std::pair<uint32_t, CommandType>> fired;
+    auto record = [&](uint32_t id, const Command& cmd) { fired.emplace_back(id, cmd.type); };
+    Telemetry t{};
+    auto sample = [&](uint32_t id, double battery, double temp, double now) {
+        t.battery_pct = battery;
+        t.temperature_c = temp;
+        return program.add_sample(id, t, now, record);
+    };
+
+    // Hysteresis: 14 trips, 20 stays disarmed, only 25 re-arms
+    for (double battery : {50.0, 14.0, 20.0, 14.0, 26.0, 14.0}) {
+        sample(2, battery, 20, 0);
+        program.evaluate(record);
+    }
+    assert(fired.size() == 2 && fired[0] == std::make_pair(2u, CommandType::EnterSafeMode));
+
+    // One batch across satellites; no rate until each has two samples
+    fired.clear();
+    sample(0, 50, 20, 1);
+    sample(1, 50, 20, 1);
+    sample(2, 50, 20, 1);
+    assert(program.queued() == 3 && program.evaluate(record) == 0);
+    sample(0, 50, 21, 2);  // +1 C/s
+    sample(1, 50, 25, 2);  // +5 C/s
+    sample(2, 10, 90, 2);  // Battery trips; rate rule does not watch sat 2
+    assert(program.evaluate(record) == 2);  // Fired in rule order
+    assert(fired[0] == std::make_pair(2u, CommandType::EnterSafeMode));
+    assert(fired[1] == std::make_pair(1u, CommandType::Reboot));
+
+    // A second sample for a queued satellite flushes the batch first
+    fired.clear();
+    sample(0, 50, 30, 3);              // +9 C/s, queued
+    assert(sample(0, 50, 30, 4) == 1);  // Flushed: the crossing at t=3 is kept
+    assert(program.evaluate(record) == 0 && fired.size() == 1);
+}
+
+// Test Chase-Lev deque hands every item out exactly once under concurrent stealing
+TEST(test_chase_lev_deque_steal) {
+    ChaseLevDeque<uint32_t> deque(4);  // Small so the owner grows it while thieves run
+    const uint32_t total = 200000;
+    std::vector<std::atomic<uint8_t>> seen(total);
+    std::atomic<bool> done{false};
+
+    auto take = [&](uint32_t v) { seen[v]++; };
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&] {
+            while (!done || !deque.empty()) {
+                if (auto v = deque.steal()) take(*v);
+            }
+        });
+    }
+
+    for (uint32_t v = 0; v < total; ++v) {
+        deque.push(v);
+        if (v % 3 == 0) {
+            if (auto mine = deque.pop()) take(*mine);
+        }
+    }
+    while (auto mine = deque.pop()) take(*mine);
+    done = true;
+    for (auto& t : thieves) t.join();
+
+    for (uint32_t v = 0; v < total; ++v) {
+        assert(seen[v] == 1);
+    }
+}
+
+// Test pool runs submitted, delayed and nested tasks, and agents until done
+TEST(test_work_stealing_pool_tasks_and_agents) {
+    WorkStealingPool pool(4);
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 100; ++i) {
+        pool.submit([&] {
+            count++;
+            pool.submit([&] { count++; });  // Spawned from a worker: local deque
+        });
+    }
+
+    auto start = WorkStealingPool::Clock::now();
+    std::atomic<int64_t> delayed_at_ms{-1};
+    pool.submit_at(start + std::chrono::milliseconds(30), [&] {
+        delayed_at_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            WorkStealingPool::Clock::now() - start).count();
+    });
+
+    // Agent alternates yield and sleep for 10 steps
+    std::atomic<int> steps{0};
+    pool.spawn_agent([&] {
+        int n = ++steps;
+        if (n == 10) return WorkStealingPool::AgentStep::done();
+        if (n % 2) return WorkStealingPool::AgentStep::yield();
+        return WorkStealingPool::AgentStep::sleep_for(std::chrono::milliseconds(1));
+    });
+
+    pool.wait_idle();
+    assert(count == 200);
+    assert(delayed_at_ms >= 30);
+    assert(steps == 10);
+    assert(pool.current_worker() == -1);
+    assert(pool.get_tasks_executed() >= 211);
+}
+
+// Measure agent step throughput as the pool grows
+TEST(test_work_stealing_pool_agent_scaling) {
+    const int num_agents = 1000;
+    const int steps_per_agent = 200;
+    const size_t max_workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+        WorkStealingPool pool(workers);
+        std::atomic<uint64_t> checksum{0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int a = 0; a < num_agents; ++a) {
+            pool.spawn_agent([&checksum, a, n = 0]() mutable {
+                // A few hundred ns of work per step, like a state update
+                uint64_t x = static_cast<uint64_t>(a) * 0x9E3779B97F4A7C15ULL + n;
+                for (int k = 0; k < 64; ++k) x = (x ^ (x >> 29)) * 0xBF58476D1CE4E5B9ULL;
+                if (++n == steps_per_agent) {
+                    checksum += x & 1;
+                    return WorkStealingPool::AgentStep::done();
+                }
+                return WorkStealingPool::AgentStep::yield();
+            });
+        }
+        pool.wait_idle();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        assert(pool.get_tasks_executed() == static_cast<uint64_t>(num_agents) * steps_per_agent);
+        std::cout << "  " << workers << " workers: "
+                  << static_cast<uint64_t>(num_agents * steps_per_agent / elapsed)
+                  << " agent steps/s, " << pool.get_steals() << " steals" << std::endl;
+    }
+}
+
+// Test constellation and ground station share one work-stealing pool
+TEST(test_constellation_on_pool) {
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+
+    const size_t n = 3000;  // Several chunks per tick
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    MultiGroundStation::Config gs_config;
+    gs_config.num_workers = 4;
+    MultiGroundStation gs(gs_config);
+    for (size_t i = 0; i < n; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+        gs.add_session(static_cast<uint32_t>(i), *links.back());
+    }
+
+    ConstellationEngine::Config config;
+    config.num_satellites = n;
+    config.num_workers = 2;
+    config.tick_hz = 50.0;
+    config.telemetry_rate_hz = 10.0;
+    ConstellationEngine engine(config, link_ptrs);
+
+    WorkStealingPool pool(2);
+    gs.start(pool);
+    engine.start(pool);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    engine.stop();
+    gs.stop();
+
+    std::cout << "  " << engine.get_ticks() << " ticks, sent " << engine.get_telemetry_sent()
+              << ", GS received " << gs.get_telemetry_received()
+              << ", ACKed " << engine.get_telemetry_acked() << std::endl;
+    assert(engine.get_ticks() >= 5);
+    assert(engine.get_telemetry_sent() >= n);
+    assert(gs.get_telemetry_received() > 0);
+    assert(engine.get_telemetry_acked() > 0);
+
+    // Nothing re-arms after stop()
+    uint64_t ticks = engine.get_ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(engine.get_ticks() == ticks);
+}
+
+static Task<int> coro_add_later(CoroutineRuntime& rt, int a, int b) {
+    co_await rt.sleep_for(std::chrono::milliseconds(2));
+    co_return a + b;
+}
+
+static Task<int> coro_throws(CoroutineRuntime& rt) {
+    co_await rt.yield();
+    throw std::runtime_error("boom");
+}
+
+// Test nested tasks, sleeps, yields, exceptions and link receives on the runtime
+TEST(test_coroutine_runtime_awaitables) {
+    CoroutineRuntime::Config config;
+    config.num_workers = 2;
+    CoroutineRuntime rt(config);
+
+    Link::Config link_config;
+    link_config.latency_ms = 20;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    Link link(link_config);
+
+    std::atomic<int> sum{0};
+    std::atomic<bool> caught{false};
+    std::atomic<bool> timed_out{false};
+    std::atomic<int64_t> recv_ms{-1};
+    std::atomic<bool> done{false};
+
+    auto agent = [&]() -> Task<void> {
+        sum = co_await coro_add_later(rt, 2, 3);
+        try {
+            co_await coro_throws(rt);
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+
+        // Nothing in flight: times out
+        auto none = co_await rt.recv_gs_to_sat(link, CoroutineRuntime::Clock::now() + std::chrono::milliseconds(5));
+        timed_out = !none.has_value();
+
+        // Arrives after the link latency
+        auto start = CoroutineRuntime::Clock::now();
+        link.send_gs_to_sat(make_test_packet(PacketType::AckPkt, 9, 0));
+        auto pkt = co_await rt.recv_gs_to_sat(link, start + std::chrono::seconds(1));
+        if (pkt && pkt->seq == 9) {
+            recv_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                CoroutineRuntime::Clock::now() - start).count();
+        }
+    };
+
+    rt.spawn(agent(), [&] { done = true; });
+    rt.wait_idle();
+
+    assert(done);
+    assert(sum == 5);
+    assert(caught);
+    assert(timed_out);
+    assert(recv_ms >= 20 && recv_ms < 500);
+}
+
+// Measure agent-to-agent switch cost on one worker
+TEST(test_coroutine_switch_cost) {
+    CoroutineRuntime::Config config;
+    config.num_workers = 1;
+    CoroutineRuntime rt(config);
+
+    const int agents = 4;
+    const int yields = 100000;
+    auto spinner = [&rt]() -> Task<void> {
+        for (int i = 0; i < yields; ++i) {
+            co_await rt.yield();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int a = 0; a < agents; ++a) {
+        rt.spawn(spinner());
+    }
+    rt.wait_idle();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << static_cast<uint64_t>(ns / (agents * yields)) << " ns per yield" << std::endl;
+}
+
+// Test thousands of satellite/ground station agents multiplexed onto two threads
+TEST(test_coroutine_agents_at_scale) {
+    Link::Config link_config;
+    link_config.latency_ms = 5;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 5.0;
+    sat_config.ack_timeout_ms = 100;
+    sat_config.recorder_capacity = 16;
+    GroundStation::Config gs_config;
+    gs_config.ack_timeout_ms = 100;
+    gs_config.log_file = "";
+
+    const size_t pairs = 1000;
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<std::unique_ptr<Satellite>> sats;
+    std::vector<std::unique_ptr<GroundStation>> stations;
+    for (size_t i = 0; i < pairs; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        sat_config.seed = static_cast<unsigned int>(i);
+        sats.push_back(std::make_unique<Satellite>(*links.back(), sat_config));
+        stations.push_back(std::make_unique<GroundStation>(*links.back(), gs_config));
+    }
+
+    CoroutineRuntime::Config config;
+    config.num_workers = 2;
+    CoroutineRuntime rt(config);
+    for (size_t i = 0; i < pairs; ++i) {
+        sats[i]->start(rt);
+        stations[i]->start(rt);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+    // Snapshot before stopping: each stop() waits for its agent's next wakeup
+    uint64_t sent = 0, received = 0;
+    for (size_t i = 0; i < pairs; ++i) {
+        sent += sats[i]->get_telemetry_sent();
+        received += stations[i]->get_telemetry_received();
+    }
+    std::vector<std::thread> stoppers;
+    for (size_t t = 0; t < 8; ++t) {
+        stoppers.emplace_back([&, t] {
+            for (size_t i = t; i < pairs; i += 8) {
+                sats[i]->stop();
+                stations[i]->stop();
+            }
+        });
+    }
+    for (auto& t : stoppers) t.join();
+
+    std::cout << "  " << pairs * 2 << " agents on " << rt.size() << " threads, 1 s: "
+              << sent << " telemetry ACKed, " << received << " received" << std::endl;
+    assert(sent >= pairs);  // ~4 per satellite per second at 5 Hz when unloaded
+    assert(received >= sent);
+}
+
+TEST(test_sweep_spec_parsing) {
+    ParameterSweep::Point base;
+    std::istringstream grid(
+        "# grid over two axes\n"
+        "replicas = 3\n"
+        "loss = 0.0, 0.1\n"
+        "ack_timeout_ms = 200..400 step 100   # three values\n");
+    ParameterSweep::Spec spec = ParameterSweep::parse_spec(grid, base);
+    assert(spec.mode == ParameterSweep::Spec::Mode::Grid);
+    assert(spec.replicas == 3);
+
+    ParameterSweep sweep(spec);
+    assert(sweep.points().size() == 6);
+    assert(sweep.total_runs() == 18);
+    assert(sweep.points()[0].loss == 0.0 && sweep.points()[0].ack_timeout_ms == 200);
+    assert(sweep.points()[5].loss == 0.1 && sweep.points()[5].ack_timeout_ms == 400);
+    assert(sweep.points()[5].latency_ms == base.latency_ms);
+
+    std::istringstream random(
+        "mode = random\n"
+        "samples = 10\n"
+        "latency_ms = uniform(50, 150)\n"
+        "max_retries = 1, 5\n");
+    ParameterSweep sampled(ParameterSweep::parse_spec(random, base));
+    assert(sampled.points().size() == 10);
+    for (const auto& p : sampled.points()) {
+        assert(p.latency_ms >= 50 && p.latency_ms <= 150);
+        assert(p.latency_ms == std::round(p.latency_ms));
+        assert(p.max_retries == 1 || p.max_retries == 5);
+    }
+
+    // Malformed specs are rejected
+    std::istringstream unknown("bandwidth = 5\n");
+    bool threw = false;
+    try { ParameterSweep::parse_spec(unknown, base); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    std::istringstream uniform_grid("loss = uniform(0, 0.1)\n");
+    threw = false;
+    try { ParameterSweep sweep2(ParameterSweep::parse_spec(uniform_grid, base)); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+TEST(test_sweep_confidence_interval) {
+    auto stat = ParameterSweep::summarize({1, 2, 3, 4, 5});
+    assert(std::abs(stat.mean - 3.0) < 1e-9);
+    assert(std::abs(stat.stddev - 1.5811) < 1e-3);
+    assert(std::abs(stat.ci95 - 2.776 * 1.5811 / std::sqrt(5.0)) < 1e-3);
+
+    auto single = ParameterSweep::summarize({7});
+    assert(single.mean == 7 && single.ci95 == 0);
+
+    // Beyond the table: twenty each of -1 and +1 plus a 0 give stddev 1,
+    // and t(0.975, 40) = 2.021
+    std::vector<double> samples;
+    for (int i = 0; i < 41; ++i) {
+        samples.push_back(i == 40 ? 0.0 : (i % 2 ? 1.0 : -1.0));
+    }
+    auto wide = ParameterSweep::summarize(samples);
+    assert(std::abs(wide.ci95 - 2.021 * wide.stddev / std::sqrt(41.0)) < 1e-3);
+}
+
+TEST(test_sweep_end_to_end) {
+    ParameterSweep::Point base;
+    base.latency_ms = 5;
+    base.jitter_ms = 0;
+    base.ack_timeout_ms = 60;
+    std::istringstream in(
+        "replicas = 2\n"
+        "duration_sec = 0.5\n"
+        "workers = 2\n"
+        "loss = 0.0, 0.5\n");
+    ParameterSweep sweep(ParameterSweep::parse_spec(in, base));
+
+    size_t batches = 0;
+    auto summaries = sweep.run([&](size_t done, size_t total) {
+        batches++;
+        assert(done <= total);
+    });
+    assert(batches == 1);
+    assert(summaries.size() == 2);
+    assert(summaries[0].runs == 2);
+
+    // Lossless point drops nothing; lossy point drops roughly half
+    assert(summaries[0].stats[ParameterSweep::PacketsDropped].mean == 0);
+    assert(summaries[0].stats[ParameterSweep::TelemetrySent].mean > 0);
+    assert(summaries[1].stats[ParameterSweep::DropRate].mean > 0.2);
+
+    std::ostringstream csv;
+    ParameterSweep::write_csv(csv, summaries);
+    std::istringstream lines(csv.str());
+    std::string header, line;
+    std::getline(lines, header);
+    assert(header.rfind("telemetry_rate_hz,loss,", 0) == 0);
+    assert(header.find("telemetry_per_sec_ci95") != std::string::npos);
+    size_t rows = 0;
+    while (std::getline(lines, line)) rows++;
+    assert(rows == 2);
+}
+
+TEST(test_checkpoint_format) {
+    std::mt19937 rng(7);
+    rng.discard(1000);
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.seq = 99;
+    pkt.payload = "{\"temp\":42}";
+    pkt.payload_size = static_cast<uint32_t>(pkt.payload.size());
+    pkt.compute_crc();
+
+    std::stringstream file;
+    {
+        CheckpointWriter out(file);
+        out.begin("TEST");
+        out.put<uint32_t>(0xDEADBEEF);
+        out.put_vector(std::vector<double>{1.5, -2.5, 3.0});
+        out.put_string("hello");
+        out.put_packet(pkt);
+        out.put_rng(rng);
+        out.end();
+        out.finish();
+    }
+    const std::string bytes = file.str();
+
+    std::stringstream copy(bytes);
+    CheckpointReader in(copy);
+    in.begin("TEST");
+    assert(in.get<uint32_t>() == 0xDEADBEEF);
+    assert((in.get_vector<double>() == std::vector<double>{1.5, -2.5, 3.0}));
+    assert(in.get_string() == "hello");
+    Packet restored = in.get_packet();
+    assert(restored.seq == 99 && restored.payload == pkt.payload && restored.verify_crc());
+    std::mt19937 restored_rng;
+    in.get_rng(restored_rng);
+    assert(restored_rng() == rng());
+    in.end();
+    in.begin("END ");
+    in.end();
+
+    // A flipped payload byte fails the section CRC
+    std::string corrupt = bytes;
+    corrupt[30] ^= 0x01;
+    std::stringstream bad(corrupt);
+    CheckpointReader bad_in(bad);
+    bool threw = false;
+    try { bad_in.begin("TEST"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    // Sections must be read in order
+    std::stringstream wrong(bytes);
+    CheckpointReader wrong_in(wrong);
+    threw = false;
+    try { wrong_in.begin("LINK"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    // A huge section length (after the 9-byte header and 4-byte tag) is
+    // reported as truncation, not attempted as an allocation
+    std::string huge = bytes;
+    const uint64_t huge_len = uint64_t{1} << 60;
+    std::memcpy(&huge[13], &huge_len, sizeof(huge_len));
+    std::stringstream huge_file(huge);
+    CheckpointReader huge_in(huge_file);
+    threw = false;
+    try { huge_in.begin("TEST"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    std::stringstream junk("not a checkpoint");
+    threw = false;
+    try { CheckpointReader junk_in(junk); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+TEST(test_checkpoint_agents_round_trip) {
+    Link::Config link_config;
+    link_config.latency_ms = 5;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    Satellite::Config sat_config;
+    sat_config.telemetry_rate_hz = 20.0;
+    sat_config.ack_timeout_ms = 50;
+    sat_config.recorder_capacity = 64;
+    GroundStation::Config gs_config;
+    gs_config.ack_timeout_ms = 50;
+    gs_config.log_file = "";
+
+    std::stringstream file;
+    uint64_t sent = 0, received = 0, link_sent = 0;
+    {
+        Link link(link_config);
+        Satellite sat(link, sat_config);
+        GroundStation gs(link, gs_config);
+        sat.start();
+        gs.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        sat.stop();
+        gs.stop();
+
+        // A packet still in flight survives the round trip
+        Packet pkt;
+        pkt.type = PacketType::AckPkt;
+        pkt.seq = 12345;
+        pkt.payload_size = 0;
+        pkt.compute_crc();
+        link.send_gs_to_sat(pkt);
+
+        CheckpointWriter out(file);
+        link.save(out);
+        sat.save(out);
+        gs.save(out);
+        out.finish();
+        sent = sat.get_telemetry_sent();
+        received = gs.get_telemetry_received();
+        link_sent = link.get_packets_sent();
+        assert(sent > 0 && received > 0);
+    }
+
+    Link link(link_config);
+    Satellite sat(link, sat_config);
+    GroundStation gs(link, gs_config);
+    CheckpointReader in(file);
+    link.restore(in);
+    sat.restore(in);
+    gs.restore(in);
+    assert(sat.get_telemetry_sent() == sent);
+    assert(gs.get_telemetry_received() == received);
+    assert(link.get_packets_sent() == link_sent);
+    Packet pkt;
+    bool found = false;
+    while (!found && link.recv_gs_to_sat(pkt, std::chrono::milliseconds(50))) {
+        found = pkt.seq == 12345;
+    }
+    assert(found);
+
+    // The run resumes from the restored counters
+    sat.start();
+    gs.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    sat.stop();
+    gs.stop();
+    assert(sat.get_telemetry_sent() > sent);
+    assert(gs.get_telemetry_received() > received);
+}
+
+// Test a restored ground station continues its command plan instead of
+// starting it over and resending commands that already went out
+TEST(test_checkpoint_ground_station_plan) {
+    std::istringstream text(
+        "at 0 sat 0 THRUST_BURN 1\n"
+        "at 0.25 sat 0 ENTER_SAFE_MODE\n");
+    const CommandPlan plan = CommandPlan::parse(text);
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    GroundStation::Config gs_config;
+    gs_config.ack_timeout_ms = 20;
+    gs_config.max_retries = 0;  // No satellite: nothing is ever ACKed
+    gs_config.log_file = "";
+    gs_config.plan = &plan;
+
+    std::stringstream file;
+    {
+        Link link(link_config);
+        GroundStation gs(link, gs_config);
+        gs.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        gs.stop();
+        assert(gs.get_plan_commands() == 1);
+        CheckpointWriter out(file);
+        gs.save(out);
+        out.finish();
+    }
+
+    Link link(link_config);
+    GroundStation gs(link, gs_config);
+    CheckpointReader in(file);
+    gs.restore(in);
+    assert(gs.get_plan_commands() == 1);
+    gs.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    gs.stop();
+    assert(gs.get_plan_commands() == 2);
+
+    // Only the second timeline went out after the restore: no second burn
+    Packet pkt;
+    size_t burns = 0, safe_modes = 0;
+    while (link.recv_gs_to_sat(pkt, std::chrono::milliseconds(0))) {
+        if (pkt.type == PacketType::CommandPkt) {
+            const Command cmd = Command::decode(pkt.payload);
+            burns += cmd.type == CommandType::ThrustBurn;
+            safe_modes += cmd.type == CommandType::EnterSafeMode;
+        }
+    }
+    assert(burns == 0 && safe_modes > 0);
+}
+
+TEST(test_constellation_incremental_capture) {
+    const size_t n = 2000;
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<Link*> link_ptrs;
+    Link::Config link_config;
+    link_config.latency_ms = 0;
+    link_config.jitter_ms = 0;
+    link_config.loss_prob = 0.0;
+    link_config.deferred_delivery = true;
+    for (size_t i = 0; i < n; ++i) {
+        links.push_back(std::make_unique<Link>(link_config));
+        link_ptrs.push_back(links.back().get());
+    }
+
+    ConstellationEngine::Config config;
+    config.num_satellites = n;
+    config.num_workers = 2;
+    config.tick_hz = 50.0;
+    config.telemetry_rate_hz = 5.0;
+    ConstellationEngine engine(config, link_ptrs);
+    for (int t = 0; t < 25; ++t) engine.step();
+
+    // First capture copies every block; an immediate second one copies none
+    auto first = engine.capture();
+    const size_t blocks = (n + 63) / 64;
+    assert(engine.get_last_capture_blocks() == blocks);
+    assert(first->tick == 25);
+    auto again = engine.capture();
+    assert(engine.get_last_capture_blocks() == 0);
+    assert(again->tx_seq == first->tx_seq);
+
+    // A held snapshot is never modified by later captures (copy-on-write)
+    const std::vector<uint32_t> held_seq = first->tx_seq;
+    const double held_temp = first->temperature_c[0];
+    engine.step();
+    auto next = engine.capture();
+    assert(next != first && next->tick == 26);
+    assert(engine.get_last_capture_blocks() == 0);  // Telemetry and ACKs alone dirty no block
+    assert(first->tx_seq == held_seq && first->temperature_c[0] == held_temp);
+    assert(next->tx_seq != held_seq);
+
+    // Capture while running pauses the engine only between ticks
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto live = engine.capture();
+    engine.stop();
+    assert(live->tick > 26);
+    std::cout << "  " << n << " satellites: live capture paused " << engine.get_last_capture_ns() / 1000
+              << " us for " << engine.get_last_capture_blocks() << "/" << blocks << " blocks" << std::endl;
+
+    // Save, restore into a fresh engine, and both evolve identically
+    std::stringstream file;
+    {
+        CheckpointWriter out(file);
+        live->save(out);
+        out.finish();
+    }
+    ConstellationEngine::Config state_only = config;
+    ConstellationEngine a(state_only, {}), b(state_only, {});
+    std::stringstream copy(file.str());
+    CheckpointReader in_a(file), in_b(copy);
+    a.restore(in_a);
+    b.restore(in_b);
+    assert(a.get_ticks() == live->tick && a.get_telemetry_sent() == live->telemetry_sent);
+    assert(a.temperature_c(7) == live->temperature_c[7]);
+    for (int t = 0; t < 10; ++t) {
+        a.step();
+        b.step();
+    }
+    for (size_t i = 0; i < n; ++i) {
+        assert(a.temperature_c(i) == b.temperature_c(i));
+        assert(a.battery_pct(i) == b.battery_pct(i));
+    }
+
+    // Size mismatch is rejected
+    ConstellationEngine::Config smaller = config;
+    smaller.num_satellites = n / 2;
+    ConstellationEngine c(smaller, {});
+    std::stringstream copy2(copy.str());
+    bool threw = false;
+    try {
+        CheckpointReader in_c(copy2);
+        c.restore(in_c);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+TEST(test_deterministic_lockstep) {
+    // Same seed, different worker counts: every counter must match exactly
+    struct Outcome {
+        uint64_t sent, acked, unacked, retries, received, link_sent, link_dropped;
+        double temperature;
+        bool operator==(const Outcome&) const = default;
+    };
+    auto run = [](size_t workers, size_t gs_workers) {
+        const size_t n = 300;
+        LogicalClock clock;
+        std::vector<std::unique_ptr<Link>> links;
+        std::vector<Link*> link_ptrs;
+        for (size_t i = 0; i < n; ++i) {
+            Link::Config link_config;
+            link_config.latency_ms = 40;
+            link_config.jitter_ms = 25;
+            link_config.loss_prob = 0.1;
+            link_config.seed = 7 + static_cast<unsigned int>(i);
+            link_config.deferred_delivery = true;
+            link_config.clock = &clock;
+            links.push_back(std::make_unique<Link>(link_config));
+            link_ptrs.push_back(links.back().get());
+        }
+
+        MultiGroundStation::Config gs_config;
+        gs_config.num_workers = gs_workers;
+        gs_config.clock = &clock;
+        MultiGroundStation gs(gs_config);
+        for (size_t i = 0; i < n; ++i) gs.add_session(static_cast<uint32_t>(i), *links[i]);
+
+        ConstellationEngine::Config config;
+        config.num_satellites = n;
+        config.num_workers = workers;
+        config.tick_hz = 20.0;
+        config.telemetry_rate_hz = 4.0;
+        config.ack_timeout_ms = 150;
+        config.clock = &clock;
+        ConstellationEngine engine(config, link_ptrs);
+        engine.set_tick_peer([&gs](size_t worker, size_t num_workers) {
+            for (size_t s = worker; s < gs.worker_count(); s += num_workers) gs.step_shard(s);
+        });
+        engine.run(120);
+        assert(engine.get_ticks() == 120);
+        assert(clock.now_ns() == 6000000000ULL);
+
+        Outcome out{engine.get_telemetry_sent(), engine.get_telemetry_acked(),
+                    engine.get_telemetry_unacked(), engine.get_retries(),
+                    gs.get_telemetry_received(), 0, 0, engine.temperature_c(n - 1)};
+        for (const auto& link : links) {
+            out.link_sent += link->get_packets_sent();
+            out.link_dropped += link->get_packets_dropped();
+        }
+        return out;
+    };
+
+    Outcome a = run(1, 1);
+    Outcome b = run(4, 3);
+    Outcome c = run(4, 3);
+    assert(a.sent > 0 && a.acked > 0 && a.retries > 0 && a.link_dropped > 0);
+    assert(a == b);
+    assert(b == c);
+}
+
+TEST(test_bench_harness_statistics) {
+    // Median, nearest-rank p99 and throughput from per-rep samples
+    bench::Harness::Result r;
+    r.bytes_per_op = 100.0;
+    std::vector<double> samples;
+    for (int i = 100; i >= 1; --i) samples.push_back(static_cast<double>(i));
+    bench::Harness::summarize(samples, r);
+    assert(r.reps == 100);
+    assert(r.median_ns == 50.5);
+    assert(r.p99_ns == 99.0);
+    assert(r.min_ns == 1.0);
+    assert(std::abs(r.mean_ns - 50.5) < 1e-9);
+    assert(std::abs(r.bytes_per_sec - 100.0 * 1e9 / 50.5) < 1e-3);
+
+    // Calibration reaches the minimum repetition time; filter skips others
+    bench::Harness::Options options;
+    options.reps = 3;
+    options.warmup_reps = 1;
+    options.min_rep_time = std::chrono::milliseconds(1);
+    options.filter = "crc";
+    bench::Harness harness(options);
+    uint64_t calls = 0;
+    harness.add("crc_tiny", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            uint8_t byte = static_cast<uint8_t>(i);
+            bench::do_not_optimize(crc::crc16_ccitt(&byte, 1));
+        }
+        calls++;
+    }, 1.0);
+    harness.add("skipped", [](uint64_t) { assert(false); });
+    auto results = harness.run();
+    assert(results.size() == 1 && results[0].reps == 3);
+    assert(results[0].iters_per_rep > 1 && results[0].median_ns > 0.0);
+    assert(calls >= 5);
+
+    std::ostringstream json;
+    bench::Harness::write_json(json, "unit", results);
+    assert(json.str().find("\"suite\": \"unit\"") != std::string::npos);
+    assert(json.str().find("\"name\": \"crc_tiny\"") != std::string::npos);
+    assert(json.str().find("\"bytes_per_second\"") != std::string::npos);
+}
+
+TEST(test_bench_harness_perf_counters) {
+    // Per-op counter arithmetic
+    bench::Harness::Result r;
+    r.name = "counted";
+    r.counted_ops = 100;
+    r.counters.values = {4000, 10000, 50, 20};
+    r.counters.valid = {true, true, false, true};
+    assert(r.ipc() == 2.5);
+    assert(r.per_op(bench::PerfCounters::Instructions) == 100.0);
+    assert(r.per_op(bench::PerfCounters::BranchMisses) == 0.2);
+    assert(!r.has(bench::PerfCounters::CacheMisses) && r.per_op(bench::PerfCounters::CacheMisses) == 0.0);
+
+    std::ostringstream table, json;
+    bench::Harness::print_table(table, {r});
+    assert(table.str().find("IPC") != std::string::npos);
+    bench::Harness::write_json(json, "unit", {r});
+    assert(json.str().find("\"hardware_counters\": true") != std::string::npos);
+    assert(json.str().find("\"ipc\": 2.5") != std::string::npos);
+    assert(json.str().find("\"branch_misses_per_op\": 0.2") != std::string::npos);
+    assert(json.str().find("cache_misses_per_op") == std::string::npos);
+
+    // Live counters work or report why not; never throw
+    bench::PerfCounters counters;
+    assert(counters.available() || !counters.unavailable_reason().empty());
+    counters.start();
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        sum += i;
+        bench::do_not_optimize(sum);
+    }
+    auto sample = counters.stop();
+    if (sample.has(bench::PerfCounters::Instructions)) {
+        assert(sample[bench::PerfCounters::Instructions] >= 100000);
+    }
+
+    // Disabled counters leave results uncounted
+    bench::Harness::Options options;
+    options.reps = 2;
+    options.warmup_reps = 0;
+    options.min_rep_time = std::chrono::microseconds(100);
+    options.counters = false;
+    auto result = bench::Harness(options).measure("plain", [](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) bench::do_not_optimize(i);
+    });
+    assert(result.counted_ops == 0 && result.ipc() == 0.0);
+}
+
+TEST(test_load_bench_ramp) {
+    assert(LoadBench::percentile({}, 50.0) == 0.0);
+    assert(LoadBench::percentile({5.0, 1.0, 3.0, 2.0, 4.0}, 50.0) == 3.0);
+    assert(LoadBench::percentile({5.0, 1.0, 3.0, 2.0, 4.0}, 100.0) == 5.0);
+    assert(LoadBench::percentile({5.0, 1.0, 3.0, 2.0, 4.0}, 0.0) == 1.0);
+
+    LoadBench::Config config;
+    config.num_satellites = 50;
+    config.start_load = 100.0;
+    config.max_steps = 2;
+    config.step_sec = 0.4;
+    config.warmup_sec = 0.1;
+    config.command_rate_hz = 50.0;
+    config.loss = 0.0;
+    config.latency_ms = 5;
+    config.jitter_ms = 0;
+    config.ack_timeout_ms = 100;
+    config.workers = 2;
+    config.gs_workers = 2;
+    LoadBench bench(config);
+    size_t reported = 0;
+    auto steps = bench.run([&](const LoadBench::Step&) { reported++; });
+    assert(!steps.empty() && steps.size() <= 2 && reported == steps.size());
+    const auto& first = steps.front();
+    assert(first.offered_per_sec == 100.0 && first.telemetry_rate_hz == 2.0);
+    assert(first.delivered_per_sec > 0.0 && first.sent_per_sec > 0.0);
+    assert(first.ticks > 0 && first.cpu_us_per_packet > 0.0);
+    assert(first.commands_acked > 0);
+    assert(first.rtt_p50_ms > 0.0 && first.rtt_p50_ms <= first.rtt_p99_ms && first.rtt_p99_ms <= first.rtt_max_ms);
+    if (steps.size() == 2) {
+        assert(steps[1].offered_per_sec == 200.0);
+    }
+
+    std::ostringstream json;
+    LoadBench::write_json(json, config, steps);
+    assert(json.str().find("\"saturation_offered_per_sec\"") != std::string::npos);
+    assert(json.str().find("\"rtt_p99_ms\"") != std::string::npos);
+}
+
+TEST(test_hdr_histogram_buckets_and_percentiles) {
+    // Every value lands in a bucket that contains it, within 1/64 relative width
+    for (uint64_t v : {uint64_t{0}, uint64_t{1}, uint64_t{127}, uint64_t{128}, uint64_t{255},
+                       uint64_t{1000}, uint64_t{123456789}, HdrHistogram::kMaxValue}) {
+        size_t i = HdrHistogram::bucket_index(v);
+        assert(i < HdrHistogram::kBucketCount);
+        assert(HdrHistogram::bucket_lowest(i) <= v && v <= HdrHistogram::bucket_highest(i));
+        assert(HdrHistogram::bucket_highest(i) - HdrHistogram::bucket_lowest(i) <=
+               HdrHistogram::bucket_lowest(i) / 64);
+    }
+    for (size_t i = 1; i < HdrHistogram::kBucketCount; ++i) {
+        assert(HdrHistogram::bucket_lowest(i) == HdrHistogram::bucket_highest(i - 1) + 1);
+    }
+    assert(HdrHistogram::bucket_index(UINT64_MAX) == HdrHistogram::kBucketCount - 1);
+
+    HdrHistogram h;
+    assert(h.percentile(50.0) == 0 && h.count() == 0);
+    for (uint64_t v = 1; v <= 100000; ++v) h.record(v * 1000);  // 1us .. 100ms
+    assert(h.count() == 100000 && h.min() == 1000 && h.max() == 100000000);
+    auto near = [](uint64_t got, double want) { return std::abs(static_cast<double>(got) - want) <= want / 64.0; };
+    assert(near(h.percentile(50.0), 50e6));
+    assert(near(h.percentile(99.0), 99e6));
+    assert(near(h.percentile(99.9), 99.9e6));
+    assert(h.percentile(100.0) == h.max());
+    assert(std::abs(h.mean() - 50000500.0) < 1.0);
+
+    // Merge is the same as recording everything in one histogram
+    HdrHistogram a, b, both;
+    for (uint64_t v = 0; v < 5000; ++v) {
+        (v % 2 ? a : b).record(v * 37);
+        both.record(v * 37);
+    }
+    a.merge(b);
+    assert(a.counts() == both.counts() && a.count() == both.count());
+    assert(a.min() == both.min() && a.max() == both.max() && a.percentile(99.0) == both.percentile(99.0));
+}
+
+TEST(test_latency_histogram_concurrent) {
+    LatencyHistogram hist;
+    const int threads = 8;
+    const uint64_t per_thread = 50000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&hist, t, per_thread] {
+            for (uint64_t i = 1; i <= per_thread; ++i) {
+                hist.record(i * 100 + static_cast<uint64_t>(t));
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    HdrHistogram snap = hist.snapshot();
+    assert(snap.count() == threads * per_thread);
+    assert(snap.min() == 100);
+    assert(snap.max() == per_thread * 100 + threads - 1);
+    hist.record(std::chrono::milliseconds(-5));  // Negative durations clamp to zero
+    assert(hist.snapshot().min() == 0);
+    hist.reset();
+    assert(hist.snapshot().count() == 0);
+
+    // Link queue residency is recorded once per delivered packet
+    LatencyHistogram down, up;
+    Link::Config config;
+    config.latency_ms = 0;
+    config.jitter_ms = 0;
+    config.loss_prob = 0.0;
+    config.sat_to_gs_residency = &down;
+    config.gs_to_sat_residency = &up;
+    Link link(config);
+    Packet pkt;
+    pkt.type = PacketType::AckPkt;
+    pkt.seq = 1;
+    pkt.payload_size = 0;
+    pkt.compute_crc();
+    for (int i = 0; i < 10; ++i) link.send_sat_to_gs(pkt);
+    link.send_gs_to_sat(pkt);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    Packet out;
+    while (link.recv_sat_to_gs(out, std::chrono::milliseconds(0))) {}
+    assert(down.snapshot().count() == 10);
+    assert(down.snapshot().max() >= 5000000);  // Waited at least the 5ms sleep
+    assert(up.snapshot().count() == 0);
+}
+
+TEST(test_packet_trace_chrome_export) {
+    const std::string path = "test_trace.json";
+    auto count_events = [&path] {
+        std::ifstream in(path);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        const std::string json = ss.str();
+        assert(json.rfind("{\"displayTimeUnit\"", 0) == 0);
+        assert(json.find("]}") != std::string::npos);
+        size_t events = 0;
+        for (size_t pos = 0; (pos = json.find("\"ph\": \"i\"", pos)) != std::string::npos; ++pos) {
+            events++;
+        }
+        return events;
+    };
+
+    auto& tracer = trace::Tracer::instance();
+    trace::emit(trace::Actor::Link, trace::Event::Sent, PacketType::TelemetryPkt, 0, 1);  // Not running
+    tracer.start(path, std::chrono::milliseconds(1));
+    assert(tracer.active());
+    bool threw = false;
+    try {
+        tracer.start(path);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    const uint32_t per_thread = 5000;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 2; ++t) {
+        threads.emplace_back([t, per_thread] {
+            for (uint32_t seq = 0; seq < per_thread; ++seq) {
+                trace::emit(trace::Actor::Satellite, trace::Event::Created, PacketType::TelemetryPkt, t, seq);
+                if (seq % 256 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));  // Let the flusher keep up
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    tracer.stop();
+    assert(!tracer.active());
+    assert(tracer.get_events_written() + tracer.get_events_dropped() == 2 * per_thread);
+    assert(count_events() == tracer.get_events_written());
+
+    // A second trace re-registers this thread's ring and starts a fresh file
+    tracer.start(path);
+    trace::emit(trace::Actor::GroundStation, trace::Event::Acked, PacketType::CommandPkt, 3, 7, 1);
+    tracer.stop();
+    assert(tracer.get_events_written() == 1 && count_events() == 1);
+    std::remove(path.c_str());
+}
+
+TEST(test_async_logger) {
+    // Ring: bounded, FIFO, reusable after a drain
+    SpscRing<uint32_t, 4> ring;
+    for (uint32_t i = 0; i < 4; ++i) assert(ring.try_push(i));
+    assert(!ring.try_push(99));
+    std::vector<uint32_t> seen;
+    assert(ring.drain([&](uint32_t v) { seen.push_back(v); }) == 4);
+    assert((seen == std::vector<uint32_t>{0, 1, 2, 3}) && ring.empty());
+    assert(ring.try_push(4) && ring.drain([](uint32_t v) { assert(v == 4); }) == 1);
+
+    // Formatting from the binary record
+    using logging::AsyncLogger;
+    std::string line;
+    {
+        auto& logger = AsyncLogger::instance();
+        std::ostringstream out;
+        logger.start(out, std::chrono::milliseconds(1));
+        logger.log("[SAT] seq=%u crc=0x%x temp=%.1fC d=%d %s %zu%% %5.2f|%-4s|",
+                   uint32_t{7}, uint16_t{0xbeef}, 21.37, -3, std::string("payload"), size_t{5}, 2.0, "ab");
+        logger.stop();
+        line = out.str();
+    }
+    assert(line == "[SAT] seq=7 crc=0xbeef temp=21.4C d=-3 payload 5%  2.00|ab  |\n");
+
+    // Lines from several threads arrive whole and in timestamp order
+    auto& logger = AsyncLogger::instance();
+    std::ostringstream out;
+    logger.start(out, std::chrono::milliseconds(1));
+    const int per_thread = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < per_thread; ++i) {
+                logging::log("[T%d] line %d of a longer message with text %s", t, i, std::string(40, 'x'));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    logger.stop();
+    assert(logger.get_lines_written() + logger.get_lines_dropped() == 3 * per_thread);
+    std::istringstream lines(out.str());
+    std::array<int, 3> next{};
+    uint64_t count = 0;
+    for (std::string l; std::getline(lines, l); ++count) {
+        int t = -1, i = -1;
+        assert(std::sscanf(l.c_str(), "[T%d] line %d", &t, &i) == 2);
+        assert(t >= 0 && t < 3 && i >= next[t]);  // Per-thread order kept
+        next[t] = i + 1;
+        assert(l.size() == l.find(std::string(40, 'x')) + 40);
+    }
+    assert(count == logger.get_lines_written());
+}
+
+TEST(test_metrics_prometheus_export) {
+    MetricsRegistry registry;
+    Link::Config link_config;
+    link_config.latency_ms = 1;
+    Link link(link_config);
+    link.register_metrics(registry, {{"sat", "0"}});
+    std::atomic<uint64_t> events{41};
+    registry.counter("test_events_total", "Events with \"quotes\"", {{"path", "a\\b\n"}},
+                     [&events] { return events.load(); });
+    registry.gauge("test_fill", "Fill ratio", {}, [] { return 0.5; });
+    HdrHistogram h;
+    for (uint64_t v : {uint64_t{50'000}, uint64_t{2'000'000}, uint64_t{3'000'000'000}}) h.record(v);
+    registry.histogram("test_age_seconds", "Ages", {{"kind", "x"}}, [&h] { return h; });
+    assert(registry.size() == 5);
+
+    Packet pkt;
+    pkt.type = PacketType::TelemetryPkt;
+    pkt.payload = "m";
+    pkt.payload_size = 1;
+    pkt.compute_crc();
+    link.send_sat_to_gs(pkt);
+    events++;
+
+    std::ostringstream out;
+    registry.write_prometheus(out);
+    const std::string text = out.str();
+    auto has = [&text](const std::string& s) { return text.find(s) != std::string::npos; };
+    assert(has("# HELP satcom_link_packets_sent_total Packets offered to the link\n"
+               "# TYPE satcom_link_packets_sent_total counter\n"
+               "satcom_link_packets_sent_total{sat=\"0\"} 1\n"));
+    assert(has("test_events_total{path=\"a\\\\b\\n\"} 42\n"));
+    assert(has("# TYPE test_fill gauge\ntest_fill 0.5\n"));
+    assert(has("# TYPE test_age_seconds histogram\n"));
+    assert(has("test_age_seconds_bucket{kind=\"x\",le=\"0.0001\"} 1\n"));
+    assert(has("test_age_seconds_bucket{kind=\"x\",le=\"0.0025\"} 2\n"));
+    assert(has("test_age_seconds_bucket{kind=\"x\",le=\"10\"} 3\n"));
+    assert(has("test_age_seconds_bucket{kind=\"x\",le=\"+Inf\"} 3\n"));
+    assert(has("test_age_seconds_sum{kind=\"x\"} 3.00205\n"));
+    assert(has("test_age_seconds_count{kind=\"x\"} 3\n"));
+
+    // Same family twice keeps one HELP/TYPE header; a type clash throws
+    registry.counter("test_events_total", "Events", {{"path", "c"}}, [] { return uint64_t{1}; });
+    std::ostringstream again;
+    registry.write_prometheus(again);
+    const std::string text2 = again.str();
+    assert(text2.find("# TYPE test_events_total") == text2.rfind("# TYPE test_events_total"));
+    assert(text2.find("test_events_total{path=\"c\"} 1\n") != std::string::npos);
+    bool threw = false;
+    try {
+        registry.gauge("test_events_total", "Events", {}, [] { return 0.0; });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Scrape over HTTP from an ephemeral port
+    MetricsServer server(registry, 0);
+    assert(server.port() != 0);
+    auto fetch = [&server](const std::string& path) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(fd >= 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(server.port());
+        assert(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        const std::string request = "GET " + path + " HTTP/1.0\r\n\r\n";
+        assert(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+        std::string response;
+        char buf[4096];
+        for (ssize_t n; (n = recv(fd, buf, sizeof(buf), 0)) > 0;) response.append(buf, static_cast<size_t>(n));
+        close(fd);
+        return response;
+    };
+    const std::string ok = fetch("/metrics");
+    assert(ok.rfind("HTTP/1.0 200 OK\r\n", 0) == 0);
+    assert(ok.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+    assert(ok.substr(ok.find("\r\n\r\n") + 4) == text2);
+    assert(fetch("/other").rfind("HTTP/1.0 404", 0) == 0);
+    assert(server.get_scrapes() == 1);
+    server.stop();
+}
+
+TEST(test_sharded_counter) {
+    // One padded slot per thread
+    static_assert(sizeof(ShardedCounter) == ShardedCounter::kSlots * 64);
+
+    ShardedCounter counter;
+    assert(counter.load() == 0);
+    counter++;
+    ++counter;
+    counter += 40;
+    assert(counter == 42);
+
+    // More threads than slots: nothing is lost when slots are shared
+    const int threads = static_cast<int>(ShardedCounter::kSlots) + 4;
+    const int per_thread = 20000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&counter] {
+            for (int i = 0; i < per_thread; ++i) counter++;
+        });
+    }
+    for (auto& w : workers) w.join();
+    assert(counter.load() == 42 + static_cast<uint64_t>(threads) * per_thread);
+
+    // store() replaces the total regardless of which slots hold it
+    std::thread([&counter] { counter += 5; }).join();
+    counter = 7;
+    assert(counter.load() == 7);
+    counter.add(3);
+    assert(counter.load() == 10);
+
+    // Threads get distinct, stable indices
+    const size_t mine = this_thread_index();
+    size_t other = mine;
+    std::thread([&other] { other = this_thread_index(); }).join();
+    assert(other != mine && this_thread_index() == mine);
+}
+
 int main() {
     std::cout << "\n=== Running Satellite Simulator Tests ===" << std::endl;
     std::cout << "\nTest results:" << std::endl;